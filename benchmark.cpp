@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    benchmark.cpp
+ * @date    18/10/2026
+ * @brief   Helpers of the startup benchmarks and the order they run in.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include "data.h"
+#include "benchmark.h"
+
+double millisecondsBetween(BenchmarkClock::time_point start, BenchmarkClock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+float randomFloat(float low, float high) {
+    return low + (high - low) * rand() / RAND_MAX;
+}
+
+#if SCENE_GRAPH_BENCHMARK || XML_PARSER_BENCHMARK
+//random tree in depth first order, each node closes 0 - 2 of the open subtrees before it is added
+void generateSceneGraph(SceneGraph* graph, int numNodes) {
+
+    clearSceneGraph(graph);
+    std::vector<int> openNodes;
+
+    for (int i = 0; i < numNodes; i++) {
+        int close = rand() % 3;
+        while (close-- > 0 && openNodes.size() > 1)
+            openNodes.pop_back();
+
+        glm::vec3 position(randomFloat(-10.0f, 10.0f), randomFloat(0.0f, 2.0f), randomFloat(-10.0f, 10.0f));
+        glm::vec3 rotation(0.0f, randomFloat(0.0f, 6.28f), 0.0f);
+        int node = addSceneNode(graph, openNodes.empty() ? -1 : openNodes.back(), SCENE_NODE_OBJECT, position, rotation, glm::vec3(randomFloat(0.5f, 1.5f)));
+        openNodes.push_back(node);
+    }
+    finishSceneGraph(graph);
+}
+
+bool writeSceneGraphFile(const SceneGraph& graph, const std::string& fileName) {
+
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    fprintf(file, "<Root>\n<SceneGraph>\n");
+    std::vector<int> openNodes;
+    for (size_t node = 0; node < graph.parents.size(); node++) {
+        while (!openNodes.empty() && openNodes.back() != graph.parents[node]) {
+            fprintf(file, "</Children></Node>\n");
+            openNodes.pop_back();
+        }
+        glm::vec3 rotation = glm::degrees(graph.rotations[node]);
+        const glm::vec3& position = graph.positions[node];
+        const glm::vec3& scale = graph.scales[node];
+        fprintf(file, "<Node name=\"node%d\" type=\"2\"><SceneObject model=\"rock\" shader=\"frag_light\"/>\n<Transform>\n"
+                      "<Rotation x=\"%f\" y=\"%f\" z=\"%f\"/>\n<Position x=\"%f\" y=\"%f\" z=\"%f\"/>\n<Scale x=\"%f\" y=\"%f\" z=\"%f\"/>\n"
+                      "</Transform>\n<Children>\n", (int)node, rotation.x, rotation.y, rotation.z, position.x, position.y, position.z, scale.x, scale.y, scale.z);
+        openNodes.push_back((int)node);
+    }
+    while (!openNodes.empty()) {
+        fprintf(file, "</Children></Node>\n");
+        openNodes.pop_back();
+    }
+    fprintf(file, "</SceneGraph>\n</Root>\n");
+
+    return fclose(file) == 0;
+}
+#endif
+
+void runStartupBenchmarks() {
+
+#if MESH_LOADER_BENCHMARK
+    benchmarkMeshLoaders();
+#endif
+#if FRUSTUM_CULLING_BENCHMARK
+    benchmarkFrustumCulling();
+#endif
+#if TRANSFORM_CACHE_BENCHMARK
+    benchmarkTransformCache();
+#endif
+#if MESH_OPTIMIZER_BENCHMARK
+    benchmarkMeshOptimizer();
+#endif
+#if SCENE_BVH_BENCHMARK
+    benchmarkSceneBvh();
+#endif
+#if SCENE_GRAPH_BENCHMARK
+    benchmarkSceneGraph();
+#endif
+#if XML_PARSER_BENCHMARK
+    benchmarkXmlParser();
+#endif
+#if ENTITY_STORAGE_BENCHMARK
+    benchmarkEntityStorage();
+#endif
+#if SCENE_ARENA_BENCHMARK
+    benchmarkSceneArena();
+#endif
+}
@@ -0,0 +1,78 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    benchmark.h
+ * @date    18/10/2026
+ * @brief   Startup benchmarks switched on by the *_BENCHMARK defines of data.h and their shared helpers.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include "render_stuff.h"
+#include "scene_graph.h"
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+double millisecondsBetween(BenchmarkClock::time_point start, BenchmarkClock::time_point end);
+//uniform in [low, high] from rand(), the benchmarks seed nothing so runs see the same numbers
+float randomFloat(float low, float high);
+
+//an object of the scene before the entities - allocated on its own, with its times and a copy of its model name
+typedef struct HeapObject {
+  Object        transform;
+  float         startTime;
+  float         currentTime;
+  std::string   id;
+} HeapObject;
+
+#if SCENE_GRAPH_BENCHMARK || XML_PARSER_BENCHMARK
+//random tree of numNodes objects in depth first order, the scene of the scene graph and XML parser benchmarks
+void generateSceneGraph(SceneGraph* graph, int numNodes);
+//writes the nodes in the format of the shipped file, one <Node> with a <Transform> and <Children> each
+bool writeSceneGraphFile(const SceneGraph& graph, const std::string& fileName);
+#endif
+
+//runs the benchmarks switched on in data.h one after another, they print to std::cout
+void runStartupBenchmarks();
+
+#if MESH_LOADER_BENCHMARK
+//compares import time of Assimp and the native OBJ loader on all models, CPU part only (no GL upload)
+void benchmarkMeshLoaders();
+#endif
+#if FRUSTUM_CULLING_BENCHMARK
+//times scalar and vectorized culling of 1M random spheres
+void benchmarkFrustumCulling();
+#endif
+#if TRANSFORM_CACHE_BENCHMARK
+//per frame matrix work of static objects plus 1% moving ones, rebuilt every frame against cached with dirty flags
+void benchmarkTransformCache();
+#endif
+#if MESH_OPTIMIZER_BENCHMARK
+//vertex cache efficiency of all shipped models before and after optimizeMesh
+void benchmarkMeshOptimizer();
+#endif
+#if SCENE_BVH_BENCHMARK
+//build, refit and query times against brute force over random boxes
+void benchmarkSceneBvh();
+#endif
+#if SCENE_GRAPH_BENCHMARK
+//load and update times of the shipped file and of generated graphs with 1M nodes
+void benchmarkSceneGraph();
+#endif
+#if XML_PARSER_BENCHMARK
+//tag, attribute and float throughput in MB/s over a large generated scene file
+void benchmarkXmlParser();
+#endif
+#if ENTITY_STORAGE_BENCHMARK
+//animation and draw pass throughput of 10k and 1M entities against separately allocated objects
+void benchmarkEntityStorage();
+#endif
+#if SCENE_ARENA_BENCHMARK
+//restart latency of 1k - 100k objects, per object new/delete against arena reset and template copy
+void benchmarkSceneArena();
+#endif
+
+#endif
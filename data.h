@@ -24,8 +24,8 @@ enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEYS_COUNT
 #define BROOM_SIZE      0.3f
 #define WAND_SIZE       0.1f
 #define HALL_SIZE       4.0f
-#define GROUND_SIZE     10.0f;
-#define EAGLE_SIZE      0.4f;
+#define GROUND_SIZE     10.0f
+#define EAGLE_SIZE      0.4f
 
 #define BILLBOARD_SIZE   0.1f
 #define FIRE_BILLBOARD_SIZE   0.1f
@@ -40,7 +40,9 @@ enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEYS_COUNT
 #define SKYBOX_PREFIX_NIGHT     "data/skyboxn/"
 #define HALL_MODEL_NAME         "data/hall/compHall.obj"
 #define EAGLE_MODEL_NAME        "data/bird/eagle.obj"
-#define ROCK_MODEL_NAME         "cliff_rock_two_obj.h"
+#define SCENE_GRAPH_FILE_NAME   "data/SceneGraphFinal.xml"
+#define ROCK_MODEL_NAME         "rock_mesh.bin"         //linked into the executable, mesh_cooker --rock writes it from cliff_rock_two_obj.h
+#define ROCK_TEXTURE_NAME       "data/rock_hardcoded/rock_texture.png"
 #define FIREPLACE_MODEL_NAME    "data/Fireplace/fireplace.obj"
 #define FIRE_TEXTURE_NAME       "data/Fireplace/fire.png"
 
@@ -50,6 +52,7 @@ enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEYS_COUNT
 
 #define VIEW_ANGLE_DELTA 2.0f
 #define DAY_LENGTH       30
+#define DAY_TRANSITION_SPEED 0.3f       //change of the day time per second at dawn and dusk, night falls in 3.3 s
 
 #define SKYBOX_SPEED        1.0f
 #define CAMERA_SPEED        1.0f
@@ -63,6 +66,37 @@ enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEYS_COUNT
 
 #define CAMERA_ELEVATION_MAX 25.0f
 
+//startup benchmarks, run by runStartupBenchmarks (benchmark.h) before the models load
+#define MESH_LOADER_BENCHMARK   0       //1 = print Assimp vs native OBJ loader import times at startup
+#define FRUSTUM_CULLING_BENCHMARK 0     //1 = print scalar vs SIMD culling times of 1M spheres at startup
+#define TRANSFORM_CACHE_BENCHMARK 0     //1 = print per frame matrix work with and without cached object transforms at startup
+#define MESH_OPTIMIZER_BENCHMARK 0      //1 = print ACMR/ATVR of all models before and after the mesh optimizer at startup
+#define SCENE_BVH_BENCHMARK     0       //1 = print BVH build, refit and query times against brute force at startup
+#define SCENE_GRAPH_BENCHMARK   0       //1 = print scene file load and transform update times, shipped file and 1M generated nodes, at startup
+#define XML_PARSER_BENCHMARK    0       //1 = print XML tag and float attribute throughput in MB/s over a generated scene file at startup
+#define ENTITY_STORAGE_BENCHMARK 0      //1 = print animation and draw pass throughput of 10k and 1M entities, dense vs separately allocated, at startup
+#define SCENE_ARENA_BENCHMARK   0       //1 = print restart latency of 1k - 100k objects, per object new/delete vs arena reset and template copy, at startup
+
+#define STARTUP_WORKER_THREADS  0       //worker threads of the startup scheduler, 0 = one per hardware thread
+#define RENDER_QUEUE_STATS      0       //1 = print draw calls and state changes of the render queue every second
+#define FOREST_TREE_COUNT       0       //extra pine trees scattered over the grounds, drawn instanced with the others
+#define SCENE_BVH_CULLING       1       //1 = cull objects with the scene BVH, 0 = test every queued item
+#define COMPACT_VERTICES        1       //1 = quantized 16 byte vertices for meshes that fit, 0 = 32 byte float vertices everywhere
+#define LOD_PIXEL_ERROR         1.0f    //coarsest level of detail whose simplification error stays under this many pixels is drawn
+#define LOD_HYSTERESIS          0.25f   //level changes only when the error leaves this fraction around LOD_PIXEL_ERROR, stops popping
+#define INSTANCE_LOD_CELLS      4       //instanced batches pick levels per cell of a CELLS x CELLS grid over the batch, not per instance
+#define GEOMETRY_ARENA          1       //1 = static meshes share page buffers per vertex layout and draw with a base vertex, 0 = own VBO/EBO/VAO per mesh
+#define GPU_DRIVEN_DRAWING      1       //1 = lit opaque objects are culled by a compute shader and drawn with multi draw indirect where GL 4.3 is available
+#define TEXTURE_STREAMING       1       //1 = cooked textures start with their smallest levels, finer ones are streamed in as objects come close
+#define TEXTURE_STREAM_BUDGET_MB 64     //video memory of streamed textures, least recently used levels are evicted above it
+#define TEXTURE_ARRAYS          1       //1 = cooked model textures of one format share a GL_TEXTURE_2D_ARRAY, one bind for all props
+#define TEXTURE_ARRAY_LAYER_SIZE 1024   //texels across an array layer, larger square textures join with their mip level of this size
+#define SCENE_ARENA_BLOCK_SIZE  (4 * 1024 * 1024)   //first block of the scene arena, a restart after a larger scene makes one block of the size it needed
+#define SIMULATION_RATE         120     //fixed simulation steps per second, frames are drawn between them
+#define SIMULATION_MAX_STEPS    12      //steps caught up per frame at most, the rest of a long stall is dropped
+#define SIMULATION_STATS        0       //1 = print simulation steps and rendered frames per second every second
+#define FRAME_RATE_LIMIT        240     //frames per second at most, the idle callback sleeps until the next one is due, 0 = no limit
+
 
 const std::string colorVertexShaderSrc(
     "#version 140\n"
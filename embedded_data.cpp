@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    embedded_data.cpp
+ * @date    18/10/2026
+ * @brief   Lookup of the blobs the linker put into the executable.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cstring>
+#include "embedded_data.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+//resources of asteroids.rc, LockResource only returns a pointer into the mapped image
+bool findEmbeddedData(const char* name, const char** data, size_t* size) {
+
+    HRSRC resource = FindResourceA(NULL, name, MAKEINTRESOURCEA(10));   // RT_RCDATA
+    if (resource == NULL)
+        return false;
+    HGLOBAL loaded = LoadResource(NULL, resource);
+    if (loaded == NULL)
+        return false;
+
+    *data = (const char*)LockResource(loaded);
+    *size = SizeofResource(NULL, resource);
+    return *data != NULL;
+}
+
+#else
+
+//.incbin puts the file into a read-only section at link time, the symbols mark its ends
+#define EMBED_FILE(symbol, file) \
+    __asm__(".section .rodata\n" \
+            ".balign 16\n" \
+            #symbol "Start:\n" \
+            ".incbin \"" file "\"\n" \
+            #symbol "End:\n" \
+            ".previous\n"); \
+    extern "C" const char symbol##Start[]; \
+    extern "C" const char symbol##End[];
+
+//.incbin opens a relative path from the working directory of the assembler, not from this file -
+//builds that do not compile in the source directory pass it, e.g. -DEMBEDDED_DATA_DIR=\"$(srcdir)\"
+#ifndef EMBEDDED_DATA_DIR
+#define EMBEDDED_DATA_DIR "."
+#endif
+
+EMBED_FILE(rockMesh, EMBEDDED_DATA_DIR "/rock_mesh.bin")
+
+//Blob name and its section symbols, mirrors asteroids.rc
+typedef struct EmbeddedFile {
+  const char*   name;
+  const char*   start;
+  const char*   end;
+} EmbeddedFile;
+
+static const EmbeddedFile embeddedFiles[] = {
+    { ROCK_MESH_RESOURCE, rockMeshStart, rockMeshEnd },
+};
+
+bool findEmbeddedData(const char* name, const char** data, size_t* size) {
+
+    for (size_t i = 0; i < sizeof(embeddedFiles) / sizeof(embeddedFiles[0]); i++) {
+        if (strcmp(embeddedFiles[i].name, name) == 0) {
+            *data = embeddedFiles[i].start;
+            *size = (size_t)(embeddedFiles[i].end - embeddedFiles[i].start);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
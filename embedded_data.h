@@ -0,0 +1,26 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    embedded_data.h
+ * @date    18/10/2026
+ * @brief   Binary blobs linked into the executable - RCDATA resources on Windows, .incbin sections elsewhere.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __EMBEDDED_DATA_H
+#define __EMBEDDED_DATA_H
+
+#include <cstddef>
+
+//resource name of the rock blob in asteroids.rc, the file is ROCK_MODEL_NAME
+#define ROCK_MESH_RESOURCE  "ROCK_MESH"
+
+/**
+ * @brief Finds blob of given resource name in the loaded executable image.
+ *
+ * The data is part of the mapped image, nothing is copied and it stays valid for the whole run.
+ *
+ * @return false if the executable was built without the blob
+ */
+bool findEmbeddedData(const char* name, const char** data, size_t* size);
+
+#endif
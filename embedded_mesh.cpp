@@ -0,0 +1,173 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    embedded_mesh.cpp
+ * @date    18/10/2026
+ * @brief   Writing of embedded mesh blobs (mesh_cooker) and their validation at startup.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include "embedded_mesh.h"
+
+//resource and section data of the executable are at least this aligned
+#define EMBEDDED_MESH_ALIGNMENT 16
+
+static uint32_t alignOffset(uint64_t offset) {
+    return (uint32_t)((offset + EMBEDDED_MESH_ALIGNMENT - 1) & ~(uint64_t)(EMBEDDED_MESH_ALIGNMENT - 1));
+}
+
+static void writePadding(std::ofstream& stream, uint32_t offset) {
+
+    static const char zeros[EMBEDDED_MESH_ALIGNMENT] = { 0 };
+    uint64_t position = (uint64_t)stream.tellp();
+    if (position < offset)
+        stream.write(zeros, offset - position);
+}
+
+bool writeEmbeddedMesh(const MeshData& mesh, bool compact, uint64_t sourceHash, const std::string& fileName) {
+
+    const size_t numVertices = mesh.positions.size() / 3;
+    if (numVertices == 0 || mesh.indices.empty())
+        return false;
+
+    EmbeddedMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EMBEDDED_MESH_MAGIC, 4);
+    header.version = EMBEDDED_MESH_VERSION;
+    header.sourceHash = sourceHash;
+    header.vertexLayout = VERTEX_LAYOUT_VERSION;
+    header.numVertices = (uint32_t)numVertices;
+    header.numIndices = (uint32_t)mesh.indices.size();
+
+    header.numLods = 1;
+    header.lods[0].numIndices = header.numIndices;
+    if (!mesh.lods.empty()) {
+        header.numLods = (uint32_t)std::min(mesh.lods.size(), (size_t)MESH_MAX_LODS);
+        for (uint32_t i = 0; i < header.numLods; i++)
+            header.lods[i] = mesh.lods[i];
+    }
+
+    // the same box and sphere computeMeshBounds gives at runtime
+    glm::vec3 boundsMin(mesh.positions[0], mesh.positions[1], mesh.positions[2]);
+    glm::vec3 boundsMax = boundsMin;
+    for (size_t v = 1; v < numVertices; v++) {
+        glm::vec3 position(mesh.positions[3 * v], mesh.positions[3 * v + 1], mesh.positions[3 * v + 2]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+    float radiusSquared = 0.0f;
+    for (size_t v = 0; v < numVertices; v++) {
+        glm::vec3 offset = glm::vec3(mesh.positions[3 * v], mesh.positions[3 * v + 1], mesh.positions[3 * v + 2]) - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    for (int i = 0; i < 3; i++) {
+        header.boundsMin[i] = boundsMin[i];
+        header.boundsMax[i] = boundsMax[i];
+        header.boundingSphere[i] = center[i];
+    }
+    header.boundingSphere[3] = sqrtf(radiusSquared);
+
+    VertexStreams streams;
+    streams.positions = mesh.positions.data();
+    streams.normals = mesh.normals.data();
+    streams.texCoords = mesh.texCoords.empty() ? NULL : mesh.texCoords.data();
+    streams.positionStride = 3;
+    streams.normalStride = 3;
+    streams.texCoordStride = 2;
+    streams.numVertices = numVertices;
+
+    std::vector<CompactVertex> compactVertices;
+    std::vector<float> floatVertices;
+    glm::vec4 texCoordTransform(1.0f, 1.0f, 0.0f, 0.0f);
+
+    const char* vertexData;
+    if (compact && encodeCompactVertices(streams, boundsMin, boundsMax, &compactVertices, &texCoordTransform)) {
+        header.vertexFormat = VERTEX_FORMAT_COMPACT;
+        vertexData = (const char*)compactVertices.data();
+    }
+    else {
+        header.vertexFormat = VERTEX_FORMAT_FLOAT;
+        copyInterleavedVertices(streams, &floatVertices);
+        vertexData = (const char*)floatVertices.data();
+    }
+    for (int i = 0; i < 4; i++)
+        header.texCoordTransform[i] = texCoordTransform[i];
+
+    std::vector<uint16_t> shortIndices;
+    const char* indexData = (const char*)mesh.indices.data();
+    header.indexSize = sizeof(unsigned int);
+    if (numVertices < 65536) {
+        shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+        indexData = (const char*)shortIndices.data();
+        header.indexSize = sizeof(uint16_t);
+    }
+
+    const size_t vertexBytes = vertexFormatSize((VertexFormat)header.vertexFormat) * numVertices;
+    header.vertexOffset = alignOffset(sizeof(EmbeddedMeshHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + vertexBytes);
+
+    //the blob is an input of the game build, a failed write must not leave half of it
+    std::string temporaryFile = fileName + ".tmp";
+    std::ofstream stream(temporaryFile.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    stream.write((const char*)&header, sizeof(header));
+    writePadding(stream, header.vertexOffset);
+    stream.write(vertexData, vertexBytes);
+    writePadding(stream, header.indexOffset);
+    stream.write(indexData, (size_t)header.indexSize * header.numIndices);
+    stream.close();
+
+    if (!stream) {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    std::remove(fileName.c_str());
+    return std::rename(temporaryFile.c_str(), fileName.c_str()) == 0;
+}
+
+bool embeddedMeshUpToDate(const std::string& fileName, uint64_t sourceHash) {
+
+    EmbeddedMeshHeader header;
+    std::ifstream stream(fileName.c_str(), std::ios::binary);
+    if (!stream.read((char*)&header, sizeof(header)))
+        return false;
+
+    return memcmp(header.magic, EMBEDDED_MESH_MAGIC, 4) == 0 && header.version == EMBEDDED_MESH_VERSION
+        && header.vertexLayout == VERTEX_LAYOUT_VERSION && header.sourceHash == sourceHash;
+}
+
+bool parseEmbeddedMesh(const char* data, size_t size, EmbeddedMesh* mesh) {
+
+    if (data == NULL || size < sizeof(EmbeddedMeshHeader))
+        return false;
+
+    const EmbeddedMeshHeader* header = (const EmbeddedMeshHeader*)data;
+    if (memcmp(header->magic, EMBEDDED_MESH_MAGIC, 4) != 0 || header->version != EMBEDDED_MESH_VERSION)
+        return false;
+    if (header->vertexLayout != VERTEX_LAYOUT_VERSION)
+        return false;
+    if (header->vertexFormat > VERTEX_FORMAT_COMPACT || (header->indexSize != 2 && header->indexSize != 4))
+        return false;
+    if (header->numLods == 0 || header->numLods > MESH_MAX_LODS)
+        return false;
+
+    const uint64_t vertexEnd = header->vertexOffset + (uint64_t)vertexFormatSize((VertexFormat)header->vertexFormat) * header->numVertices;
+    const uint64_t indexEnd = header->indexOffset + (uint64_t)header->indexSize * header->numIndices;
+    if (vertexEnd > size || indexEnd > size || header->vertexOffset < sizeof(EmbeddedMeshHeader) || header->indexOffset < vertexEnd)
+        return false;
+
+    mesh->header = header;
+    mesh->vertices = data + header->vertexOffset;
+    mesh->indices = data + header->indexOffset;
+    return true;
+}
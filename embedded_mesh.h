@@ -0,0 +1,63 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    embedded_mesh.h
+ * @date    18/10/2026
+ * @brief   Mesh blob linked into the executable - vertices and indices in the layout OpenGL gets them.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __EMBEDDED_MESH_H
+#define __EMBEDDED_MESH_H
+
+#include <cstdint>
+#include <string>
+#include "mesh_data.h"
+#include "vertex_format.h"
+
+#define EMBEDDED_MESH_MAGIC     "HGEM"
+#define EMBEDDED_MESH_VERSION   2
+
+//Fixed size header at the beginning of the blob, offsets are from its start
+typedef struct EmbeddedMeshHeader {
+  char      magic[4];
+  uint32_t  version;
+  uint64_t  sourceHash;             // of the source arrays and the cooking switches, an equal one is not cooked again
+  uint32_t  vertexLayout;           // VERTEX_LAYOUT_VERSION the vertices were written with
+
+  uint32_t  numVertices;
+  uint32_t  numIndices;
+  uint32_t  numLods;
+  MeshLod   lods[MESH_MAX_LODS];
+
+  uint32_t  vertexFormat;           // VertexFormat of the vertex block
+  float     boundsMin[3];           // the compact vertices are quantized in this box
+  float     boundsMax[3];
+  float     boundingSphere[4];      // center in the box, radius to the farthest vertex
+  float     texCoordTransform[4];   // xy scale, zw offset of the compact UVs
+  uint32_t  indexSize;              // 2 or 4 bytes
+
+  uint32_t  vertexOffset;
+  uint32_t  indexOffset;
+} EmbeddedMeshHeader;
+
+//Views into the blob, valid as long as the blob memory is
+typedef struct EmbeddedMesh {
+  const EmbeddedMeshHeader* header;
+  const void*               vertices;
+  const void*               indices;
+} EmbeddedMesh;
+
+/**
+ * @brief Writes the mesh as it will be uploaded - compact vertices if compact is set and the UVs fit, 16 bit indices if possible.
+ * @param mesh        already optimized, with its levels of detail
+ * @param sourceHash  identity of what the mesh was cooked from, embeddedMeshUpToDate compares it
+ */
+bool writeEmbeddedMesh(const MeshData& mesh, bool compact, uint64_t sourceHash, const std::string& fileName);
+
+//true if the blob file exists, is of this version and vertex layout and was cooked from sourceHash
+bool embeddedMeshUpToDate(const std::string& fileName, uint64_t sourceHash);
+
+//checks the header and the block bounds, a blob of another version or vertex layout is rejected
+bool parseEmbeddedMesh(const char* data, size_t size, EmbeddedMesh* mesh);
+
+#endif
@@ -0,0 +1,282 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    entity_storage.cpp
+ * @date    18/10/2026
+ * @brief   Handle bookkeeping and swap removal of the dense component arrays.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "entity_storage.h"
+
+#if ENTITY_STORAGE_BENCHMARK
+#include "benchmark.h"
+#endif
+
+//capacity of the first arrays, doubled whenever they are full
+#define ENTITY_MIN_CAPACITY     64
+
+//arrays of all components have the same layout, one place lists them
+#define ENTITY_ARRAYS(X) \
+    X(transforms, Object) X(kinds, ObjectKind) X(animations, ObjectAnimation) X(stencilIds, unsigned char) \
+    X(denseSlots, uint32_t) X(slotEntities, uint32_t) X(slotGenerations, uint32_t) X(freeSlots, uint32_t)
+
+void initEntities(EntityStorage* storage, SceneArena* arena) {
+
+    *storage = EntityStorage();
+    storage->arena = arena;
+}
+
+void clearEntities(EntityStorage* storage) {
+
+    // live slots die, the generations stay so old handles do not find the next owners
+    storage->numFreeSlots = 0;
+    for (size_t slot = storage->numSlots; slot-- > 0;) {
+        if (storage->slotGenerations[slot] & 1)
+            storage->slotGenerations[slot]++;
+        storage->freeSlots[storage->numFreeSlots++] = (uint32_t)slot;
+    }
+    storage->count = 0;
+}
+
+void reserveEntities(EntityStorage* storage, size_t numEntities) {
+
+    if (numEntities <= storage->capacity)
+        return;
+
+    // new arrays after the old ones, the old ones are freed by the arena reset
+    // every array is used up to numSlots at most, the slot arrays exactly
+#define GROW_ARRAY(name, type) { \
+        type* array = allocateSceneArray<type>(storage->arena, numEntities); \
+        if (storage->numSlots > 0) \
+            memcpy(array, storage->name, storage->numSlots * sizeof(type)); \
+        storage->name = array; }
+    ENTITY_ARRAYS(GROW_ARRAY)
+#undef GROW_ARRAY
+
+    storage->capacity = numEntities;
+}
+
+void copyEntities(EntityStorage* destination, SceneArena* arena, const EntityStorage& source) {
+
+    initEntities(destination, arena);
+    reserveEntities(destination, source.numSlots);
+
+#define COPY_ARRAY(name, type) \
+    if (source.numSlots > 0) \
+        memcpy(destination->name, source.name, source.numSlots * sizeof(type));
+    ENTITY_ARRAYS(COPY_ARRAY)
+#undef COPY_ARRAY
+
+    destination->count = source.count;
+    destination->numSlots = source.numSlots;
+    destination->numFreeSlots = source.numFreeSlots;
+}
+
+EntityHandle createEntity(EntityStorage* storage, ObjectKind kind, int stencilId) {
+
+    if (storage->count == storage->capacity)
+        reserveEntities(storage, std::max(2 * storage->capacity, (size_t)ENTITY_MIN_CAPACITY));
+
+    EntityHandle entity;
+    if (storage->numFreeSlots > 0) {
+        entity.slot = storage->freeSlots[--storage->numFreeSlots];
+    }
+    else {
+        entity.slot = (uint32_t)storage->numSlots++;
+        storage->slotGenerations[entity.slot] = 0;
+    }
+    entity.generation = ++storage->slotGenerations[entity.slot];
+
+    const size_t index = storage->count++;
+    storage->slotEntities[entity.slot] = (uint32_t)index;
+
+    Object& transform = storage->transforms[index];
+    transform.position = glm::vec3(0.0f);
+    transform.direction = glm::vec3(0.0f, 1.0f, 0.0f);
+    transform.rotationAngle = 0.0f;
+    transform.size = 1.0f;
+    transform.modelMatrix = glm::mat4(1.0f);
+    transform.normalMatrix = glm::mat4(1.0f);
+    transform.transformDirty = true;
+    transform.lodLevel = 0;
+
+    ObjectAnimation& animation = storage->animations[index];
+    animation.startTime = 0.0f;
+    animation.currentTime = 0.0f;
+    animation.frameDuration = 0.0f;
+    animation.speed = 0.0f;
+    animation.initPosition = glm::vec3(0.0f);
+
+    storage->kinds[index] = kind;
+    storage->stencilIds[index] = (unsigned char)stencilId;
+    storage->denseSlots[index] = entity.slot;
+
+    return entity;
+}
+
+bool destroyEntity(EntityStorage* storage, EntityHandle entity) {
+
+    int index = entityIndex(*storage, entity);
+    if (index < 0)
+        return false;
+
+    // the last entity moves into the hole, its slot follows it
+    size_t last = --storage->count;
+    storage->transforms[index] = storage->transforms[last];
+    storage->kinds[index] = storage->kinds[last];
+    storage->animations[index] = storage->animations[last];
+    storage->stencilIds[index] = storage->stencilIds[last];
+    storage->denseSlots[index] = storage->denseSlots[last];
+    storage->slotEntities[storage->denseSlots[index]] = (uint32_t)index;
+
+    // odd generations are live, the next create makes it odd again
+    storage->slotGenerations[entity.slot]++;
+    storage->freeSlots[storage->numFreeSlots++] = entity.slot;
+    return true;
+}
+
+bool entityAlive(const EntityStorage& storage, EntityHandle entity) {
+
+    return entity.slot < storage.numSlots && entity.generation != 0 && storage.slotGenerations[entity.slot] == entity.generation;
+}
+
+int entityIndex(const EntityStorage& storage, EntityHandle entity) {
+
+    return entityAlive(storage, entity) ? (int)storage.slotEntities[entity.slot] : -1;
+}
+
+Object* entityTransform(EntityStorage* storage, EntityHandle entity) {
+
+    int index = entityIndex(*storage, entity);
+    return index < 0 ? NULL : &storage->transforms[index];
+}
+
+ObjectAnimation* entityAnimation(EntityStorage* storage, EntityHandle entity) {
+
+    int index = entityIndex(*storage, entity);
+    return index < 0 ? NULL : &storage->animations[index];
+}
+
+void gatherEntityTransforms(EntityStorage* storage, ObjectKind kind, std::vector<Object*>* transforms) {
+
+    transforms->clear();
+    for (size_t i = 0; i < storage->count; i++) {
+        if (storage->kinds[i] == kind)
+            transforms->push_back(&storage->transforms[i]);
+    }
+}
+
+#if ENTITY_STORAGE_BENCHMARK
+//every 100th object moves, the draw pass refreshes its matrices and reads the translation of all
+static float drawPass(Object* const* transforms, size_t count) {
+
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        updateObjectTransform(OBJECT_TREE, transforms[i], glm::mat4(1.0f));
+        sum += transforms[i]->modelMatrix[3].x;
+    }
+    return sum;
+}
+
+static void benchmarkEntityCount(size_t numEntities, int numFrames) {
+
+    typedef BenchmarkClock Clock;
+
+    // separate objects, created between other allocations as a game creates them over time
+    std::vector<HeapObject*> separate(numEntities);
+    std::vector<std::string*> garbage;
+    for (size_t i = 0; i < numEntities; i++) {
+        separate[i] = new HeapObject;
+        separate[i]->transform.position = glm::vec3((float)(i % 1000), 0.0f, (float)(i / 1000));
+        separate[i]->transform.direction = glm::vec3(0.0f, 1.0f, 0.0f);
+        separate[i]->transform.rotationAngle = 0.0f;
+        separate[i]->transform.size = 1.0f;
+        separate[i]->startTime = 0.0f;
+        separate[i]->id = TREE_MODEL_NAME;
+        if (rand() % 4 == 0)
+            garbage.push_back(new std::string(64 + rand() % 64, 'x'));
+    }
+    std::vector<Object*> separateTransforms(numEntities);
+    for (size_t i = 0; i < numEntities; i++)
+        separateTransforms[i] = &separate[i]->transform;
+
+    // entities, the creation time of the first and the last tenth shows the cost does not grow
+    SceneArena arena;
+    initSceneArena(&arena, SCENE_ARENA_BLOCK_SIZE);
+    EntityStorage storage;
+    initEntities(&storage, &arena);
+    std::vector<EntityHandle> handles(numEntities);
+    const size_t tenth = std::max(numEntities / 10, (size_t)1);
+    double firstTenthTime = 0.0, lastTenthTime = 0.0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < numEntities; i++) {
+        if (i == tenth)
+            firstTenthTime = millisecondsBetween(start, Clock::now());
+        if (i == numEntities - tenth)
+            start = Clock::now();
+        handles[i] = createEntity(&storage, OBJECT_TREE, 4);
+        storage.transforms[i].position = separate[i]->transform.position;
+    }
+    lastTenthTime = millisecondsBetween(start, Clock::now());
+
+    std::vector<Object*> denseTransforms;
+    gatherEntityTransforms(&storage, OBJECT_TREE, &denseTransforms);
+
+    double separateAnimationTime = 0.0, denseAnimationTime = 0.0;
+    double separateDrawTime = 0.0, denseDrawTime = 0.0;
+    float checksum = 0.0f;
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        const float time = 0.016f * frame;
+
+        for (size_t i = frame % 100; i < numEntities; i += 100) {
+            separate[i]->transform.position.y = time;
+            separate[i]->transform.transformDirty = true;
+            storage.transforms[i].position.y = time;
+            storage.transforms[i].transformDirty = true;
+        }
+
+        start = Clock::now();
+        for (size_t i = 0; i < numEntities; i++)
+            separate[i]->currentTime = time;
+        separateAnimationTime += millisecondsBetween(start, Clock::now());
+
+        start = Clock::now();
+        for (size_t i = 0; i < storage.count; i++)
+            storage.animations[i].currentTime = time;
+        denseAnimationTime += millisecondsBetween(start, Clock::now());
+
+        start = Clock::now();
+        checksum += drawPass(separateTransforms.data(), numEntities);
+        separateDrawTime += millisecondsBetween(start, Clock::now());
+
+        start = Clock::now();
+        checksum -= drawPass(denseTransforms.data(), denseTransforms.size());
+        denseDrawTime += millisecondsBetween(start, Clock::now());
+    }
+
+    const double entitiesPerMs = (double)numEntities * numFrames / 1000.0;   // millions per second
+    std::cout << "  " << numEntities << " entities: animation pass " << entitiesPerMs / separateAnimationTime << " -> "
+              << entitiesPerMs / denseAnimationTime << " M/s, draw pass " << entitiesPerMs / separateDrawTime << " -> "
+              << entitiesPerMs / denseDrawTime << " M/s" << std::endl;
+    std::cout << "    create " << 1000000.0 * firstTenthTime / tenth << " ns each in the first tenth, "
+              << 1000000.0 * lastTenthTime / tenth << " ns in the last (checksum " << checksum << ")" << std::endl;
+
+    for (size_t i = 0; i < numEntities; i++)
+        delete separate[i];
+    for (size_t i = 0; i < garbage.size(); i++)
+        delete garbage[i];
+    deleteSceneArena(&arena);
+}
+
+void benchmarkEntityStorage() {
+
+    std::cout << "entity storage benchmark, separately allocated objects -> dense components:" << std::endl;
+    benchmarkEntityCount(10000, 100);
+    benchmarkEntityCount(1000000, 10);
+}
+#endif
@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    entity_storage.h
+ * @date    18/10/2026
+ * @brief   Scene objects as dense component arrays addressed by stable entity handles.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __ENTITY_STORAGE_H
+#define __ENTITY_STORAGE_H
+
+#include <cstdint>
+#include <vector>
+#include "render_stuff.h"
+#include "scene_arena.h"
+
+//Names an entity as long as it lives, a handle of a destroyed entity never finds the slot's next owner
+typedef struct EntityHandle {
+  uint32_t      slot;
+  uint32_t      generation;             // 0 is never used, a zeroed handle is invalid
+} EntityHandle;
+
+//Components of all entities in parallel dense arrays, entity i has transforms[i], kinds[i], ...
+//destroying swaps the last entity into the hole, so the arrays stay packed and passes run over [0, count)
+//all arrays are in the scene arena and have capacity elements, growing leaves the old ones there until its reset
+typedef struct EntityStorage {
+  SceneArena*       arena = NULL;
+  size_t            count = 0;
+  size_t            capacity = 0;
+
+  //hot, read by every update and draw
+  Object*           transforms = NULL;
+  ObjectKind*       kinds = NULL;           // render - geometry, program and pass
+  ObjectAnimation*  animations = NULL;
+  unsigned char*    stencilIds = NULL;      // picking, written to the stencil buffer while drawing
+
+  //cold, only for handle lookups
+  uint32_t*         denseSlots = NULL;      // slot of entity i
+  uint32_t*         slotEntities = NULL;    // entity index of a live slot
+  uint32_t*         slotGenerations = NULL;
+  uint32_t*         freeSlots = NULL;
+  size_t            numSlots = 0;           // never more than capacity, a slot is only added when none is free
+  size_t            numFreeSlots = 0;
+} EntityStorage;
+
+//empty storage in the arena, the arrays are allocated by the first create
+void initEntities(EntityStorage* storage, SceneArena* arena);
+//removes all entities, handles of them become stale but the arena memory is kept
+void clearEntities(EntityStorage* storage);
+//space for numEntities without growing, component pointers stay valid while the count stays below it
+void reserveEntities(EntityStorage* storage, size_t numEntities);
+
+/**
+ * @brief Makes destination a copy of source in the arena, handles of source are valid in the copy.
+ *
+ * Only memcpy of the arrays, used to restore a prebuilt scene after the arena was reset.
+ */
+void copyEntities(EntityStorage* destination, SceneArena* arena, const EntityStorage& source);
+
+/**
+ * @brief Appends an entity with an identity transform and no animation, amortized O(1).
+ *
+ * Pointers to components of other entities are valid until the arrays grow.
+ */
+EntityHandle createEntity(EntityStorage* storage, ObjectKind kind, int stencilId);
+
+/**
+ * @brief Removes the entity, the last one takes its index.
+ * @return false if the handle is stale
+ */
+bool destroyEntity(EntityStorage* storage, EntityHandle entity);
+
+bool entityAlive(const EntityStorage& storage, EntityHandle entity);
+//index into the component arrays, -1 if the handle is stale
+int entityIndex(const EntityStorage& storage, EntityHandle entity);
+
+//components of a live entity, NULL for a stale handle
+Object* entityTransform(EntityStorage* storage, EntityHandle entity);
+ObjectAnimation* entityAnimation(EntityStorage* storage, EntityHandle entity);
+
+//transforms of all entities of the kind, in index order
+void gatherEntityTransforms(EntityStorage* storage, ObjectKind kind, std::vector<Object*>* transforms);
+
+#endif
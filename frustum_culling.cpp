@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    frustum_culling.cpp
+ * @date    18/10/2026
+ * @brief   View frustum planes and vectorized bounding sphere tests.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#ifdef __AVX__
+#include <immintrin.h>
+#else
+#include <xmmintrin.h>
+#endif
+#include "data.h"
+#include "frustum_culling.h"
+#if FRUSTUM_CULLING_BENCHMARK
+#include "glm/gtc/matrix_transform.hpp"
+#include "benchmark.h"
+#endif
+
+void extractFrustumPlanes(const glm::mat4& matrix, Frustum* frustum) {
+
+    // rows of the matrix, glm stores columns
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+    frustum->planes[0] = rows[3] + rows[0];    // left
+    frustum->planes[1] = rows[3] - rows[0];    // right
+    frustum->planes[2] = rows[3] + rows[1];    // bottom
+    frustum->planes[3] = rows[3] - rows[1];    // top
+    frustum->planes[4] = rows[3] + rows[2];    // near
+    frustum->planes[5] = rows[3] - rows[2];    // far
+
+    for (int i = 0; i < 6; i++) {
+        float length = glm::length(glm::vec3(frustum->planes[i]));
+        frustum->planes[i] = frustum->planes[i] * (1.0f / length);
+    }
+}
+
+size_t cullSpheresScalar(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+                         const float* radius, size_t count, unsigned char* visible) {
+
+    size_t numVisible = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = (plane.x * centerX[i] + plane.y * centerY[i]) + (plane.z * centerZ[i] + plane.w);
+            inside = distance > -radius[i];
+        }
+        visible[i] = inside ? 1 : 0;
+        numVisible += visible[i];
+    }
+
+    return numVisible;
+}
+
+size_t cullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+                   const float* radius, size_t count, unsigned char* visible) {
+
+    size_t numVisible = 0;
+    size_t i = 0;
+
+#ifdef __AVX__
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++) {
+        planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(centerX + i);
+        __m256 y = _mm256_loadu_ps(centerY + i);
+        __m256 z = _mm256_loadu_ps(centerZ + i);
+        __m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(radius + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; k++) {
+            visible[i + k] = (unsigned char)((mask >> k) & 1);
+            numVisible += visible[i + k];
+        }
+    }
+#else
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++) {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(centerX + i);
+        __m128 y = _mm_loadu_ps(centerY + i);
+        __m128 z = _mm_loadu_ps(centerZ + i);
+        __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; k++) {
+            visible[i + k] = (unsigned char)((mask >> k) & 1);
+            numVisible += visible[i + k];
+        }
+    }
+#endif
+
+    // remaining spheres
+    numVisible += cullSpheresScalar(frustum, centerX + i, centerY + i, centerZ + i, radius + i, count - i, visible + i);
+
+    return numVisible;
+}
+
+#if FRUSTUM_CULLING_BENCHMARK
+void benchmarkFrustumCulling() {
+
+    const size_t count = 1000000;
+
+    std::vector<float> x(count), y(count), z(count), r(count);
+    for (size_t i = 0; i < count; i++) {
+        x[i] = -50.0f + 100.0f * rand() / RAND_MAX;
+        y[i] = -5.0f + 10.0f * rand() / RAND_MAX;
+        z[i] = -50.0f + 100.0f * rand() / RAND_MAX;
+        r[i] = 0.05f + 0.5f * rand() / RAND_MAX;
+    }
+
+    glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 30.0f);
+
+    Frustum frustum;
+    extractFrustumPlanes(projectionMatrix * viewMatrix, &frustum);
+
+    std::vector<unsigned char> scalarVisible(count), simdVisible(count);
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    size_t scalarCount = cullSpheresScalar(frustum, x.data(), y.data(), z.data(), r.data(), count, scalarVisible.data());
+    std::chrono::high_resolution_clock::time_point middle = std::chrono::high_resolution_clock::now();
+    size_t simdCount = cullSpheres(frustum, x.data(), y.data(), z.data(), r.data(), count, simdVisible.data());
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    double scalarTime = std::chrono::duration<double, std::milli>(middle - start).count();
+    double simdTime = std::chrono::duration<double, std::milli>(end - middle).count();
+
+    std::cout << "frustum culling benchmark, " << count << " spheres:" << std::endl;
+    std::cout << "  scalar " << scalarTime << " ms, " << scalarCount << " visible" << std::endl;
+#ifdef __AVX__
+    std::cout << "  AVX    " << simdTime << " ms, " << simdCount << " visible";
+#else
+    std::cout << "  SSE    " << simdTime << " ms, " << simdCount << " visible";
+#endif
+    std::cout << " (" << scalarTime / simdTime << "x, results " << (scalarVisible == simdVisible ? "match" : "DIFFER") << ")" << std::endl;
+}
+#endif
@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    frustum_culling.h
+ * @date    18/10/2026
+ * @brief   View frustum planes and vectorized bounding sphere tests.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __FRUSTUM_CULLING_H
+#define __FRUSTUM_CULLING_H
+
+#include <cstddef>
+#include "glm/glm.hpp"
+
+//Six planes (left, right, bottom, top, near, far) with normals pointing inside, xyz normalized
+typedef struct Frustum {
+  glm::vec4 planes[6];
+} Frustum;
+
+//Result of the last culling pass
+typedef struct CullingStats {
+  unsigned int  tested;
+  unsigned int  visible;
+  unsigned int  culled;
+  double        time;       // milliseconds
+} CullingStats;
+
+//planes of the clip space cube transformed back to world space, matrix = projection * view
+void extractFrustumPlanes(const glm::mat4& matrix, Frustum* frustum);
+
+/**
+ * @brief Tests bounding spheres stored as separate arrays against the frustum.
+ *
+ * Runs 8 spheres per iteration with AVX, 4 with SSE, the rest scalar.
+ * A sphere is visible unless it lies completely behind one of the planes.
+ *
+ * @param visible  one byte per sphere, set to 1 if visible and 0 if culled
+ * @return number of visible spheres
+ */
+size_t cullSpheres(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+                   const float* radius, size_t count, unsigned char* visible);
+
+//same test one sphere at a time, reference for the vectorized version
+size_t cullSpheresScalar(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+                         const float* radius, size_t count, unsigned char* visible);
+
+#endif
@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    geometry_arena.cpp
+ * @date    18/10/2026
+ * @brief   Page buffers and best fit free lists of the geometry arena.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "geometry_arena.h"
+
+//smallest free block of at least size bytes, -1 if there is none
+static int findBestBlock(const std::vector<ArenaBlock>& freeBlocks, size_t size) {
+
+    int best = -1;
+    for (size_t i = 0; i < freeBlocks.size(); i++) {
+        if (freeBlocks[i].size >= size && (best < 0 || freeBlocks[i].size < freeBlocks[best].size))
+            best = (int)i;
+    }
+    return best;
+}
+
+//cuts size bytes from the front of the free block
+static ArenaBlock takeBlock(std::vector<ArenaBlock>* freeBlocks, int index, size_t size) {
+
+    ArenaBlock& freeBlock = (*freeBlocks)[index];
+    ArenaBlock block = { freeBlock.offset, size };
+
+    freeBlock.offset += size;
+    freeBlock.size -= size;
+    if (freeBlock.size == 0)
+        freeBlocks->erase(freeBlocks->begin() + index);
+
+    return block;
+}
+
+//puts the block back in offset order and merges it with free neighbours
+static void returnBlock(std::vector<ArenaBlock>* freeBlocks, const ArenaBlock& block) {
+
+    if (block.size == 0)
+        return;
+
+    std::vector<ArenaBlock>::iterator next = std::lower_bound(freeBlocks->begin(), freeBlocks->end(), block,
+        [](const ArenaBlock& a, const ArenaBlock& b) { return a.offset < b.offset; });
+    std::vector<ArenaBlock>::iterator inserted = freeBlocks->insert(next, block);
+
+    std::vector<ArenaBlock>::iterator following = inserted + 1;
+    if (following != freeBlocks->end() && inserted->offset + inserted->size == following->offset) {
+        inserted->size += following->size;
+        inserted = freeBlocks->erase(following) - 1;
+    }
+    if (inserted != freeBlocks->begin()) {
+        std::vector<ArenaBlock>::iterator previous = inserted - 1;
+        if (previous->offset + previous->size == inserted->offset) {
+            previous->size += inserted->size;
+            freeBlocks->erase(inserted);
+        }
+    }
+}
+
+static ArenaPage* createPage(size_t vertexCapacity, size_t indexCapacity) {
+
+    ArenaPage* page = new ArenaPage;
+    page->vertexCapacity = vertexCapacity;
+    page->indexCapacity = indexCapacity;
+    page->vertexArrayObject = 0;
+
+    // the copy target does not touch the element buffer binding of the bound VAO
+    // glGetError would also report errors left by earlier calls, the size of the store shows if it was allocated
+    GLint vertexBytes = 0, indexBytes = 0;
+    glGenBuffers(1, &page->vertexBufferObject);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->vertexBufferObject);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity, NULL, GL_STATIC_DRAW);
+    glGetBufferParameteriv(GL_COPY_WRITE_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+
+    glGenBuffers(1, &page->elementBufferObject);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->elementBufferObject);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, NULL, GL_STATIC_DRAW);
+    glGetBufferParameteriv(GL_COPY_WRITE_BUFFER, GL_BUFFER_SIZE, &indexBytes);
+
+    if ((size_t)vertexBytes != vertexCapacity || (size_t)indexBytes != indexCapacity) {
+        glDeleteBuffers(1, &page->vertexBufferObject);
+        glDeleteBuffers(1, &page->elementBufferObject);
+        delete page;
+        return NULL;
+    }
+
+    ArenaBlock vertexBlock = { 0, vertexCapacity };
+    ArenaBlock indexBlock = { 0, indexCapacity };
+    page->freeVertices.assign(1, vertexBlock);
+    page->freeIndices.assign(1, indexBlock);
+
+    return page;
+}
+
+void initGeometryArena(GeometryArena* arena, size_t vertexSize) {
+
+    arena->vertexSize = vertexSize;
+    arena->pages.clear();
+}
+
+void deleteGeometryArena(GeometryArena* arena) {
+
+    for (size_t i = 0; i < arena->pages.size(); i++) {
+        ArenaPage* page = arena->pages[i];
+        if (page->vertexArrayObject != 0)
+            glDeleteVertexArrays(1, &page->vertexArrayObject);
+        glDeleteBuffers(1, &page->vertexBufferObject);
+        glDeleteBuffers(1, &page->elementBufferObject);
+        delete page;
+    }
+    arena->pages.clear();
+}
+
+bool allocateArenaMesh(GeometryArena* arena, const void* vertices, size_t numVertices, const void* indices, size_t indexBytes,
+                       ArenaAllocation* allocation) {
+
+    const size_t vertexBytes = numVertices * arena->vertexSize;
+    const size_t indexBlockBytes = (indexBytes + GEOMETRY_ARENA_INDEX_ALIGNMENT - 1) / GEOMETRY_ARENA_INDEX_ALIGNMENT * GEOMETRY_ARENA_INDEX_ALIGNMENT;
+
+    ArenaPage* page = NULL;
+    int vertexBlock = -1;
+    int indexBlock = -1;
+
+    for (size_t i = 0; i < arena->pages.size() && page == NULL; i++) {
+        vertexBlock = findBestBlock(arena->pages[i]->freeVertices, vertexBytes);
+        indexBlock = findBestBlock(arena->pages[i]->freeIndices, indexBlockBytes);
+        if (vertexBlock >= 0 && indexBlock >= 0)
+            page = arena->pages[i];
+    }
+
+    if (page == NULL) {
+        // whole vertices per page, so every vertex offset divides into a base vertex
+        const size_t pageVertices = GEOMETRY_ARENA_PAGE_SIZE / arena->vertexSize * arena->vertexSize;
+        page = createPage(std::max(pageVertices, vertexBytes), std::max((size_t)GEOMETRY_ARENA_PAGE_SIZE, indexBlockBytes));
+        if (page == NULL)
+            return false;
+
+        arena->pages.push_back(page);
+        vertexBlock = 0;
+        indexBlock = 0;
+    }
+
+    allocation->page = page;
+    allocation->vertices = takeBlock(&page->freeVertices, vertexBlock, vertexBytes);
+    allocation->indices = takeBlock(&page->freeIndices, indexBlock, indexBlockBytes);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->vertexBufferObject);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation->vertices.offset, vertexBytes, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->elementBufferObject);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation->indices.offset, indexBytes, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return true;
+}
+
+void freeArenaMesh(ArenaAllocation* allocation) {
+
+    if (allocation->page == NULL)
+        return;
+
+    returnBlock(&allocation->page->freeVertices, allocation->vertices);
+    returnBlock(&allocation->page->freeIndices, allocation->indices);
+    allocation->page = NULL;
+}
+
+GLint arenaBaseVertex(const GeometryArena& arena, const ArenaAllocation& allocation) {
+
+    return (GLint)(allocation.vertices.offset / arena.vertexSize);
+}
+
+void addGeometryArenaStats(const GeometryArena& arena, ArenaStats* stats) {
+
+    for (size_t i = 0; i < arena.pages.size(); i++) {
+        const ArenaPage* page = arena.pages[i];
+        stats->pages++;
+        stats->capacityBytes += page->vertexCapacity + page->indexCapacity;
+        stats->usedBytes += page->vertexCapacity + page->indexCapacity;
+
+        for (int list = 0; list < 2; list++) {
+            const std::vector<ArenaBlock>& freeBlocks = list == 0 ? page->freeVertices : page->freeIndices;
+            for (size_t b = 0; b < freeBlocks.size(); b++) {
+                stats->usedBytes -= freeBlocks[b].size;
+                stats->freeBlocks++;
+                stats->largestFreeBlock = std::max(stats->largestFreeBlock, freeBlocks[b].size);
+            }
+        }
+    }
+}
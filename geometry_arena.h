@@ -0,0 +1,81 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    geometry_arena.h
+ * @date    18/10/2026
+ * @brief   Large shared vertex and index buffers handing out blocks to static meshes, drawn with a base vertex.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __GEOMETRY_ARENA_H
+#define __GEOMETRY_ARENA_H
+
+#include <vector>
+#include "pgr.h"
+
+//bytes of the vertex and of the index buffer of one page, meshes that do not fit get a page of their own size
+#define GEOMETRY_ARENA_PAGE_SIZE    (4 * 1024 * 1024)
+//index blocks start at multiples of this, so both 16 and 32 bit indices can share a buffer
+#define GEOMETRY_ARENA_INDEX_ALIGNMENT  4
+
+//Byte range of a page buffer
+typedef struct ArenaBlock {
+  size_t  offset;
+  size_t  size;
+} ArenaBlock;
+
+//One vertex buffer and one index buffer, all meshes in them are drawn from one VAO
+typedef struct ArenaPage {
+  GLuint                  vertexBufferObject;
+  GLuint                  elementBufferObject;
+  GLuint                  vertexArrayObject;    // 0 until the owner sets up the attributes, deleted with the page
+  size_t                  vertexCapacity;       // bytes
+  size_t                  indexCapacity;
+  std::vector<ArenaBlock> freeVertices;         // sorted by offset, neighbours are merged when a block returns
+  std::vector<ArenaBlock> freeIndices;
+} ArenaPage;
+
+//Pages of one vertex layout, vertex blocks are whole vertices so every offset is a base vertex
+typedef struct GeometryArena {
+  size_t                  vertexSize;
+  std::vector<ArenaPage*> pages;
+} GeometryArena;
+
+//Where a mesh lives, page NULL = nothing allocated
+typedef struct ArenaAllocation {
+  ArenaPage*  page = NULL;
+  ArenaBlock  vertices;
+  ArenaBlock  indices;
+} ArenaAllocation;
+
+typedef struct ArenaStats {
+  size_t  pages;
+  size_t  capacityBytes;        // vertex and index buffers of all pages
+  size_t  usedBytes;            // handed out blocks, index alignment included
+  size_t  freeBlocks;           // more blocks than pages = fragmented free space
+  size_t  largestFreeBlock;
+} ArenaStats;
+
+void initGeometryArena(GeometryArena* arena, size_t vertexSize);
+//deletes the buffers and VAOs of all pages, allocations of the arena must not be used afterwards
+void deleteGeometryArena(GeometryArena* arena);
+
+/**
+ * @brief Copies a mesh into the first page with room for it, a new page is created if none has.
+ *
+ * Blocks are taken best fit from the free lists. The vertex buffer is never bound to GL_ARRAY_BUFFER
+ * or GL_ELEMENT_ARRAY_BUFFER here, so the bound VAO is not changed.
+ *
+ * @param indexBytes  indices are relative to the first vertex of the block (the base vertex)
+ * @return false if the buffers of a new page can not be created
+ */
+bool allocateArenaMesh(GeometryArena* arena, const void* vertices, size_t numVertices, const void* indices, size_t indexBytes,
+                       ArenaAllocation* allocation);
+//returns the blocks to the free lists of their page, the page stays for later meshes
+void freeArenaMesh(ArenaAllocation* allocation);
+
+//vertex index of the first vertex of the allocation
+GLint arenaBaseVertex(const GeometryArena& arena, const ArenaAllocation& allocation);
+//adds the arena to stats
+void addGeometryArenaStats(const GeometryArena& arena, ArenaStats* stats);
+
+#endif
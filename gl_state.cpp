@@ -0,0 +1,250 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    gl_state.cpp
+ * @date    18/10/2026
+ * @brief   Shadow copy of the GL state, calls that would not change anything are skipped.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cstring>
+#include <unordered_map>
+#include "glm/gtc/type_ptr.hpp"
+#include "gl_state.h"
+
+//value no object name or enum can have, the first call always goes through
+#define UNKNOWN_STATE   0xFFFFFFFFu
+
+//tracked texture targets and capabilities, anything else is passed through
+static const GLenum trackedTextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
+static const GLenum trackedCapabilities[] = { GL_BLEND, GL_STENCIL_TEST, GL_DEPTH_TEST, GL_CULL_FACE };
+
+#define NUM_TEXTURE_TARGETS     (sizeof(trackedTextureTargets) / sizeof(trackedTextureTargets[0]))
+#define NUM_CAPABILITIES        (sizeof(trackedCapabilities) / sizeof(trackedCapabilities[0]))
+
+//last value sent to a uniform, up to a mat4
+typedef struct UniformValue {
+  float     data[16];
+  GLsizei   size;           // bytes
+} UniformValue;
+
+static struct GLState {
+  GLuint    program;
+  GLuint    vertexArrayObject;
+  GLuint    activeTextureUnit;
+  GLuint    textures[GL_STATE_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+
+  GLuint    capabilities[NUM_CAPABILITIES];       // 0, 1 or UNKNOWN_STATE
+  GLuint    blendSource;
+  GLuint    blendDestination;
+  GLuint    stencilFunction;
+  GLuint    stencilReference;
+  GLuint    stencilFunctionMask;
+  GLuint    stencilFail;
+  GLuint    stencilDepthFail;
+  GLuint    stencilDepthPass;
+  GLuint    stencilMask;
+
+  //key is program << 32 | location
+  std::unordered_map<unsigned long long, UniformValue> uniforms;
+} state;
+
+static GLStateStats stats;
+
+void invalidateGLBindings() {
+
+    state.program = UNKNOWN_STATE;
+    state.vertexArrayObject = UNKNOWN_STATE;
+    state.activeTextureUnit = UNKNOWN_STATE;
+    for (int unit = 0; unit < GL_STATE_TEXTURE_UNITS; unit++) {
+        for (size_t target = 0; target < NUM_TEXTURE_TARGETS; target++)
+            state.textures[unit][target] = UNKNOWN_STATE;
+    }
+}
+
+void resetGLState() {
+
+    invalidateGLBindings();
+
+    for (size_t i = 0; i < NUM_CAPABILITIES; i++)
+        state.capabilities[i] = UNKNOWN_STATE;
+
+    state.blendSource = state.blendDestination = UNKNOWN_STATE;
+    state.stencilFunction = state.stencilReference = state.stencilFunctionMask = UNKNOWN_STATE;
+    state.stencilFail = state.stencilDepthFail = state.stencilDepthPass = UNKNOWN_STATE;
+    state.stencilMask = UNKNOWN_STATE;
+
+    state.uniforms.clear();
+}
+
+void resetGLStateStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+const GLStateStats& getGLStateStats() {
+    return stats;
+}
+
+//true if the call has to be issued, updates the shadow value and the counter
+static bool changeState(GLuint* current, GLuint value, GLStateCounter* counter) {
+
+    if (*current == value) {
+        counter->skipped++;
+        return false;
+    }
+    *current = value;
+    counter->issued++;
+    return true;
+}
+
+void bindProgram(GLuint program) {
+
+    if (changeState(&state.program, program, &stats.programs))
+        glUseProgram(program);
+}
+
+void bindVertexArray(GLuint vertexArrayObject) {
+
+    if (changeState(&state.vertexArrayObject, vertexArrayObject, &stats.vertexArrays))
+        glBindVertexArray(vertexArrayObject);
+}
+
+void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+
+    size_t targetIndex = 0;
+    while (targetIndex < NUM_TEXTURE_TARGETS && trackedTextureTargets[targetIndex] != target)
+        targetIndex++;
+
+    if (unit < GL_STATE_TEXTURE_UNITS && targetIndex < NUM_TEXTURE_TARGETS) {
+        if (state.textures[unit][targetIndex] == texture) {
+            stats.textures.skipped++;
+            return;
+        }
+        state.textures[unit][targetIndex] = texture;
+    }
+
+    if (state.activeTextureUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        state.activeTextureUnit = unit;
+        stats.textures.issued++;
+    }
+
+    glBindTexture(target, texture);
+    stats.textures.issued++;
+}
+
+void setCapability(GLenum capability, bool enabled) {
+
+    size_t index = 0;
+    while (index < NUM_CAPABILITIES && trackedCapabilities[index] != capability)
+        index++;
+
+    if (index < NUM_CAPABILITIES && !changeState(&state.capabilities[index], enabled ? 1 : 0, &stats.renderStates))
+        return;
+    if (index == NUM_CAPABILITIES)
+        stats.renderStates.issued++;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void setBlendFunc(GLenum source, GLenum destination) {
+
+    if (state.blendSource == source && state.blendDestination == destination) {
+        stats.renderStates.skipped++;
+        return;
+    }
+    state.blendSource = source;
+    state.blendDestination = destination;
+    stats.renderStates.issued++;
+
+    glBlendFunc(source, destination);
+}
+
+void setStencilFunc(GLenum function, GLint reference, GLuint mask) {
+
+    if (state.stencilFunction == function && state.stencilReference == (GLuint)reference && state.stencilFunctionMask == mask) {
+        stats.renderStates.skipped++;
+        return;
+    }
+    state.stencilFunction = function;
+    state.stencilReference = (GLuint)reference;
+    state.stencilFunctionMask = mask;
+    stats.renderStates.issued++;
+
+    glStencilFunc(function, reference, mask);
+}
+
+void setStencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass) {
+
+    if (state.stencilFail == stencilFail && state.stencilDepthFail == depthFail && state.stencilDepthPass == depthPass) {
+        stats.renderStates.skipped++;
+        return;
+    }
+    state.stencilFail = stencilFail;
+    state.stencilDepthFail = depthFail;
+    state.stencilDepthPass = depthPass;
+    stats.renderStates.issued++;
+
+    glStencilOp(stencilFail, depthFail, depthPass);
+}
+
+void setStencilMask(GLuint mask) {
+
+    if (changeState(&state.stencilMask, mask, &stats.renderStates))
+        glStencilMask(mask);
+}
+
+//true if the uniform of the bound program has to be sent, -1 locations are never sent
+static bool changeUniform(GLint location, const void* data, GLsizei size) {
+
+    if (location < 0 || state.program == UNKNOWN_STATE) {
+        if (location < 0)
+            stats.uniforms.skipped++;
+        else
+            stats.uniforms.issued++;
+        return location >= 0;
+    }
+
+    UniformValue& value = state.uniforms[((unsigned long long)state.program << 32) | (unsigned int)location];
+    if (value.size == size && memcmp(value.data, data, size) == 0) {
+        stats.uniforms.skipped++;
+        return false;
+    }
+
+    memcpy(value.data, data, size);
+    value.size = size;
+    stats.uniforms.issued++;
+    return true;
+}
+
+void setUniformInt(GLint location, int value) {
+
+    if (changeUniform(location, &value, sizeof(value)))
+        glUniform1i(location, value);
+}
+
+void setUniformFloat(GLint location, float value) {
+
+    if (changeUniform(location, &value, sizeof(value)))
+        glUniform1f(location, value);
+}
+
+void setUniformVec3(GLint location, const glm::vec3& value) {
+
+    if (changeUniform(location, glm::value_ptr(value), sizeof(value)))
+        glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void setUniformVec4(GLint location, const glm::vec4& value) {
+
+    if (changeUniform(location, glm::value_ptr(value), sizeof(value)))
+        glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void setUniformMat4(GLint location, const glm::mat4& value) {
+
+    if (changeUniform(location, glm::value_ptr(value), sizeof(value)))
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,58 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    gl_state.h
+ * @date    18/10/2026
+ * @brief   Shadow copy of the GL state, calls that would not change anything are skipped.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __GL_STATE_H
+#define __GL_STATE_H
+
+#include "pgr.h"
+
+//texture units tracked by bindTexture, higher units are always bound
+#define GL_STATE_TEXTURE_UNITS  8
+
+//Calls passed to the driver and calls dropped because the state was already set
+typedef struct GLStateCounter {
+  unsigned int  issued;
+  unsigned int  skipped;
+} GLStateCounter;
+
+typedef struct GLStateStats {
+  GLStateCounter  programs;
+  GLStateCounter  vertexArrays;
+  GLStateCounter  textures;         // active unit changes are counted with the binds
+  GLStateCounter  renderStates;     // enable/disable, blending and stencil
+  GLStateCounter  uniforms;
+} GLStateStats;
+
+//forgets everything, call after the state was changed by direct GL calls or programs were deleted
+void resetGLState();
+//forgets bound program, VAO and textures but keeps render states and uniforms, loading code binds objects directly
+void invalidateGLBindings();
+
+void resetGLStateStats();
+const GLStateStats& getGLStateStats();
+
+void bindProgram(GLuint program);
+void bindVertexArray(GLuint vertexArrayObject);
+//switches the active unit only if the binding changes, GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP and GL_TEXTURE_2D_ARRAY are tracked
+void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+//GL_BLEND, GL_STENCIL_TEST, GL_DEPTH_TEST and GL_CULL_FACE are tracked
+void setCapability(GLenum capability, bool enabled);
+void setBlendFunc(GLenum source, GLenum destination);
+void setStencilFunc(GLenum function, GLint reference, GLuint mask);
+void setStencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+void setStencilMask(GLuint mask);
+
+//uniforms of the bound program, remembered per program and location (values stay in the program when it is unbound)
+void setUniformInt(GLint location, int value);
+void setUniformFloat(GLint location, float value);
+void setUniformVec3(GLint location, const glm::vec3& value);
+void setUniformVec4(GLint location, const glm::vec4& value);
+void setUniformMat4(GLint location, const glm::mat4& value);
+
+#endif
@@ -0,0 +1,426 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    gpu_culling.cpp
+ * @date    18/10/2026
+ * @brief   Object and draw records, the culling dispatch and the multi draw indirect submission.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <algorithm>
+#include "pgr.h"
+#include "gpu_culling.h"
+#include "gl_state.h"
+#include "texture_array.h"
+
+//compute program of gpuCulling.comp, 0 = GPU driven drawing is not available
+static GLuint cullingProgram = 0;
+
+static GLint numDrawsLocation = -1;
+static GLint frustumPlanesLocation = -1;
+static GLint cullingVmatrixLocation = -1;
+static GLint lodPixelsPerUnitLocation = -1;
+static GLint lodPixelErrorLocation = -1;
+static GLint lodHysteresisLocation = -1;
+
+bool gpuCullingSupported() {
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 3))
+        return false;
+
+    // storage buffers are optional in the vertex stage even in 4.3, the lit shader reads two
+    GLint vertexStorageBlocks = 0;
+    glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &vertexStorageBlocks);
+    return vertexStorageBlocks >= 2;
+}
+
+bool initGpuCulling(const std::string& computeSource) {
+
+    if (!gpuCullingSupported()) {
+        std::cerr << "initGpuCulling(): OpenGL 4.3 with vertex shader storage buffers is not available, drawing stays on the render queue" << std::endl;
+        return false;
+    }
+
+    std::vector<GLuint> shaderList;
+    GLuint computeShader = pgr::createShaderFromSource(GL_COMPUTE_SHADER, computeSource);
+    if (computeShader == 0) {
+        std::cerr << "initGpuCulling(): gpuCulling.comp failed to compile, drawing stays on the render queue" << std::endl;
+        return false;
+    }
+    shaderList.push_back(computeShader);
+
+    cullingProgram = pgr::createProgram(shaderList);
+    if (cullingProgram == 0) {
+        std::cerr << "initGpuCulling(): gpuCulling.comp failed to link, drawing stays on the render queue" << std::endl;
+        return false;
+    }
+
+    numDrawsLocation = glGetUniformLocation(cullingProgram, "numDraws");
+    frustumPlanesLocation = glGetUniformLocation(cullingProgram, "frustumPlanes");
+    cullingVmatrixLocation = glGetUniformLocation(cullingProgram, "Vmatrix");
+    lodPixelsPerUnitLocation = glGetUniformLocation(cullingProgram, "lodPixelsPerUnit");
+    lodPixelErrorLocation = glGetUniformLocation(cullingProgram, "lodPixelError");
+    lodHysteresisLocation = glGetUniformLocation(cullingProgram, "lodHysteresis");
+
+    return true;
+}
+
+void cleanupGpuCulling() {
+
+    if (cullingProgram != 0)
+        pgr::deleteProgramAndShaders(cullingProgram);
+    cullingProgram = 0;
+}
+
+bool gpuCullingReady() {
+
+    return cullingProgram != 0;
+}
+
+//one draw record per material part of the geometry, levels are given in indices from the start of the element buffer
+static void addGeometryDraws(GpuScene* scene, uint32_t object, const MeshGeometry* geometry, int stencilId) {
+
+    const size_t indexSize = geometry->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    const uint32_t meshFirstIndex = (uint32_t)(geometry->indexByteOffset / indexSize);
+
+    for (size_t p = 0; p < geometry->parts.size(); p++) {
+        const MeshPart& part = geometry->parts[p];
+
+        GpuDraw draw = {};
+        draw.object = object;
+        draw.level = 0;
+        draw.numLods = std::max(geometry->numLods, 1u);
+        draw.baseVertex = geometry->baseVertex;
+
+        for (unsigned int level = 0; level < draw.numLods; level++) {
+            draw.firstIndex[level] = meshFirstIndex + part.ranges[level].firstIndex;
+            draw.count[level] = part.ranges[level].numIndices;
+            draw.lodError[level] = geometry->lods[level].error;
+        }
+
+        draw.ambient = glm::vec4(part.ambient, part.shininess);
+        draw.diffuse = glm::vec4(part.diffuse, part.texture == 0 ? 0.0f : (part.textureLayer >= 0 ? 2.0f + part.textureLayer : 1.0f));
+        draw.specular = glm::vec4(part.specular, 0.0f);
+        draw.positionScale = glm::vec4(geometry->positionScale, geometry->vertexFormat == VERTEX_FORMAT_COMPACT ? 1.0f : 0.0f);
+        draw.positionOffset = glm::vec4(geometry->positionOffset, geometry->boundingSphere.w);
+        draw.texCoordTransform = geometry->texCoordTransform;
+
+        GpuDrawSource source = { geometry, part.texture, part.textureLayer >= 0, stencilId };
+        scene->draws.push_back(draw);
+        scene->sources.push_back(source);
+    }
+}
+
+static void writeObjectRecord(GpuObject* record, const glm::mat4& modelMatrix, const glm::mat4& normalMatrix, const glm::vec4& modelSphere) {
+
+    record->modelMatrix = modelMatrix;
+    record->normalMatrix = normalMatrix;
+    record->sphere = transformBoundingSphere(modelSphere, modelMatrix);
+}
+
+static uint32_t addObjectRecord(GpuScene* scene, const glm::mat4& modelMatrix, const glm::mat4& normalMatrix, const glm::vec4& modelSphere) {
+
+    GpuObject record;
+    writeObjectRecord(&record, modelMatrix, normalMatrix, modelSphere);
+    scene->objects.push_back(record);
+
+    return (uint32_t)(scene->objects.size() - 1);
+}
+
+//records [first, end) from the CPU copy into the object buffer
+static void uploadObjectRecords(GpuScene* scene, size_t first, size_t end) {
+
+    if (first >= end)
+        return;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, scene->objectBufferObject);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(GpuObject), (end - first) * sizeof(GpuObject), &scene->objects[first]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    scene->stats.uploadedObjects += (unsigned int)(end - first);
+}
+
+void addGpuObject(GpuScene* scene, ObjectKind kind, Object* object, const MeshGeometry* geometry, int stencilId) {
+
+    if (geometry == NULL || geometry->parts.empty())
+        return;
+
+    // the view matrix only matters for the fire billboard, which is never GPU driven
+    updateObjectTransform(kind, object, glm::mat4(1.0f));
+
+    uint32_t record = addObjectRecord(scene, object->modelMatrix, object->normalMatrix, geometry->boundingSphere);
+    scene->sceneObjects.push_back(object);
+    scene->sceneKinds.push_back(kind);
+    scene->sceneSpheres.push_back(geometry->boundingSphere);
+    scene->sceneRecords.push_back(record);
+
+    addGeometryDraws(scene, record, geometry, stencilId);
+}
+
+void addGpuInstances(GpuScene* scene, const InstanceBatch* batch, int stencilId) {
+
+    if (batch == NULL || batch->geometry->parts.empty())
+        return;
+
+    for (unsigned int i = 0; i < batch->numInstances; i++) {
+        uint32_t record = addObjectRecord(scene, batch->instanceData[2 * i], batch->instanceData[2 * i + 1], batch->geometry->boundingSphere);
+        addGeometryDraws(scene, record, batch->geometry, stencilId);
+    }
+}
+
+void moveGpuObjects(GpuScene* scene, const Object* oldObjects, Object* newObjects, size_t count) {
+
+    // the old memory may be gone already, the pointers are only used as addresses
+    const uintptr_t oldStart = (uintptr_t)oldObjects;
+    const uintptr_t newStart = (uintptr_t)newObjects;
+
+    for (size_t i = 0; i < scene->sceneObjects.size(); i++)
+        scene->sceneObjects[i] = (Object*)(newStart + ((uintptr_t)scene->sceneObjects[i] - oldStart));
+
+    if (scene->objectBufferObject == 0)
+        return;
+
+    // the copies may hold other matrices than the records, the whole single object range is sent again
+    for (size_t i = 0; i < scene->sceneObjects.size(); i++) {
+        const Object* object = scene->sceneObjects[i];
+        writeObjectRecord(&scene->objects[scene->firstSceneRecord + i], object->modelMatrix, object->normalMatrix, scene->sceneSpheres[i]);
+    }
+    uploadObjectRecords(scene, scene->firstSceneRecord, scene->objects.size());
+}
+
+void buildGpuScene(GpuScene* scene, const SCommonShaderProgram& program) {
+
+    scene->groups.clear();
+    if (scene->draws.empty() || program.drawIndexLocation < 0)
+        return;
+
+    // draws of one group end up next to each other, one multi draw covers the whole range
+    std::vector<size_t> order(scene->draws.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    const std::vector<GpuDrawSource>& sources = scene->sources;
+    std::stable_sort(order.begin(), order.end(), [&sources](size_t a, size_t b) {
+        const GpuDrawSource& first = sources[a];
+        const GpuDrawSource& second = sources[b];
+        if (first.geometry->vertexBufferObject != second.geometry->vertexBufferObject)
+            return first.geometry->vertexBufferObject < second.geometry->vertexBufferObject;
+        if (first.geometry->indexType != second.geometry->indexType)
+            return first.geometry->indexType < second.geometry->indexType;
+        if (first.texture != second.texture)
+            return first.texture < second.texture;
+        return first.stencilId < second.stencilId;
+    });
+
+    std::vector<GpuDraw> sortedDraws(order.size());
+    std::vector<GpuDrawSource> sortedSources(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sortedDraws[i] = scene->draws[order[i]];
+        sortedSources[i] = sources[order[i]];
+    }
+    scene->draws.swap(sortedDraws);
+    scene->sources.swap(sortedSources);
+
+    // batch instance records first, then the single objects in one range - only that range is uploaded again
+    std::vector<bool> single(scene->objects.size(), false);
+    for (size_t i = 0; i < scene->sceneRecords.size(); i++)
+        single[scene->sceneRecords[i]] = true;
+
+    std::vector<uint32_t> newRecord(scene->objects.size());
+    std::vector<GpuObject> sortedObjects;
+    sortedObjects.reserve(scene->objects.size());
+    for (size_t i = 0; i < scene->objects.size(); i++) {
+        if (!single[i]) {
+            newRecord[i] = (uint32_t)sortedObjects.size();
+            sortedObjects.push_back(scene->objects[i]);
+        }
+    }
+    scene->firstSceneRecord = sortedObjects.size();
+    for (size_t i = 0; i < scene->sceneRecords.size(); i++) {
+        newRecord[scene->sceneRecords[i]] = (uint32_t)sortedObjects.size();
+        sortedObjects.push_back(scene->objects[scene->sceneRecords[i]]);
+    }
+    for (size_t i = 0; i < scene->draws.size(); i++)
+        scene->draws[i].object = newRecord[scene->draws[i].object];
+    scene->objects.swap(sortedObjects);
+    scene->sceneRecords.clear();
+
+    // base instance i reads element i, so the draw index is just a counting sequence
+    std::vector<uint32_t> drawIndices(scene->draws.size());
+    for (size_t i = 0; i < drawIndices.size(); i++)
+        drawIndices[i] = (uint32_t)i;
+
+    glGenBuffers(1, &scene->drawIndexBufferObject);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->drawIndexBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(uint32_t), drawIndices.data(), GL_STATIC_DRAW);
+
+    // one VAO per vertex buffer with the draw index attribute added to the mesh attributes
+    GLuint currentBuffer = 0;
+    GLuint currentVertexArray = 0;
+
+    for (size_t i = 0; i < scene->sources.size(); i++) {
+        const GpuDrawSource& source = scene->sources[i];
+
+        if (i == 0 || source.geometry->vertexBufferObject != currentBuffer) {
+            currentBuffer = source.geometry->vertexBufferObject;
+
+            glGenVertexArrays(1, &currentVertexArray);
+            bindVertexArray(currentVertexArray);
+            scene->vertexArrays.push_back(currentVertexArray);
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, source.geometry->elementBufferObject);
+            glBindBuffer(GL_ARRAY_BUFFER, source.geometry->vertexBufferObject);
+            setMeshAttributes(source.geometry, program);
+
+            glBindBuffer(GL_ARRAY_BUFFER, scene->drawIndexBufferObject);
+            glEnableVertexAttribArray(program.drawIndexLocation);
+            glVertexAttribIPointer(program.drawIndexLocation, 1, GL_UNSIGNED_INT, 0, 0);
+            glVertexAttribDivisor(program.drawIndexLocation, 1);
+        }
+
+        if (scene->groups.empty() || scene->groups.back().vertexArrayObject != currentVertexArray
+                || scene->groups.back().indexType != source.geometry->indexType
+                || scene->groups.back().texture != source.texture || scene->groups.back().stencilId != source.stencilId) {
+            GpuDrawGroup group = { currentVertexArray, source.geometry->indexType, source.texture, source.textureArray, source.stencilId, (unsigned int)i, 0 };
+            scene->groups.push_back(group);
+        }
+        scene->groups.back().numDraws++;
+    }
+    bindVertexArray(0);
+
+    glGenBuffers(1, &scene->objectBufferObject);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, scene->objectBufferObject);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, scene->objects.size() * sizeof(GpuObject), scene->objects.data(), GL_DYNAMIC_DRAW);
+
+    // levels are written back by the culling shader, the CPU copy only holds the initial state
+    glGenBuffers(1, &scene->drawBufferObject);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, scene->drawBufferObject);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, scene->draws.size() * sizeof(GpuDraw), scene->draws.data(), GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &scene->commandBufferObject);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, scene->commandBufferObject);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, scene->draws.size() * sizeof(GpuDrawCommand), NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    scene->stats.objects = (unsigned int)scene->objects.size();
+    scene->stats.uploadedObjects = (unsigned int)scene->objects.size();
+    scene->stats.draws = (unsigned int)scene->draws.size();
+    scene->stats.multiDrawCalls = 0;
+
+    CHECK_GL_ERROR();
+}
+
+void deleteGpuScene(GpuScene* scene) {
+
+    if (!scene->vertexArrays.empty())
+        glDeleteVertexArrays((GLsizei)scene->vertexArrays.size(), scene->vertexArrays.data());
+
+    GLuint buffers[] = { scene->objectBufferObject, scene->drawBufferObject, scene->commandBufferObject, scene->drawIndexBufferObject };
+    glDeleteBuffers(4, buffers);
+    invalidateGLBindings();
+
+    scene->objects.clear();
+    scene->draws.clear();
+    scene->groups.clear();
+    scene->sceneObjects.clear();
+    scene->sceneKinds.clear();
+    scene->sceneSpheres.clear();
+    scene->sceneRecords.clear();
+    scene->firstSceneRecord = 0;
+    scene->sources.clear();
+    scene->vertexArrays.clear();
+
+    scene->objectBufferObject = 0;
+    scene->drawBufferObject = 0;
+    scene->commandBufferObject = 0;
+    scene->drawIndexBufferObject = 0;
+    scene->stats = GpuSceneStats();
+}
+
+void drawGpuScene(GpuScene* scene, const SCommonShaderProgram& program, const Frustum& frustum,
+                  const glm::mat4& viewMatrix, const glm::mat4& PVmatrix, float lodPixelsPerUnit) {
+
+    scene->stats.multiDrawCalls = 0;
+    scene->stats.uploadedObjects = 0;
+    if (cullingProgram == 0 || scene->groups.empty())
+        return;
+
+    // the BVH refit or the render queue may have refreshed a transform already and cleared its dirty flag,
+    // so the matrices are compared with the records - only the span from the first to the last change is sent
+    size_t firstChanged = scene->objects.size();
+    size_t endChanged = 0;
+    for (size_t i = 0; i < scene->sceneObjects.size(); i++) {
+        Object* object = scene->sceneObjects[i];
+        updateObjectTransform(scene->sceneKinds[i], object, viewMatrix);
+
+        const size_t r = scene->firstSceneRecord + i;
+        if (scene->objects[r].modelMatrix == object->modelMatrix)
+            continue;
+
+        writeObjectRecord(&scene->objects[r], object->modelMatrix, object->normalMatrix, scene->sceneSpheres[i]);
+        firstChanged = std::min(firstChanged, r);
+        endChanged = r + 1;
+    }
+    uploadObjectRecords(scene, firstChanged, endChanged);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, scene->objectBufferObject);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scene->drawBufferObject);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, scene->commandBufferObject);
+
+    // culling and level selection, one invocation per draw
+    bindProgram(cullingProgram);
+    setUniformInt(numDrawsLocation, (int)scene->draws.size());
+    glUniform4fv(frustumPlanesLocation, 6, glm::value_ptr(frustum.planes[0]));
+    setUniformMat4(cullingVmatrixLocation, viewMatrix);
+    setUniformFloat(lodPixelsPerUnitLocation, lodPixelsPerUnit);
+    setUniformFloat(lodPixelErrorLocation, LOD_PIXEL_ERROR);
+    setUniformFloat(lodHysteresisLocation, LOD_HYSTERESIS);
+
+    glDispatchCompute((GLuint)((scene->draws.size() + GPU_CULLING_GROUP_SIZE - 1) / GPU_CULLING_GROUP_SIZE), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    bindProgram(program.program);
+    setUniformMat4(program.PVmatrixLocation, PVmatrix);
+    setUniformMat4(program.VmatrixLocation, viewMatrix);
+    setUniformInt(program.texSamplerLocation, 0);
+    setUniformInt(program.texArraySamplerLocation, TEXTURE_ARRAY_UNIT);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene->commandBufferObject);
+
+    setCapability(GL_BLEND, false);
+    setCapability(GL_STENCIL_TEST, true);
+    setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+    for (size_t g = 0; g < scene->groups.size(); g++) {
+        const GpuDrawGroup& group = scene->groups[g];
+
+        if (group.stencilId == 0) {
+            setStencilMask(0x00);
+        }
+        else {
+            setStencilMask(0xFF);
+            setStencilFunc(GL_ALWAYS, group.stencilId, 0xFF);
+        }
+
+        bindVertexArray(group.vertexArrayObject);
+        if (group.texture != 0 && group.textureArray)
+            bindTexture(TEXTURE_ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, group.texture);
+        else if (group.texture != 0)
+            bindTexture(0, GL_TEXTURE_2D, group.texture);
+        setUniformInt(program.useTextureLocation, group.texture != 0 ? 1 : 0);
+
+        // culled draws have no instances, the group range never changes
+        glMultiDrawElementsIndirect(GL_TRIANGLES, group.indexType, (const void*)(group.firstDraw * sizeof(GpuDrawCommand)),
+                                    group.numDraws, 0);
+        scene->stats.multiDrawCalls++;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    setStencilMask(0xFF);
+    setCapability(GL_STENCIL_TEST, false);
+
+    CHECK_GL_ERROR();
+}
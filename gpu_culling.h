@@ -0,0 +1,133 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    gpu_culling.h
+ * @date    18/10/2026
+ * @brief   GPU driven drawing of lit opaque objects - compute shader culling and multi draw indirect.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __GPU_CULLING_H
+#define __GPU_CULLING_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "render_stuff.h"
+#include "frustum_culling.h"
+
+//local size of gpuCulling.comp
+#define GPU_CULLING_GROUP_SIZE  64
+
+//Per object record in the Objects storage buffer, std430 layout of ObjectRecord in the shaders
+typedef struct GpuObject {
+  glm::mat4   modelMatrix;
+  glm::mat4   normalMatrix;
+  glm::vec4   sphere;                       // world space bounding sphere
+} GpuObject;
+
+//Per draw record in the Draws storage buffer, one per object and material part, DrawRecord in the shaders
+typedef struct GpuDraw {
+  uint32_t    object;
+  uint32_t    level;                        // written by the culling shader
+  uint32_t    numLods;
+  int32_t     baseVertex;
+  uint32_t    firstIndex[MESH_MAX_LODS];    // of the part range in every level, in indices from the buffer start
+  uint32_t    count[MESH_MAX_LODS];
+  float       lodError[MESH_MAX_LODS];
+  glm::vec4   ambient;                      // w = shininess
+  glm::vec4   diffuse;                      // w = 0 untextured, 1 GL_TEXTURE_2D, 2 + layer of a texture array
+  glm::vec4   specular;
+  glm::vec4   positionScale;                // w = 1 for octahedral normals
+  glm::vec4   positionOffset;               // w = model space bounding sphere radius
+  glm::vec4   texCoordTransform;
+} GpuDraw;
+
+//DrawElementsIndirectCommand, written by the culling shader
+typedef struct GpuDrawCommand {
+  uint32_t    count;
+  uint32_t    instanceCount;
+  uint32_t    firstIndex;
+  int32_t     baseVertex;
+  uint32_t    baseInstance;                 // = draw index, picks the record in the vertex shader
+} GpuDrawCommand;
+
+static_assert(sizeof(GpuObject) == 144, "GpuObject must match the std430 ObjectRecord");
+static_assert(sizeof(GpuDraw) == 160, "GpuDraw must match the std430 DrawRecord");
+static_assert(sizeof(GpuDrawCommand) == 20, "GpuDrawCommand must match DrawElementsIndirectCommand");
+
+//Draws that need the same VAO, index type, texture and stencil id, submitted with one glMultiDrawElementsIndirect
+typedef struct GpuDrawGroup {
+  GLuint        vertexArrayObject;
+  GLenum        indexType;
+  GLuint        texture;
+  bool          textureArray;               // texture is a GL_TEXTURE_2D_ARRAY, the draws carry their layers
+  int           stencilId;
+  unsigned int  firstDraw;
+  unsigned int  numDraws;
+} GpuDrawGroup;
+
+typedef struct GpuSceneStats {
+  unsigned int  objects;
+  unsigned int  uploadedObjects;                // records sent to the object buffer in the last frame
+  unsigned int  draws;
+  unsigned int  multiDrawCalls;
+} GpuSceneStats;
+
+//Where a draw comes from, kept until buildGpuScene sorts the draws into groups
+typedef struct GpuDrawSource {
+  const MeshGeometry* geometry;
+  GLuint              texture;
+  bool                textureArray;
+  int                 stencilId;
+} GpuDrawSource;
+
+//Lit opaque objects of the scene, filled by addGpuObject/addGpuInstances and uploaded by buildGpuScene
+typedef struct GpuScene {
+  std::vector<GpuObject>        objects;
+  std::vector<GpuDraw>          draws;          // sorted by group after buildGpuScene
+  std::vector<GpuDrawGroup>     groups;
+
+  //single objects, batch instances never move - their records are uploaded once by buildGpuScene
+  std::vector<Object*>          sceneObjects;
+  std::vector<ObjectKind>       sceneKinds;
+  std::vector<glm::vec4>        sceneSpheres;   // model space bounding spheres
+  std::vector<uint32_t>         sceneRecords;   // record of each single object until buildGpuScene moves them together
+  size_t                        firstSceneRecord = 0;   // records of sceneObjects from here on, in the same order
+
+  std::vector<GpuDrawSource>    sources;        // parallel to draws
+  std::vector<GLuint>           vertexArrays;   // one per geometry buffer, with the draw index attribute
+
+  GLuint        objectBufferObject = 0;
+  GLuint        drawBufferObject = 0;
+  GLuint        commandBufferObject = 0;
+  GLuint        drawIndexBufferObject = 0;      // 0, 1, 2, ... read as an instanced attribute
+
+  GpuSceneStats stats;
+} GpuScene;
+
+//true if the context has compute shaders, storage buffers in vertex shaders and multi draw indirect (GL 4.3)
+bool gpuCullingSupported();
+//builds the culling program, false if unsupported or the shader fails - the CPU render queue stays in use then
+bool initGpuCulling(const std::string& computeSource);
+void cleanupGpuCulling();
+bool gpuCullingReady();
+
+//one draw per material part, the object transform is refreshed every frame if it is dirty
+void addGpuObject(GpuScene* scene, ObjectKind kind, Object* object, const MeshGeometry* geometry, int stencilId);
+//every instance of the batch becomes an object, the batch matrices must not change
+void addGpuInstances(GpuScene* scene, const InstanceBatch* batch, int stencilId);
+//the single objects were copied from oldObjects to newObjects (count of them), their records are rewritten and uploaded - buffers and batch instances stay
+void moveGpuObjects(GpuScene* scene, const Object* oldObjects, Object* newObjects, size_t count);
+//sorts the draws into groups, puts the single object records after the instances and creates the buffers, program is the INDIRECT variant of the lit program
+void buildGpuScene(GpuScene* scene, const SCommonShaderProgram& program);
+void deleteGpuScene(GpuScene* scene);
+
+/**
+ * @brief Uploads the records of single objects that moved, culls and picks levels on the GPU and draws every group with one call.
+ *
+ * @param lodPixelsPerUnit  see setLodProjection, 0 = full meshes only
+ */
+void drawGpuScene(GpuScene* scene, const SCommonShaderProgram& program, const Frustum& frustum,
+                  const glm::mat4& viewMatrix, const glm::mat4& PVmatrix, float lodPixelsPerUnit);
+
+#endif
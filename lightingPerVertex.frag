@@ -10,27 +10,49 @@ struct Material {
 };
 
 uniform sampler2D texSampler;
+uniform sampler2DArray texArraySampler;     // props packed by texture_array.h
+
+//per frame lighting computed on the CPU, the same block is in all programs using it (LightingBlock in lighting_buffer.h)
+struct Light {
+    vec4  ambient;
+    vec4  diffuse;
+    vec4  specular;
+    vec4  position;         // view space, w = 0 for directional lights
+    vec4  spotDirection;    // view space
+    vec4  parameters;       // x = spot cos cut off, y = spot exponent, z = intensity (0 = off)
+};
+
+layout(std140) uniform Lighting {
+    Light sun;              // directional light moving on sky during daytime
+    Light torch;            // flashlight moving with camera
+    Light lamp;             // point light as a lamp on castle
+    vec4  globalAmbient;
+    vec4  fogColour;        // rgb, a = 1 if fog is on
+    vec4  dayTime;          // x = 0 at day .. 1 at night
+};
 
 uniform Material material;
 
 smooth in vec4 color_v;
 smooth in vec2 texCoord_v;
+flat in float textureLayer_v;               // >= 0 samples this layer of texArraySampler
 out vec4       color_f;
 
 in float visibility;        //fog factor
-uniform vec3 fogColour;     //for colour
-uniform bool fogOn;         //is fog showing
 
 void main() {
 
     color_f = color_v;
 
     if(material.useTexture){
-        color_f =  color_v * texture(texSampler, texCoord_v);
+        if(textureLayer_v >= 0.0)
+            color_f =  color_v * texture(texArraySampler, vec3(texCoord_v, textureLayer_v));
+        else
+            color_f =  color_v * texture(texSampler, texCoord_v);
     }
 
-    if(fogOn){
-         color_f = mix(vec4(fogColour, 1.0f), color_f, visibility);  //mix colour with fog according to visibility
+    if(fogColour.a > 0.0){
+         color_f = mix(vec4(fogColour.rgb, 1.0f), color_f, visibility);  //mix colour with fog according to visibility
     }
 
 }
@@ -11,21 +11,75 @@ struct Material {
 
 uniform sampler2D texSampler;
 
+//per frame lighting computed on the CPU, the same block is in all programs using it (LightingBlock in lighting_buffer.h)
 struct Light {
-    vec3  ambient;
-    vec3  diffuse;
-    vec3  specular;
-    vec3  position;
-    vec3  spotDirection;
-    float spotCosCutOff;
-    float spotExponent;
+    vec4  ambient;
+    vec4  diffuse;
+    vec4  specular;
+    vec4  position;         // view space, w = 0 for directional lights
+    vec4  spotDirection;    // view space
+    vec4  parameters;       // x = spot cos cut off, y = spot exponent, z = intensity (0 = off)
+};
+
+layout(std140) uniform Lighting {
+    Light sun;              // directional light moving on sky during daytime
+    Light torch;            // flashlight moving with camera
+    Light lamp;             // point light as a lamp on castle
+    vec4  globalAmbient;
+    vec4  fogColour;        // rgb, a = 1 if fog is on
+    vec4  dayTime;          // x = 0 at day .. 1 at night
 };
 
 in vec3 position;
 in vec3 normal;
 in vec2 texCoord;
 
-uniform float time;
+#ifdef INSTANCED
+//per instance attributes, the variant is compiled with INSTANCED defined
+in mat4 instanceModelMatrix;
+in mat4 instanceNormalMatrix;
+
+uniform mat4 PVmatrix;
+#endif
+
+#ifdef INDIRECT
+//GPU driven variant (gpu_culling.h), compiled as #version 430 - per draw data comes from the records written on the CPU,
+//drawIndex is an instanced attribute holding 0, 1, 2, ... so the draw's base instance selects its record
+in uint drawIndex;
+
+struct ObjectRecord {
+    mat4  modelMatrix;
+    mat4  normalMatrix;
+    vec4  sphere;           // world space bounds, used by the culling
+};
+
+struct DrawRecord {
+    uint  object;
+    uint  level;
+    uint  numLods;
+    int   baseVertex;
+    uint  firstIndex[4];
+    uint  count[4];
+    float lodError[4];
+    vec4  ambient;          // w = shininess
+    vec4  diffuse;          // w = 0 untextured, 1 texSampler, 2 + layer of texArraySampler
+    vec4  specular;
+    vec4  positionScale;    // w = 1 for octahedral normals
+    vec4  positionOffset;   // w = model space bounding sphere radius
+    vec4  texCoordTransform;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectRecord objects[];
+};
+
+layout(std430, binding = 1) readonly buffer Draws {
+    DrawRecord draws[];
+};
+
+uniform mat4 PVmatrix;
+#endif
+
 uniform Material material;
 
 uniform mat4 PVMmatrix;
@@ -33,15 +87,18 @@ uniform mat4 Vmatrix;
 uniform mat4 Mmatrix;
 uniform mat4 normalMatrix;
 
-uniform vec3 torchPosition;
-uniform vec3 torchDirection;
+//compact vertices come as 0..1 values (vertex_format.h), float meshes have scale 1 and offset 0
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec4 texCoordTransform;     // xy scale, zw offset
+uniform float textureLayer;         // layer of texArraySampler, -1 samples texSampler
+uniform bool octahedralNormal;      // normal.xy is an octahedral encoded normal
 
-uniform bool torchOn;
-uniform float dayTime;
 uniform bool lampsOn;
 uniform vec3 lampLight;
 
 smooth out vec2 texCoord_v;
+flat out float textureLayer_v;
 smooth out vec4 color_v;
 
 out float visibility;
@@ -50,21 +107,21 @@ vec4 spotLight(Light light, Material material, vec3 vertexPosition, vec3 vertexN
 
     vec3 ret = vec3(0.0);
 
-    vec3 L = normalize(light.position - vertexPosition);
+    vec3 L = normalize(light.position.xyz - vertexPosition);
     vec3 R = reflect(-L, vertexNormal);
     vec3 V = normalize(-vertexPosition);
     float NdotL = max(0.0, dot(vertexNormal, L));
     float RdotV = max(0.0, dot(R, V));
-    float spotCoef = max(0.0, dot(-L, light.spotDirection));
+    float spotCoef = max(0.0, dot(-L, light.spotDirection.xyz));
 
-    ret += material.ambient * light.ambient;
-    ret += material.diffuse * light.diffuse * NdotL;
-    ret += material.specular * light.specular * pow(RdotV, material.shininess);
+    ret += material.ambient * light.ambient.rgb;
+    ret += material.diffuse * light.diffuse.rgb * NdotL;
+    ret += material.specular * light.specular.rgb * pow(RdotV, material.shininess);
 
-    if(spotCoef < light.spotCosCutOff)
+    if(spotCoef < light.parameters.x)
     ret *= 0.0;
     else
-    ret *= pow(spotCoef, light.spotExponent);
+    ret *= pow(spotCoef, light.parameters.y);
 
     return vec4(ret, 1.0);
 
@@ -74,17 +131,17 @@ vec4 pointLight(Light light, Material material, vec3 vertexPosition, vec3 vertex
 
     vec3 ret = vec3(0.0);
 
-    vec3 L = normalize(light.position - vertexPosition);
+    vec3 L = normalize(light.position.xyz - vertexPosition);
     vec3 R = reflect(-L, vertexNormal);
     vec3 V = normalize(-vertexPosition);
     float NdotL = max(0.0, dot(vertexNormal, L));
     float RdotV = max(0.0, dot(R, V));
-    float dist = length(light.position - vertexPosition);
+    float dist = length(light.position.xyz - vertexPosition);
     float attentuation = 1.0f/(0.0f + 0.8f * dist + 10.0f * (dist * dist)); //constant 1.0, linear 0.7, quadric 1.8, distance 7
 
-    ret += material.ambient * light.ambient * attentuation;
-    ret += material.diffuse * light.diffuse * NdotL * attentuation;
-    ret += material.specular * light.specular * pow(RdotV, material.shininess) * attentuation;
+    ret += material.ambient * light.ambient.rgb * attentuation;
+    ret += material.diffuse * light.diffuse.rgb * NdotL * attentuation;
+    ret += material.specular * light.specular.rgb * pow(RdotV, material.shininess) * attentuation;
 
     return vec4(ret, 1.0);
 
@@ -94,62 +151,70 @@ vec4 directionalLight(Light light, Material material, vec3 vertexPosition, vec3
 
     vec3 ret = vec3(0.0);
 
-    vec3 L = normalize(light.position);
+    vec3 L = normalize(light.position.xyz);
     vec3 R = reflect(-L, vertexNormal);
     vec3 V = normalize(-vertexPosition);
     float NdotL = max(0.0, dot(vertexNormal, L));
     float RdotV = max(0.0, dot(R, V));
 
-    ret += material.ambient * light.ambient;
-    ret += material.diffuse * light.diffuse * NdotL;
-    ret += material.specular * light.specular * pow(RdotV, material.shininess);
+    ret += material.ambient * light.ambient.rgb;
+    ret += material.diffuse * light.diffuse.rgb * NdotL;
+    ret += material.specular * light.specular.rgb * pow(RdotV, material.shininess);
 
     return vec4(ret, 1.0);
 
 }
 
 
-Light sun;                      //directional light moving on sky during daytime
-float sunSpeed = 3.14/15;       //count sun speed so that at the end of day its in 180 degree angle
-Light moon;                     //directional light moving on sky during nighttime
-
-Light torch;                    //flashlight moving with camera
-Light pointlight;               //point light as a lamp on castle
-
-void setupLights() {
+vec3 decodeOctahedral(vec2 encoded) {
 
-    sun.ambient  = vec3(0.0f);
-    sun.specular = vec3(1.0f);
-    sun.diffuse  = vec3(0.5f*dayTime + 0.5f, 0.5f, 0.25f);    //sun and moon are red in the morning and in the evening
-    sun.position = (Vmatrix * vec4(cos(time * sunSpeed), sin(time * sunSpeed), 0.0, 0.0)).xyz; //sun and moon start on the opposite side
-
-    torch.ambient       = vec3(0.2f);
-    torch.diffuse       = vec3(1.0f, 1.0f, 1.0f);
-    torch.specular      = vec3(1.0f);
-    torch.spotCosCutOff = 0.95f;
-    torch.spotExponent  = 0.0;
-
-    torch.position = (Vmatrix * vec4(torchPosition, 1.0)).xyz;
-    torch.spotDirection = normalize((Vmatrix * vec4(torchDirection, 0.0)).xyz);
-
-    pointlight.ambient       = vec3(0.2f);
-    pointlight.diffuse       = vec3(1.0f, 1.0f, 1.0f);
-    pointlight.specular      = vec3(1.0f);
-    pointlight.spotCosCutOff = 0.9f;
-    pointlight.spotExponent  = 0.0;
-    pointlight.position      = (Vmatrix*vec4(-4.0f, 0.14f, 1.3f, 1.0f)).xyz;
+    vec2 e = encoded * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
 
 }
 
 void main() {
 
-    setupLights();
-
-    vec3 vertexPosition = (Vmatrix * Mmatrix * vec4(position, 1.0)).xyz;
-    vec3 vertexNormal   = normalize((Vmatrix * normalMatrix * vec4(normal, 0.0) ).xyz);
-
-    vec3 globalAmbientLight = vec3(0.4f);
-    vec4 outputColor = vec4(material.ambient * globalAmbientLight, 0.0);
+#ifdef INDIRECT
+    Material drawMaterial = Material(draws[drawIndex].ambient.rgb, draws[drawIndex].diffuse.rgb, draws[drawIndex].specular.rgb,
+                                     draws[drawIndex].ambient.w, draws[drawIndex].diffuse.w > 0.0);
+    vec3 drawPositionScale       = draws[drawIndex].positionScale.xyz;
+    vec3 drawPositionOffset      = draws[drawIndex].positionOffset.xyz;
+    vec4 drawTexCoordTransform   = draws[drawIndex].texCoordTransform;
+    float drawTextureLayer       = draws[drawIndex].diffuse.w - 2.0;
+    bool drawOctahedralNormal    = draws[drawIndex].positionScale.w > 0.0;
+#else
+    Material drawMaterial = material;
+    vec3 drawPositionScale       = positionScale;
+    vec3 drawPositionOffset      = positionOffset;
+    vec4 drawTexCoordTransform   = texCoordTransform;
+    float drawTextureLayer       = textureLayer;
+    bool drawOctahedralNormal    = octahedralNormal;
+#endif
+
+    vec3 objectPosition = drawPositionOffset + position * drawPositionScale;
+    vec3 objectNormal   = drawOctahedralNormal ? decodeOctahedral(normal.xy) : normal;
+
+#if defined(INSTANCED)
+    mat4 modelMatrix       = instanceModelMatrix;
+    mat4 modelNormalMatrix = instanceNormalMatrix;
+#elif defined(INDIRECT)
+    mat4 modelMatrix       = objects[draws[drawIndex].object].modelMatrix;
+    mat4 modelNormalMatrix = objects[draws[drawIndex].object].normalMatrix;
+#else
+    mat4 modelMatrix       = Mmatrix;
+    mat4 modelNormalMatrix = normalMatrix;
+#endif
+
+    vec3 vertexPosition = (Vmatrix * modelMatrix * vec4(objectPosition, 1.0)).xyz;
+    vec3 vertexNormal   = normalize((Vmatrix * modelNormalMatrix * vec4(objectNormal, 0.0) ).xyz);
+
+    vec4 outputColor = vec4(drawMaterial.ambient * globalAmbient.rgb, 0.0);
 
     const float density = 1.0f;
     const float gradient = 2.0f;
@@ -160,15 +225,20 @@ void main() {
     visibility = clamp(visibility, 0.0f, 1.0f);         //count vertex visibility in fog
 
     //sun is invisible at night, moon at day
-    outputColor += directionalLight(sun, material, vertexPosition, vertexNormal)*(1-dayTime);
-    if(torchOn){
-        outputColor += spotLight(torch, material, vertexPosition, vertexNormal);
+    outputColor += directionalLight(sun, drawMaterial, vertexPosition, vertexNormal) * sun.parameters.z;
+    if(torch.parameters.z > 0.0){
+        outputColor += spotLight(torch, drawMaterial, vertexPosition, vertexNormal);
     }
-    outputColor += pointLight(pointlight, material, vertexPosition, vertexNormal);
+    outputColor += pointLight(lamp, drawMaterial, vertexPosition, vertexNormal);
 
-    gl_Position = PVMmatrix * vec4(position, 1);
+#if defined(INSTANCED) || defined(INDIRECT)
+    gl_Position = PVmatrix * modelMatrix * vec4(objectPosition, 1);
+#else
+    gl_Position = PVMmatrix * vec4(objectPosition, 1);
+#endif
 
     color_v = outputColor;
-    texCoord_v = texCoord;
+    texCoord_v = drawTexCoordTransform.zw + texCoord * drawTexCoordTransform.xy;
+    textureLayer_v = drawTextureLayer;
 
 }
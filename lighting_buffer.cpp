@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    lighting_buffer.cpp
+ * @date    18/10/2026
+ * @brief   Per frame lighting state computed on the CPU and shared by all programs in one uniform buffer.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include "lighting_buffer.h"
+
+//sun makes half a turn during the day
+static const float sunSpeed = 3.14f / 15.0f;
+//point light on the castle, world space
+static const glm::vec3 lampPosition(-4.0f, 0.14f, 1.3f);
+
+static GLuint lightingBufferObject = 0;
+
+void initializeLightingBuffer() {
+
+    glGenBuffers(1, &lightingBufferObject);
+    glBindBuffer(GL_UNIFORM_BUFFER, lightingBufferObject);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTING_BLOCK_BINDING, lightingBufferObject);
+
+    CHECK_GL_ERROR();
+}
+
+void cleanupLightingBuffer() {
+
+    glDeleteBuffers(1, &lightingBufferObject);
+    lightingBufferObject = 0;
+}
+
+void bindLightingBlock(GLuint program) {
+
+    GLuint blockIndex = glGetUniformBlockIndex(program, "Lighting");
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, blockIndex, LIGHTING_BLOCK_BINDING);
+}
+
+void updateLightingBuffer(const glm::mat4& viewMatrix, float time, float dayTime,
+                          bool torchOn, const glm::vec3& torchPosition, const glm::vec3& torchDirection,
+                          bool fogOn, const glm::vec3& fogColour) {
+
+    LightingBlock block;
+
+    //sun and moon start on the opposite side, red in the morning and in the evening, invisible at night
+    block.sun.ambient = glm::vec4(0.0f);
+    block.sun.diffuse = glm::vec4(0.5f * dayTime + 0.5f, 0.5f, 0.25f, 0.0f);
+    block.sun.specular = glm::vec4(1.0f);
+    block.sun.position = viewMatrix * glm::vec4(cos(time * sunSpeed), sin(time * sunSpeed), 0.0f, 0.0f);
+    block.sun.spotDirection = glm::vec4(0.0f);
+    block.sun.parameters = glm::vec4(0.0f, 0.0f, 1.0f - dayTime, 0.0f);
+
+    block.torch.ambient = glm::vec4(0.2f);
+    block.torch.diffuse = glm::vec4(1.0f);
+    block.torch.specular = glm::vec4(1.0f);
+    block.torch.position = viewMatrix * glm::vec4(torchPosition, 1.0f);
+    block.torch.spotDirection = glm::vec4(glm::normalize(glm::vec3(viewMatrix * glm::vec4(torchDirection, 0.0f))), 0.0f);
+    block.torch.parameters = glm::vec4(0.95f, 0.0f, torchOn ? 1.0f : 0.0f, 0.0f);
+
+    block.lamp.ambient = glm::vec4(0.2f);
+    block.lamp.diffuse = glm::vec4(1.0f);
+    block.lamp.specular = glm::vec4(1.0f);
+    block.lamp.position = viewMatrix * glm::vec4(lampPosition, 1.0f);
+    block.lamp.spotDirection = glm::vec4(0.0f);
+    block.lamp.parameters = glm::vec4(0.9f, 0.0f, 1.0f, 0.0f);
+
+    block.globalAmbient = glm::vec4(0.4f);
+    block.fogColour = glm::vec4(fogColour, fogOn ? 1.0f : 0.0f);
+    block.dayTime = glm::vec4(dayTime, 0.0f, 0.0f, 0.0f);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, lightingBufferObject);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
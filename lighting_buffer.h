@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    lighting_buffer.h
+ * @date    18/10/2026
+ * @brief   Per frame lighting state computed on the CPU and shared by all programs in one uniform buffer.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __LIGHTING_BUFFER_H
+#define __LIGHTING_BUFFER_H
+
+#include "pgr.h"
+
+//binding point of the Lighting block in every program
+#define LIGHTING_BLOCK_BINDING  0
+
+//One light in std140 layout, only vec4 members so the C++ and GLSL layouts are the same
+typedef struct LightData {
+  glm::vec4 ambient;
+  glm::vec4 diffuse;
+  glm::vec4 specular;
+  glm::vec4 position;           // view space, w = 0 for directional lights
+  glm::vec4 spotDirection;      // view space
+  glm::vec4 parameters;         // x = spot cos cut off, y = spot exponent, z = intensity (0 = off)
+} LightData;
+
+//Contents of the Lighting uniform block in lightingPerVertex and skybox shaders, keep them in sync
+typedef struct LightingBlock {
+  LightData sun;                // moves over the sky during the day
+  LightData torch;              // flashlight at the camera
+  LightData lamp;               // point light on the castle
+  glm::vec4 globalAmbient;
+  glm::vec4 fogColour;          // rgb, a = 1 if fog is on
+  glm::vec4 dayTime;            // x = 0 at day .. 1 at night
+} LightingBlock;
+
+static_assert(sizeof(LightData) == 96, "LightData must match the std140 layout of Light");
+static_assert(sizeof(LightingBlock) == 3 * 96 + 48, "LightingBlock must match the std140 layout of Lighting");
+
+//creates the buffer and binds it to LIGHTING_BLOCK_BINDING, call with a current context
+void initializeLightingBuffer();
+void cleanupLightingBuffer();
+
+//attaches the Lighting block of the program to the shared binding, no-op if the program does not use it
+void bindLightingBlock(GLuint program);
+
+/**
+ * @brief Computes all lights in view space and uploads them, once per frame.
+ *
+ * @param time            seconds since start, moves the sun
+ * @param dayTime         0 at day .. 1 at night
+ * @param torchPosition   world space camera position
+ * @param torchDirection  world space view direction
+ */
+void updateLightingBuffer(const glm::mat4& viewMatrix, float time, float dayTime,
+                          bool torchOn, const glm::vec3& torchPosition, const glm::vec3& torchDirection,
+                          bool fogOn, const glm::vec3& fogColour);
+
+#endif
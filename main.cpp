@@ -9,14 +9,25 @@
 
 #include <time.h>
 #include <tuple>
+#include <chrono>
+#include <thread>
 #include "pgr.h"
 #include "render_stuff.h"
 #include "spline.h"
+#include "task_scheduler.h"
+#include "scene_bvh.h"
+#include "lighting_buffer.h"
+#include "gl_state.h"
+#include "gpu_culling.h"
+#include "texture_streamer.h"
+#include "entity_storage.h"
 #include <iostream>
 #include "glm/ext.hpp"
 
 //init shader program
 extern SCommonShaderProgram shaderProgram;
+extern SCommonShaderProgram instancedShaderProgram;
+extern SCommonShaderProgram indirectShaderProgram;
 extern SkyboxShaderProgram skyboxShaderProgram;
 
 
@@ -26,6 +37,7 @@ struct GameState {
   int windowHeight;
 
   int cameraMode;               
+  int requestedCameraMode;      //set by the input, the next simulation step switches to it
   //camera 1 - static, start position
   //camera 2 - static 2
   //camera 3 - free camera with broomstick
@@ -34,46 +46,223 @@ struct GameState {
   
   bool torchOn;
   bool fogOn;
+  bool lodOn;                   //distance based levels of detail, off = full meshes everywhere
+  bool gpuDrivenOn;             //lit opaque objects culled and drawn by the GPU (gpu_culling.h), off = render queue for all
 
-  float elapsedTime;
+  float elapsedTime;            //of the drawn frame, between the last two simulation steps
 
-  glm::vec3 skyColour;          //colour of fog, changes from grey to black at night
   float dayTime;                //0 if day, 1 if night, in between at dawn and dusk
 
 } gameState;
 
+//Values advanced by the simulation steps, the frame draws a blend of the last two
+typedef struct SimulationState {
+  glm::vec3 cameraPosition;     //of the free camera
+  float     dayTime;
+} SimulationState;
+
+#define SIMULATION_STEP (1.0 / SIMULATION_RATE)
+
+//Fixed step loop run by idleCallback, times in seconds since initializeApplication
+struct GameTiming {
+
+  std::chrono::steady_clock::time_point start;
+  double            lastFrameTime;
+  double            accumulator;        // clock time not simulated yet, less than one step between frames
+  double            simulationTime;     // of the current state, the state before it is one step older
+  double            nextFrameTime;      // idleCallback waits for it, FRAME_RATE_LIMIT
+  SimulationState   previous;           // the live values in gameState and gameObjects are the current state
+
+  //counted for SIMULATION_STATS
+  unsigned int      steps;
+  unsigned int      frames;
+  unsigned int      droppedSteps;
+
+} gameTiming;
+
 /**
  * @brief Struct with all objects or lists of objects in game
 */
 struct GameObjects {
 
-  CameraObject*     camera;
-  Object*           tree1;
-  Object*           tree2;
-  Object*           tree3;
-  Object*           tree4;
-  Object*           tree5;
-  Object*           plant;
-  Object*           plant1;
-  Object*           plant2;
-  Object*           plant3;
-  Object*           plant4;
-  MoveableObject*   eagle;
-  GroundObject*     ground;
-  WaterObject*      water;
-  FireObject*       fire;
-
-  Object*           bench1;
-  Object*           bench2;
-  Object*           hall;
-  Object*           hat;
-  Object*           broom;
-  Object*           wand;
-  Object*           fireplace;
-  Object*           rock;
+  CameraObject      camera;         //not drawn, moved by the keyboard and the mouse
+  EntityStorage     entities;       //everything drawn, made by createObject
+  SceneArena        arena;          //memory of the entities, freed at once by restartGame
+
+  EntityHandle      eagle;          //flies along the curve every frame
 
 } gameObjects;
 
+//value of each kind in the stencil buffer, mouseCallback picks by it
+static const int objectStencilIds[OBJECT_KIND_COUNT] = {
+    1,      // OBJECT_GROUND
+    2,      // OBJECT_WATER
+    3,      // OBJECT_PLANT
+    4,      // OBJECT_TREE
+    5,      // OBJECT_BENCH
+    6,      // OBJECT_HALL
+    7,      // OBJECT_EAGLE
+    8,      // OBJECT_HAT
+    9,      // OBJECT_BROOM
+    10,     // OBJECT_WAND
+    11,     // OBJECT_ROCK
+    12,     // OBJECT_FIREPLACE
+    0,      // OBJECT_FIRE
+};
+
+//the entities as startGame made them, restartGame copies them back instead of creating them again
+static SceneArena templateArena;
+static EntityStorage sceneTemplate;
+
+//draw items of the current frame, reused so it does not allocate every frame
+static RenderQueue renderQueue;
+
+//instanced batches of repeated static objects (NULL when instancing is not available), they keep copies of the matrices
+//so a restart, which puts the same objects back, leaves them as they are
+static InstanceBatch* treeBatch = NULL;
+static InstanceBatch* plantBatch = NULL;
+static InstanceBatch* benchBatch = NULL;
+
+void createInstanceBatches() {
+
+    std::vector<Object*> objects;
+    gatherEntityTransforms(&gameObjects.entities, OBJECT_TREE, &objects);
+    createInstanceBatch(OBJECT_TREE, objects, &treeBatch);
+    gatherEntityTransforms(&gameObjects.entities, OBJECT_PLANT, &objects);
+    createInstanceBatch(OBJECT_PLANT, objects, &plantBatch);
+    gatherEntityTransforms(&gameObjects.entities, OBJECT_BENCH, &objects);
+    createInstanceBatch(OBJECT_BENCH, objects, &benchBatch);
+}
+
+void deleteInstanceBatches() {
+
+    if (treeBatch != NULL) {
+        deleteInstanceBatch(treeBatch);
+        treeBatch = NULL;
+    }
+    if (plantBatch != NULL) {
+        deleteInstanceBatch(plantBatch);
+        plantBatch = NULL;
+    }
+    if (benchBatch != NULL) {
+        deleteInstanceBatch(benchBatch);
+        benchBatch = NULL;
+    }
+}
+
+//Something queued for drawing, an object or an instanced batch
+typedef struct SceneEntry {
+  ObjectKind            kind;
+  int                   entity;         // index into gameObjects.entities, -1 for a batch
+  InstanceBatch*        batch;          // levels of its instances change while queued
+  int                   stencilId;
+  bool                  gpuDriven;      // also in gpuScene, skipped by the render queue while gpuDrivenOn
+} SceneEntry;
+
+//hierarchy over the world boxes of the entries, BVH object id = index into sceneEntries
+//the entries hold entity indices, which the template keeps - a restart copies the BVH of the template back
+static SceneBvh sceneBvh;
+static SceneBvh templateBvh;
+static const Object* hierarchyTransforms = NULL;   //entity transforms the GPU scene points into
+static std::vector<SceneEntry> sceneEntries;
+static std::vector<int> visibleEntries;
+static int eagleEntry = -1;
+
+//lit opaque entries again, culled and drawn on the GPU when it can (GPU_DRIVEN_DRAWING)
+static GpuScene gpuScene;
+
+//skipped if the geometry is not loaded
+void addSceneEntry(ObjectKind kind, int entity, InstanceBatch* batch, int stencilId) {
+
+    Object* object = batch != NULL ? NULL : &gameObjects.entities.transforms[entity];
+    glm::vec3 boundsMin, boundsMax;
+    if (batch != NULL) {
+        boundsMin = batch->boundsMin;
+        boundsMax = batch->boundsMax;
+    }
+    else if (!objectWorldBounds(kind, object, &boundsMin, &boundsMax)) {
+        return;
+    }
+
+    SceneEntry entry = { kind, entity, batch, stencilId, false };
+
+#if GPU_DRIVEN_DRAWING
+    // water and fire have their own programs and blending
+    if (kind != OBJECT_WATER && kind != OBJECT_FIRE && gpuDrivenAvailable()) {
+        if (batch != NULL)
+            addGpuInstances(&gpuScene, batch, stencilId);
+        else
+            addGpuObject(&gpuScene, kind, object, getObjectGeometry(kind), stencilId);
+        entry.gpuDriven = true;
+    }
+#endif
+
+    sceneEntries.push_back(entry);
+    addBvhObject(&sceneBvh, boundsMin, boundsMax);
+}
+
+//all drawn entities with their stencil IDs, the instanced kinds as one entry per batch, call after createInstanceBatches
+//the BVH and the GPU scene keep pointers to the transforms, no entity may be added or destroyed until deleteSceneHierarchy
+void createSceneHierarchy() {
+
+    InstanceBatch* batches[OBJECT_KIND_COUNT] = { NULL };
+    batches[OBJECT_PLANT] = plantBatch;
+    batches[OBJECT_TREE] = treeBatch;
+    batches[OBJECT_BENCH] = benchBatch;
+
+    for (int kind = 0; kind < OBJECT_KIND_COUNT; kind++) {
+        if (batches[kind] != NULL)
+            addSceneEntry((ObjectKind)kind, -1, batches[kind], objectStencilIds[kind]);
+    }
+
+    const EntityStorage& entities = gameObjects.entities;
+    const int eagle = entityIndex(entities, gameObjects.eagle);
+
+    for (size_t i = 0; i < entities.count; i++) {
+        if (batches[entities.kinds[i]] != NULL)
+            continue;
+        addSceneEntry(entities.kinds[i], (int)i, NULL, entities.stencilIds[i]);
+        if ((int)i == eagle && !sceneEntries.empty() && sceneEntries.back().entity == eagle)
+            eagleEntry = (int)sceneEntries.size() - 1;
+    }
+
+    buildSceneBvh(&sceneBvh);
+    buildGpuScene(&gpuScene, indirectShaderProgram);
+    templateBvh = sceneBvh;
+    hierarchyTransforms = entities.transforms;
+}
+
+//after the template is copied back into the entities - the BVH of the template replaces the refitted one in its storage,
+//the GPU scene keeps its buffers and only its pointers follow the transforms if the copy put them elsewhere
+void restoreSceneHierarchy() {
+
+    sceneBvh = templateBvh;
+
+    Object* transforms = gameObjects.entities.transforms;
+    if (transforms != hierarchyTransforms) {
+        moveGpuObjects(&gpuScene, hierarchyTransforms, transforms, gameObjects.entities.count);
+        hierarchyTransforms = transforms;
+    }
+}
+
+void deleteSceneHierarchy() {
+
+    clearSceneBvh(&sceneBvh);
+    clearSceneBvh(&templateBvh);
+    deleteGpuScene(&gpuScene);
+    hierarchyTransforms = NULL;
+    sceneEntries.clear();
+    eagleEntry = -1;
+}
+
+//moving objects are refitted, the static ones stay where they were built
+void updateSceneHierarchy() {
+
+    glm::vec3 boundsMin, boundsMax;
+    if (eagleEntry >= 0 && objectWorldBounds(OBJECT_EAGLE, entityTransform(&gameObjects.entities, gameObjects.eagle), &boundsMin, &boundsMax))
+        updateBvhObject(&sceneBvh, eagleEntry, boundsMin, boundsMax);
+}
+
 //GUI menu 
 static int window;
 static int value = 0;
@@ -122,26 +311,26 @@ void createMenu(void) {
 glm::vec3 changeCameraPosition(bool forwards, bool backwards, bool right, bool left, float timeDelta) {
 
     if (((forwards && backwards) || !(forwards || backwards)) && ((right && left) || !(right || left))) {
-        gameObjects.camera->speed = 0;
+        gameObjects.camera.speed = 0;
         return glm::vec3(0.0f, 0.0f, 0.0f);
     }
     if (forwards) {
-        gameObjects.camera->speed = CAMERA_SPEED;
-        glm::vec3 v = glm::vec3(gameObjects.camera->direction.x, 0, gameObjects.camera->direction.z);
+        gameObjects.camera.speed = CAMERA_SPEED;
+        glm::vec3 v = glm::vec3(gameObjects.camera.direction.x, 0, gameObjects.camera.direction.z);
         return timeDelta * v * CAMERA_SPEED;
     }
     else if(backwards){
-        gameObjects.camera->speed = -CAMERA_SPEED;
-        glm::vec3 v = glm::vec3(gameObjects.camera->direction.x, 0, gameObjects.camera->direction.z);
+        gameObjects.camera.speed = -CAMERA_SPEED;
+        glm::vec3 v = glm::vec3(gameObjects.camera.direction.x, 0, gameObjects.camera.direction.z);
         return - timeDelta * v * CAMERA_SPEED;
     }
     else if (left) {
-        gameObjects.camera->speed = -CAMERA_SPEED;
-        return - glm::normalize(glm::cross(gameObjects.camera->direction, glm::vec3(0.0f, 1.0f, 0.0f))) * CAMERA_SPEED * timeDelta;
+        gameObjects.camera.speed = -CAMERA_SPEED;
+        return - glm::normalize(glm::cross(gameObjects.camera.direction, glm::vec3(0.0f, 1.0f, 0.0f))) * CAMERA_SPEED * timeDelta;
     }
     else if (right) {
-        gameObjects.camera->speed = CAMERA_SPEED;
-        return glm::normalize(glm::cross(gameObjects.camera->direction, glm::vec3(0.0f, 1.0f, 0.0f))) * CAMERA_SPEED * timeDelta;
+        gameObjects.camera.speed = CAMERA_SPEED;
+        return glm::normalize(glm::cross(gameObjects.camera.direction, glm::vec3(0.0f, 1.0f, 0.0f))) * CAMERA_SPEED * timeDelta;
     }
     return glm::vec3(0.0f, 0.0f, 0.0f);
 
@@ -173,285 +362,200 @@ bool checkCollisionBorder(glm::vec3 newCameraPosition) {
     return true;
 }
 
-// Deletes all objects in game
+// Deletes GPU data of all objects in game, the entities stay until the arena is reset
 void cleanUpObjects() {
-    if (gameObjects.tree1 != NULL) {
-        delete gameObjects.tree1;
-        gameObjects.tree1 = NULL;
-    }
-    if (gameObjects.tree2 != NULL) {
-        delete gameObjects.tree2;
-        gameObjects.tree2 = NULL;
-    }
-    if (gameObjects.tree3 != NULL) {
-        delete gameObjects.tree3;
-        gameObjects.tree3 = NULL;
-    }
-    if (gameObjects.tree5 != NULL) {
-        delete gameObjects.tree5;
-        gameObjects.tree5 = NULL;
-    }
-    if (gameObjects.tree4 != NULL) {
-        delete gameObjects.tree4;
-        gameObjects.tree4 = NULL;
-    }
-    if (gameObjects.plant != NULL) {
-        delete gameObjects.plant;
-        gameObjects.plant = NULL;
-    }
-    if (gameObjects.plant1 != NULL) {
-        delete gameObjects.plant1;
-        gameObjects.plant1 = NULL;
-    }
-    if (gameObjects.plant2 != NULL) {
-        delete gameObjects.plant2;
-        gameObjects.plant2 = NULL;
-    }
-    if (gameObjects.plant3 != NULL) {
-        delete gameObjects.plant3;
-        gameObjects.plant3 = NULL;
-    }
-    if (gameObjects.plant4 != NULL) {
-        delete gameObjects.plant4;
-        gameObjects.plant4 = NULL;
-    }
-    if (gameObjects.camera != NULL) {
-        delete gameObjects.camera;
-        gameObjects.camera = NULL;
-    }
-    if (gameObjects.bench1 != NULL) {
-        delete gameObjects.bench1;
-        gameObjects.bench1 = NULL;
-    }
-    if (gameObjects.bench2 != NULL) {
-        delete gameObjects.bench2;
-        gameObjects.bench2 = NULL;
-    }
-    if (gameObjects.hall != NULL) {
-        delete gameObjects.hall;
-        gameObjects.hall = NULL;
-    }
-    
-    if (gameObjects.broom != NULL) {
-        delete gameObjects.broom;
-        gameObjects.broom = NULL;
-    }
-    if (gameObjects.hat != NULL) {
-        delete gameObjects.hat;
-        gameObjects.hat = NULL;
-    }
-    if (gameObjects.ground != NULL) {
-        delete gameObjects.ground;
-        gameObjects.ground = NULL;
-    }
-    if (gameObjects.water != NULL) {
-        delete gameObjects.water;
-        gameObjects.water = NULL;
-    }
-    if (gameObjects.eagle != NULL) {
-        delete gameObjects.eagle;
-        gameObjects.eagle = NULL;
-    }
-    if (gameObjects.rock != NULL) {
-        delete gameObjects.rock;
-        gameObjects.rock = NULL;
-    }
-    if (gameObjects.fire != NULL) {
-        delete gameObjects.fire;
-        gameObjects.fire = NULL;
-    }
-
-    if (gameObjects.fireplace != NULL) {
-        delete gameObjects.fireplace;
-        gameObjects.fireplace = NULL;
-    }
-
+    deleteSceneHierarchy();
+    deleteInstanceBatches();
 }
 
-//setting normal objects = loads given parametrs into object
-void setObject(glm::vec3 position, glm::vec3 direction, float rotationAngle, float size, std::string id, Object *obj, glm::vec3 size3D, glm::vec3 point) {
+//adds drawn object with given transform, its animation time starts now
+EntityHandle createObject(ObjectKind kind, glm::vec3 position, glm::vec3 direction, float rotationAngle, float size) {
 
+    EntityHandle entity = createEntity(&gameObjects.entities, kind, objectStencilIds[kind]);
+
+    Object* obj = entityTransform(&gameObjects.entities, entity);
     obj->position = position;
     obj->rotationAngle = rotationAngle;
     obj->direction = direction;
     obj->size = size;
-    obj->id = id;
+    obj->transformDirty = true;
 
-    obj->startTime = gameState.elapsedTime;
-    obj->currentTime = gameState.elapsedTime;
+    ObjectAnimation* animation = entityAnimation(&gameObjects.entities, entity);
+    animation->startTime = gameState.elapsedTime;
+    animation->currentTime = gameState.elapsedTime;
 
+    return entity;
 }
 
-GroundObject* createGround(void) {
-    GroundObject* newGround = new GroundObject;
-
-    newGround->size = GROUND_SIZE;
-    newGround->position = glm::vec3(0.0f, 0.0f, 0.0f);
-
-    return newGround;
+EntityHandle createGround(void) {
+    return createObject(OBJECT_GROUND, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, GROUND_SIZE);
 }
 
-WaterObject* createWater(void) {
-    WaterObject* newWater = new WaterObject;
-
-    newWater->speed = 0.0f;
-
-    newWater->startTime = gameState.elapsedTime;
-    newWater->currentTime = newWater->startTime;
-
-    newWater->size = BILLBOARD_SIZE * 4.4;
-    newWater->direction = glm::vec3(0.0f, 0.0f, 1.0f);
-
-    newWater->frameDuration = 0.1f;
-    newWater->textureFrames = 16;
-
-    newWater->position = glm::vec3(0.0f, -0.55f, 0.0f);
-
-    return newWater;
+EntityHandle createWater(void) {
+    EntityHandle water = createObject(OBJECT_WATER, glm::vec3(0.0f, -0.55f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.0f, BILLBOARD_SIZE * 4.4);
+    entityAnimation(&gameObjects.entities, water)->frameDuration = 0.1f;
+    return water;
 }
 
-MoveableObject* createEagle(void) {
-    MoveableObject* newEagle = new MoveableObject;
-
-    newEagle->startTime = gameState.elapsedTime;
-    newEagle->currentTime = newEagle->startTime;
+EntityHandle createEagle(void) {
+    glm::vec3 initPosition = glm::vec3(-7.0f, 4.0f, 5.0f);
+    EntityHandle eagle = createObject(OBJECT_EAGLE, initPosition, glm::vec3(1.0f, 0.0f, 0.0f), 180.0f, EAGLE_SIZE);
 
-    newEagle->size = EAGLE_SIZE;
-    newEagle->initPosition = glm::vec3(-7.0f, 4.0f, 5.0f);
-    newEagle->position = newEagle->initPosition;
-    newEagle->rotationAngle = 180.0f;
-    newEagle->rotdirection = glm::vec3(1.0f, 0.0f, 0.0f);
-    newEagle->speed = 1;
+    ObjectAnimation* animation = entityAnimation(&gameObjects.entities, eagle);
+    animation->initPosition = initPosition;
+    animation->speed = 1;
 
-    return newEagle;
+    return eagle;
 }
-FireObject* createFire(const glm::vec3& position) {
-    FireObject* newFire = new FireObject;
-
-    newFire->startTime = gameState.elapsedTime;
-    newFire->currentTime = newFire->startTime;
-
-    newFire->size = FIRE_BILLBOARD_SIZE;
-    newFire->direction = glm::vec3(0.0f, 0.0f, 1.0f);
-
-    newFire->frameDuration = 0.3f;
-    newFire->textureFrames = 16;
 
-    newFire->position = position;
-
-    return newFire;
+EntityHandle createFire(const glm::vec3& position) {
+    EntityHandle fire = createObject(OBJECT_FIRE, position, glm::vec3(0.0f, 0.0f, 1.0f), 0.0f, FIRE_BILLBOARD_SIZE);
+    entityAnimation(&gameObjects.entities, fire)->frameDuration = 0.3f;
+    return fire;
 }
 
-Object* generateBenche(glm::vec3 position, float rad) {
-    
-    Object* obj = new Object;
-    setObject(position, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(rad), BENCH_SIZE, BENCH_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle generateBenche(glm::vec3 position, float rad) {
+    return createObject(OBJECT_BENCH, position, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(rad), BENCH_SIZE);
 }
 
-Object* generateTree(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), TREE_SIZE, TREE_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle generateTree(glm::vec3 position, float rad) {
+    return createObject(OBJECT_TREE, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), TREE_SIZE);
+}
 
+EntityHandle createPlant(glm::vec3 position, float rad){
+    return createObject(OBJECT_PLANT, position, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(rad), PLANT_SIZE);
 }
 
-Object* createPlant(glm::vec3 position, float rad){
-    Object* obj = new Object;
-    setObject(position, glm::vec3(0.0f, 1.0f, 0.0f), glm::radians(rad), PLANT_SIZE, PLANT_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle createHall(glm::vec3 position, float rad) {
+    return createObject(OBJECT_HALL, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), HALL_SIZE);
+}
 
+EntityHandle createHat(glm::vec3 position, float rad) {
+    return createObject(OBJECT_HAT, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), HAT_SIZE);
 }
 
-Object* createHall(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), HALL_SIZE, HALL_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle createBroom(glm::vec3 position, float rad) {
+    return createObject(OBJECT_BROOM, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), BROOM_SIZE);
 }
 
-Object* createHat(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), HAT_SIZE, HAT_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle createWand(glm::vec3 position, float rad) {
+    return createObject(OBJECT_WAND, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), WAND_SIZE);
 }
 
-Object* createBroom(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), BROOM_SIZE, BROOM_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle createRock(glm::vec3 position, float rad) {
+    return createObject(OBJECT_ROCK, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), WAND_SIZE*0.01f);
 }
 
-Object* createWand(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), WAND_SIZE, WAND_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+EntityHandle createFireplace(glm::vec3 position, float rad) {
+    return createObject(OBJECT_FIREPLACE, position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), PLANT_SIZE);
 }
 
-Object* createRock(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), WAND_SIZE*0.01f, ROCK_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+//view direction of the free camera from its yaw and pitch
+glm::vec3 freeCameraDirection() {
+
+    glm::vec3 front;
+    front.x = cos(glm::radians(gameObjects.camera.yaw)) * cos(glm::radians(gameObjects.camera.pitch));
+    front.y = sin(glm::radians(gameObjects.camera.pitch));
+    front.z = sin(glm::radians(gameObjects.camera.yaw)) * cos(glm::radians(gameObjects.camera.pitch));
+    return glm::normalize(front);
 }
 
-Object* createFireplace(glm::vec3 position, float rad) {
-    Object* obj = new Object;
-    setObject(position, glm::vec3(1.0f, 0.0f, 0.0f), glm::radians(rad), PLANT_SIZE, FIREPLACE_MODEL_NAME, obj, glm::vec3(0, 0, 0), glm::vec3(0, 0, 0));
-    return obj;
+//camera of the static views 1 and 2, the free camera starts where the last static view was
+void placeStaticCamera(int cameraMode) {
+
+    if (cameraMode == 1) {                      //first static view (view from starting position)
+        gameObjects.camera.position = glm::vec3(0.0f, 0.1f, -1.4f);
+        gameObjects.camera.direction = glm::vec3(0.4f, 0, -1);
+        gameObjects.camera.yaw = 270;
+    }
+    else {                                      //second static view
+        gameObjects.camera.position = glm::vec3(-8.0f, 0.1f, 5.0f);
+        gameObjects.camera.direction = glm::vec3(0.9, 0.5, -1);
+        gameObjects.camera.yaw = 45;
+    }
+    gameObjects.camera.pitch = 0;
 }
 
-void startGame() {
+//state and camera of a new game
+void resetGameState() {
 
-    gameState.skyColour = glm::vec3(0.5f, 0.5f, 0.5f);
     gameState.dayTime = 0; 
     gameState.cameraMode = 1; 
-    gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); 
+    gameState.requestedCameraMode = 1;
+    gameState.elapsedTime = (float)gameTiming.simulationTime;
     gameState.fogOn = false;
+    gameState.lodOn = true;
+    gameState.gpuDrivenOn = true;
+
+    gameObjects.camera.speed = 0.0f;
+    placeStaticCamera(1);
 
-    //static camera 1
-    if(gameObjects.camera == NULL)
-        gameObjects.camera = new CameraObject;
-
-    gameObjects.camera->yaw = 270.0f;
-    gameObjects.camera->pitch = 0;
-    gameObjects.camera->speed = 0.0f;
- 
-    setObject(glm::vec3(-0.2f, 1.0f, -1.3f), glm::vec3(cos(glm::radians(gameObjects.camera->yaw)), 0.0f, sin(glm::radians(gameObjects.camera->yaw))), 0.0f, 0.0f, "none", gameObjects.camera, glm::vec3(0, 0, 0), glm::vec3(0.0f, 0.06f, 1.0f));
-
-    gameObjects.bench1 = generateBenche(glm::vec3(0.0f, -0.1f, -1.5f), 120.0f);
-    gameObjects.bench2 = generateBenche(glm::vec3(1.8f, -0.1f, -0.3f), 170.0f);
-    Object* tree1 = generateTree(glm::vec3(-3.8f, 0.8f, -6.3f), 270.0f);
-    Object* tree2 = generateTree(glm::vec3(-4.5f, 0.8f, -5.0f), 270.0f);
-    Object* tree3 = generateTree(glm::vec3(-2.2f, 0.8f, -7.4f), 270.0f);
-    Object* tree4 = generateTree(glm::vec3(-1.5, 0.8f, -6.7f), 270.0f);
-    Object* tree5 = generateTree(glm::vec3(-0.5f, 0.8f, -7.0f), 270.0f);
-    GroundObject* ground = createGround();
-    gameObjects.plant = createPlant(glm::vec3(2.5f, 0.0f, -0.4f), 10.0f);
-    gameObjects.plant1 = createPlant(glm::vec3(1.2f, -0.18f, -0.5f), 200.0f);
-    gameObjects.plant2 = createPlant(glm::vec3(2.49f, -0.05f, 0.0f), 250.0f);
-    gameObjects.plant3 = createPlant(glm::vec3(2.53f, 0.05f, 0.45f), 90.0f);
-    gameObjects.plant4 = createPlant(glm::vec3(2.8f, 0.1f, -0.3f), 180.0f);
-    gameObjects.hall = createHall(glm::vec3(-6.0f, 3.05f, 1.0f), 270.0f);
+    //nothing to blend with before the first step
+    gameTiming.previous.cameraPosition = gameObjects.camera.position;
+    gameTiming.previous.dayTime = gameState.dayTime;
+}
+
+//creates all objects of the scene one by one
+void populateScene() {
+
+    generateBenche(glm::vec3(0.0f, -0.1f, -1.5f), 120.0f);
+    generateBenche(glm::vec3(1.8f, -0.1f, -0.3f), 170.0f);
+    generateTree(glm::vec3(-3.8f, 0.8f, -6.3f), 270.0f);
+    generateTree(glm::vec3(-4.5f, 0.8f, -5.0f), 270.0f);
+    generateTree(glm::vec3(-2.2f, 0.8f, -7.4f), 270.0f);
+    generateTree(glm::vec3(-1.5, 0.8f, -6.7f), 270.0f);
+    generateTree(glm::vec3(-0.5f, 0.8f, -7.0f), 270.0f);
+    createGround();
+    createPlant(glm::vec3(2.5f, 0.0f, -0.4f), 10.0f);
+    createPlant(glm::vec3(1.2f, -0.18f, -0.5f), 200.0f);
+    createPlant(glm::vec3(2.49f, -0.05f, 0.0f), 250.0f);
+    createPlant(glm::vec3(2.53f, 0.05f, 0.45f), 90.0f);
+    createPlant(glm::vec3(2.8f, 0.1f, -0.3f), 180.0f);
+    createHall(glm::vec3(-6.0f, 3.05f, 1.0f), 270.0f);
     gameObjects.eagle = createEagle();
-    gameObjects.hat = createHat(glm::vec3(1.5f, 0.05f, 2.3f), 340.0f);
-    gameObjects.broom = createBroom(glm::vec3(-8.0f, -0.15f, 4.3f), 0.0f);
-    gameObjects.wand = createWand(glm::vec3(-4.0f, 0.1f, 1.3f), 0.0f);
-    gameObjects.rock = createRock(glm::vec3(1.0f, -0.4f, -1.3f), 270.0f);
-    gameObjects.fire = createFire(glm::vec3(-8.3f, -0.05f, 6.0f));
-    gameObjects.fireplace = createFireplace(glm::vec3(-8.3f, -0.15f, 6.0f), 0.0f);
-
-    gameObjects.ground = ground;
-    gameObjects.water = createWater();
-    gameObjects.tree1 = tree1;
-    gameObjects.tree2 = tree2;
-    gameObjects.tree3 = tree3;
-    gameObjects.tree4 = tree4;
-    gameObjects.tree5 = tree5;
-   
+    createHat(glm::vec3(1.5f, 0.05f, 2.3f), 340.0f);
+    createBroom(glm::vec3(-8.0f, -0.15f, 4.3f), 0.0f);
+    createWand(glm::vec3(-4.0f, 0.1f, 1.3f), 0.0f);
+    createRock(glm::vec3(1.0f, -0.4f, -1.3f), 270.0f);
+    createFire(glm::vec3(-8.3f, -0.05f, 6.0f));
+    createFireplace(glm::vec3(-8.3f, -0.15f, 6.0f), 0.0f);
+    createWater();
+
+    //pines scattered around to load the instanced path, none by default
+    for (int i = 0; i < FOREST_TREE_COUNT; i++) {
+        glm::vec3 position(-9.0f + 18.0f * rand() / RAND_MAX, 0.8f, -9.0f + 18.0f * rand() / RAND_MAX);
+        generateTree(position, 270.0f);
+    }
+}
+
+void startGame() {
+
+    resetGameState();
+    populateScene();
+
+    createInstanceBatches();
+    createSceneHierarchy();
+
+    //transforms are clean now, the copies do not compute their matrices again
+    copyEntities(&sceneTemplate, &templateArena, gameObjects.entities);
 }
 
+//the arena drops all entities at once and the template is copied into it, nothing is allocated if the scene fits
+//the batches, the BVH and the GPU scene describe the same objects and are kept
 void restartGame() {
-    cleanUpObjects();
-    startGame();
+
+    resetGameState();
+
+    resetSceneArena(&gameObjects.arena);
+    copyEntities(&gameObjects.entities, &gameObjects.arena, sceneTemplate);
+
+    EntityStorage& entities = gameObjects.entities;
+    for (size_t i = 0; i < entities.count; i++) {
+        entities.animations[i].startTime = gameState.elapsedTime;
+        entities.animations[i].currentTime = gameState.elapsedTime;
+    }
+
+    restoreSceneHierarchy();
 }
 
 // Called when mouse is moving while no mouse buttons are pressed.
@@ -465,13 +569,14 @@ void passiveMouseMotionCallback(int mouseX, int mouseY) {
         xoffset *= sensitivity;
         yoffset *= sensitivity;
 
-        gameObjects.camera->yaw += xoffset;
-        gameObjects.camera->pitch += yoffset;
+        gameObjects.camera.yaw += xoffset;
+        gameObjects.camera.pitch += yoffset;
 
-        if (gameObjects.camera->pitch > 89.0f)
-            gameObjects.camera->pitch = 89.0f;
-        if (gameObjects.camera->pitch < -89.0f)
-            gameObjects.camera->pitch = -89.0f;
+        if (gameObjects.camera.pitch > 89.0f)
+            gameObjects.camera.pitch = 89.0f;
+        if (gameObjects.camera.pitch < -89.0f)
+            gameObjects.camera.pitch = -89.0f;
+        gameObjects.camera.direction = freeCameraDirection();
 
         glutWarpPointer(gameState.windowWidth / 2, gameState.windowHeight / 2);
 
@@ -480,28 +585,22 @@ void passiveMouseMotionCallback(int mouseX, int mouseY) {
 
 }
 
-//setting up camera position and return viewMatrix and ProjectionMatrix
-std::tuple<glm::mat4, glm::mat4> setupCamera() {
+//setting up camera position and return viewMatrix and ProjectionMatrix, the free camera stands at freeCameraPosition
+std::tuple<glm::mat4, glm::mat4> setupCamera(const glm::vec3& freeCameraPosition) {
 
     glm::mat4 viewMatrix;
     glm::mat4 projectionMatrix;
 
     //free camera
     if (gameState.cameraMode == 3) {
-        glm::vec3 cameraPosition = gameObjects.camera->position;
+        glm::vec3 cameraPosition = freeCameraPosition;
         
         glm::vec3 cameraUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
 
-        glm::vec3 front;
-        front.x = cos(glm::radians(gameObjects.camera->yaw)) * cos(glm::radians(gameObjects.camera->pitch));
-        front.y = sin(glm::radians(gameObjects.camera->pitch));
-        front.z = sin(glm::radians(gameObjects.camera->yaw)) * cos(glm::radians(gameObjects.camera->pitch));
-        glm::vec3 cameraViewDirection = glm::normalize(front);
+        glm::vec3 cameraViewDirection = gameObjects.camera.direction;
 
         glm::vec3 cameraCenter = cameraPosition + cameraViewDirection;
 
-        gameObjects.camera->direction = cameraViewDirection;
-
         viewMatrix = glm::lookAt(
             cameraPosition,
             cameraCenter,
@@ -518,23 +617,18 @@ std::tuple<glm::mat4, glm::mat4> setupCamera() {
         glutMotionFunc(NULL);
     }
 
-    //first static view (view from starting position)
-    if (gameState.cameraMode == 1) {
+    //static views, simulationStep placed the camera when switching to them
+    if (gameState.cameraMode == 1 || gameState.cameraMode == 2) {
 
-        glm::vec3 cameraPosition = glm::vec3(0.0f, 0.1f, -1.4f);
+        glm::vec3 cameraPosition = gameObjects.camera.position;
 
         glm::vec3 cameraUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
         glm::vec3 cameraCenter;
 
-        glm::vec3 cameraViewDirection = glm::vec3(0.4f, 0, -1);
+        glm::vec3 cameraViewDirection = gameObjects.camera.direction;
 
         cameraCenter = cameraPosition + cameraViewDirection;
 
-        gameObjects.camera->direction = cameraViewDirection;
-        gameObjects.camera->position = cameraPosition;
-        gameObjects.camera->pitch = 0;
-        gameObjects.camera->yaw = 270;
-
         viewMatrix = glm::lookAt(
             cameraPosition,
             cameraCenter,
@@ -543,105 +637,147 @@ std::tuple<glm::mat4, glm::mat4> setupCamera() {
 
         projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth / (float)gameState.windowHeight, 0.1f, 10.0f);
     }
+    return std::make_tuple(viewMatrix, projectionMatrix);
 
-    //second static view 
-    if (gameState.cameraMode == 2) {
-        glm::vec3 cameraPosition = glm::vec3(-8.0f, 0.1f, 5.0f);
-
-        glm::vec3 cameraUpVector = glm::vec3(0.0f, 1.0f, 0.0f);
-        glm::vec3 cameraCenter;
-
-        glm::vec3 cameraViewDirection = glm::vec3(0.9, 0.5, -1);
+}
 
-        cameraCenter = cameraPosition + cameraViewDirection;
+//water, fire and the eagle are functions of time, evaluated at the time of the drawn frame
+void animateObjects(float elapsedTime) {
 
-        gameObjects.camera->direction = cameraViewDirection;
-        gameObjects.camera->position = cameraPosition;
-        gameObjects.camera->pitch = 0;
-        gameObjects.camera->yaw = 45;
+    //texture frames of water and fire, one pass over the dense animations
+    EntityStorage& entities = gameObjects.entities;
+    for (size_t i = 0; i < entities.count; i++)
+        entities.animations[i].currentTime = elapsedTime;
 
-        viewMatrix = glm::lookAt(
-            cameraPosition,
-            cameraCenter,
-            cameraUpVector
-        );
-
-        projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth / (float)gameState.windowHeight, 0.1f, 10.0f);
+    //Make the curve and have the eagle path it
+    Object* eagle = entityTransform(&entities, gameObjects.eagle);
+    if (eagle != NULL) {
+        const ObjectAnimation* animation = entityAnimation(&entities, gameObjects.eagle);
+        float curveParam = animation->speed * (animation->currentTime - animation->startTime);
+        eagle->position = animation->initPosition + evaluateClosedCurve(curveData, curveSize, curveParam);
+        eagle->direction = glm::normalize(evaluateClosedCurve_1stDerivative(curveData, curveSize, curveParam));
+        eagle->transformDirty = true;
     }
-    return std::make_tuple(viewMatrix, projectionMatrix);
+
+    updateSceneHierarchy();
 
 }
 
 void drawWindowContents() {
 
+    //restart and loading bind objects directly, uniforms and render states are still known
+    invalidateGLBindings();
+    resetGLStateStats();
+
+    //the frame lies between the last two simulation steps
+    const float blend = (float)(gameTiming.accumulator / SIMULATION_STEP);
+    const glm::vec3 freeCameraPosition = glm::mix(gameTiming.previous.cameraPosition, gameObjects.camera.position, blend);
+    const float dayTime = glm::mix(gameTiming.previous.dayTime, gameState.dayTime, blend);
+    const glm::vec3 skyColour = glm::vec3(0.5f * (1.0f - dayTime));     //colour of fog, changes from grey to black at night
+
+    gameState.elapsedTime = (float)(gameTiming.simulationTime - SIMULATION_STEP * (1.0f - blend));
+    animateObjects(gameState.elapsedTime);
+
     glm::mat4 viewMatrix, projectionMatrix;
-    std::tie(viewMatrix, projectionMatrix) = setupCamera();
-    
+    std::tie(viewMatrix, projectionMatrix) = setupCamera(freeCameraPosition);
+    const glm::vec3 cameraPosition = gameState.cameraMode == 3 ? freeCameraPosition : gameObjects.camera.position;
 
-    glUseProgram(shaderProgram.program);
-    glUniform1f(shaderProgram.timeLocation, gameState.elapsedTime);
-
-    glUniform3fv(shaderProgram.torchDirectionLocation, 1, glm::value_ptr(gameObjects.camera->direction));
-    glUniform3fv(shaderProgram.torchPositionLocation, 1, glm::value_ptr(gameObjects.camera->position));
-    glUniform1i(shaderProgram.torchOnLocation, gameState.torchOn);
-    glUniform1f(shaderProgram.dayTimeLocation, gameState.dayTime);
-    glUniform3fv(shaderProgram.fogColourLocation, 1, glm::value_ptr(gameState.skyColour));
-    glUniform1i(shaderProgram.fogOnLocation, gameState.fogOn);
-    glUseProgram(0);
-
-    glUseProgram(skyboxShaderProgram.program);
-    glUniform3fv(skyboxShaderProgram.fogColourLocation, 1, glm::value_ptr(gameState.skyColour));
-    glUniform1f(skyboxShaderProgram.blendFactorLocation, gameState.dayTime);
-    glUniform1f(skyboxShaderProgram.fogActiveLocation, gameState.fogOn);
-    
-    glUseProgram(0);
+    //one upload of all lights for the lit programs and the skybox
+    updateLightingBuffer(viewMatrix, gameState.elapsedTime, dayTime,
+                         gameState.torchOn, cameraPosition, gameObjects.camera.direction,
+                         gameState.fogOn, skyColour);
 
     CHECK_GL_ERROR();
     
    
     drawSkybox(viewMatrix, projectionMatrix);
-    drawFire(gameObjects.fire, viewMatrix, projectionMatrix);
-  
 
-    glEnable(GL_STENCIL_TEST);
-    // set the stencil operations - if the stencil test and depth test are passed than
-
-    // value in the stencil buffer is replaced with the object ID (byte 1..255, 0 ... background)
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-    //draw all objects 
-    glStencilFunc(GL_ALWAYS, 1, -1);
-    drawBase(gameObjects.ground, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 2, -1);
-    drawWater(gameObjects.water, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 3, -1);
-    drawPlant(gameObjects.plant, viewMatrix, projectionMatrix);
-    drawPlant(gameObjects.plant1, viewMatrix, projectionMatrix);
-    drawPlant(gameObjects.plant2, viewMatrix, projectionMatrix);
-    drawPlant(gameObjects.plant3, viewMatrix, projectionMatrix);
-    drawPlant(gameObjects.plant4, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 4, -1);
-    drawTree(gameObjects.tree1, viewMatrix, projectionMatrix);
-    drawTree(gameObjects.tree2, viewMatrix, projectionMatrix);
-    drawTree(gameObjects.tree3, viewMatrix, projectionMatrix);
-    drawTree(gameObjects.tree4, viewMatrix, projectionMatrix);
-    drawTree(gameObjects.tree5, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 5, -1);
-    drawBench(gameObjects.bench1, viewMatrix, projectionMatrix);
-    drawBench(gameObjects.bench2, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 6, -1);
-    drawHall(gameObjects.hall, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 7, -1);
-    drawEagle(gameObjects.eagle, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 8, -1);
-    drawHat(gameObjects.hat, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 9, -1);
-    drawBroom(gameObjects.broom, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 10, -1);
-    drawWand(gameObjects.wand, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 11, -1);
-    drawRock(gameObjects.rock, viewMatrix, projectionMatrix);
-    glStencilFunc(GL_ALWAYS, 12, -1);
-    drawFireplace(gameObjects.fireplace, viewMatrix, projectionMatrix);
+    //once per frame for culling and every draw
+    glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
+    setLodProjection(projectionMatrix, gameState.windowHeight, gameState.lodOn);
+
+    Frustum frustum;
+    extractFrustumPlanes(PVmatrix, &frustum);
+
+#if SCENE_BVH_CULLING
+    cullSceneBvh(&sceneBvh, frustum, &visibleEntries);
+#else
+    visibleEntries.resize(sceneEntries.size());
+    for (size_t i = 0; i < sceneEntries.size(); i++)
+        visibleEntries[i] = (int)i;
+#endif
+
+    //queue visible entries, order does not matter - the queue sorts them by state
+    clearRenderQueue(&renderQueue);
+
+    //GPU driven entries are culled by the compute shader from all objects, the BVH result is not needed for them
+    const bool gpuDriven = gameState.gpuDrivenOn && !gpuScene.groups.empty();
+
+    for (size_t i = 0; i < visibleEntries.size(); i++) {
+        const SceneEntry& entry = sceneEntries[visibleEntries[i]];
+        if (gpuDriven && entry.gpuDriven) {
+            if (entry.batch != NULL)
+                requestBatchTextures(entry.batch, viewMatrix);
+            else
+                requestObjectTextures(entry.kind, &gameObjects.entities.transforms[entry.entity], viewMatrix);
+            continue;
+        }
+        if (entry.batch != NULL)
+            queueInstanceBatch(&renderQueue, entry.batch, entry.stencilId, viewMatrix);
+        else
+            queueObject(&renderQueue, entry.kind, &gameObjects.entities.transforms[entry.entity], &gameObjects.entities.animations[entry.entity], entry.stencilId, viewMatrix);
+    }
+
+#if !SCENE_BVH_CULLING
+    cullRenderQueue(&renderQueue, frustum);
+#endif
+
+    if (gpuDriven)
+        drawGpuScene(&gpuScene, indirectShaderProgram, frustum, viewMatrix, PVmatrix, getLodPixelsPerUnit());
+
+    submitRenderQueue(&renderQueue, viewMatrix, PVmatrix);
+
+    //levels requested while queueing
+    updateTextureStreaming();
+
+#if RENDER_QUEUE_STATS
+    static int lastStatsTime = -1;
+    if ((int)gameState.elapsedTime != lastStatsTime) {
+        const RenderStats& stats = renderQueue.stats;
+        std::cout << "render queue: " << stats.items << " items, " << stats.instances << " objects, " << stats.drawCalls << " draw calls"
+                  << " (per object drawing: " << stats.instances << ")" << std::endl;
+        std::cout << "vertex data: " << stats.vertexBytes / (1024.0 * 1024.0) << " MB drawn, GPU time " << stats.gpuTime << " ms" << std::endl;
+        std::cout << "triangles: " << stats.triangles << " submitted, " << stats.fullTriangles << " at full detail (LOD "
+                  << (gameState.lodOn ? "on" : "off") << ")" << std::endl;
+        const GLStateStats& glStats = getGLStateStats();
+        std::cout << "GL calls issued/skipped: program " << glStats.programs.issued << "/" << glStats.programs.skipped
+                  << ", VAO " << glStats.vertexArrays.issued << "/" << glStats.vertexArrays.skipped
+                  << ", texture " << glStats.textures.issued << "/" << glStats.textures.skipped
+                  << ", render state " << glStats.renderStates.issued << "/" << glStats.renderStates.skipped
+                  << ", uniform " << glStats.uniforms.issued << "/" << glStats.uniforms.skipped << std::endl;
+        ArenaStats arena;
+        getGeometryArenaStats(&arena);
+        std::cout << "geometry arena: " << arena.pages << " pages, " << arena.usedBytes / (1024.0 * 1024.0) << " of "
+                  << arena.capacityBytes / (1024.0 * 1024.0) << " MB used, overhead " << (arena.capacityBytes - arena.usedBytes) / (1024.0 * 1024.0)
+                  << " MB in " << arena.freeBlocks << " free blocks" << std::endl;
+        std::cout << "GPU driven: " << (gpuDriven ? "on" : "off") << ", " << gpuScene.stats.objects << " objects ("
+                  << gpuScene.stats.uploadedObjects << " uploaded last frame), " << gpuScene.stats.draws
+                  << " draws in " << gpuScene.stats.multiDrawCalls << " multi draw calls" << std::endl;
+        const TextureStreamStats& streaming = getTextureStreamStats();
+        std::cout << "texture streaming: " << streaming.textures << " textures, " << streaming.residentBytes / (1024.0 * 1024.0) << " of "
+                  << streaming.budgetBytes / (1024.0 * 1024.0) << " MB resident, " << streaming.loading << " levels loading, "
+                  << streaming.levelsLoaded << " loaded / " << streaming.levelsEvicted << " evicted, latency " << streaming.latency
+                  << " ms (max " << streaming.maxLatency << ")" << std::endl;
+#if SCENE_BVH_CULLING
+        const CullingStats& culling = sceneBvh.culling;
+#else
+        const CullingStats& culling = renderQueue.culling;
+#endif
+        std::cout << "frustum culling: " << culling.tested << (SCENE_BVH_CULLING ? " nodes" : " items") << " tested, " << culling.visible << " visible, "
+                  << culling.culled << " culled in " << culling.time << " ms" << std::endl;
+        lastStatsTime = (int)gameState.elapsedTime;
+    }
+#endif
 }
 
 // Called to update the display. You should call glutSwapBuffers after all of your
@@ -657,15 +793,15 @@ void displayCallback() {
         restartGame();
     }
     else if (value == 2) {
-        gameState.cameraMode = 3;
+        gameState.requestedCameraMode = 3;
         glutPassiveMotionFunc(passiveMouseMotionCallback);
     }
     else if (value == 3) {
-        gameState.cameraMode = 1;
+        gameState.requestedCameraMode = 1;
         glutPassiveMotionFunc(NULL);
     }
     else if (value == 4) {
-        gameState.cameraMode = 2;
+        gameState.requestedCameraMode = 2;
         glutPassiveMotionFunc(NULL);
     }
     else if (value == 5) {
@@ -687,6 +823,15 @@ void displayCallback() {
     drawWindowContents();
 
     glutSwapBuffers();
+    gameTiming.frames++;
+
+    static bool firstFrame = true;
+    if (firstFrame) {
+        glFinish();
+        printStartupReport();
+        printTextureReport();
+        firstFrame = false;
+    }
 
 }
 
@@ -702,54 +847,93 @@ void reshapeCallback(int newWidth, int newHeight) {
 }
 
 
-void updateObjects(float elapsedTime) {
-    
-    float timeDelta = elapsedTime - gameObjects.camera->currentTime;
-    gameObjects.camera->currentTime = elapsedTime;
+//one fixed step of the free camera and the day and night cycle
+void simulationStep(float timeDelta) {
+
+    //a new view is a jump, the previous state starts there so the frames do not blend across it
+    if (gameState.requestedCameraMode != gameState.cameraMode) {
+        gameState.cameraMode = gameState.requestedCameraMode;
+        if (gameState.cameraMode != 3)
+            placeStaticCamera(gameState.cameraMode);
+        else
+            gameObjects.camera.direction = freeCameraDirection();
+    }
+
+    gameTiming.previous.cameraPosition = gameObjects.camera.position;
+    gameTiming.previous.dayTime = gameState.dayTime;
+
     if (gameState.cameraMode == 3) {
-        glm::vec3 newPosition = changeCameraPosition(gameState.keyMap[KEY_UP_ARROW], gameState.keyMap[KEY_DOWN_ARROW], gameState.keyMap[KEY_RIGHT_ARROW], gameState.keyMap[KEY_LEFT_ARROW], timeDelta);//gameObjects.camera->position + timeDelta * gameObjects.camera->speed * gameObjects.camera->direction;
-        if (checkCollisionPond(gameObjects.camera->position + newPosition) && checkCollisionBorder(gameObjects.camera->position + newPosition)) {
-            gameObjects.camera->position += newPosition;
+        glm::vec3 newPosition = changeCameraPosition(gameState.keyMap[KEY_UP_ARROW], gameState.keyMap[KEY_DOWN_ARROW], gameState.keyMap[KEY_RIGHT_ARROW], gameState.keyMap[KEY_LEFT_ARROW], timeDelta);//gameObjects.camera.position + timeDelta * gameObjects.camera.speed * gameObjects.camera.direction;
+        if (checkCollisionPond(gameObjects.camera.position + newPosition) && checkCollisionBorder(gameObjects.camera.position + newPosition)) {
+            gameObjects.camera.position += newPosition;
         }
     }
 
-    int time = (int) elapsedTime;
+    int time = (int) gameTiming.simulationTime;
     //tracks day and night changes
-    if (time % DAY_LENGTH < DAY_LENGTH / 2 && gameState.dayTime > 0.0) {             //day is rising
-        gameState.dayTime -= 0.01;
-        gameState.dayTime = roundf(gameState.dayTime * 100) / 100;
-        gameState.skyColour += glm::vec3(0.005, 0.005, 0.005);
-        if (gameState.dayTime == -0.0) { gameState.dayTime = 0.0; }
-    }
-    else if (time % DAY_LENGTH >= DAY_LENGTH/2 && gameState.dayTime < 1.0) {        //night is falling
-        gameState.dayTime += 0.01;
-        gameState.dayTime = roundf(gameState.dayTime * 100) / 100;
-        gameState.skyColour -= glm::vec3(0.005, 0.005, 0.005);
-        if (gameState.dayTime == -0.0) { gameState.dayTime = 0.0; }
-    }
-    gameObjects.water->currentTime = elapsedTime;
-    
-    gameObjects.eagle->currentTime = elapsedTime;
-    gameObjects.fire->currentTime = elapsedTime;
-    //Make the curve and have the eagle path it
-    float curveParam = gameObjects.eagle->speed * (gameObjects.eagle->currentTime - gameObjects.eagle->startTime);
-    gameObjects.eagle->position = gameObjects.eagle->initPosition + evaluateClosedCurve(curveData, curveSize, curveParam);
-    gameObjects.eagle->direction = glm::normalize(evaluateClosedCurve_1stDerivative(curveData, curveSize, curveParam));
-    glm::vec3 derivative = evaluateClosedCurve_1stDerivative(curveData, curveSize, curveParam);
+    if (time % DAY_LENGTH < DAY_LENGTH / 2) {             //day is rising
+        gameState.dayTime = std::max(gameState.dayTime - DAY_TRANSITION_SPEED * timeDelta, 0.0f);
+    }
+    else {                                                  //night is falling
+        gameState.dayTime = std::min(gameState.dayTime + DAY_TRANSITION_SPEED * timeDelta, 1.0f);
+    }
+}
 
+//seconds of the high resolution clock since initializeApplication
+double clockTime() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - gameTiming.start).count();
 }
 
-// Callback responsible for the scene update
-void timerCallback(int) {
+// Runs the simulation steps the clock has gone past and asks for a frame, GLUT calls it whenever there are no events
+void idleCallback() {
+
+    //without vsync GLUT calls it in a tight loop, the core is given up until the next frame is due -
+    //whole milliseconds are slept, the rest is yielded as the sleep granularity can be coarser
+    double now = clockTime();
+#if FRAME_RATE_LIMIT > 0
+    while (now < gameTiming.nextFrameTime) {
+        if (gameTiming.nextFrameTime - now > 0.002)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        else
+            std::this_thread::yield();
+        now = clockTime();
+    }
+    //a late frame does not make the next ones come sooner
+    gameTiming.nextFrameTime = std::max(gameTiming.nextFrameTime + 1.0 / FRAME_RATE_LIMIT, now);
+#endif
 
-    gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME);
-    
-    updateObjects(gameState.elapsedTime);
+    gameTiming.accumulator += now - gameTiming.lastFrameTime;
+    gameTiming.lastFrameTime = now;
 
-    glutTimerFunc(33, timerCallback, 0);
+    int steps = 0;
+    while (gameTiming.accumulator >= SIMULATION_STEP && steps < SIMULATION_MAX_STEPS) {
+        gameTiming.simulationTime += SIMULATION_STEP;
+        simulationStep((float)SIMULATION_STEP);
+        gameTiming.accumulator -= SIMULATION_STEP;
+        steps++;
+    }
 
-    glutPostRedisplay();
+    //a stall (window drag, loading) is not caught up, the game continues from now
+    if (gameTiming.accumulator >= SIMULATION_STEP) {
+        gameTiming.droppedSteps += (unsigned int)(gameTiming.accumulator / SIMULATION_STEP);
+        gameTiming.accumulator = fmod(gameTiming.accumulator, SIMULATION_STEP);
+    }
+    gameTiming.steps += steps;
+
+#if SIMULATION_STATS
+    static double lastStatsTime = 0.0;
+    if (now - lastStatsTime >= 1.0) {
+        const double seconds = now - lastStatsTime;
+        std::cout << "simulation: " << gameTiming.steps / seconds << " steps/s (" << SIMULATION_RATE << " Hz, " << gameTiming.droppedSteps
+                  << " dropped), render: " << gameTiming.frames / seconds << " frames/s" << std::endl;
+        gameTiming.steps = 0;
+        gameTiming.frames = 0;
+        gameTiming.droppedSteps = 0;
+        lastStatsTime = now;
+    }
+#endif
 
+    glutPostRedisplay();
 }
 
 void mouseCallback(int buttonPressed, int buttonState, int mouseX, int mouseY) {
@@ -817,13 +1001,13 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
     #endif
             break;
         case 'u':
-            gameState.cameraMode = 1;                   //first static view
+            gameState.requestedCameraMode = 1;          //first static view
             break;
         case 'i':
-            gameState.cameraMode = 2;                   //second static view
+            gameState.requestedCameraMode = 2;          //second static view
             break;
         case 'o':
-            gameState.cameraMode = 3;                   //free camera
+            gameState.requestedCameraMode = 3;          //free camera
             break;
         case 'l':
             gameState.torchOn = !gameState.torchOn;     //switch on/off torch
@@ -831,11 +1015,17 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
         case 'f':
             gameState.fogOn = !gameState.fogOn;         //switch on/off fog
             break;
+        case 'k':
+            gameState.lodOn = !gameState.lodOn;         //switch on/off levels of detail
+            break;
+        case 'g':
+            gameState.gpuDrivenOn = !gameState.gpuDrivenOn; //switch between GPU driven drawing and the render queue
+            break;
         case 'r':
             restartGame();         //switch on/off fog
             break;
         case 'd':
-            std::cout << glm::to_string(gameObjects.camera->position) << std::endl;;         //switch on/off fog
+            std::cout << glm::to_string(gameObjects.camera.position) << std::endl;;         //switch on/off fog
             break;
         
     }
@@ -903,11 +1093,23 @@ void initializeApplication() {
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glEnable(GL_DEPTH_TEST);
+    resetGLState();
 
+    initializeLightingBuffer();
     initializeShaderPrograms();
     initializeModels();
+    runStartupTasks();
+
+    //the game clock starts with the scene, startup loading is not simulated
+    gameTiming.start = std::chrono::steady_clock::now();
+    gameTiming.lastFrameTime = 0.0;
+    gameTiming.accumulator = 0.0;
+    gameTiming.simulationTime = 0.0;
+    gameTiming.nextFrameTime = 0.0;
 
-    gameObjects.camera = NULL;
+    initSceneArena(&gameObjects.arena, SCENE_ARENA_BLOCK_SIZE);
+    initSceneArena(&templateArena, SCENE_ARENA_BLOCK_SIZE);
+    initEntities(&gameObjects.entities, &gameObjects.arena);
 
     startGame();
 
@@ -916,10 +1118,13 @@ void initializeApplication() {
 void finalizeApplication(void) {
 
     cleanUpObjects();
+    deleteSceneArena(&gameObjects.arena);
+    deleteSceneArena(&templateArena);
 
     cleanupModels();
 
     cleanupShaderPrograms();
+    cleanupLightingBuffer();
 
 }
 
@@ -952,7 +1157,7 @@ int main(int argc, char** argv) {
    
     glutMouseFunc(mouseCallback);
 
-    glutTimerFunc(33, timerCallback, 0);
+    glutIdleFunc(idleCallback);
 
 
     if (!pgr::initialize(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR)) {
@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mapped_file.cpp
+ * @date    18/10/2026
+ * @brief   Read-only memory mapping of whole files (Win32 and POSIX).
+ */
+ //----------------------------------------------------------------------------------------
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool mapFile(const std::string& fileName, MappedFile* file) {
+
+    file->data = NULL;
+    file->size = 0;
+    file->fileHandle = INVALID_HANDLE_VALUE;
+    file->mappingHandle = NULL;
+
+    HANDLE fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    file->data = (const char*)view;
+    file->size = (size_t)size.QuadPart;
+    file->fileHandle = fileHandle;
+    file->mappingHandle = mappingHandle;
+
+    return true;
+}
+
+void unmapFile(MappedFile* file) {
+
+    if (file->data != NULL)
+        UnmapViewOfFile(file->data);
+    if (file->mappingHandle != NULL)
+        CloseHandle((HANDLE)file->mappingHandle);
+    if (file->fileHandle != INVALID_HANDLE_VALUE && file->fileHandle != NULL)
+        CloseHandle((HANDLE)file->fileHandle);
+
+    file->data = NULL;
+    file->size = 0;
+    file->fileHandle = INVALID_HANDLE_VALUE;
+    file->mappingHandle = NULL;
+}
+
+#else
+
+bool mapFile(const std::string& fileName, MappedFile* file) {
+
+    file->data = NULL;
+    file->size = 0;
+    file->fileDescriptor = -1;
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    file->data = (const char*)view;
+    file->size = (size_t)info.st_size;
+    file->fileDescriptor = fd;
+
+    return true;
+}
+
+void unmapFile(MappedFile* file) {
+
+    if (file->data != NULL)
+        munmap((void*)file->data, file->size);
+    if (file->fileDescriptor >= 0)
+        close(file->fileDescriptor);
+
+    file->data = NULL;
+    file->size = 0;
+    file->fileDescriptor = -1;
+}
+
+#endif
+
+bool prefetchFile(const std::string& fileName) {
+
+    MappedFile file;
+    if (!mapFile(fileName, &file))
+        return false;
+
+    volatile char sum = 0;
+    for (size_t i = 0; i < file.size; i += 4096)
+        sum += file.data[i];
+
+    unmapFile(&file);
+    return true;
+}
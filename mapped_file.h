@@ -0,0 +1,37 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mapped_file.h
+ * @date    18/10/2026
+ * @brief   Read-only memory mapping of whole files.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __MAPPED_FILE_H
+#define __MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+//Read-only view of a whole file, data stays valid until unmapFile is called
+typedef struct MappedFile {
+  const char*   data;
+  size_t        size;
+
+#ifdef _WIN32
+  void*         fileHandle;
+  void*         mappingHandle;
+#else
+  int           fileDescriptor;
+#endif
+} MappedFile;
+
+//maps the whole file into memory, returns false if it can not be opened
+bool mapFile(const std::string& fileName, MappedFile* file);
+
+//releases the mapping, safe to call on a file that failed to map
+void unmapFile(MappedFile* file);
+
+//reads every page of the file once so a following load is served from the OS file cache
+bool prefetchFile(const std::string& fileName);
+
+#endif
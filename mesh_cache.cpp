@@ -0,0 +1,411 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_cache.cpp
+ * @date    18/10/2026
+ * @brief   Writing, validating and mapping of cooked mesh blobs.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "mesh_cache.h"
+#include "obj_loader.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+//blob streams start on this boundary
+#define MESH_CACHE_ALIGNMENT 16
+
+uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool fileStamp(const std::string& fileName, uint64_t* size, int64_t* time) {
+
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(fileName.c_str(), &info) != 0)
+        return false;
+#else
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0)
+        return false;
+#endif
+
+    *size = (uint64_t)info.st_size;
+    *time = (int64_t)info.st_mtime;
+    return true;
+}
+
+static void createDirectory(const std::string& path) {
+
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static std::string directoryOf(const std::string& fileName) {
+
+    size_t found = fileName.find_last_of("/\\");
+    return found != std::string::npos ? fileName.substr(0, found + 1) : std::string();
+}
+
+//path of the first mtllib of a mapped .obj, relative to the working directory ("" if there is none)
+static std::string findMaterialLibrary(const MappedFile& obj, const std::string& objFile) {
+
+    const char* p = obj.data;
+    const char* end = obj.data + obj.size;
+
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (lineEnd == NULL)
+            lineEnd = end;
+
+        while (p < lineEnd && (*p == ' ' || *p == '\t'))
+            ++p;
+
+        if (lineEnd - p > 7 && memcmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t')) {
+            p += 7;
+            while (p < lineEnd && (*p == ' ' || *p == '\t'))
+                ++p;
+            const char* nameEnd = lineEnd;
+            while (nameEnd > p && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+                --nameEnd;
+            return directoryOf(objFile) + std::string(p, nameEnd - p);
+        }
+
+        p = lineEnd + 1;
+    }
+
+    return std::string();
+}
+
+//content hash, total size and newest modification time of the .obj and its .mtl
+static bool identifySource(const std::string& objFile, std::string* materialLibrary,
+                           uint64_t* hash, uint64_t* size, int64_t* time) {
+
+    MappedFile obj;
+    if (!mapFile(objFile, &obj))
+        return false;
+
+    *materialLibrary = findMaterialLibrary(obj, objFile);
+    *hash = hashBytes(HASH_SEED, obj.data, obj.size);
+    unmapFile(&obj);
+
+    if (!fileStamp(objFile, size, time))
+        return false;
+
+    MappedFile mtl;
+    if (!materialLibrary->empty() && mapFile(*materialLibrary, &mtl)) {
+        *hash = hashBytes(*hash, mtl.data, mtl.size);
+        unmapFile(&mtl);
+
+        uint64_t mtlSize;
+        int64_t mtlTime;
+        if (fileStamp(*materialLibrary, &mtlSize, &mtlTime)) {
+            *size += mtlSize;
+            *time = std::max(*time, mtlTime);
+        }
+    }
+
+    return true;
+}
+
+//checks header and that all streams lie inside the file and levels of detail inside the indices
+static bool validateBlob(const MappedFile& file) {
+
+    if (file.size < sizeof(MeshCacheHeader))
+        return false;
+
+    const MeshCacheHeader* header = (const MeshCacheHeader*)file.data;
+    if (memcmp(header->magic, MESH_CACHE_MAGIC, 4) != 0 || header->version != MESH_CACHE_VERSION)
+        return false;
+
+    if (header->numLods == 0 || header->numLods > MESH_MAX_LODS)
+        return false;
+    for (uint32_t i = 0; i < header->numLods; i++) {
+        if ((uint64_t)header->lods[i].firstIndex + header->lods[i].numIndices > header->numIndices)
+            return false;
+    }
+
+    const uint64_t vertexBytes = 8ull * sizeof(float) * header->numVertices;
+    const uint64_t indexBytes = (uint64_t)sizeof(unsigned int) * header->numIndices;
+    const uint64_t materialBytes = (uint64_t)sizeof(MeshCacheMaterial) * header->numMaterials;
+    const uint64_t rangeBytes = (uint64_t)sizeof(MeshRange) * header->numLods * header->numMaterials;
+
+    bool valid = header->numVertices > 0 && header->numIndices > 0 && header->numMaterials > 0
+        && header->vertexOffset + vertexBytes <= file.size
+        && header->indexOffset + indexBytes <= file.size
+        && header->materialOffset + materialBytes <= file.size
+        && header->rangeOffset + rangeBytes <= file.size
+        && (uint64_t)header->stringOffset + header->stringLength <= file.size
+        && (uint64_t)header->materialLibraryOffset + header->materialLibraryLength <= file.size;
+    if (!valid)
+        return false;
+
+    const MeshCacheMaterial* materials = (const MeshCacheMaterial*)(file.data + header->materialOffset);
+    for (uint32_t i = 0; i < header->numMaterials; i++) {
+        if ((uint64_t)materials[i].texturePathOffset + materials[i].texturePathLength > file.size)
+            return false;
+    }
+
+    const MeshRange* ranges = (const MeshRange*)(file.data + header->rangeOffset);
+    for (uint32_t i = 0; i < header->numLods * header->numMaterials; i++) {
+        if ((uint64_t)ranges[i].firstIndex + ranges[i].numIndices > header->numIndices)
+            return false;
+    }
+    return true;
+}
+
+std::string meshCachePath(const std::string& sourceFile) {
+
+    std::string name = sourceFile;
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':')
+            name[i] = '_';
+    }
+
+    return std::string(MESH_CACHE_DIRECTORY) + name + ".mesh";
+}
+
+bool openMeshCache(const std::string& sourceFile, MeshCache* cache) {
+
+    if (!mapFile(meshCachePath(sourceFile), &cache->file))
+        return false;
+
+    if (!validateBlob(cache->file)) {
+        unmapFile(&cache->file);
+        return false;
+    }
+
+    const MeshCacheHeader* header = (const MeshCacheHeader*)cache->file.data;
+    std::string materialLibrary(cache->file.data + header->materialLibraryOffset, header->materialLibraryLength);
+
+    //same size and time as when cooked -> no need to read the sources at all
+    uint64_t size = 0;
+    int64_t time = 0;
+    bool sourceExists = fileStamp(sourceFile, &size, &time);
+
+    if (sourceExists && !materialLibrary.empty()) {
+        uint64_t mtlSize;
+        int64_t mtlTime;
+        if (fileStamp(materialLibrary, &mtlSize, &mtlTime)) {
+            size += mtlSize;
+            time = std::max(time, mtlTime);
+        }
+    }
+
+    //sources may be missing in a shipped build - the blob is all we have then
+    if (sourceExists && (size != header->sourceSize || time != header->sourceTime)) {
+        uint64_t hash;
+        if (!identifySource(sourceFile, &materialLibrary, &hash, &size, &time) || hash != header->sourceHash) {
+            unmapFile(&cache->file);
+            return false;
+        }
+    }
+
+    cache->header = header;
+    cache->vertices = (const float*)(cache->file.data + header->vertexOffset);
+    cache->indices = (const unsigned int*)(cache->file.data + header->indexOffset);
+    cache->ranges = (const MeshRange*)(cache->file.data + header->rangeOffset);
+
+    const MeshCacheMaterial* materials = (const MeshCacheMaterial*)(cache->file.data + header->materialOffset);
+    cache->materials.resize(header->numMaterials);
+    for (uint32_t i = 0; i < header->numMaterials; i++) {
+        MeshMaterial& material = cache->materials[i];
+        material.ambient = glm::vec3(materials[i].ambient[0], materials[i].ambient[1], materials[i].ambient[2]);
+        material.diffuse = glm::vec3(materials[i].diffuse[0], materials[i].diffuse[1], materials[i].diffuse[2]);
+        material.specular = glm::vec3(materials[i].specular[0], materials[i].specular[1], materials[i].specular[2]);
+        material.shininess = materials[i].shininess;
+        material.texturePath.assign(cache->file.data + materials[i].texturePathOffset, materials[i].texturePathLength);
+    }
+
+    return true;
+}
+
+void closeMeshCache(MeshCache* cache) {
+
+    unmapFile(&cache->file);
+    cache->header = NULL;
+    cache->vertices = NULL;
+    cache->indices = NULL;
+    cache->ranges = NULL;
+    cache->materials.clear();
+}
+
+static uint32_t alignOffset(uint64_t offset) {
+    return (uint32_t)((offset + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1));
+}
+
+static void writePadding(std::ofstream& stream, uint32_t offset) {
+
+    static const char zeros[MESH_CACHE_ALIGNMENT] = { 0 };
+    uint64_t position = (uint64_t)stream.tellp();
+    if (position < offset)
+        stream.write(zeros, offset - position);
+}
+
+static bool writeBlob(const std::string& blobFile, const MeshData& mesh, const std::string& materialLibrary,
+                      uint64_t hash, uint64_t size, int64_t time) {
+
+    const uint32_t numVertices = (uint32_t)(mesh.positions.size() / 3);
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = hash;
+    header.sourceSize = size;
+    header.sourceTime = time;
+    header.numVertices = numVertices;
+    header.numIndices = (uint32_t)mesh.indices.size();
+
+    header.numLods = 1;
+    header.lods[0].numIndices = header.numIndices;
+    if (!mesh.lods.empty()) {
+        header.numLods = (uint32_t)std::min(mesh.lods.size(), (size_t)MESH_MAX_LODS);
+        for (uint32_t i = 0; i < header.numLods; i++)
+            header.lods[i] = mesh.lods[i];
+    }
+
+    //one range per level and material, a mesh without material ranges is one part with all indices of every level
+    header.numMaterials = (uint32_t)std::max(mesh.materials.size(), (size_t)1);
+    std::vector<MeshRange> ranges(mesh.ranges);
+    if (ranges.size() != (size_t)header.numLods * header.numMaterials) {
+        if (header.numMaterials != 1)
+            return false;
+        ranges.resize(header.numLods);
+        for (uint32_t i = 0; i < header.numLods; i++) {
+            ranges[i].firstIndex = header.lods[i].firstIndex;
+            ranges[i].numIndices = header.lods[i].numIndices;
+        }
+    }
+
+    header.vertexOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + 8ull * sizeof(float) * numVertices);
+    header.materialOffset = header.indexOffset + (uint32_t)(sizeof(unsigned int) * mesh.indices.size());
+    header.rangeOffset = header.materialOffset + (uint32_t)(sizeof(MeshCacheMaterial) * header.numMaterials);
+    header.stringOffset = header.rangeOffset + (uint32_t)(sizeof(MeshRange) * ranges.size());
+
+    std::vector<MeshCacheMaterial> materials(header.numMaterials);
+    memset(materials.data(), 0, sizeof(MeshCacheMaterial) * materials.size());
+    std::string strings;
+    for (size_t m = 0; m < mesh.materials.size(); m++) {
+        const MeshMaterial& material = mesh.materials[m];
+        for (int i = 0; i < 3; i++) {
+            materials[m].ambient[i] = material.ambient[i];
+            materials[m].diffuse[i] = material.diffuse[i];
+            materials[m].specular[i] = material.specular[i];
+        }
+        materials[m].shininess = material.shininess;
+        materials[m].texturePathOffset = header.stringOffset + (uint32_t)strings.size();
+        materials[m].texturePathLength = (uint32_t)material.texturePath.size();
+        strings += material.texturePath;
+    }
+    if (mesh.materials.empty())
+        materials[0].texturePathOffset = header.stringOffset;
+
+    header.stringLength = (uint32_t)strings.size();
+    header.materialLibraryOffset = header.stringOffset + header.stringLength;
+    header.materialLibraryLength = (uint32_t)materialLibrary.size();
+
+    //write next to the blob and rename, so a running game never maps half written file
+    std::string temporaryFile = blobFile + ".tmp";
+    std::ofstream stream(temporaryFile.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    stream.write((const char*)&header, sizeof(header));
+    writePadding(stream, header.vertexOffset);
+    for (uint32_t v = 0; v < numVertices; v++) {
+        stream.write((const char*)&mesh.positions[3 * v], 3 * sizeof(float));
+        stream.write((const char*)&mesh.normals[3 * v], 3 * sizeof(float));
+        stream.write((const char*)&mesh.texCoords[2 * v], 2 * sizeof(float));
+    }
+    writePadding(stream, header.indexOffset);
+    stream.write((const char*)mesh.indices.data(), sizeof(unsigned int) * mesh.indices.size());
+    stream.write((const char*)materials.data(), sizeof(MeshCacheMaterial) * materials.size());
+    stream.write((const char*)ranges.data(), sizeof(MeshRange) * ranges.size());
+    stream.write(strings.data(), strings.size());
+    stream.write(materialLibrary.data(), materialLibrary.size());
+    stream.close();
+
+    if (!stream) {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    std::remove(blobFile.c_str());
+    return std::rename(temporaryFile.c_str(), blobFile.c_str()) == 0;
+}
+
+bool cookMesh(const std::string& sourceFile, bool force, bool* cooked) {
+
+    *cooked = false;
+
+    std::string materialLibrary;
+    uint64_t hash, size;
+    int64_t time;
+
+    if (!identifySource(sourceFile, &materialLibrary, &hash, &size, &time)) {
+        std::cerr << "cookMesh(): can not read " << sourceFile << std::endl;
+        return false;
+    }
+
+    std::string blobFile = meshCachePath(sourceFile);
+
+    //content did not change - only refresh the size/time stamp if it is outdated
+    MappedFile existing;
+    if (!force && mapFile(blobFile, &existing)) {
+        MeshCacheHeader header;
+        bool upToDate = validateBlob(existing);
+        if (upToDate) {
+            memcpy(&header, existing.data, sizeof(header));
+            upToDate = (header.sourceHash == hash);
+        }
+        unmapFile(&existing);
+
+        if (upToDate) {
+            if (header.sourceSize != size || header.sourceTime != time) {
+                header.sourceSize = size;
+                header.sourceTime = time;
+                std::fstream stream(blobFile.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+                stream.write((const char*)&header, sizeof(header));
+            }
+            return true;
+        }
+    }
+
+    MeshData mesh;
+    if (!parseObjFile(sourceFile, &mesh))
+        return false;
+
+    //the game maps the blob as it is, so levels of detail and the triangle order are built here once
+    buildMeshLods(&mesh);
+    optimizeMesh(&mesh);
+
+    createDirectory(MESH_CACHE_DIRECTORY);
+
+    if (!writeBlob(blobFile, mesh, materialLibrary, hash, size, time)) {
+        std::cerr << "cookMesh(): can not write " << blobFile << std::endl;
+        return false;
+    }
+
+    *cooked = true;
+    return true;
+}
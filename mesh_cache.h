@@ -0,0 +1,88 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_cache.h
+ * @date    18/10/2026
+ * @brief   Versioned binary mesh blobs cooked from OBJ models, memory mapped at startup.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __MESH_CACHE_H
+#define __MESH_CACHE_H
+
+#include <cstdint>
+#include "mesh_data.h"
+#include "mapped_file.h"
+
+#define MESH_CACHE_MAGIC        "HGMC"
+#define MESH_CACHE_VERSION      4
+#define MESH_CACHE_DIRECTORY    "data/cache/"
+
+//Material of the blob, its texture path is in the string block
+typedef struct MeshCacheMaterial {
+  float     ambient[3];
+  float     diffuse[3];
+  float     specular[3];
+  float     shininess;
+  uint32_t  texturePathOffset;      // from the start of the file
+  uint32_t  texturePathLength;
+} MeshCacheMaterial;
+
+//Fixed size header at the beginning of every blob, all offsets are from the start of the file
+typedef struct MeshCacheHeader {
+  char      magic[4];
+  uint32_t  version;
+
+  //source .obj + .mtl identity - size and time for a cheap check, content hash decides
+  uint64_t  sourceHash;
+  uint64_t  sourceSize;
+  int64_t   sourceTime;
+
+  uint32_t  numVertices;
+  uint32_t  numIndices;
+  uint32_t  numLods;                // ranges of the index stream, level 0 first (mesh_simplifier.h)
+  MeshLod   lods[MESH_MAX_LODS];
+  uint32_t  numMaterials;
+
+  uint32_t  vertexOffset;           // 8 floats per vertex, interleaved position | normal | texCoord
+  uint32_t  indexOffset;            // unsigned int indices, 3 per triangle, all levels of detail, optimized order (mesh_optimizer.h)
+  uint32_t  materialOffset;         // numMaterials MeshCacheMaterial
+  uint32_t  rangeOffset;            // numLods * numMaterials MeshRange, ranges[level * numMaterials + material]
+  uint32_t  stringOffset;           // texture paths of the materials
+  uint32_t  stringLength;
+  uint32_t  materialLibraryOffset;  // .mtl used by the source, needed for the staleness check
+  uint32_t  materialLibraryLength;
+} MeshCacheHeader;
+
+//Mapped blob, pointers stay valid until closeMeshCache
+typedef struct MeshCache {
+  MappedFile              file;
+  const MeshCacheHeader*  header;
+  const float*            vertices;
+  const unsigned int*     indices;
+  const MeshRange*        ranges;
+  std::vector<MeshMaterial> materials;  // decoded from the blob, texture paths relative to the working directory
+} MeshCache;
+
+//offset basis of hashBytes, the hash of no bytes
+#define HASH_SEED   14695981039346656037ull
+
+//64 bit FNV-1a, continues from the given hash
+uint64_t hashBytes(uint64_t hash, const char* data, size_t size);
+
+//blob file name for given source model, e.g. data/bench/bench.obj -> data/cache/data_bench_bench.obj.mesh
+std::string meshCachePath(const std::string& sourceFile);
+
+//maps the blob of the source model, fails if it is missing, of other version or stale
+bool openMeshCache(const std::string& sourceFile, MeshCache* cache);
+void closeMeshCache(MeshCache* cache);
+
+/**
+ * @brief Converts the source model into its blob, skipped when the blob is up to date.
+ * @param sourceFile  .obj model
+ * @param force       cook even if the content hash did not change
+ * @param cooked      set to true if the blob was (re)written
+ * @return false if the model can not be loaded or the blob written
+ */
+bool cookMesh(const std::string& sourceFile, bool force, bool* cooked);
+
+#endif
@@ -0,0 +1,253 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_cooker.cpp
+ * @date    18/10/2026
+ * @brief   Offline tool converting the OBJ models and textures into binary blobs in data/cache/.
+ *
+ * Usage: mesh_cooker [--force] [--uncompressed] [model.obj | image ...]
+ *        mesh_cooker --rock [--force | --check]
+ * Without arguments all models loaded by the game are cooked, followed by their textures and
+ * the skybox, water and fire images. Textures get a full mip chain and BC1/BC3 compression
+ * in KTX2, --uncompressed stores RGBA8 instead. Run it from the directory the game is started
+ * from, blobs which are up to date are skipped.
+ * --rock writes the hardcoded rock to ROCK_MODEL_NAME, which is linked into the executable
+ * (asteroids.rc, embedded_data.cpp). It is run from the source directory before every build of
+ * the game and skips the blob while cliff_rock_two_obj.h, the cooking switches, the vertex layout
+ * and the blob version are those it was written with. --check only reports a stale blob and fails.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <IL/il.h>
+#include "data.h"
+#include "mesh_cache.h"
+#include "texture_cache.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "embedded_mesh.h"
+#include "cliff_rock_two_obj.h"
+
+//source images as OpenGL gets them from pgr::createTexture - RGBA8, bottom row first
+static bool decodeImage(const std::string& fileName, TextureImage* image) {
+
+    ILuint handle;
+    ilGenImages(1, &handle);
+    ilBindImage(handle);
+
+    bool decoded = ilLoadImage((ILstring)fileName.c_str()) && ilConvertImage(IL_RGBA, IL_UNSIGNED_BYTE);
+    if (decoded) {
+        image->width = (unsigned int)ilGetInteger(IL_IMAGE_WIDTH);
+        image->height = (unsigned int)ilGetInteger(IL_IMAGE_HEIGHT);
+        image->pixels.assign(ilGetData(), ilGetData() + (size_t)image->width * image->height * 4);
+    }
+
+    ilDeleteImages(1, &handle);
+    return decoded;
+}
+
+static const char* formatName(TextureFormat format) {
+
+    if (format == TEXTURE_FORMAT_BC1)
+        return "BC1";
+    if (format == TEXTURE_FORMAT_BC3)
+        return "BC3";
+    return "RGBA8";
+}
+
+static bool isModel(const std::string& fileName) {
+
+    return fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".obj") == 0;
+}
+
+//the rock arrays and every switch that changes what cookRock writes from them
+static uint64_t rockSourceHash() {
+
+    const float switches[] = {
+        COMPACT_VERTICES != 0 ? 1.0f : 0.0f, (float)MESH_MAX_LODS, MESH_LOD_REDUCTION, MESH_LOD_MAX_ERROR,
+        (float)MESH_LOD_MIN_TRIANGLES, (float)VERTEX_CACHE_LRU_SIZE, OVERDRAW_ACMR_THRESHOLD
+    };
+
+    uint64_t hash = hashBytes(HASH_SEED, (const char*)cliff_rock_two_objVertices, 8 * sizeof(float) * cliff_rock_two_objNVertices);
+    hash = hashBytes(hash, (const char*)cliff_rock_two_objTriangles, 3 * sizeof(cliff_rock_two_objTriangles[0]) * cliff_rock_two_objNTriangles);
+    return hashBytes(hash, (const char*)switches, sizeof(switches));
+}
+
+//hardcoded rock, the header has interlaced arrays of 8 floats - position, normal, texture coordinates
+//the material is set by initRockGeometry, the blob has only the geometry
+static bool cookRock(bool force, bool check) {
+
+    const uint64_t sourceHash = rockSourceHash();
+    if (!force && embeddedMeshUpToDate(ROCK_MODEL_NAME, sourceHash)) {
+        std::cout << "up to date  rock -> " << ROCK_MODEL_NAME << std::endl;
+        return true;
+    }
+    if (check) {
+        std::cerr << "STALE       rock -> " << ROCK_MODEL_NAME << ", run mesh_cooker --rock" << std::endl;
+        return false;
+    }
+
+    MeshData mesh;
+    for (int v = 0; v < cliff_rock_two_objNVertices; v++) {
+        const float* vertex = cliff_rock_two_objVertices + 8 * v;
+        mesh.positions.insert(mesh.positions.end(), vertex, vertex + 3);
+        mesh.normals.insert(mesh.normals.end(), vertex + 3, vertex + 6);
+        mesh.texCoords.insert(mesh.texCoords.end(), vertex + 6, vertex + 8);
+    }
+    mesh.indices.assign(cliff_rock_two_objTriangles, cliff_rock_two_objTriangles + 3 * cliff_rock_two_objNTriangles);
+
+    buildMeshLods(&mesh);
+    optimizeMesh(&mesh);
+
+    if (!writeEmbeddedMesh(mesh, COMPACT_VERTICES != 0, sourceHash, ROCK_MODEL_NAME)) {
+        std::cerr << "FAILED      " << ROCK_MODEL_NAME << std::endl;
+        return false;
+    }
+
+    std::cout << "cooked      rock -> " << ROCK_MODEL_NAME << " (" << mesh.positions.size() / 3 << " vertices, "
+              << (mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].numIndices) / 3 << " triangles, " << mesh.lods.size() << " levels)" << std::endl;
+    return true;
+}
+
+static void addUnique(std::vector<std::string>* files, const std::string& fileName) {
+
+    if (std::find(files->begin(), files->end(), fileName) == files->end())
+        files->push_back(fileName);
+}
+
+int main(int argc, char** argv) {
+
+    bool force = false;
+    bool compress = true;
+    bool rock = false;
+    bool check = false;
+    std::vector<std::string> models;
+    std::vector<std::string> textures;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rock") == 0)
+            rock = true;
+        else if (strcmp(argv[i], "--check") == 0)
+            check = true;
+        else if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (strcmp(argv[i], "--uncompressed") == 0)
+            compress = false;
+        else if (isModel(argv[i]))
+            models.push_back(argv[i]);
+        else
+            textures.push_back(argv[i]);
+    }
+
+    if (rock)
+        return cookRock(force, check) ? 0 : 1;
+
+    //everything the game loads, the model textures are added once the models are cooked
+    const bool everything = models.empty() && textures.empty();
+    if (everything) {
+        models.push_back(BENCH_MODEL_NAME);
+        models.push_back(TREE_MODEL_NAME);
+        models.push_back(PLANT_MODEL_NAME);
+        models.push_back(HAT_MODEL_NAME);
+        models.push_back(BROOM_MODEL_NAME);
+        models.push_back(WAND_MODEL_NAME);
+        models.push_back(HALL_MODEL_NAME);
+        models.push_back(EAGLE_MODEL_NAME);
+        models.push_back(FIREPLACE_MODEL_NAME);
+        models.push_back(GROUND_MODEL_NAME);
+
+        for (int i = 0; i < 6; i++) {
+            textures.push_back(std::string(SKYBOX_PREFIX_DAY) + std::to_string(i + 1) + ".png");
+            textures.push_back(std::string(SKYBOX_PREFIX_NIGHT) + std::to_string(i + 1) + ".jpg");
+        }
+        textures.push_back(WATER_TEXTURE_NAME);
+        textures.push_back(FIRE_TEXTURE_NAME);
+        textures.push_back(ROCK_TEXTURE_NAME);
+    }
+
+    int failed = 0;
+
+    for (size_t i = 0; i < models.size(); i++) {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        bool cooked;
+        if (!cookMesh(models[i], force, &cooked)) {
+            std::cerr << "FAILED      " << models[i] << std::endl;
+            failed++;
+            continue;
+        }
+
+        double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << (cooked ? "cooked      " : "up to date  ") << models[i] << " -> " << meshCachePath(models[i])
+                  << " (" << time << " ms)" << std::endl;
+
+        MeshCache cache;
+        if (everything && openMeshCache(models[i], &cache)) {
+            for (size_t m = 0; m < cache.materials.size(); m++) {
+                if (!cache.materials[m].texturePath.empty())
+                    addUnique(&textures, cache.materials[m].texturePath);
+            }
+            closeMeshCache(&cache);
+        }
+    }
+
+    ilInit();
+    ilEnable(IL_ORIGIN_SET);
+    ilOriginFunc(IL_ORIGIN_LOWER_LEFT);
+
+    //what the game spends without the cooked textures, and what both ways take in video memory
+    double decodeTime = 0.0;
+    size_t uncompressedBytes = 0;
+    size_t cookedBytes = 0;
+
+    for (size_t i = 0; i < textures.size(); i++) {
+        // the game does without some of its images, only asked for ones must exist
+        if (everything && !std::ifstream(textures[i].c_str()).good()) {
+            std::cout << "missing     " << textures[i] << std::endl;
+            continue;
+        }
+
+        if (!force && textureCacheUpToDate(textures[i])) {
+            std::cout << "up to date  " << textures[i] << " -> " << textureCachePath(textures[i]) << std::endl;
+            continue;
+        }
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        TextureImage image;
+        if (!decodeImage(textures[i], &image)) {
+            std::cerr << "FAILED      " << textures[i] << " (can not decode)" << std::endl;
+            failed++;
+            continue;
+        }
+        double decoded = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        TextureCookStats stats;
+        if (!writeTextureCache(textures[i], image, compress, &stats)) {
+            std::cerr << "FAILED      " << textures[i] << std::endl;
+            failed++;
+            continue;
+        }
+
+        double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "cooked      " << textures[i] << " -> " << textureCachePath(textures[i]) << " (" << stats.width << "x" << stats.height
+                  << ", " << stats.levels << " levels, " << formatName(stats.format) << ", " << stats.uncompressedBytes / 1024 << " -> "
+                  << stats.bytes / 1024 << " KB, rms error " << stats.error << ", decode " << decoded << " ms, total " << time << " ms)" << std::endl;
+
+        decodeTime += decoded;
+        uncompressedBytes += stats.uncompressedBytes;
+        cookedBytes += stats.bytes;
+    }
+
+    if (cookedBytes > 0) {
+        std::cout << "textures: decode " << decodeTime << " ms no longer spent at startup, video memory "
+                  << uncompressedBytes / (1024.0 * 1024.0) << " MB as RGBA8 with mipmaps -> " << cookedBytes / (1024.0 * 1024.0) << " MB cooked" << std::endl;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
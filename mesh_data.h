@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_data.h
+ * @date    18/10/2026
+ * @brief   CPU side mesh data, produced by the loaders and uploaded to OpenGL.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __MESH_DATA_H
+#define __MESH_DATA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+//levels of detail of a mesh at most, level 0 is the full mesh
+#define MESH_MAX_LODS   4
+
+//Range of the index array drawn for one level of detail, all levels share the vertices
+typedef struct MeshLod {
+  uint32_t  firstIndex;
+  uint32_t  numIndices;
+  float     error;          // model space distance of the level from the full mesh
+} MeshLod;
+
+//Triangles of one material in one level of detail
+typedef struct MeshRange {
+  uint32_t  firstIndex;
+  uint32_t  numIndices;
+} MeshRange;
+
+//Material specifics of a part of the mesh
+typedef struct MeshMaterial {
+  glm::vec3     ambient;
+  glm::vec3     diffuse;
+  glm::vec3     specular;
+  float         shininess;
+  std::string   texturePath;                // empty if the part has no diffuse texture
+} MeshMaterial;
+
+//Mesh as the loaders produce it - planar streams of positions, normals and texture coordinates, interleaved on upload
+typedef struct MeshData {
+  std::vector<float>        positions;      // 3 floats per vertex
+  std::vector<float>        normals;        // 3 floats per vertex
+  std::vector<float>        texCoords;      // 2 floats per vertex
+  std::vector<unsigned int> indices;        // 3 indices per triangle, all levels of detail one after another, each sorted by material
+  std::vector<MeshLod>      lods;           // filled by buildMeshLods, empty = one level with all indices
+
+  std::vector<MeshMaterial> materials;      // at least one, all parts share the vertices
+  std::vector<MeshRange>    ranges;         // ranges[level * materials.size() + material], the loaders fill level 0
+} MeshData;
+
+#endif
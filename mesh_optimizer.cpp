@@ -0,0 +1,337 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_optimizer.cpp
+ * @date    18/10/2026
+ * @brief   Triangle and vertex reordering for the post transform cache, overdraw and vertex fetch.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+#include "mesh_optimizer.h"
+
+//Forsyth's scoring constants
+static const float cacheDecayPower = 1.5f;
+static const float lastTriangleScore = 0.75f;
+static const float valenceBoostScale = 2.0f;
+static const float valenceBoostPower = 0.5f;
+
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int cacheSize) {
+
+    VertexCacheStats stats = { 0.0f, 0.0f };
+    if (numIndices < 3)
+        return stats;
+
+    // vertex is in the FIFO while fewer than cacheSize vertices were added after it
+    std::vector<unsigned int> timestamps(numVertices, 0);
+    std::vector<char> used(numVertices, 0);
+    unsigned int time = cacheSize + 1;
+    size_t misses = 0;
+    size_t usedVertices = 0;
+
+    for (size_t i = 0; i < numIndices; i++) {
+        unsigned int vertex = indices[i];
+        if (time - timestamps[vertex] > cacheSize) {
+            timestamps[vertex] = time++;
+            misses++;
+        }
+        if (!used[vertex]) {
+            used[vertex] = 1;
+            usedVertices++;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(numIndices / 3);
+    stats.atvr = (float)misses / (float)usedVertices;
+    return stats;
+}
+
+//valence boost is tabulated up to this many remaining triangles
+#define VALENCE_TABLE_SIZE      32
+
+//cached vertices score by their age, the last triangle's ones a bit less so strips do not run away
+//vertices with few remaining triangles get a boost to finish them off
+static float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+
+    // powf is the hot spot, both parts are tabulated
+    static float cacheScores[VERTEX_CACHE_LRU_SIZE];
+    static float valenceScores[VALENCE_TABLE_SIZE];
+    static bool tablesReady = false;
+
+    if (!tablesReady) {
+        for (int i = 0; i < VERTEX_CACHE_LRU_SIZE; i++)
+            cacheScores[i] = (i < 3) ? lastTriangleScore : powf(1.0f - (float)(i - 3) / (float)(VERTEX_CACHE_LRU_SIZE - 3), cacheDecayPower);
+        for (int i = 1; i < VALENCE_TABLE_SIZE; i++)
+            valenceScores[i] = valenceBoostScale * powf((float)i, -valenceBoostPower);
+        tablesReady = true;
+    }
+
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = (cachePosition >= 0) ? cacheScores[cachePosition] : 0.0f;
+    if (remainingTriangles < VALENCE_TABLE_SIZE)
+        return score + valenceScores[remainingTriangles];
+    return score + valenceBoostScale * powf((float)remainingTriangles, -valenceBoostPower);
+}
+
+void optimizeVertexCache(std::vector<unsigned int>* indices, size_t numVertices) {
+
+    const size_t numIndices = indices->size();
+    const size_t numTriangles = numIndices / 3;
+    if (numTriangles == 0)
+        return;
+
+    // triangles of every vertex, the not yet emitted ones are kept at the front of its range
+    std::vector<unsigned int> remaining(numVertices, 0);
+    for (size_t i = 0; i < numIndices; i++)
+        remaining[(*indices)[i]]++;
+
+    std::vector<unsigned int> adjacencyOffset(numVertices + 1, 0);
+    for (size_t v = 0; v < numVertices; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(numIndices);
+    std::vector<unsigned int> cursor(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t i = 0; i < numIndices; i++)
+        adjacency[cursor[(*indices)[i]]++] = (unsigned int)(i / 3);
+
+    std::vector<int> cachePosition(numVertices, -1);
+    std::vector<float> score(numVertices);
+    for (size_t v = 0; v < numVertices; v++)
+        score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(numTriangles);
+    for (size_t t = 0; t < numTriangles; t++)
+        triangleScore[t] = score[(*indices)[3 * t]] + score[(*indices)[3 * t + 1]] + score[(*indices)[3 * t + 2]];
+
+    std::vector<char> emitted(numTriangles, 0);
+    std::vector<unsigned int> result;
+    result.reserve(numIndices);
+
+    unsigned int cache[VERTEX_CACHE_LRU_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t nextUnemitted = 0;
+    long long bestTriangle = -1;
+
+    while (result.size() < numIndices) {
+
+        // nothing in the cache has triangles left, continue with the next one in the input order
+        if (bestTriangle < 0) {
+            while (emitted[nextUnemitted])
+                nextUnemitted++;
+            bestTriangle = (long long)nextUnemitted;
+        }
+
+        const unsigned int* triangle = &(*indices)[3 * bestTriangle];
+        emitted[bestTriangle] = 1;
+
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int vertex = triangle[corner];
+            result.push_back(vertex);
+
+            // move the triangle behind the ones still waiting
+            unsigned int* begin = &adjacency[adjacencyOffset[vertex]];
+            unsigned int* last = begin + remaining[vertex] - 1;
+            *std::find(begin, last + 1, (unsigned int)bestTriangle) = *last;
+            remaining[vertex]--;
+        }
+
+        // new LRU order - the triangle first, then the old entries, the ones past the end fall out
+        unsigned int newCache[VERTEX_CACHE_LRU_SIZE + 3];
+        size_t newCount = 0;
+        for (int corner = 0; corner < 3; corner++) {
+            if (std::find(newCache, newCache + newCount, triangle[corner]) == newCache + newCount)
+                newCache[newCount++] = triangle[corner];
+        }
+        for (size_t i = 0; i < cacheCount; i++) {
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                newCache[newCount++] = cache[i];
+        }
+
+        for (size_t i = 0; i < newCount; i++) {
+            unsigned int vertex = newCache[i];
+            cachePosition[vertex] = (i < VERTEX_CACHE_LRU_SIZE) ? (int)i : -1;
+            score[vertex] = vertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        // only triangles around the changed vertices change their score
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < newCount; i++) {
+            unsigned int vertex = newCache[i];
+            for (unsigned int a = 0; a < remaining[vertex]; a++) {
+                unsigned int t = adjacency[adjacencyOffset[vertex] + a];
+                triangleScore[t] = score[(*indices)[3 * t]] + score[(*indices)[3 * t + 1]] + score[(*indices)[3 * t + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, (size_t)VERTEX_CACHE_LRU_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+
+    indices->swap(result);
+}
+
+//Run of triangles sorted as a whole by the overdraw order
+typedef struct TriangleCluster {
+  size_t    first;      // index of the first triangle
+  size_t    count;
+  float     key;        // how much the cluster faces away from the mesh center
+} TriangleCluster;
+
+void optimizeOverdraw(std::vector<unsigned int>* indices, const std::vector<float>& positions, float threshold) {
+
+    const size_t numIndices = indices->size();
+    const size_t numTriangles = numIndices / 3;
+    const size_t numVertices = positions.size() / 3;
+    if (numTriangles < 2)
+        return;
+
+    // cluster boundaries where the FIFO misses all three vertices
+    std::vector<TriangleCluster> clusters;
+    std::vector<unsigned int> timestamps(numVertices, 0);
+    unsigned int time = VERTEX_CACHE_FIFO_SIZE + 1;
+
+    for (size_t t = 0; t < numTriangles; t++) {
+        int misses = 0;
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int vertex = (*indices)[3 * t + corner];
+            if (time - timestamps[vertex] > VERTEX_CACHE_FIFO_SIZE) {
+                timestamps[vertex] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            TriangleCluster cluster = { t, 0, 0.0f };
+            clusters.push_back(cluster);
+        }
+        clusters.back().count++;
+    }
+
+    if (clusters.size() < 2)
+        return;
+
+    // area weighted centroids and normals, the mesh center first
+    const float* p = positions.data();
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> triangleCenters(numTriangles);
+    std::vector<glm::vec3> triangleNormals(numTriangles);
+
+    for (size_t t = 0; t < numTriangles; t++) {
+        const unsigned int* triangle = &(*indices)[3 * t];
+        glm::vec3 a(p[3 * triangle[0]], p[3 * triangle[0] + 1], p[3 * triangle[0] + 2]);
+        glm::vec3 b(p[3 * triangle[1]], p[3 * triangle[1] + 1], p[3 * triangle[1] + 2]);
+        glm::vec3 c(p[3 * triangle[2]], p[3 * triangle[2] + 1], p[3 * triangle[2] + 2]);
+
+        triangleNormals[t] = glm::cross(b - a, c - a);     // length is twice the area
+        triangleCenters[t] = (a + b + c) * (1.0f / 3.0f);
+
+        float area = glm::length(triangleNormals[t]);
+        meshCenter += triangleCenters[t] * area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCenter = meshCenter * (1.0f / meshArea);
+
+    for (size_t i = 0; i < clusters.size(); i++) {
+        TriangleCluster& cluster = clusters[i];
+        glm::vec3 center(0.0f), normal(0.0f);
+        float area = 0.0f;
+
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; t++) {
+            float triangleArea = glm::length(triangleNormals[t]);
+            center += triangleCenters[t] * triangleArea;
+            normal += triangleNormals[t];
+            area += triangleArea;
+        }
+
+        float normalLength = glm::length(normal);
+        if (area > 0.0f && normalLength > 0.0f)
+            cluster.key = glm::dot(center * (1.0f / area) - meshCenter, normal * (1.0f / normalLength));
+    }
+
+    // outwards facing clusters occlude the rest of the mesh, draw them first
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const TriangleCluster& a, const TriangleCluster& b) { return a.key > b.key; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(numIndices);
+    for (size_t i = 0; i < clusters.size(); i++)
+        sorted.insert(sorted.end(), indices->begin() + 3 * clusters[i].first, indices->begin() + 3 * (clusters[i].first + clusters[i].count));
+
+    VertexCacheStats before = analyzeVertexCache(indices->data(), numIndices, numVertices, VERTEX_CACHE_FIFO_SIZE);
+    VertexCacheStats after = analyzeVertexCache(sorted.data(), numIndices, numVertices, VERTEX_CACHE_FIFO_SIZE);
+
+    if (after.acmr <= before.acmr * threshold)
+        indices->swap(sorted);
+}
+
+void optimizeVertexFetch(MeshData* mesh) {
+
+    const size_t numVertices = mesh->positions.size() / 3;
+    const bool hasTexCoords = mesh->texCoords.size() == 2 * numVertices;
+
+    std::vector<unsigned int> remap(numVertices, ~0u);
+    unsigned int nextVertex = 0;
+
+    for (size_t i = 0; i < mesh->indices.size(); i++) {
+        unsigned int& index = mesh->indices[i];
+        if (remap[index] == ~0u)
+            remap[index] = nextVertex++;
+        index = remap[index];
+    }
+
+    std::vector<float> positions(3 * nextVertex), normals(3 * nextVertex), texCoords(hasTexCoords ? 2 * nextVertex : 0);
+
+    for (size_t v = 0; v < numVertices; v++) {
+        unsigned int target = remap[v];
+        if (target == ~0u)
+            continue;
+
+        for (int c = 0; c < 3; c++) {
+            positions[3 * target + c] = mesh->positions[3 * v + c];
+            normals[3 * target + c] = mesh->normals[3 * v + c];
+        }
+        if (hasTexCoords) {
+            texCoords[2 * target] = mesh->texCoords[2 * v];
+            texCoords[2 * target + 1] = mesh->texCoords[2 * v + 1];
+        }
+    }
+
+    mesh->positions.swap(positions);
+    mesh->normals.swap(normals);
+    mesh->texCoords.swap(texCoords);
+}
+
+void optimizeMesh(MeshData* mesh) {
+
+    const size_t numVertices = mesh->positions.size() / 3;
+
+    std::vector<MeshRange> ranges = mesh->ranges;
+    if (ranges.empty()) {
+        MeshRange all = { 0, (uint32_t)mesh->indices.size() };
+        ranges.push_back(all);
+    }
+    // ranges of level 0 come first
+    const size_t numLevels = std::max(mesh->lods.size(), (size_t)1);
+    const size_t numMaterials = ranges.size() / numLevels;
+
+    // every material of every level is drawn on its own, each range is ordered separately, overdraw matters up close only
+    std::vector<unsigned int> range;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        std::vector<unsigned int>::iterator first = mesh->indices.begin() + ranges[i].firstIndex;
+        range.assign(first, first + ranges[i].numIndices);
+        optimizeVertexCache(&range, numVertices);
+        if (i < numMaterials)
+            optimizeOverdraw(&range, mesh->positions, OVERDRAW_ACMR_THRESHOLD);
+        std::copy(range.begin(), range.end(), first);
+    }
+    // the full level comes first, the coarser ones reuse its vertices
+    optimizeVertexFetch(mesh);
+}
@@ -0,0 +1,51 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_optimizer.h
+ * @date    18/10/2026
+ * @brief   Triangle and vertex reordering for the post transform cache, overdraw and vertex fetch.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __MESH_OPTIMIZER_H
+#define __MESH_OPTIMIZER_H
+
+#include <vector>
+#include "mesh_data.h"
+
+//LRU cache the triangle order is optimized for
+#define VERTEX_CACHE_LRU_SIZE   32
+//FIFO cache of the statistics, smaller than the optimized one to stay on the safe side
+#define VERTEX_CACHE_FIFO_SIZE  16
+//overdraw order is kept only if the ACMR grows at most this much
+#define OVERDRAW_ACMR_THRESHOLD 1.05f
+
+//Vertex shader invocations per triangle (ACMR, 0.5 .. 3) and per used vertex (ATVR, 1 is ideal)
+typedef struct VertexCacheStats {
+  float     acmr;
+  float     atvr;
+} VertexCacheStats;
+
+//simulates a FIFO post transform cache of given size over the indices
+VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t numIndices, size_t numVertices, unsigned int cacheSize);
+
+//reorders triangles for the post transform cache (Forsyth's linear speed optimization)
+void optimizeVertexCache(std::vector<unsigned int>* indices, size_t numVertices);
+
+/**
+ * @brief Sorts clusters of triangles so that the ones facing outwards are drawn first.
+ *
+ * Clusters start where the cache order already misses all three vertices, so the vertex cache
+ * barely suffers. The order is dropped if the ACMR grows more than the threshold.
+ *
+ * @param positions  3 floats per vertex
+ */
+void optimizeOverdraw(std::vector<unsigned int>* indices, const std::vector<float>& positions, float threshold);
+
+//renumbers vertices in the order the indices first use them, unused vertices are dropped
+void optimizeVertexFetch(MeshData* mesh);
+
+//vertex cache, overdraw and vertex fetch in this order, per material range of every level of detail
+//runs on the CPU side data before the upload
+void optimizeMesh(MeshData* mesh);
+
+#endif
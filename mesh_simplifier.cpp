@@ -0,0 +1,397 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_simplifier.cpp
+ * @date    18/10/2026
+ * @brief   Quadric error edge collapse building index only levels of detail over the shared vertices.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include "mesh_simplifier.h"
+
+//boundary edges are held in place by a plane perpendicular to the surface, this much stronger than the surface
+#define BOUNDARY_WEIGHT         10.0
+//a level has to drop at least this fraction of the previous one's triangles to be kept
+#define MESH_LOD_MIN_SAVING     0.2f
+
+//Symmetric 4x4 plane quadric, sum of squared distances to the planes
+typedef struct Quadric {
+  double    a2, ab, ac, ad;
+  double    b2, bc, bd;
+  double    c2, cd;
+  double    d2;
+  double    weight;         // area of the surface planes, the error is averaged over it
+} Quadric;
+
+//Edge collapse of a position group into another one, the target keeps its position
+typedef struct Collapse {
+  unsigned int  source;
+  unsigned int  target;
+  double        cost;
+} Collapse;
+
+static void addPlane(Quadric* q, const glm::dvec3& normal, double d, double weight, double area) {
+
+    q->a2 += weight * normal.x * normal.x;
+    q->ab += weight * normal.x * normal.y;
+    q->ac += weight * normal.x * normal.z;
+    q->ad += weight * normal.x * d;
+    q->b2 += weight * normal.y * normal.y;
+    q->bc += weight * normal.y * normal.z;
+    q->bd += weight * normal.y * d;
+    q->c2 += weight * normal.z * normal.z;
+    q->cd += weight * normal.z * d;
+    q->d2 += weight * d * d;
+    q->weight += area;
+}
+
+static void addQuadric(Quadric* q, const Quadric& other) {
+
+    q->a2 += other.a2; q->ab += other.ab; q->ac += other.ac; q->ad += other.ad;
+    q->b2 += other.b2; q->bc += other.bc; q->bd += other.bd;
+    q->c2 += other.c2; q->cd += other.cd;
+    q->d2 += other.d2;
+    q->weight += other.weight;
+}
+
+//squared distance to the planes at p, averaged over their area
+static double quadricError(const Quadric& q, const glm::dvec3& p) {
+
+    double error = q.a2 * p.x * p.x + 2.0 * q.ab * p.x * p.y + 2.0 * q.ac * p.x * p.z + 2.0 * q.ad * p.x
+                 + q.b2 * p.y * p.y + 2.0 * q.bc * p.y * p.z + 2.0 * q.bd * p.y
+                 + q.c2 * p.z * p.z + 2.0 * q.cd * p.z
+                 + q.d2;
+
+    return std::max(error, 0.0) / std::max(q.weight, 1e-12);
+}
+
+static glm::dvec3 vertexPosition(const std::vector<float>& positions, unsigned int vertex) {
+    return glm::dvec3(positions[3 * vertex], positions[3 * vertex + 1], positions[3 * vertex + 2]);
+}
+
+static glm::vec3 vertexVector(const std::vector<float>& values, unsigned int vertex) {
+    return glm::vec3(values[3 * vertex], values[3 * vertex + 1], values[3 * vertex + 2]);
+}
+
+//every vertex gets the lowest index of the vertices at the same position
+static void weldPositions(const std::vector<float>& positions, std::vector<unsigned int>* groups) {
+
+    const size_t numVertices = positions.size() / 3;
+    std::vector<unsigned int> order(numVertices);
+    for (size_t v = 0; v < numVertices; v++)
+        order[v] = (unsigned int)v;
+
+    const float* p = positions.data();
+    auto less = [p](unsigned int a, unsigned int b) {
+        if (p[3 * a] != p[3 * b]) return p[3 * a] < p[3 * b];
+        if (p[3 * a + 1] != p[3 * b + 1]) return p[3 * a + 1] < p[3 * b + 1];
+        if (p[3 * a + 2] != p[3 * b + 2]) return p[3 * a + 2] < p[3 * b + 2];
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    groups->resize(numVertices);
+    for (size_t i = 0; i < numVertices; i++) {
+        unsigned int v = order[i];
+        bool same = i > 0 && p[3 * v] == p[3 * order[i - 1]] && p[3 * v + 1] == p[3 * order[i - 1] + 1] && p[3 * v + 2] == p[3 * order[i - 1] + 2];
+        (*groups)[v] = same ? (*groups)[order[i - 1]] : v;
+    }
+}
+
+static uint64_t edgeKey(unsigned int a, unsigned int b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+//surface planes of the triangles and side planes of the boundary edges
+static void computeQuadrics(const std::vector<float>& positions, const std::vector<unsigned int>& groups,
+                            const std::vector<unsigned int>& indices, std::vector<Quadric>* quadrics) {
+
+    const Quadric zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    quadrics->assign(groups.size(), zero);
+
+    std::unordered_map<uint64_t, int> edgeUses;
+    edgeUses.reserve(indices.size());
+
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        unsigned int corner[3] = { groups[indices[t]], groups[indices[t + 1]], groups[indices[t + 2]] };
+        glm::dvec3 a = vertexPosition(positions, corner[0]);
+        glm::dvec3 normal = glm::cross(vertexPosition(positions, corner[1]) - a, vertexPosition(positions, corner[2]) - a);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+
+        normal = normal * (1.0 / length);
+        double area = 0.5 * length;
+        for (int c = 0; c < 3; c++) {
+            addPlane(&(*quadrics)[corner[c]], normal, -glm::dot(normal, a), area, area);
+            edgeUses[edgeKey(corner[c], corner[(c + 1) % 3])]++;
+        }
+    }
+
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        unsigned int corner[3] = { groups[indices[t]], groups[indices[t + 1]], groups[indices[t + 2]] };
+        glm::dvec3 a = vertexPosition(positions, corner[0]);
+        glm::dvec3 normal = glm::cross(vertexPosition(positions, corner[1]) - a, vertexPosition(positions, corner[2]) - a);
+        if (glm::length(normal) == 0.0)
+            continue;
+
+        for (int c = 0; c < 3; c++) {
+            unsigned int from = corner[c];
+            unsigned int to = corner[(c + 1) % 3];
+            if (edgeUses[edgeKey(from, to)] != 1)
+                continue;
+
+            glm::dvec3 edge = vertexPosition(positions, to) - vertexPosition(positions, from);
+            glm::dvec3 side = glm::cross(edge, normal);
+            double sideLength = glm::length(side);
+            if (sideLength == 0.0)
+                continue;
+
+            side = side * (1.0 / sideLength);
+            double weight = BOUNDARY_WEIGHT * glm::dot(edge, edge);
+            double d = -glm::dot(side, vertexPosition(positions, from));
+            addPlane(&(*quadrics)[from], side, d, weight, 0.0);
+            addPlane(&(*quadrics)[to], side, d, weight, 0.0);
+        }
+    }
+}
+
+//triangles around every position group, triangles[offsets[g] .. offsets[g + 1]]
+static void buildAdjacency(const std::vector<unsigned int>& groups, const std::vector<unsigned int>& indices,
+                           std::vector<unsigned int>* offsets, std::vector<unsigned int>* triangles) {
+
+    offsets->assign(groups.size() + 1, 0);
+    for (size_t i = 0; i < indices.size(); i++)
+        (*offsets)[groups[indices[i]] + 1]++;
+    for (size_t g = 0; g < groups.size(); g++)
+        (*offsets)[g + 1] += (*offsets)[g];
+
+    std::vector<unsigned int> fill(offsets->begin(), offsets->end() - 1);
+    triangles->resize(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+        (*triangles)[fill[groups[indices[i]]]++] = (unsigned int)(i / 3);
+}
+
+//true if moving source onto target turns none of the remaining triangles around source over
+static bool collapseKeepsOrientation(const std::vector<float>& positions, const std::vector<unsigned int>& groups,
+                                     const std::vector<unsigned int>& indices, const unsigned int* triangles, size_t numTriangles,
+                                     unsigned int source, unsigned int target) {
+
+    const glm::dvec3 targetPosition = vertexPosition(positions, target);
+
+    for (size_t i = 0; i < numTriangles; i++) {
+        const unsigned int* triangle = &indices[3 * triangles[i]];
+        unsigned int corner[3] = { groups[triangle[0]], groups[triangle[1]], groups[triangle[2]] };
+        if (corner[0] == target || corner[1] == target || corner[2] == target)
+            continue;   // removed by the collapse
+
+        glm::dvec3 before[3], after[3];
+        for (int c = 0; c < 3; c++) {
+            before[c] = vertexPosition(positions, corner[c]);
+            after[c] = corner[c] == source ? targetPosition : before[c];
+        }
+
+        glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+        if (glm::dot(normalBefore, normalAfter) <= 0.0)
+            return false;
+    }
+    return true;
+}
+
+void simplifyMesh(const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<unsigned int>& indices,
+                  size_t targetIndices, float maxError, std::vector<unsigned int>* result, float* error) {
+
+    const size_t numVertices = positions.size() / 3;
+    *result = indices;
+    *error = 0.0f;
+
+    std::vector<unsigned int> groups;
+    weldPositions(positions, &groups);
+
+    // vertices of each position group, a corner moved to another group picks the closest normal among them
+    std::vector<unsigned int> groupFirst(numVertices, ~0u), groupNext(numVertices, ~0u);
+    for (size_t v = numVertices; v-- > 0; ) {
+        groupNext[v] = groupFirst[groups[v]];
+        groupFirst[groups[v]] = (unsigned int)v;
+    }
+
+    std::vector<Quadric> quadrics;
+    computeQuadrics(positions, groups, indices, &quadrics);
+
+    const double maxCost = (double)maxError * (double)maxError;
+    std::vector<unsigned int> offsets, triangles;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> collapseTarget(numVertices);
+    std::vector<char> locked(numVertices);
+
+    // every pass collapses the cheapest edges that do not touch each other, then rebuilds the triangles
+    while (result->size() > targetIndices) {
+        buildAdjacency(groups, *result, &offsets, &triangles);
+
+        collapses.clear();
+        for (size_t t = 0; t < result->size(); t += 3) {
+            for (int c = 0; c < 3; c++) {
+                unsigned int a = groups[(*result)[t + c]];
+                unsigned int b = groups[(*result)[t + (c + 1) % 3]];
+                if (a == b)
+                    continue;
+
+                // merged quadric evaluated at either end, the cheaper direction wins
+                Quadric merged = quadrics[a];
+                addQuadric(&merged, quadrics[b]);
+                double costToA = quadricError(merged, vertexPosition(positions, a));
+                double costToB = quadricError(merged, vertexPosition(positions, b));
+                Collapse collapse = { costToA < costToB ? b : a, costToA < costToB ? a : b, std::min(costToA, costToB) };
+                if (collapse.cost <= maxCost)
+                    collapses.push_back(collapse);
+            }
+        }
+        if (collapses.empty())
+            break;
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        for (size_t v = 0; v < numVertices; v++) {
+            collapseTarget[v] = (unsigned int)v;
+            locked[v] = 0;
+        }
+
+        // each collapse removes about two triangles
+        const size_t trianglesToRemove = (result->size() - targetIndices) / 3;
+        size_t removedTriangles = 0;
+        double passCost = 0.0;
+
+        for (size_t i = 0; i < collapses.size() && removedTriangles < trianglesToRemove; i++) {
+            const Collapse& collapse = collapses[i];
+            if (locked[collapse.source] || locked[collapse.target])
+                continue;
+
+            const unsigned int* sourceTriangles = &triangles[offsets[collapse.source]];
+            const size_t numSourceTriangles = offsets[collapse.source + 1] - offsets[collapse.source];
+            if (!collapseKeepsOrientation(positions, groups, *result, sourceTriangles, numSourceTriangles, collapse.source, collapse.target))
+                continue;
+
+            collapseTarget[collapse.source] = collapse.target;
+            addQuadric(&quadrics[collapse.target], quadrics[collapse.source]);
+            passCost = std::max(passCost, collapse.cost);
+
+            // the neighbourhood of both ends changes, it waits for the next pass
+            const unsigned int ends[2] = { collapse.source, collapse.target };
+            for (int e = 0; e < 2; e++) {
+                for (unsigned int k = offsets[ends[e]]; k < offsets[ends[e] + 1]; k++) {
+                    const unsigned int* triangle = &(*result)[3 * triangles[k]];
+                    bool removed = false;
+                    for (int c = 0; c < 3; c++) {
+                        locked[groups[triangle[c]]] = 1;
+                        removed = removed || (e == 0 && groups[triangle[c]] == collapse.target);
+                    }
+                    if (removed)
+                        removedTriangles++;
+                }
+            }
+        }
+        if (removedTriangles == 0)
+            break;
+
+        *error = std::max(*error, (float)sqrt(passCost));
+
+        // move the corners of collapsed groups, degenerate triangles are dropped
+        std::vector<unsigned int> simplified;
+        simplified.reserve(result->size());
+        for (size_t t = 0; t < result->size(); t += 3) {
+            unsigned int triangle[3];
+            for (int c = 0; c < 3; c++) {
+                unsigned int vertex = (*result)[t + c];
+                unsigned int target = collapseTarget[groups[vertex]];
+                if (target != groups[vertex]) {
+                    glm::vec3 normal = vertexVector(normals, vertex);
+                    unsigned int best = target;
+                    float bestDot = -2.0f;
+                    for (unsigned int candidate = groupFirst[target]; candidate != ~0u; candidate = groupNext[candidate]) {
+                        float d = glm::dot(normal, vertexVector(normals, candidate));
+                        if (d > bestDot) {
+                            bestDot = d;
+                            best = candidate;
+                        }
+                    }
+                    vertex = best;
+                }
+                triangle[c] = vertex;
+            }
+
+            if (groups[triangle[0]] == groups[triangle[1]] || groups[triangle[1]] == groups[triangle[2]] || groups[triangle[0]] == groups[triangle[2]])
+                continue;
+            simplified.insert(simplified.end(), triangle, triangle + 3);
+        }
+        result->swap(simplified);
+    }
+}
+
+void buildMeshLods(MeshData* mesh) {
+
+    mesh->lods.clear();
+    const size_t numVertices = mesh->positions.size() / 3;
+    if (numVertices == 0 || mesh->indices.empty())
+        return;
+
+    if (mesh->ranges.empty()) {
+        MeshRange all = { 0, (uint32_t)mesh->indices.size() };
+        mesh->ranges.push_back(all);
+    }
+    const size_t numMaterials = mesh->ranges.size();
+
+    MeshLod full = { 0, (uint32_t)mesh->indices.size(), 0.0f };
+    mesh->lods.push_back(full);
+
+    glm::vec3 boundsMin = vertexVector(mesh->positions, 0);
+    glm::vec3 boundsMax = boundsMin;
+    for (size_t v = 1; v < numVertices; v++) {
+        boundsMin = glm::min(boundsMin, vertexVector(mesh->positions, (unsigned int)v));
+        boundsMax = glm::max(boundsMax, vertexVector(mesh->positions, (unsigned int)v));
+    }
+    const float maxError = MESH_LOD_MAX_ERROR * glm::length(boundsMax - boundsMin);
+
+    // every level simplifies each material of the previous one on its own, material borders are
+    // boundaries and stay in place, the errors of the levels add up
+    std::vector<unsigned int> part, simplified, level;
+    std::vector<MeshRange> levelRanges;
+    float error = 0.0f;
+
+    while (mesh->lods.size() < MESH_MAX_LODS && error < maxError) {
+        const MeshLod& previous = mesh->lods.back();
+        if ((size_t)((float)(previous.numIndices / 3) * MESH_LOD_REDUCTION) < MESH_LOD_MIN_TRIANGLES)
+            break;
+
+        const uint32_t levelStart = (uint32_t)mesh->indices.size();
+        const MeshRange* previousRanges = &mesh->ranges[(mesh->lods.size() - 1) * numMaterials];
+        float levelError = 0.0f;
+        level.clear();
+        levelRanges.clear();
+
+        for (size_t m = 0; m < numMaterials; m++) {
+            part.assign(mesh->indices.begin() + previousRanges[m].firstIndex,
+                        mesh->indices.begin() + previousRanges[m].firstIndex + previousRanges[m].numIndices);
+            size_t targetTriangles = (size_t)((float)(part.size() / 3) * MESH_LOD_REDUCTION);
+
+            float partError = 0.0f;
+            simplifyMesh(mesh->positions, mesh->normals, part, 3 * targetTriangles, maxError - error, &simplified, &partError);
+
+            MeshRange range = { levelStart + (uint32_t)level.size(), (uint32_t)simplified.size() };
+            levelRanges.push_back(range);
+            level.insert(level.end(), simplified.begin(), simplified.end());
+            levelError = std::max(levelError, partError);
+        }
+
+        if ((float)level.size() > (1.0f - MESH_LOD_MIN_SAVING) * (float)previous.numIndices)
+            break;
+
+        error += levelError;
+        MeshLod lod = { levelStart, (uint32_t)level.size(), error };
+        mesh->indices.insert(mesh->indices.end(), level.begin(), level.end());
+        mesh->ranges.insert(mesh->ranges.end(), levelRanges.begin(), levelRanges.end());
+        mesh->lods.push_back(lod);
+    }
+}
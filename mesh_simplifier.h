@@ -0,0 +1,40 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    mesh_simplifier.h
+ * @date    18/10/2026
+ * @brief   Quadric error edge collapse building index only levels of detail over the shared vertices.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __MESH_SIMPLIFIER_H
+#define __MESH_SIMPLIFIER_H
+
+#include <vector>
+#include "mesh_data.h"
+
+//each level aims at this fraction of the triangles of the previous one
+#define MESH_LOD_REDUCTION      0.5f
+//largest error of a level relative to the mesh box diagonal, coarser levels are not built
+#define MESH_LOD_MAX_ERROR      0.05f
+//levels are not built below this many triangles
+#define MESH_LOD_MIN_TRIANGLES  64
+
+/**
+ * @brief Collapses edges until at most targetIndices indices are left or the next collapse would exceed maxError.
+ *
+ * Vertices with the same position are collapsed together, so UV and normal seams do not stop the
+ * simplification. Vertices never move, the result indexes the same vertex arrays as the input.
+ *
+ * @param positions  3 floats per vertex
+ * @param normals    3 floats per vertex, pick the vertex on the other side of a seam
+ * @param maxError   model space distance
+ * @param error      set to the error of the simplified surface, model space distance
+ */
+void simplifyMesh(const std::vector<float>& positions, const std::vector<float>& normals, const std::vector<unsigned int>& indices,
+                  size_t targetIndices, float maxError, std::vector<unsigned int>* result, float* error);
+
+//fills mesh->lods with up to MESH_MAX_LODS levels, the coarser ones are appended to the indices
+//each material is simplified on its own and gets its range in every level
+void buildMeshLods(MeshData* mesh);
+
+#endif
@@ -0,0 +1,90 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    number_parser.cpp
+ * @date    18/10/2026
+ * @brief   Locale independent number parsing of text that is not null terminated (OBJ, MTL and XML files).
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cstdint>
+#include "number_parser.h"
+
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const char* parseFloat(const char* p, const char* end, float* value) {
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    while (p < end && isDigit(*p)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0)
+                digits++;
+        }
+        else {
+            exponent++;
+        }
+        ++p;
+    }
+
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0)
+                    digits++;
+                exponent--;
+            }
+            ++p;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            ++p;
+        }
+        int e = 0;
+        while (p < end && isDigit(*p)) {
+            if (e < 1000)
+                e = e * 10 + (*p - '0');
+            ++p;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    double result = (double)mantissa;
+    while (exponent > 22) {
+        result *= 1e22;
+        exponent -= 22;
+    }
+    while (exponent < -22) {
+        result /= 1e22;
+        exponent += 22;
+    }
+    result = exponent >= 0 ? result * powersOfTen[exponent] : result / powersOfTen[-exponent];
+
+    *value = (float)(negative ? -result : result);
+    return p;
+}
@@ -0,0 +1,21 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    number_parser.h
+ * @date    18/10/2026
+ * @brief   Locale independent number parsing of text that is not null terminated (OBJ, MTL and XML files).
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __NUMBER_PARSER_H
+#define __NUMBER_PARSER_H
+
+/**
+ * @brief Parses a decimal float, much faster than strtof.
+ *
+ * Leading spaces and tabs are skipped, the mantissa keeps 19 significant digits.
+ *
+ * @return position just after the number, value is 0 if there are no digits
+ */
+const char* parseFloat(const char* p, const char* end, float* value);
+
+#endif
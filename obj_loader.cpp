@@ -0,0 +1,625 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    obj_loader.cpp
+ * @date    18/10/2026
+ * @brief   Native Wavefront OBJ/MTL loader - memory mapped, chunked and multi-threaded.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <thread>
+#include "obj_loader.h"
+#include "mapped_file.h"
+#include "number_parser.h"
+
+//smallest part of the file given to one parsing thread
+#define OBJ_MIN_CHUNK_SIZE  (256 * 1024)
+
+//one face corner, indices into the global position/uv/normal arrays (-1 if missing)
+typedef struct ObjCorner {
+    int v;
+    int vt;
+    int vn;
+} ObjCorner;
+
+//part of the file parsed by one thread
+typedef struct ObjChunk {
+    const char* begin;
+    const char* end;
+
+    //counted in the first pass, turned into global offsets before the second one
+    size_t numPositions;
+    size_t numTexCoords;
+    size_t numNormals;
+    size_t basePosition;
+    size_t baseTexCoord;
+    size_t baseNormal;
+
+    std::vector<ObjCorner> corners;     // already triangulated, 3 corners per triangle
+
+    std::string materialLibrary;        // first mtllib in the chunk
+    std::vector<std::string> materials; // usemtl names in the order of first use
+    std::vector<int> triangleMaterials; // index into materials, -1 = material of the previous chunk continues
+    int         lastMaterial;           // material at the end of the chunk, -1 if the chunk has no usemtl
+    bool        badIndex;
+} ObjChunk;
+
+static inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    return p;
+}
+
+//returns end of the current line (points to '\n' or end)
+static inline const char* findLineEnd(const char* p, const char* end) {
+    const char* newLine = (const char*)memchr(p, '\n', end - p);
+    return newLine != NULL ? newLine : end;
+}
+
+static const char* parseInt(const char* p, const char* end, int* value) {
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    int result = 0;
+    while (p < end && isDigit(*p)) {
+        result = result * 10 + (*p - '0');
+        ++p;
+    }
+
+    *value = negative ? -result : result;
+    return p;
+}
+
+//rest of the line without leading and trailing white space
+static std::string lineArgument(const char* p, const char* lineEnd) {
+
+    p = skipSpaces(p, lineEnd);
+    while (lineEnd > p && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t' || lineEnd[-1] == '\r'))
+        --lineEnd;
+
+    return std::string(p, lineEnd - p);
+}
+
+static inline bool startsWith(const char* p, const char* lineEnd, const char* keyword, size_t length) {
+    return (size_t)(lineEnd - p) > length && memcmp(p, keyword, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+}
+
+//first pass - counts v, vt and vn lines so that every chunk knows its global offsets
+static void countChunk(ObjChunk* chunk) {
+
+    chunk->numPositions = chunk->numTexCoords = chunk->numNormals = 0;
+
+    const char* p = chunk->begin;
+    while (p < chunk->end) {
+        const char* lineEnd = findLineEnd(p, chunk->end);
+        p = skipSpaces(p, lineEnd);
+
+        if (lineEnd - p > 2 && p[0] == 'v') {
+            if (p[1] == ' ' || p[1] == '\t')
+                chunk->numPositions++;
+            else if (p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+                chunk->numTexCoords++;
+            else if (p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+                chunk->numNormals++;
+        }
+        p = lineEnd + 1;
+    }
+}
+
+//turns OBJ index (1 based or negative = relative) into global 0 based index, -1 if out of range
+static inline int resolveIndex(int index, size_t base, size_t localCount, size_t total) {
+
+    long long resolved;
+    if (index > 0)
+        resolved = (long long)index - 1;
+    else if (index < 0)
+        resolved = (long long)(base + localCount) + index;
+    else
+        return -1;
+
+    return (resolved >= 0 && resolved < (long long)total) ? (int)resolved : -1;
+}
+
+//second pass - parses attributes straight into the global arrays and collects triangulated faces
+static void parseChunk(ObjChunk* chunk, float* positions, float* texCoords, float* normals,
+                       size_t totalPositions, size_t totalTexCoords, size_t totalNormals) {
+
+    size_t localPositions = 0;
+    size_t localTexCoords = 0;
+    size_t localNormals = 0;
+
+    chunk->badIndex = false;
+    chunk->lastMaterial = -1;
+    chunk->corners.reserve(chunk->numPositions * 6);
+
+    std::vector<ObjCorner> polygon;
+
+    const char* p = chunk->begin;
+    while (p < chunk->end) {
+        const char* lineEnd = findLineEnd(p, chunk->end);
+        p = skipSpaces(p, lineEnd);
+
+        if (lineEnd - p <= 2) {
+            p = lineEnd + 1;
+            continue;
+        }
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            float* out = positions + 3 * (chunk->basePosition + localPositions++);
+            p = parseFloat(p + 1, lineEnd, out + 0);
+            p = parseFloat(p, lineEnd, out + 1);
+            parseFloat(p, lineEnd, out + 2);
+        }
+        else if (p[0] == 'v' && p[1] == 't' && lineEnd - p > 2 && (p[2] == ' ' || p[2] == '\t')) {
+            float* out = texCoords + 2 * (chunk->baseTexCoord + localTexCoords++);
+            p = parseFloat(p + 2, lineEnd, out + 0);
+            parseFloat(p, lineEnd, out + 1);
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && lineEnd - p > 2 && (p[2] == ' ' || p[2] == '\t')) {
+            float* out = normals + 3 * (chunk->baseNormal + localNormals++);
+            p = parseFloat(p + 2, lineEnd, out + 0);
+            p = parseFloat(p, lineEnd, out + 1);
+            parseFloat(p, lineEnd, out + 2);
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            polygon.clear();
+            p = skipSpaces(p + 1, lineEnd);
+
+            while (p < lineEnd && *p != '\r') {
+                ObjCorner corner;
+                int index;
+
+                p = parseInt(p, lineEnd, &index);
+                corner.v = resolveIndex(index, chunk->basePosition, localPositions, totalPositions);
+                corner.vt = -1;
+                corner.vn = -1;
+
+                if (p < lineEnd && *p == '/') {
+                    ++p;
+                    if (p < lineEnd && *p != '/') {
+                        p = parseInt(p, lineEnd, &index);
+                        corner.vt = resolveIndex(index, chunk->baseTexCoord, localTexCoords, totalTexCoords);
+                    }
+                    if (p < lineEnd && *p == '/') {
+                        ++p;
+                        p = parseInt(p, lineEnd, &index);
+                        corner.vn = resolveIndex(index, chunk->baseNormal, localNormals, totalNormals);
+                    }
+                }
+
+                //the whole face is skipped, a fan of the corners read so far would be a different surface
+                if (corner.v < 0) {
+                    chunk->badIndex = true;
+                    polygon.clear();
+                    break;
+                }
+
+                polygon.push_back(corner);
+                p = skipSpaces(p, lineEnd);
+            }
+
+            //triangulate polygon as a fan
+            for (size_t i = 2; i < polygon.size(); i++) {
+                chunk->corners.push_back(polygon[0]);
+                chunk->corners.push_back(polygon[i - 1]);
+                chunk->corners.push_back(polygon[i]);
+                chunk->triangleMaterials.push_back(chunk->lastMaterial);
+            }
+        }
+        else if (startsWith(p, lineEnd, "usemtl", 6)) {
+            std::string material = lineArgument(p + 6, lineEnd);
+            std::vector<std::string>::iterator found = std::find(chunk->materials.begin(), chunk->materials.end(), material);
+            chunk->lastMaterial = (int)(found - chunk->materials.begin());
+            if (found == chunk->materials.end())
+                chunk->materials.push_back(material);
+        }
+        else if (startsWith(p, lineEnd, "mtllib", 6)) {
+            if (chunk->materialLibrary.empty())
+                chunk->materialLibrary = lineArgument(p + 6, lineEnd);
+        }
+
+        p = lineEnd + 1;
+    }
+}
+
+//reads the materials of given names from .mtl file, "" is the first material of the file
+//keeps Assimp defaults for missing values, found[i] tells if names[i] is in the file
+static bool parseMtlFile(const std::string& fileName, const std::vector<std::string>& names,
+                         std::vector<MeshMaterial>* materials, std::vector<char>* found) {
+
+    found->assign(names.size(), 0);
+
+    MappedFile file;
+    if (!mapFile(fileName, &file))
+        return false;
+
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    bool firstMaterial = true;
+    std::vector<MeshMaterial*> current;     // a name can be listed once, "" adds the first material
+
+    while (p < end) {
+        const char* lineEnd = findLineEnd(p, end);
+        p = skipSpaces(p, lineEnd);
+
+        if (startsWith(p, lineEnd, "newmtl", 6)) {
+            std::string name = lineArgument(p + 6, lineEnd);
+            current.clear();
+            for (size_t i = 0; i < names.size(); i++) {
+                if ((*found)[i] || !(names[i] == name || (names[i].empty() && firstMaterial)))
+                    continue;
+                (*found)[i] = 1;
+                current.push_back(&(*materials)[i]);
+            }
+            firstMaterial = false;
+        }
+        else if (!current.empty()) {
+            MeshMaterial material = *current[0];
+            if (startsWith(p, lineEnd, "Ka", 2)) {
+                p = parseFloat(p + 2, lineEnd, &material.ambient.x);
+                p = parseFloat(p, lineEnd, &material.ambient.y);
+                parseFloat(p, lineEnd, &material.ambient.z);
+            }
+            else if (startsWith(p, lineEnd, "Kd", 2)) {
+                p = parseFloat(p + 2, lineEnd, &material.diffuse.x);
+                p = parseFloat(p, lineEnd, &material.diffuse.y);
+                parseFloat(p, lineEnd, &material.diffuse.z);
+            }
+            else if (startsWith(p, lineEnd, "Ks", 2)) {
+                p = parseFloat(p + 2, lineEnd, &material.specular.x);
+                p = parseFloat(p, lineEnd, &material.specular.y);
+                parseFloat(p, lineEnd, &material.specular.z);
+            }
+            else if (startsWith(p, lineEnd, "Ns", 2)) {
+                parseFloat(p + 2, lineEnd, &material.shininess);
+            }
+            else if (startsWith(p, lineEnd, "map_Kd", 6)) {
+                //texture name is the last token, options like -s or -o may precede it
+                std::string argument = lineArgument(p + 6, lineEnd);
+                size_t separator = argument.find_last_of(" \t");
+                material.texturePath = (separator == std::string::npos) ? argument : argument.substr(separator + 1);
+            }
+            for (size_t i = 0; i < current.size(); i++)
+                *current[i] = material;
+        }
+
+        p = lineEnd + 1;
+    }
+
+    unmapFile(&file);
+
+    return true;
+}
+
+//hash table key for vertex welding
+static inline uint32_t hashCorner(const ObjCorner& corner) {
+
+    uint32_t h = (uint32_t)corner.v * 73856093u;
+    h ^= (uint32_t)corner.vt * 19349663u;
+    h ^= (uint32_t)corner.vn * 83492791u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+
+    return h;
+}
+
+bool parseObjFile(const std::string& fileName, MeshData* mesh) {
+
+    MappedFile file;
+    if (!mapFile(fileName, &file)) {
+        std::cerr << "obj loader error: can not open file " << fileName << std::endl;
+        return false;
+    }
+
+    //split the file into chunks, each ending at a line break
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 1;
+    size_t numChunks = file.size / OBJ_MIN_CHUNK_SIZE + 1;
+    if (numChunks > numThreads)
+        numChunks = numThreads;
+
+    std::vector<ObjChunk> chunks(numChunks);
+    const char* fileEnd = file.data + file.size;
+    const char* chunkBegin = file.data;
+
+    for (size_t i = 0; i < numChunks; i++) {
+        const char* chunkEnd = (i + 1 == numChunks) ? fileEnd : file.data + file.size * (i + 1) / numChunks;
+        if (chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        if (chunkEnd < fileEnd)
+            chunkEnd = findLineEnd(chunkEnd, fileEnd);
+        if (chunkEnd < fileEnd)
+            chunkEnd++;
+
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    std::vector<std::thread> workers;
+
+    //first pass in parallel - count attributes
+    for (size_t i = 1; i < numChunks; i++)
+        workers.push_back(std::thread(countChunk, &chunks[i]));
+    countChunk(&chunks[0]);
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+
+    size_t totalPositions = 0;
+    size_t totalTexCoords = 0;
+    size_t totalNormals = 0;
+
+    for (size_t i = 0; i < numChunks; i++) {
+        chunks[i].basePosition = totalPositions;
+        chunks[i].baseTexCoord = totalTexCoords;
+        chunks[i].baseNormal = totalNormals;
+        totalPositions += chunks[i].numPositions;
+        totalTexCoords += chunks[i].numTexCoords;
+        totalNormals += chunks[i].numNormals;
+    }
+
+    std::vector<float> positions(3 * totalPositions);
+    std::vector<float> texCoords(2 * totalTexCoords);
+    std::vector<float> normals(3 * totalNormals);
+
+    //second pass in parallel - parse numbers and faces
+    for (size_t i = 1; i < numChunks; i++)
+        workers.push_back(std::thread(parseChunk, &chunks[i], positions.data(), texCoords.data(), normals.data(),
+                                      totalPositions, totalTexCoords, totalNormals));
+    parseChunk(&chunks[0], positions.data(), texCoords.data(), normals.data(), totalPositions, totalTexCoords, totalNormals);
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    unmapFile(&file);
+
+    size_t totalCorners = 0;
+    std::string materialLibrary;
+    bool badIndex = false;
+
+    //material names of the whole file in the order of first use, "" for faces before the first usemtl
+    std::vector<std::string> materialNames;
+    std::vector<int> triangleMaterials;
+    int currentMaterial = -1;
+
+    for (size_t i = 0; i < numChunks; i++) {
+        totalCorners += chunks[i].corners.size();
+        badIndex = badIndex || chunks[i].badIndex;
+
+        if (materialLibrary.empty())
+            materialLibrary = chunks[i].materialLibrary;
+
+        std::vector<int> chunkMaterials(chunks[i].materials.size());
+        for (size_t m = 0; m < chunks[i].materials.size(); m++) {
+            std::vector<std::string>::iterator found = std::find(materialNames.begin(), materialNames.end(), chunks[i].materials[m]);
+            chunkMaterials[m] = (int)(found - materialNames.begin());
+            if (found == materialNames.end())
+                materialNames.push_back(chunks[i].materials[m]);
+        }
+
+        for (size_t t = 0; t < chunks[i].triangleMaterials.size(); t++) {
+            int material = chunks[i].triangleMaterials[t];
+            if (material >= 0) {
+                triangleMaterials.push_back(chunkMaterials[material]);
+                continue;
+            }
+            if (currentMaterial < 0) {
+                currentMaterial = (int)materialNames.size();
+                materialNames.push_back(std::string());
+            }
+            triangleMaterials.push_back(currentMaterial);
+        }
+
+        if (chunks[i].lastMaterial >= 0)
+            currentMaterial = chunkMaterials[chunks[i].lastMaterial];
+        std::vector<int>().swap(chunks[i].triangleMaterials);
+    }
+
+    if (badIndex)
+        std::cerr << "obj loader warning: " << fileName << " has faces with invalid indices, they were skipped" << std::endl;
+
+    if (totalCorners == 0) {
+        std::cerr << "obj loader error: " << fileName << " contains no triangles" << std::endl;
+        return false;
+    }
+
+    //weld identical corners into vertices - open addressing hash table of vertex index + 1
+    size_t tableSize = 1;
+    while (tableSize < 2 * totalCorners)
+        tableSize <<= 1;
+    std::vector<uint32_t> table(tableSize, 0);
+    std::vector<ObjCorner> uniqueCorners;
+    uniqueCorners.reserve(totalCorners / 2);
+
+    mesh->indices.clear();
+    mesh->indices.reserve(totalCorners);
+
+    for (size_t c = 0; c < numChunks; c++) {
+        const std::vector<ObjCorner>& corners = chunks[c].corners;
+        for (size_t i = 0; i < corners.size(); i++) {
+            const ObjCorner& corner = corners[i];
+            size_t slot = hashCorner(corner) & (tableSize - 1);
+
+            while (true) {
+                uint32_t entry = table[slot];
+                if (entry == 0) {
+                    uniqueCorners.push_back(corner);
+                    table[slot] = (uint32_t)uniqueCorners.size();
+                    mesh->indices.push_back((unsigned int)uniqueCorners.size() - 1);
+                    break;
+                }
+                const ObjCorner& other = uniqueCorners[entry - 1];
+                if (other.v == corner.v && other.vt == corner.vt && other.vn == corner.vn) {
+                    mesh->indices.push_back(entry - 1);
+                    break;
+                }
+                slot = (slot + 1) & (tableSize - 1);
+            }
+        }
+        std::vector<ObjCorner>().swap(chunks[c].corners);
+    }
+
+    //triangles sorted by material, stable so the file order stays within a material, unused materials are dropped
+    const size_t numTriangles = mesh->indices.size() / 3;
+    std::vector<uint32_t> materialStart(materialNames.size() + 1, 0);
+    for (size_t t = 0; t < numTriangles; t++)
+        materialStart[triangleMaterials[t] + 1]++;
+
+    std::vector<int> materialSlot(materialNames.size(), -1);
+    std::vector<std::string> usedNames;
+    for (size_t m = 0; m < materialNames.size(); m++) {
+        if (materialStart[m + 1] > 0) {
+            materialSlot[m] = (int)usedNames.size();
+            usedNames.push_back(materialNames[m]);
+        }
+        materialStart[m + 1] += materialStart[m];
+    }
+
+    mesh->ranges.clear();
+    for (size_t m = 0; m < materialNames.size(); m++) {
+        if (materialSlot[m] < 0)
+            continue;
+        MeshRange range = { 3 * materialStart[m], 3 * (materialStart[m + 1] - materialStart[m]) };
+        mesh->ranges.push_back(range);
+    }
+
+    if (usedNames.size() > 1) {
+        std::vector<unsigned int> sorted(mesh->indices.size());
+        for (size_t t = 0; t < numTriangles; t++) {
+            unsigned int* triangle = &sorted[3 * materialStart[triangleMaterials[t]]++];
+            triangle[0] = mesh->indices[3 * t];
+            triangle[1] = mesh->indices[3 * t + 1];
+            triangle[2] = mesh->indices[3 * t + 2];
+        }
+        mesh->indices.swap(sorted);
+    }
+    mesh->lods.clear();
+
+    //smooth normals for corners without vn - average of face normals around each position
+    std::vector<float> smoothNormals;
+    bool missingNormals = false;
+    for (size_t i = 0; i < uniqueCorners.size(); i++) {
+        if (uniqueCorners[i].vn < 0) {
+            missingNormals = true;
+            break;
+        }
+    }
+
+    if (missingNormals) {
+        smoothNormals.assign(3 * totalPositions, 0.0f);
+        for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3) {
+            const float* a = &positions[3 * uniqueCorners[mesh->indices[i + 0]].v];
+            const float* b = &positions[3 * uniqueCorners[mesh->indices[i + 1]].v];
+            const float* c = &positions[3 * uniqueCorners[mesh->indices[i + 2]].v];
+
+            glm::vec3 faceNormal = glm::cross(glm::vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]),
+                                              glm::vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+            float length = glm::length(faceNormal);
+            if (length <= 0.0f)
+                continue;
+            faceNormal /= length;
+
+            for (int k = 0; k < 3; k++) {
+                float* n = &smoothNormals[3 * uniqueCorners[mesh->indices[i + k]].v];
+                n[0] += faceNormal.x;
+                n[1] += faceNormal.y;
+                n[2] += faceNormal.z;
+            }
+        }
+    }
+
+    //fill planar vertex streams and the bounding box
+    const size_t numVertices = uniqueCorners.size();
+    mesh->positions.resize(3 * numVertices);
+    mesh->normals.resize(3 * numVertices);
+    mesh->texCoords.resize(2 * numVertices);
+
+    glm::vec3 minBound(INFINITY);
+    glm::vec3 maxBound(-INFINITY);
+
+    for (size_t i = 0; i < numVertices; i++) {
+        const ObjCorner& corner = uniqueCorners[i];
+
+        glm::vec3 position(positions[3 * corner.v + 0], positions[3 * corner.v + 1], positions[3 * corner.v + 2]);
+        minBound = glm::min(minBound, position);
+        maxBound = glm::max(maxBound, position);
+        mesh->positions[3 * i + 0] = position.x;
+        mesh->positions[3 * i + 1] = position.y;
+        mesh->positions[3 * i + 2] = position.z;
+
+        glm::vec3 normal(0.0f, 1.0f, 0.0f);
+        if (corner.vn >= 0)
+            normal = glm::vec3(normals[3 * corner.vn + 0], normals[3 * corner.vn + 1], normals[3 * corner.vn + 2]);
+        else {
+            glm::vec3 sum(smoothNormals[3 * corner.v + 0], smoothNormals[3 * corner.v + 1], smoothNormals[3 * corner.v + 2]);
+            if (glm::length(sum) > 0.0f)
+                normal = glm::normalize(sum);
+        }
+        mesh->normals[3 * i + 0] = normal.x;
+        mesh->normals[3 * i + 1] = normal.y;
+        mesh->normals[3 * i + 2] = normal.z;
+
+        mesh->texCoords[2 * i + 0] = corner.vt >= 0 ? texCoords[2 * corner.vt + 0] : 0.0f;
+        mesh->texCoords[2 * i + 1] = corner.vt >= 0 ? texCoords[2 * corner.vt + 1] : 0.0f;
+    }
+
+    //unitize the same way as AI_CONFIG_PP_PTV_NORMALIZE - center and scale into (-1..1)^3
+    glm::vec3 delta = maxBound - minBound;
+    glm::vec3 center = minBound + delta * 0.5f;
+    float halfExtent = 0.5f * std::max(delta.x, std::max(delta.y, delta.z));
+    if (halfExtent <= 0.0f)
+        halfExtent = 1.0f;
+
+    for (size_t i = 0; i < numVertices; i++) {
+        mesh->positions[3 * i + 0] = (mesh->positions[3 * i + 0] - center.x) / halfExtent;
+        mesh->positions[3 * i + 1] = (mesh->positions[3 * i + 1] - center.y) / halfExtent;
+        mesh->positions[3 * i + 2] = (mesh->positions[3 * i + 2] - center.z) / halfExtent;
+    }
+
+    //materials, Assimp OBJ importer defaults for anything the .mtl does not specify
+    MeshMaterial defaultMaterial;
+    defaultMaterial.ambient = glm::vec3(0.0f);
+    defaultMaterial.diffuse = glm::vec3(0.6f);
+    defaultMaterial.specular = glm::vec3(0.0f);
+    defaultMaterial.shininess = 0.0f;
+    mesh->materials.assign(usedNames.size(), defaultMaterial);
+
+    std::string directory;
+    size_t found = fileName.find_last_of("/\\");
+    if (found != std::string::npos)
+        directory = fileName.substr(0, found + 1);
+
+    if (!materialLibrary.empty()) {
+        std::vector<char> materialFound;
+        if (!parseMtlFile(directory + materialLibrary, usedNames, &mesh->materials, &materialFound)) {
+            std::cerr << "obj loader warning: can not read " << directory + materialLibrary << std::endl;
+        }
+        else {
+            for (size_t m = 0; m < usedNames.size(); m++) {
+                if (!materialFound[m])
+                    std::cerr << "obj loader warning: material " << usedNames[m] << " not found in " << directory + materialLibrary << std::endl;
+            }
+        }
+    }
+
+    for (size_t m = 0; m < mesh->materials.size(); m++) {
+        if (!mesh->materials[m].texturePath.empty())
+            mesh->materials[m].texturePath.insert(0, directory);
+    }
+
+    return true;
+}
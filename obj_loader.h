@@ -0,0 +1,29 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    obj_loader.h
+ * @date    18/10/2026
+ * @brief   Native Wavefront OBJ/MTL loader, used instead of Assimp for the models in data/.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __OBJ_LOADER_H
+#define __OBJ_LOADER_H
+
+#include "mesh_data.h"
+
+/**
+ * @brief Parses an OBJ file and its material library into MeshData.
+ *
+ * The file is memory mapped and split into chunks on line boundaries, the chunks are
+ * tokenized on worker threads and the (position, uv, normal) triplets are welded into
+ * unique vertices with a hash table. The result matches what loadSingleMesh gets from
+ * Assimp: triangulated, smooth normals generated when the file has none, and scaled
+ * to fit into (-1..1)^3. Triangles are sorted by material, one range per usemtl material.
+ *
+ * @param fileName  path to the .obj file
+ * @param mesh      output mesh, texture paths of the materials are relative to the working directory
+ * @return false if the file can not be read or contains no triangles
+ */
+bool parseObjFile(const std::string& fileName, MeshData* mesh);
+
+#endif
@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    render_queue.cpp
+ * @date    18/10/2026
+ * @brief   Sort keys and sorting of the render queue, submission is in render_stuff.cpp.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include "render_queue.h"
+
+uint64_t makeSortKey(RenderPass pass, RenderProgram program, unsigned int texture, unsigned int vertexArrayObject, float depth) {
+
+    float normalizedDepth = std::min(std::max(depth / RENDER_QUEUE_DEPTH_RANGE, 0.0f), 1.0f);
+    uint64_t depthBits = (uint64_t)(normalizedDepth * 4294967295.0);
+
+    uint64_t key = (uint64_t)(pass & 0xF) << 60;
+
+    if (pass == PASS_TRANSPARENT) {
+        key |= (0xFFFFFFFFull - depthBits) << 28;
+        key |= (uint64_t)(program & 0xF) << 24;
+        key |= (uint64_t)(texture & 0xFFF) << 12;
+        key |= (uint64_t)(vertexArrayObject & 0xFFF);
+    }
+    else {
+        key |= (uint64_t)(program & 0xF) << 56;
+        key |= (uint64_t)(texture & 0xFFF) << 44;
+        key |= (uint64_t)(vertexArrayObject & 0xFFF) << 32;
+        key |= depthBits;
+    }
+
+    return key;
+}
+
+void clearRenderQueue(RenderQueue* queue) {
+
+    //keeps the capacity, after the first frame no allocations
+    queue->items.clear();
+    queue->boundsX.clear();
+    queue->boundsY.clear();
+    queue->boundsZ.clear();
+    queue->boundsRadius.clear();
+}
+
+DrawItem* addDrawItem(RenderQueue* queue, const glm::vec4& boundingSphere) {
+
+    queue->boundsX.push_back(boundingSphere.x);
+    queue->boundsY.push_back(boundingSphere.y);
+    queue->boundsZ.push_back(boundingSphere.z);
+    queue->boundsRadius.push_back(boundingSphere.w);
+
+    queue->items.push_back(DrawItem());
+    return &queue->items.back();
+}
+
+void cullRenderQueue(RenderQueue* queue, const Frustum& frustum) {
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    const size_t count = queue->items.size();
+    queue->visible.resize(count);
+
+    size_t numVisible = cullSpheres(frustum, queue->boundsX.data(), queue->boundsY.data(), queue->boundsZ.data(),
+                                    queue->boundsRadius.data(), count, queue->visible.data());
+
+    //keep visible items in their order, bounds are not needed any more
+    size_t last = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (queue->visible[i])
+            queue->items[last++] = queue->items[i];
+    }
+    queue->items.resize(last);
+
+    queue->culling.tested = (unsigned int)count;
+    queue->culling.visible = (unsigned int)numVisible;
+    queue->culling.culled = (unsigned int)(count - numVisible);
+    queue->culling.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool compareKeys(const DrawItem& a, const DrawItem& b) {
+    return a.key < b.key;
+}
+
+void sortRenderQueue(RenderQueue* queue) {
+
+    //stable so items with equal keys keep the order they were queued in
+    std::stable_sort(queue->items.begin(), queue->items.end(), compareKeys);
+}
@@ -0,0 +1,95 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    render_queue.h
+ * @date    18/10/2026
+ * @brief   Draw items collected each frame, sorted by a packed key and submitted in one loop.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __RENDER_QUEUE_H
+#define __RENDER_QUEUE_H
+
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "frustum_culling.h"
+
+struct MeshGeometry;
+struct InstanceBatch;
+
+//view distance mapped onto the depth bits of the sort key, farther items share the last value
+#define RENDER_QUEUE_DEPTH_RANGE    50.0f
+
+//Passes in submission order, the skybox is drawn on its own before the queue
+enum RenderPass {
+  PASS_OPAQUE,
+  PASS_TRANSPARENT,     // additive blending, sorted back to front
+};
+
+//Shader program of an item, index into the programs in render_stuff.cpp
+enum RenderProgram {
+  PROGRAM_COMMON,       // lightingPerVertex, lit and textured meshes
+  PROGRAM_WATER,        // scrolling texture
+  PROGRAM_FIRE,         // animated billboard
+  PROGRAM_INSTANCED,    // lightingPerVertex with per instance matrices
+};
+
+//One draw call with everything needed to issue it
+typedef struct DrawItem {
+  uint64_t              key;
+  RenderPass            pass;
+  RenderProgram         program;
+  const MeshGeometry*   geometry;       // VAO, texture, material and size
+  const InstanceBatch*  batch;          // instanced draw of the geometry, NULL for a single object
+  int                   lodLevel;       // range of the geometry's element buffer, instanced items draw all levels of the batch
+  const glm::mat4*      modelMatrix;    // cached in the object, NULL for instanced items
+  const glm::mat4*      normalMatrix;
+  int                   stencilId;      // written to the stencil buffer for picking, 0 = not pickable
+  float                 time;           // animated programs - time since the object was created
+  float                 frameDuration;
+} DrawItem;
+
+//Counters of the last submitted frame
+typedef struct RenderStats {
+  unsigned int  items;
+  unsigned int  instances;      // objects drawn, an instanced item counts all its instances
+  unsigned int  drawCalls;      // state changes are counted by gl_state
+  size_t        vertexBytes;    // vertex buffer bytes of the lit draws, every instance counts
+  size_t        triangles;      // triangles of the lit draws at the selected levels of detail
+  size_t        fullTriangles;  // the same draws at full detail
+  float         gpuTime;        // ms, measured a few frames ago (RENDER_QUEUE_STATS only)
+} RenderStats;
+
+typedef struct RenderQueue {
+  std::vector<DrawItem>  items;
+  RenderStats            stats;
+
+  //world space bounding sphere of every item, one array per component for the vectorized test
+  std::vector<float>          boundsX;
+  std::vector<float>          boundsY;
+  std::vector<float>          boundsZ;
+  std::vector<float>          boundsRadius;
+  std::vector<unsigned char>  visible;
+  CullingStats                culling;
+} RenderQueue;
+
+/**
+ * @brief Packs the sort key of an item, lower keys are drawn first.
+ *
+ * Opaque:      pass:4 | program:4 | texture:12 | VAO:12 | depth:32      (front to back within a state)
+ * Transparent: pass:4 | far-to-near depth:32 | program:4 | texture:12 | VAO:12
+ *
+ * @param depth  view space distance of the item
+ */
+uint64_t makeSortKey(RenderPass pass, RenderProgram program, unsigned int texture, unsigned int vertexArrayObject, float depth);
+
+void clearRenderQueue(RenderQueue* queue);
+
+//new item with its world space bounding sphere (center xyz, radius w)
+DrawItem* addDrawItem(RenderQueue* queue, const glm::vec4& boundingSphere);
+
+//removes items outside of the frustum, call before sortRenderQueue
+void cullRenderQueue(RenderQueue* queue, const Frustum& frustum);
+void sortRenderQueue(RenderQueue* queue);
+
+#endif
@@ -8,9 +8,35 @@
  //----------------------------------------------------------------------------------------
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
 #include "pgr.h"
 #include "render_stuff.h"
 #include "spline.h"
+#include "obj_loader.h"
+#include "mesh_cache.h"
+#include "task_scheduler.h"
+#include "scene_bvh.h"
+#include "lighting_buffer.h"
+#include "gl_state.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "geometry_arena.h"
+#include "gpu_culling.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "texture_array.h"
+#include "embedded_data.h"
+#include "embedded_mesh.h"
+#include "scene_graph.h"
+#include "xml_parser.h"
+#include "entity_storage.h"
+#include "scene_arena.h"
+#include "benchmark.h"
 
 //init all geometry
 CubeMapGeometry* skyboxGeometry = NULL;
@@ -30,6 +56,8 @@ MeshGeometry* fireplaceGeometry = NULL;
 
 //init shader programs
 SCommonShaderProgram    shaderProgram;
+SCommonShaderProgram    instancedShaderProgram;
+SCommonShaderProgram    indirectShaderProgram;
 SkyboxShaderProgram     skyboxShaderProgram;
 
 float day = 0; //as a gameState day time
@@ -65,500 +93,820 @@ struct fireShaderProgram {
     GLint frameDurationLocation; // = -1;
 } fireShaderProgram;
 
-//Sends matrices to shader - sets correct transformations
-void setTransformUniforms(const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix) {
+//Sends matrices to shader - sets correct transformations, model and normal matrix come from the object cache
+void setTransformUniforms(const glm::mat4 &modelMatrix, const glm::mat4 &normalMatrix, const glm::mat4 &viewMatrix, const glm::mat4 &PVmatrix) {
 
-    glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * modelMatrix;
-
-    glUniformMatrix4fv(shaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));
-    glUniformMatrix4fv(shaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(shaderProgram.MmatrixLocation, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-
-    const glm::mat4 modelRotationMatrix = glm::mat4(
-    modelMatrix[0],
-    modelMatrix[1],
-    modelMatrix[2],
-    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-    );
-    glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelRotationMatrix));
-
-    glUniformMatrix4fv(shaderProgram.normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+    setUniformMat4(shaderProgram.PVMmatrixLocation, PVmatrix * modelMatrix);
+    setUniformMat4(shaderProgram.VmatrixLocation, viewMatrix);
+    setUniformMat4(shaderProgram.MmatrixLocation, modelMatrix);
+    setUniformMat4(shaderProgram.normalMatrixLocation, normalMatrix);
 
 }
 
 //Sends material specifics to shader - function that has our materials set by uniform
-int setMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess, GLuint texture) {
+int setMaterialUniforms(const SCommonShaderProgram &program, const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess, GLuint texture) {
 
-    glUniform3fv(shaderProgram.diffuseLocation,  1, glm::value_ptr(diffuse));
-    glUniform3fv(shaderProgram.ambientLocation,  1, glm::value_ptr(ambient));
-    glUniform3fv(shaderProgram.specularLocation, 1, glm::value_ptr(specular));
-    glUniform1f(shaderProgram.shininessLocation, shininess);
+    //skipped by gl_state when the previous item had the same material
+    setUniformVec3(program.diffuseLocation, diffuse);
+    setUniformVec3(program.ambientLocation, ambient);
+    setUniformVec3(program.specularLocation, specular);
+    setUniformFloat(program.shininessLocation, shininess);
 
+    //texture itself is bound by submitRenderQueue
     if(texture != 0) {
-        glUniform1i(shaderProgram.useTextureLocation, 1);
-        glUniform1i(shaderProgram.texSamplerLocation, 0);
-        glActiveTexture(GL_TEXTURE0 + 0);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        setUniformInt(program.useTextureLocation, 1);
+        setUniformInt(program.texSamplerLocation, 0);
+        setUniformInt(program.texArraySamplerLocation, TEXTURE_ARRAY_UNIT);
     }
     else {
-        glUniform1i(shaderProgram.useTextureLocation, 0);
+        setUniformInt(program.useTextureLocation, 0);
     }
 
     return 0;
 
 }
 
-//Drawing objects = all with specific parametrs 
-
-void drawRock(Object* rock, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+//Sends dequantization ranges of the mesh vertices, float meshes have identity ranges
+void setVertexFormatUniforms(const SCommonShaderProgram &program, const MeshGeometry* geometry) {
 
-    glUseProgram(shaderProgram.program);
+    setUniformVec3(program.positionScaleLocation, geometry->positionScale);
+    setUniformVec3(program.positionOffsetLocation, geometry->positionOffset);
+    setUniformVec4(program.texCoordTransformLocation, geometry->texCoordTransform);
+    setUniformInt(program.octahedralNormalLocation, geometry->vertexFormat == VERTEX_FORMAT_COMPACT ? 1 : 0);
+}
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), rock->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(rock->size));
-    modelMatrix = glm::rotate(modelMatrix, rock->rotationAngle, rock->direction);
+//attribute pointers of the mesh for the common, instanced or indirect program, the vertex buffer must be bound
+void setMeshAttributes(const MeshGeometry* geometry, const SCommonShaderProgram& shader) {
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    glEnableVertexAttribArray(shader.posLocation);
+    glEnableVertexAttribArray(shader.normalLocation);
+    glEnableVertexAttribArray(shader.texCoordLocation);
 
-    setMaterialUniforms(
-        rockGeometry->ambient,
-        rockGeometry->diffuse,
-        rockGeometry->specular,
-        rockGeometry->shininess,
-        rockGeometry->texture
-    );
+    if (geometry->vertexFormat == VERTEX_FORMAT_COMPACT) {
+        // normalized shorts reach the shader as 0..1, the normal has only two components (z = 0)
+        glVertexAttribPointer(shader.posLocation, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        glVertexAttribPointer(shader.normalLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+        glVertexAttribPointer(shader.texCoordLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoord));
+    }
+    else {
+        // interleaved 8 floats per vertex
+        glVertexAttribPointer(shader.posLocation, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
+        glVertexAttribPointer(shader.normalLocation, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(shader.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    }
+    CHECK_GL_ERROR();
+}
 
-    // draw geometry
+//geometry of each ObjectKind
+static MeshGeometry** objectGeometries[OBJECT_KIND_COUNT] = {
+    &groundGeometry, &waterGeometry, &plantGeometry, &treeGeometry, &benchGeometry, &hallGeometry, &eagleGeometry,
+    &hatGeometry, &broomGeometry, &wandGeometry, &rockGeometry, &fireplaceGeometry, &fireGeometry
+};
 
-    glUniform1i(shaderProgram.useTextureLocation, 1);
-    glBindVertexArray(rockGeometry->vertexArrayObject);
-    glUniform1i(shaderProgram.texSamplerLocation, 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, rockGeometry->texture);
-    glDrawElements(GL_TRIANGLES, rockGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+//level of detail selection of the frame, see setLodProjection
+static float lodPixelsPerUnit = 0.0f;   // pixels covered by one world unit one unit in front of the camera
+static bool lodEnabled = true;
 
+void setLodProjection(const glm::mat4& projectionMatrix, int viewportHeight, bool enabled) {
 
+    lodPixelsPerUnit = projectionMatrix[1][1] * 0.5f * (float)viewportHeight;
+    lodEnabled = enabled;
+}
 
-    glUniform1i(shaderProgram.useTextureLocation, 0);
-    glBindVertexArray(0);
-    glUseProgram(0);
+float getLodPixelsPerUnit() {
 
-    return;
+    return lodEnabled ? lodPixelsPerUnit : 0.0f;
 }
 
-void drawFire(FireObject* fire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
+const MeshGeometry* getObjectGeometry(ObjectKind kind) {
 
-    glUseProgram(fireShaderProgram.program);
+    return *objectGeometries[kind];
+}
 
-    // just take 3x3 rotation part of the view transform
-    glm::mat4 billboardRotationMatrix = glm::mat4(
-        viewMatrix[0],
-        viewMatrix[1],
-        viewMatrix[2],
-        glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-    );
-    // inverse view rotation
-    billboardRotationMatrix = glm::transpose(billboardRotationMatrix);
+/**
+ * @brief Coarsest level whose error projects to at most LOD_PIXEL_ERROR pixels.
+ *
+ * The current level is refined only when its error grows above the threshold by LOD_HYSTERESIS
+ * and coarsened only when the next error falls below it by the same fraction.
+ *
+ * @param worldSphere  world space sphere around what is drawn at the level, distance is measured to its nearest point
+ * @param modelRadius  bounding sphere radius of the geometry after the model transform, carries the model scale
+ */
+static int selectLod(const MeshGeometry* geometry, int current, const glm::vec4& worldSphere, float modelRadius, const glm::mat4& viewMatrix) {
 
-    glm::mat4 matrix = glm::translate(glm::mat4(1.0f), fire->position);
-    matrix = glm::scale(matrix, glm::vec3(fire->size));
-    matrix = matrix * billboardRotationMatrix; // make billboard to face the camera
+    if (!lodEnabled || geometry->numLods <= 1 || geometry->boundingSphere.w <= 0.0f)
+        return 0;
 
-    glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * matrix;
-    glUniformMatrix4fv(fireShaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));  // model-view-projection
-    glUniformMatrix4fv(fireShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));   // view
-    glUniform1f(fireShaderProgram.timeLocation, fire->currentTime - fire->startTime);
-    glUniform1i(fireShaderProgram.texSamplerLocation, 0);
-    glUniform1f(fireShaderProgram.frameDurationLocation, fire->frameDuration);
+    glm::vec3 viewCenter = glm::vec3(viewMatrix * glm::vec4(glm::vec3(worldSphere), 1.0f));
+    float distance = std::max(glm::length(viewCenter) - worldSphere.w, 1e-3f);
 
-    glBindVertexArray(fireGeometry->vertexArrayObject);
-    glBindTexture(GL_TEXTURE_2D, fireGeometry->texture);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, fireGeometry->numTriangles);
+    // errors are in model units
+    float pixelsPerModelUnit = lodPixelsPerUnit * (modelRadius / geometry->boundingSphere.w) / distance;
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    int level = std::min(std::max(current, 0), (int)geometry->numLods - 1);
+    while (level > 0 && geometry->lods[level].error * pixelsPerModelUnit > LOD_PIXEL_ERROR * (1.0f + LOD_HYSTERESIS))
+        level--;
+    while (level + 1 < (int)geometry->numLods && geometry->lods[level + 1].error * pixelsPerModelUnit <= LOD_PIXEL_ERROR * (1.0f - LOD_HYSTERESIS))
+        level++;
 
-    glDisable(GL_BLEND);
+    return level;
 }
 
-void drawEagle(MoveableObject* eagle, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+//pixels across an object of modelRadius at the nearest point of the sphere, the texture streaming priority and level
+static float projectedPixels(const glm::vec4& worldSphere, float modelRadius, const glm::mat4& viewMatrix) {
 
-    glUseProgram(shaderProgram.program);
-
-    glm::mat4 modelMatrix = glm::rotate(modelMatrix, eagle->rotationAngle, eagle->rotdirection);
-    modelMatrix = alignObject(eagle->position, eagle->direction, glm::vec3(0.0f, 1.0f, 0.0f));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(eagle->size));
+    glm::vec3 viewCenter = glm::vec3(viewMatrix * glm::vec4(glm::vec3(worldSphere), 1.0f));
+    float distance = std::max(glm::length(viewCenter) - worldSphere.w, 1e-3f);
+    return 2.0f * modelRadius * lodPixelsPerUnit / distance;
+}
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+//asks the streamer for the levels of all textures of the geometry
+static void requestGeometryTextures(const MeshGeometry* geometry, float pixels) {
 
-    setMaterialUniforms(
-        eagleGeometry->ambient,
-        eagleGeometry->diffuse,
-        eagleGeometry->specular,
-        eagleGeometry->shininess,
-        eagleGeometry->texture
-    );
+    if (geometry->texture != 0)
+        requestStreamedTexture(geometry->texture, pixels);
+    for (size_t p = 0; p < geometry->parts.size(); p++) {
+        if (geometry->parts[p].texture != 0)
+            requestStreamedTexture(geometry->parts[p].texture, pixels);
+    }
+}
 
-    // draw geometry
-    glBindVertexArray(eagleGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, eagleGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+void requestObjectTextures(ObjectKind kind, Object* object, const glm::mat4& viewMatrix) {
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    const MeshGeometry* geometry = *objectGeometries[kind];
+    if (geometry == NULL)
+        return;
 
-    return;
+    updateObjectTransform(kind, object, viewMatrix);
+    glm::vec4 worldSphere = transformBoundingSphere(geometry->boundingSphere, object->modelMatrix);
+    requestGeometryTextures(geometry, projectedPixels(worldSphere, worldSphere.w, viewMatrix));
 }
 
+void requestBatchTextures(const InstanceBatch* batch, const glm::mat4& viewMatrix) {
 
-void drawHall(Object* hall, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    float pixels = 0.0f;
+    for (unsigned int c = 0; c < batch->numCells; c++) {
+        const InstanceCell& cell = batch->cells[c];
+        pixels = std::max(pixels, projectedPixels(cell.boundingSphere, cell.instanceRadius, viewMatrix));
+    }
+    requestGeometryTextures(batch->geometry, pixels);
+}
 
-    glUseProgram(shaderProgram.program);
+//byte offset of the range's first index in the element buffer
+static const void* rangeIndexOffset(const MeshGeometry* geometry, const MeshRange& range) {
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), hall->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(hall->size));
-    modelMatrix = glm::rotate(modelMatrix, hall->rotationAngle, hall->direction);
+    size_t indexSize = geometry->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    return (const void*)(geometry->indexByteOffset + range.firstIndex * indexSize);
+}
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+//texture in the sort key, the first part stands for lit meshes
+static GLuint sortTexture(const MeshGeometry* geometry) {
 
-    int ret = setMaterialUniforms(
-        hallGeometry->ambient,
-        hallGeometry->diffuse,
-        hallGeometry->specular,
-        hallGeometry->shininess,
-        hallGeometry->texture
-    );
+    return geometry->parts.empty() ? geometry->texture : geometry->parts[0].texture;
+}
 
+//binds the part texture and sends its material
+static void setPartUniforms(const SCommonShaderProgram& program, const MeshPart& part) {
 
-    // draw geometry
-    glBindVertexArray(hallGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, hallGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+    if (part.texture != 0 && part.textureLayer >= 0)
+        bindTexture(TEXTURE_ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, part.texture);
+    else if (part.texture != 0)
+        bindTexture(0, GL_TEXTURE_2D, part.texture);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
-
-    return;
+    setMaterialUniforms(program, part.ambient, part.diffuse, part.specular, part.shininess, part.texture);
+    setUniformFloat(program.textureLayerLocation, (float)part.textureLayer);
 }
 
-void drawFireplace(Object* fireplace, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+//AABB and bounding sphere (centered in the AABB) of positions, stride in floats
+void computeMeshBounds(MeshGeometry* geometry, const float* positions, size_t numVertices, size_t stride) {
 
-    glUseProgram(shaderProgram.program);
+    glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), fireplace->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(fireplace->size));
-    modelMatrix = glm::rotate(modelMatrix, fireplace->rotationAngle, fireplace->direction);
+    for (size_t i = 0; i < numVertices; i++) {
+        glm::vec3 position(positions[i * stride], positions[i * stride + 1], positions[i * stride + 2]);
+        boundsMin = (i == 0) ? position : glm::min(boundsMin, position);
+        boundsMax = (i == 0) ? position : glm::max(boundsMax, position);
+    }
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+    float radiusSquared = 0.0f;
 
-    int ret = setMaterialUniforms(
-        fireplaceGeometry->ambient,
-        fireplaceGeometry->diffuse,
-        fireplaceGeometry->specular,
-        fireplaceGeometry->shininess,
-        fireplaceGeometry->texture
-    );
+    for (size_t i = 0; i < numVertices; i++) {
+        glm::vec3 offset = glm::vec3(positions[i * stride], positions[i * stride + 1], positions[i * stride + 2]) - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
 
+    geometry->boundsMin = boundsMin;
+    geometry->boundsMax = boundsMax;
+    geometry->boundingSphere = glm::vec4(center, sqrtf(radiusSquared));
+}
 
-    // draw geometry
-    glBindVertexArray(fireplaceGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, fireplaceGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+//sphere after the model transform, radius grows with the largest axis scale
+glm::vec4 transformBoundingSphere(const glm::vec4& sphere, const glm::mat4& modelMatrix) {
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(glm::vec3(sphere), 1.0f));
+    float scale = std::max(glm::length(glm::vec3(modelMatrix[0])), std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
 
-    return;
+    return glm::vec4(center, sphere.w * scale);
 }
 
-void drawBench(Object* bench, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+bool objectWorldBounds(ObjectKind kind, Object* object, glm::vec3* boundsMin, glm::vec3* boundsMax) {
 
-    glUseProgram(shaderProgram.program);
-
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), bench->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(bench->size));
-    modelMatrix = glm::rotate(modelMatrix, bench->rotationAngle, bench->direction);
+    const MeshGeometry* geometry = *objectGeometries[kind];
+    if (geometry == NULL)
+        return false;
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    if (kind == OBJECT_FIRE) {
+        // billboard turns with the camera, box around every orientation
+        glm::vec4 sphere = transformBoundingSphere(geometry->boundingSphere, objectModelMatrix(kind, object, glm::mat4(1.0f)));
+        float radius = sphere.w + glm::distance(glm::vec3(sphere), object->position);
+        *boundsMin = object->position - glm::vec3(radius);
+        *boundsMax = object->position + glm::vec3(radius);
+        return true;
+    }
 
-    setMaterialUniforms(
-        benchGeometry->ambient,
-        benchGeometry->diffuse,
-        benchGeometry->specular,
-        benchGeometry->shininess,
-        benchGeometry->texture
-    );
+    updateObjectTransform(kind, object, glm::mat4(1.0f));
+    const glm::mat4& modelMatrix = object->modelMatrix;
 
-    // draw geometry
-    glBindVertexArray(benchGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, benchGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+    // transformed AABB, extent grows with the absolute values of the rotation and scale
+    glm::vec3 center = 0.5f * (geometry->boundsMin + geometry->boundsMax);
+    glm::vec3 halfSize = 0.5f * (geometry->boundsMax - geometry->boundsMin);
+    glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.0f));
+    glm::vec3 worldHalfSize(0.0f);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    for (int column = 0; column < 3; column++)
+        worldHalfSize += glm::abs(glm::vec3(modelMatrix[column])) * halfSize[column];
 
-    return;
+    *boundsMin = worldCenter - worldHalfSize;
+    *boundsMax = worldCenter + worldHalfSize;
+    return true;
 }
 
-void drawHat(Object* hat, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+//model matrix placing the object in the scene, same for single and instanced drawing
+glm::mat4 objectModelMatrix(ObjectKind kind, const Object* object, const glm::mat4& viewMatrix) {
+
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), object->position);
+
+    switch (kind) {
+    case OBJECT_GROUND:
+    case OBJECT_PLANT:
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(object->size));
+        break;
+
+    case OBJECT_EAGLE:
+        modelMatrix = alignObject(object->position, object->direction, glm::vec3(0.0f, 1.0f, 0.0f));
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(object->size));
+        break;
+
+    case OBJECT_WATER:
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(object->size * 22));
+        modelMatrix = glm::rotate(modelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+        break;
+
+    case OBJECT_FIRE: {
+        // inverse of the 3x3 rotation part of the view transform, makes billboard face the camera
+        glm::mat4 billboardRotationMatrix = glm::transpose(glm::mat4(
+            viewMatrix[0],
+            viewMatrix[1],
+            viewMatrix[2],
+            glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+        ));
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(object->size));
+        modelMatrix = modelMatrix * billboardRotationMatrix;
+        break;
+    }
 
-    glUseProgram(shaderProgram.program);
+    default:
+        modelMatrix = glm::scale(modelMatrix, glm::vec3(object->size));
+        modelMatrix = glm::rotate(modelMatrix, object->rotationAngle, object->direction);
+        break;
+    }
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), hat->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(hat->size));
-    modelMatrix = glm::rotate(modelMatrix, hat->rotationAngle, hat->direction);
+    return modelMatrix;
+}
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+//normal matrix of the rotation and scale part
+static glm::mat4 normalMatrixOf(const glm::mat4& modelMatrix) {
 
-    setMaterialUniforms(
-        hatGeometry->ambient,
-        hatGeometry->diffuse,
-        hatGeometry->specular,
-        hatGeometry->shininess,
-        hatGeometry->texture
+    const glm::mat4 modelRotationMatrix = glm::mat4(
+        modelMatrix[0],
+        modelMatrix[1],
+        modelMatrix[2],
+        glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
     );
+    return glm::transpose(glm::inverse(modelRotationMatrix));
+}
 
-    // draw geometry
-    glBindVertexArray(hatGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, hatGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+void updateObjectTransform(ObjectKind kind, Object* object, const glm::mat4& viewMatrix) {
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    if (!object->transformDirty && kind != OBJECT_FIRE)
+        return;
 
-    return;
+    object->modelMatrix = objectModelMatrix(kind, object, viewMatrix);
+    object->normalMatrix = normalMatrixOf(object->modelMatrix);
+    object->transformDirty = false;
 }
 
-void drawWand(Object* wand, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+//Queues object for drawing - picks geometry, program and pass
+void queueObject(RenderQueue* queue, ObjectKind kind, Object* object, const ObjectAnimation* animation, int stencilId, const glm::mat4& viewMatrix) {
+
+    const MeshGeometry* geometry = *objectGeometries[kind];
+    if (geometry == NULL)
+        return;
+
+    updateObjectTransform(kind, object, viewMatrix);
+
+    glm::vec4 worldSphere = transformBoundingSphere(geometry->boundingSphere, object->modelMatrix);
+    requestGeometryTextures(geometry, projectedPixels(worldSphere, worldSphere.w, viewMatrix));
+
+    DrawItem* item = addDrawItem(queue, worldSphere);
+    item->geometry = geometry;
+    item->batch = NULL;
+    item->lodLevel = 0;
+    item->stencilId = stencilId;
+    item->pass = PASS_OPAQUE;
+    item->program = PROGRAM_COMMON;
+    item->time = animation != NULL ? animation->currentTime - animation->startTime : 0.0f;
+    item->frameDuration = animation != NULL ? animation->frameDuration : 0.0f;
+    item->modelMatrix = &object->modelMatrix;
+    item->normalMatrix = &object->normalMatrix;
+
+    if (kind == OBJECT_WATER) {
+        item->pass = PASS_TRANSPARENT;
+        item->program = PROGRAM_WATER;
+    }
+    else if (kind == OBJECT_FIRE) {
+        item->pass = PASS_TRANSPARENT;
+        item->program = PROGRAM_FIRE;
+    }
+    else {
+        object->lodLevel = selectLod(geometry, object->lodLevel, worldSphere, worldSphere.w, viewMatrix);
+        item->lodLevel = object->lodLevel;
+    }
 
-    glUseProgram(shaderProgram.program);
+    float depth = -(viewMatrix * object->modelMatrix[3]).z;
+    item->key = makeSortKey(item->pass, item->program, sortTexture(geometry), geometry->vertexArrayObject, depth);
+}
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), wand->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(wand->size));
-    modelMatrix = glm::rotate(modelMatrix, wand->rotationAngle, wand->direction);
+//grid cell of the sphere center, rows run back and forth so the next cell in order is always a neighbour
+static unsigned int instanceCellOf(const glm::vec4& sphere, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    int column = 0, row = 0;
+    if (boundsMax.x > boundsMin.x)
+        column = std::min((int)((sphere.x - boundsMin.x) / (boundsMax.x - boundsMin.x) * INSTANCE_LOD_CELLS), INSTANCE_LOD_CELLS - 1);
+    if (boundsMax.z > boundsMin.z)
+        row = std::min((int)((sphere.z - boundsMin.z) / (boundsMax.z - boundsMin.z) * INSTANCE_LOD_CELLS), INSTANCE_LOD_CELLS - 1);
+    column = std::max(column, 0);
+    row = std::max(row, 0);
 
-    setMaterialUniforms(
-        wandGeometry->ambient,
-        wandGeometry->diffuse,
-        wandGeometry->specular,
-        wandGeometry->shininess,
-        wandGeometry->texture
-    );
+    return row * INSTANCE_LOD_CELLS + (row % 2 == 0 ? column : INSTANCE_LOD_CELLS - 1 - column);
+}
 
-    // draw geometry
-    glBindVertexArray(wandGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, wandGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+bool createInstanceBatch(ObjectKind kind, const std::vector<Object*>& objects, InstanceBatch** batch) {
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    const MeshGeometry* geometry = *objectGeometries[kind];
 
-    return;
-}
+    if (geometry == NULL || objects.empty() || instancedShaderProgram.instanceModelMatrixLocation < 0) {
+        *batch = NULL;
+        return false;
+    }
 
-void drawBroom(Object* broom, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    *batch = new InstanceBatch;
+    (*batch)->geometry = geometry;
+    (*batch)->numInstances = (unsigned int)objects.size();
 
-    glUseProgram(shaderProgram.program);
+    std::vector<glm::vec4> instanceSpheres(objects.size());
+    glm::vec3 boundsMin, boundsMax;
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), broom->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(broom->size));
-    modelMatrix = glm::rotate(modelMatrix, broom->rotationAngle, broom->direction);
+    for (size_t i = 0; i < objects.size(); i++) {
+        updateObjectTransform(kind, objects[i], glm::mat4(1.0f));
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+        instanceSpheres[i] = transformBoundingSphere(geometry->boundingSphere, objects[i]->modelMatrix);
+        glm::vec3 center = glm::vec3(instanceSpheres[i]);
+        boundsMin = (i == 0) ? center - instanceSpheres[i].w : glm::min(boundsMin, center - instanceSpheres[i].w);
+        boundsMax = (i == 0) ? center + instanceSpheres[i].w : glm::max(boundsMax, center + instanceSpheres[i].w);
+    }
 
-    setMaterialUniforms(
-        broomGeometry->ambient,
-        broomGeometry->diffuse,
-        broomGeometry->specular,
-        broomGeometry->shininess,
-        broomGeometry->texture
-    );
+    // sphere around the instance spheres
+    glm::vec3 batchCenter = 0.5f * (boundsMin + boundsMax);
+    float batchRadius = 0.0f;
+    for (size_t i = 0; i < objects.size(); i++)
+        batchRadius = std::max(batchRadius, glm::length(glm::vec3(instanceSpheres[i]) - batchCenter) + instanceSpheres[i].w);
+    (*batch)->boundingSphere = glm::vec4(batchCenter, batchRadius);
+    (*batch)->boundsMin = boundsMin;
+    (*batch)->boundsMax = boundsMax;
+
+    // counting sort of the instances by grid cell
+    std::vector<unsigned int> instanceCells(objects.size());
+    unsigned int cellStart[INSTANCE_MAX_CELLS + 1] = { 0 };
+    for (size_t i = 0; i < objects.size(); i++) {
+        instanceCells[i] = instanceCellOf(instanceSpheres[i], boundsMin, boundsMax);
+        cellStart[instanceCells[i] + 1]++;
+    }
+    for (int cell = 0; cell < INSTANCE_MAX_CELLS; cell++)
+        cellStart[cell + 1] += cellStart[cell];
+
+    // model matrix followed by normal matrix, 32 floats per instance
+    std::vector<glm::mat4>& instanceData = (*batch)->instanceData;
+    std::vector<glm::vec4> cellSpheres(objects.size());
+    instanceData.resize(2 * objects.size());
+    unsigned int cellFill[INSTANCE_MAX_CELLS];
+    memcpy(cellFill, cellStart, sizeof(cellFill));
+    for (size_t i = 0; i < objects.size(); i++) {
+        unsigned int slot = cellFill[instanceCells[i]]++;
+        instanceData[2 * slot] = objects[i]->modelMatrix;
+        instanceData[2 * slot + 1] = objects[i]->normalMatrix;
+        cellSpheres[slot] = instanceSpheres[i];
+    }
 
-    // draw geometry
-    glBindVertexArray(broomGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, broomGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+    // empty cells are left out, runs of the others stay in grid order
+    (*batch)->numCells = 0;
+    for (int grid = 0; grid < INSTANCE_MAX_CELLS; grid++) {
+        if (cellStart[grid + 1] == cellStart[grid])
+            continue;
+
+        InstanceCell& cell = (*batch)->cells[(*batch)->numCells++];
+        cell.firstInstance = cellStart[grid];
+        cell.numInstances = cellStart[grid + 1] - cellStart[grid];
+        cell.lodLevel = 0;
+
+        glm::vec3 cellMin = glm::vec3(cellSpheres[cell.firstInstance]) - cellSpheres[cell.firstInstance].w;
+        glm::vec3 cellMax = glm::vec3(cellSpheres[cell.firstInstance]) + cellSpheres[cell.firstInstance].w;
+        for (unsigned int i = cell.firstInstance; i < cellStart[grid + 1]; i++) {
+            cellMin = glm::min(cellMin, glm::vec3(cellSpheres[i]) - cellSpheres[i].w);
+            cellMax = glm::max(cellMax, glm::vec3(cellSpheres[i]) + cellSpheres[i].w);
+        }
+        glm::vec3 cellCenter = 0.5f * (cellMin + cellMax);
+        float cellRadius = 0.0f;
+        cell.instanceRadius = 0.0f;
+        for (unsigned int i = cell.firstInstance; i < cellStart[grid + 1]; i++) {
+            cellRadius = std::max(cellRadius, glm::length(glm::vec3(cellSpheres[i]) - cellCenter) + cellSpheres[i].w);
+            cell.instanceRadius = std::max(cell.instanceRadius, cellSpheres[i].w);
+        }
+        cell.boundingSphere = glm::vec4(cellCenter, cellRadius);
+    }
+
+    // static from now on, the levels only change which index range a cell draws
+    glGenBuffers(1, &((*batch)->instanceBufferObject));
+    glBindBuffer(GL_ARRAY_BUFFER, (*batch)->instanceBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(glm::mat4), instanceData.data(), GL_STATIC_DRAW);
+
+    // own VAO per cell - the geometry buffers with the instanced program locations plus the instances from the cell's first one,
+    // GL 3.x has no base instance
+    glGenVertexArrays((*batch)->numCells, (*batch)->vertexArrayObjects);
+    for (unsigned int c = 0; c < (*batch)->numCells; c++) {
+        glBindVertexArray((*batch)->vertexArrayObjects[c]);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject);
+        glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+        setMeshAttributes(geometry, instancedShaderProgram);
+
+        glBindBuffer(GL_ARRAY_BUFFER, (*batch)->instanceBufferObject);
+        const size_t cellOffset = 2 * sizeof(glm::mat4) * (*batch)->cells[c].firstInstance;
+        for (int column = 0; column < 4; column++) {
+            GLuint modelLocation = instancedShaderProgram.instanceModelMatrixLocation + column;
+            glEnableVertexAttribArray(modelLocation);
+            glVertexAttribPointer(modelLocation, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::mat4), (void*)(cellOffset + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(modelLocation, 1);
+
+            GLuint normalLocation = instancedShaderProgram.instanceNormalMatrixLocation + column;
+            glEnableVertexAttribArray(normalLocation);
+            glVertexAttribPointer(normalLocation, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::mat4), (void*)(cellOffset + sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(normalLocation, 1);
+        }
+    }
+    CHECK_GL_ERROR();
 
     glBindVertexArray(0);
-    glUseProgram(0);
 
-    return;
+    return true;
 }
 
+void deleteInstanceBatch(InstanceBatch* batch) {
 
-void drawPlant(Object* plant, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    glDeleteVertexArrays(batch->numCells, batch->vertexArrayObjects);
+    glDeleteBuffers(1, &(batch->instanceBufferObject));
+    delete batch;
+}
 
-    glUseProgram(shaderProgram.program);
+//one queue item for the whole batch, the item draws every cell at its level
+void queueInstanceBatch(RenderQueue* queue, InstanceBatch* batch, int stencilId, const glm::mat4& viewMatrix) {
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), plant->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(plant->size));
+    if (batch == NULL)
+        return;
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    // the largest instance at the nearest point of the cell sets its level, the cost does not grow with the instances
+    for (unsigned int c = 0; c < batch->numCells; c++) {
+        InstanceCell& cell = batch->cells[c];
+        cell.lodLevel = selectLod(batch->geometry, cell.lodLevel, cell.boundingSphere, cell.instanceRadius, viewMatrix);
+    }
+    requestBatchTextures(batch, viewMatrix);
+
+    DrawItem* item = addDrawItem(queue, batch->boundingSphere);
+    item->geometry = batch->geometry;
+    item->batch = batch;
+    item->lodLevel = 0;
+    item->stencilId = stencilId;
+    item->pass = PASS_OPAQUE;
+    item->program = PROGRAM_INSTANCED;
+    item->time = 0.0f;
+    item->frameDuration = 0.0f;
+    item->modelMatrix = NULL;
+    item->normalMatrix = NULL;
+
+    float depth = -(viewMatrix * glm::vec4(glm::vec3(batch->boundingSphere), 1.0f)).z;
+    item->key = makeSortKey(item->pass, item->program, sortTexture(batch->geometry), batch->vertexArrayObjects[0], depth);
+}
 
-    setMaterialUniforms(
-        plantGeometry->ambient,
-        plantGeometry->diffuse,
-        plantGeometry->specular,
-        plantGeometry->shininess,
-        plantGeometry->texture
-    );
+#if RENDER_QUEUE_STATS
+//GPU time of the queue, results are read RENDER_TIMER_QUERIES frames later so the CPU does not wait for them
+#define RENDER_TIMER_QUERIES 4
+static GLuint timerQueries[RENDER_TIMER_QUERIES] = { 0 };
+static unsigned int timerFrame = 0;
+#endif
+
+//Sorts the queue and draws it, GL state is only changed when the next item needs a different one
+void submitRenderQueue(RenderQueue* queue, const glm::mat4& viewMatrix, const glm::mat4& PVmatrix) {
+
+    RenderStats& stats = queue->stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.items = (unsigned int)queue->items.size();
+
+#if RENDER_QUEUE_STATS
+    if (timerQueries[0] == 0)
+        glGenQueries(RENDER_TIMER_QUERIES, timerQueries);
+
+    GLuint timerQuery = timerQueries[timerFrame % RENDER_TIMER_QUERIES];
+    if (timerFrame >= RENDER_TIMER_QUERIES) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+        stats.gpuTime = elapsed * 1e-6f;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+#endif
 
-    // draw geometry
-    glBindVertexArray(plantGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, plantGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+    sortRenderQueue(queue);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    const GLuint programs[] = { shaderProgram.program, waterShaderProgram.program, fireShaderProgram.program, instancedShaderProgram.program };
 
-    return;
-}
+    // value in the stencil buffer is replaced with the object ID (byte 1..255, 0 ... background)
+    setCapability(GL_STENCIL_TEST, true);
+    setStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
-void drawTree(Object* tree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    //state is set for every item, gl_state drops what is already set
+    for (size_t i = 0; i < queue->items.size(); i++) {
+        const DrawItem& item = queue->items[i];
+        const MeshGeometry* geometry = item.geometry;
 
-    glUseProgram(shaderProgram.program);
+        if (item.pass == PASS_TRANSPARENT) {
+            setCapability(GL_BLEND, true);
+            setBlendFunc(GL_ONE, GL_ONE);
+        }
+        else {
+            setCapability(GL_BLEND, false);
+        }
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), tree->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(tree->size));
-    modelMatrix = glm::rotate(modelMatrix, tree->rotationAngle, tree->direction);
+        bindProgram(programs[item.program]);
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+        // uniforms shared by all items of the program
+        if (item.program == PROGRAM_WATER) {
+            setUniformMat4(waterShaderProgram.VmatrixLocation, viewMatrix);
+            setUniformInt(waterShaderProgram.texSamplerLocation, 0);
+        }
+        else if (item.program == PROGRAM_FIRE) {
+            setUniformMat4(fireShaderProgram.VmatrixLocation, viewMatrix);
+            setUniformInt(fireShaderProgram.texSamplerLocation, 0);
+        }
+        else if (item.program == PROGRAM_INSTANCED) {
+            setUniformMat4(instancedShaderProgram.PVmatrixLocation, PVmatrix);
+            setUniformMat4(instancedShaderProgram.VmatrixLocation, viewMatrix);
+        }
 
-    setMaterialUniforms(
-        treeGeometry->ambient,
-        treeGeometry->diffuse,
-        treeGeometry->specular,
-        treeGeometry->shininess,
-        treeGeometry->texture
-    );
+        if (item.stencilId == 0) {
+            // not pickable, keep whatever is behind it
+            setStencilMask(0x00);
+        }
+        else {
+            setStencilMask(0xFF);
+            setStencilFunc(GL_ALWAYS, item.stencilId, 0xFF);
+        }
 
-    // draw geometry
-    glBindVertexArray(treeGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, treeGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+        // instanced items bind the VAO of each level they draw
+        if (item.batch == NULL)
+            bindVertexArray(geometry->vertexArrayObject);
+
+        if (geometry->texture != 0)
+            bindTexture(0, GL_TEXTURE_2D, geometry->texture);
+
+        if (item.program == PROGRAM_COMMON) {
+            // send matrices to the vertex & fragment shader
+            setTransformUniforms(*item.modelMatrix, *item.normalMatrix, viewMatrix, PVmatrix);
+            setVertexFormatUniforms(shaderProgram, geometry);
+
+            // one draw per material, the parts share the VAO
+            for (size_t p = 0; p < geometry->parts.size(); p++) {
+                const MeshPart& part = geometry->parts[p];
+                const MeshRange& range = part.ranges[item.lodLevel];
+                if (range.numIndices == 0)
+                    continue;
+
+                setPartUniforms(shaderProgram, part);
+                glDrawElementsBaseVertex(GL_TRIANGLES, range.numIndices, geometry->indexType, rangeIndexOffset(geometry, range), geometry->baseVertex);
+                stats.drawCalls++;
+            }
+            stats.instances++;
+            stats.vertexBytes += geometry->numVertices * vertexFormatSize(geometry->vertexFormat);
+            stats.triangles += geometry->lods[item.lodLevel].numIndices / 3;
+            stats.fullTriangles += geometry->lods[0].numIndices / 3;
+        }
+        else if (item.program == PROGRAM_INSTANCED) {
+            setVertexFormatUniforms(instancedShaderProgram, geometry);
+
+            // material changes once per part, the cell VAOs differ only in the first instance
+            const InstanceBatch* batch = item.batch;
+            for (size_t p = 0; p < geometry->parts.size(); p++) {
+                const MeshPart& part = geometry->parts[p];
+                setPartUniforms(instancedShaderProgram, part);
+
+                // following cells at the same level are one draw from the VAO of the first
+                for (unsigned int c = 0; c < batch->numCells;) {
+                    const unsigned int first = c;
+                    const int level = batch->cells[c].lodLevel;
+                    unsigned int numInstances = 0;
+                    while (c < batch->numCells && batch->cells[c].lodLevel == level)
+                        numInstances += batch->cells[c++].numInstances;
+
+                    const MeshRange& range = part.ranges[level];
+                    if (range.numIndices == 0)
+                        continue;
+
+                    bindVertexArray(batch->vertexArrayObjects[first]);
+                    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.numIndices, geometry->indexType, rangeIndexOffset(geometry, range),
+                                                      numInstances, geometry->baseVertex);
+                    stats.drawCalls++;
+                }
+            }
+            for (unsigned int c = 0; c < batch->numCells; c++)
+                stats.triangles += (size_t)batch->cells[c].numInstances * (geometry->lods[batch->cells[c].lodLevel].numIndices / 3);
+            stats.instances += batch->numInstances;
+            stats.vertexBytes += batch->numInstances * geometry->numVertices * vertexFormatSize(geometry->vertexFormat);
+            stats.fullTriangles += (size_t)batch->numInstances * (geometry->lods[0].numIndices / 3);
+        }
+        else if (item.program == PROGRAM_WATER) {
+            setUniformMat4(waterShaderProgram.PVMmatrixLocation, PVmatrix * *item.modelMatrix);  // model-view-projection
+            setUniformFloat(waterShaderProgram.timeLocation, item.time);
+            setUniformFloat(waterShaderProgram.frameDurationLocation, item.frameDuration);
+
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, geometry->numTriangles);
+            stats.instances++;
+            stats.drawCalls++;
+        }
+        else {
+            setUniformMat4(fireShaderProgram.PVMmatrixLocation, PVmatrix * *item.modelMatrix);  // model-view-projection
+            setUniformFloat(fireShaderProgram.timeLocation, item.time);
+            setUniformFloat(fireShaderProgram.frameDurationLocation, item.frameDuration);
+
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, geometry->numTriangles);
+            stats.instances++;
+            stats.drawCalls++;
+        }
+    }
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    //program and VAO stay bound, the next frame starts with the same ones
+    setCapability(GL_BLEND, false);
+    setStencilMask(0xFF);
+    setCapability(GL_STENCIL_TEST, false);
 
-    return;
+#if RENDER_QUEUE_STATS
+    glEndQuery(GL_TIME_ELAPSED);
+    timerFrame++;
+#endif
 }
 
-void drawWater(WaterObject* water, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
+void cleanupShaderPrograms() {
 
-    glUseProgram(waterShaderProgram.program);
+    resetGLState();
 
-    glm::mat4 matrix = glm::translate(glm::mat4(1.0f), water->position);
-    matrix = glm::scale(matrix, glm::vec3(water->size * 22));
-    matrix = glm::rotate(matrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    pgr::deleteProgramAndShaders(shaderProgram.program);
+    pgr::deleteProgramAndShaders(instancedShaderProgram.program);
+    if (indirectShaderProgram.program != 0)
+        pgr::deleteProgramAndShaders(indirectShaderProgram.program);
+    indirectShaderProgram.program = 0;
+    cleanupGpuCulling();
+    pgr::deleteProgramAndShaders(skyboxShaderProgram.program);
+    pgr::deleteProgramAndShaders(fireShaderProgram.program);
+    pgr::deleteProgramAndShaders(waterShaderProgram.program);
 
+}
 
-    glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * matrix;
-    glUniformMatrix4fv(waterShaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));  // model-view-projection
-    glUniformMatrix4fv(waterShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));   // view
-    glUniform1f(waterShaderProgram.timeLocation, water->currentTime - water->startTime);
-    glUniform1i(waterShaderProgram.texSamplerLocation, 0);
-    glUniform1f(waterShaderProgram.frameDurationLocation, water->frameDuration);
+//attribute and uniform locations of lightingPerVertex, same for the instanced variant
+void initializeCommonShaderLocations(SCommonShaderProgram& program) {
 
-    glBindVertexArray(waterGeometry->vertexArrayObject);
-    glBindTexture(GL_TEXTURE_2D, waterGeometry->texture);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, waterGeometry->numTriangles);
+    program.posLocation = glGetAttribLocation(program.program, "position");
+    program.normalLocation = glGetAttribLocation(program.program, "normal");
+    program.texCoordLocation = glGetAttribLocation(program.program, "texCoord");
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    program.PVMmatrixLocation = glGetUniformLocation(program.program, "PVMmatrix");
+    program.VmatrixLocation = glGetUniformLocation(program.program, "Vmatrix");
+    program.MmatrixLocation = glGetUniformLocation(program.program, "Mmatrix");
+    program.normalMatrixLocation = glGetUniformLocation(program.program, "normalMatrix");
 
-    glDisable(GL_BLEND);
+    program.ambientLocation = glGetUniformLocation(program.program, "material.ambient");
+    program.diffuseLocation = glGetUniformLocation(program.program, "material.diffuse");
+    program.specularLocation = glGetUniformLocation(program.program, "material.specular");
+    program.shininessLocation = glGetUniformLocation(program.program, "material.shininess");
 
-    return;
-}
+    program.texSamplerLocation = glGetUniformLocation(program.program, "texSampler");
+    program.useTextureLocation = glGetUniformLocation(program.program, "material.useTexture");
+    program.texArraySamplerLocation = glGetUniformLocation(program.program, "texArraySampler");
+    program.textureLayerLocation = glGetUniformLocation(program.program, "textureLayer");
 
-void drawBase(GroundObject* ground, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+    // samplers of different types must not share a unit even in draws that sample neither
+    if (program.texArraySamplerLocation >= 0) {
+        bindProgram(program.program);
+        setUniformInt(program.texArraySamplerLocation, TEXTURE_ARRAY_UNIT);
+    }
 
-    glUseProgram(shaderProgram.program);
+    program.positionScaleLocation = glGetUniformLocation(program.program, "positionScale");
+    program.positionOffsetLocation = glGetUniformLocation(program.program, "positionOffset");
+    program.texCoordTransformLocation = glGetUniformLocation(program.program, "texCoordTransform");
+    program.octahedralNormalLocation = glGetUniformLocation(program.program, "octahedralNormal");
 
-    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), ground->position);
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(ground->size));
+    bindLightingBlock(program.program);
 
-    // send matrices to the vertex & fragment shader
-    setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    program.instanceModelMatrixLocation = glGetAttribLocation(program.program, "instanceModelMatrix");
+    program.instanceNormalMatrixLocation = glGetAttribLocation(program.program, "instanceNormalMatrix");
+    program.PVmatrixLocation = glGetUniformLocation(program.program, "PVmatrix");
 
-    setMaterialUniforms(
-        groundGeometry->ambient,
-        groundGeometry->diffuse,
-        groundGeometry->specular,
-        groundGeometry->shininess,
-        groundGeometry->texture
-    );
+    program.drawIndexLocation = glGetAttribLocation(program.program, "drawIndex");
+}
 
-    // draw geometry
-    glBindVertexArray(groundGeometry->vertexArrayObject);
-    glDrawElements(GL_TRIANGLES, groundGeometry->numTriangles * 3, GL_UNSIGNED_INT, 0);
+//the same source with defines added right after #version, version replaces the one of the source if not empty
+static std::string shaderVariant(const std::string& source, const std::string& version, const std::string& defines) {
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    std::string variant = source;
+    size_t versionEnd = variant.find('\n');
+    if (!version.empty() && variant.compare(0, 8, "#version") == 0)
+        variant.replace(0, versionEnd != std::string::npos ? versionEnd : variant.size(), version);
 
-    return;
+    versionEnd = variant.find('\n');
+    variant.insert(versionEnd != std::string::npos ? versionEnd + 1 : 0, defines);
+    return variant;
 }
 
-void cleanupShaderPrograms() {
-
-    pgr::deleteProgramAndShaders(shaderProgram.program);
-    pgr::deleteProgramAndShaders(skyboxShaderProgram.program);
-    pgr::deleteProgramAndShaders(fireShaderProgram.program);
-    pgr::deleteProgramAndShaders(waterShaderProgram.program);
+bool gpuDrivenAvailable() {
 
+    return indirectShaderProgram.program != 0 && indirectShaderProgram.drawIndexLocation >= 0 && gpuCullingReady();
 }
 
-void initializeShaderPrograms() {
+//shader programs are built from sources read by the startup workers
+void initializeCommonShaderProgram(const std::string& vertexSource, const std::string& fragmentSource) {
 
     std::vector<GLuint> shaderList;
 
     if (!day == 1) {
 
-        shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "lightingPerVertex.vert"));
-        shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "lightingPerVertex.frag"));
+        shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, vertexSource));
+        shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
 
         shaderProgram.program = pgr::createProgram(shaderList);
+        initializeCommonShaderLocations(shaderProgram);
+        shaderList.clear();
 
-        shaderProgram.posLocation = glGetAttribLocation(shaderProgram.program, "position");
-        shaderProgram.normalLocation = glGetAttribLocation(shaderProgram.program, "normal");
-        shaderProgram.texCoordLocation = glGetAttribLocation(shaderProgram.program, "texCoord");
-
-        shaderProgram.PVMmatrixLocation = glGetUniformLocation(shaderProgram.program, "PVMmatrix");
-        shaderProgram.VmatrixLocation = glGetUniformLocation(shaderProgram.program, "Vmatrix");
-        shaderProgram.MmatrixLocation = glGetUniformLocation(shaderProgram.program, "Mmatrix");
-        shaderProgram.normalMatrixLocation = glGetUniformLocation(shaderProgram.program, "normalMatrix");
-        shaderProgram.timeLocation = glGetUniformLocation(shaderProgram.program, "time");
-
-        shaderProgram.ambientLocation = glGetUniformLocation(shaderProgram.program, "material.ambient");
-        shaderProgram.diffuseLocation = glGetUniformLocation(shaderProgram.program, "material.diffuse");
-        shaderProgram.specularLocation = glGetUniformLocation(shaderProgram.program, "material.specular");
-        shaderProgram.shininessLocation = glGetUniformLocation(shaderProgram.program, "material.shininess");
-
-        shaderProgram.texSamplerLocation = glGetUniformLocation(shaderProgram.program, "texSampler");
-        shaderProgram.useTextureLocation = glGetUniformLocation(shaderProgram.program, "material.useTexture");
-
-        shaderProgram.torchPositionLocation = glGetUniformLocation(shaderProgram.program, "torchPosition");
-        shaderProgram.torchDirectionLocation = glGetUniformLocation(shaderProgram.program, "torchDirection");
-        shaderProgram.torchOnLocation = glGetUniformLocation(shaderProgram.program, "torchOn");
-        shaderProgram.dayTimeLocation = glGetUniformLocation(shaderProgram.program, "dayTime");
-        shaderProgram.fogColourLocation = glGetUniformLocation(shaderProgram.program, "fogColour");
-        shaderProgram.fogOnLocation = glGetUniformLocation(shaderProgram.program, "fogOn");
+        // instanced variant - the same source with INSTANCED defined right after #version
+        shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, shaderVariant(vertexSource, "", "#define INSTANCED\n")));
+        shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
+
+        instancedShaderProgram.program = pgr::createProgram(shaderList);
+        initializeCommonShaderLocations(instancedShaderProgram);
         shaderList.clear();
+
+#if GPU_DRIVEN_DRAWING
+        // GPU driven variant - storage buffers need #version 430, the fragment shader stays the same
+        if (gpuCullingSupported()) {
+            GLuint vertexShader = pgr::createShaderFromSource(GL_VERTEX_SHADER, shaderVariant(vertexSource, "#version 430", "#define INDIRECT\n"));
+            if (vertexShader != 0) {
+                shaderList.push_back(vertexShader);
+                shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
+
+                indirectShaderProgram.program = pgr::createProgram(shaderList);
+                if (indirectShaderProgram.program != 0)
+                    initializeCommonShaderLocations(indirectShaderProgram);
+                shaderList.clear();
+            }
+            if (indirectShaderProgram.program == 0)
+                std::cerr << "initializeCommonShaderProgram(): INDIRECT variant failed to build, drawing stays on the render queue" << std::endl;
+        }
+#endif
     }
-    
+}
+
+void initializeSkyboxShaderProgram(const std::string& vertexSource, const std::string& fragmentSource) {
 
-    shaderList.clear();
+    std::vector<GLuint> shaderList;
 
-    shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "skybox.vert"));
-    shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "skybox.frag"));
+    shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, vertexSource));
+    shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
 
     skyboxShaderProgram.program = pgr::createProgram(shaderList);
 
@@ -567,15 +915,15 @@ void initializeShaderPrograms() {
     skyboxShaderProgram.skyboxSampler2Location = glGetUniformLocation(skyboxShaderProgram.program, "skyboxSampler2");
     skyboxShaderProgram.inversePVmatrixLocation = glGetUniformLocation(skyboxShaderProgram.program, "inversePVmatrix");
 
-    skyboxShaderProgram.fogColourLocation = glGetUniformLocation(skyboxShaderProgram.program, "fogColour");
-    skyboxShaderProgram.fogActiveLocation = glGetUniformLocation(skyboxShaderProgram.program, "fogActive");
-    skyboxShaderProgram.blendFactorLocation = glGetUniformLocation(skyboxShaderProgram.program, "blendFactor");
+    bindLightingBlock(skyboxShaderProgram.program);
+}
 
-    shaderList.clear();
+void initializeWaterShaderProgram(const std::string& vertexSource, const std::string& fragmentSource) {
 
+    std::vector<GLuint> shaderList;
 
-        shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "water.vert"));
-        shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "water.frag"));
+        shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, vertexSource));
+        shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
 
         waterShaderProgram.program = pgr::createProgram(shaderList);
 
@@ -586,12 +934,15 @@ void initializeShaderPrograms() {
         waterShaderProgram.VmatrixLocation = glGetUniformLocation(waterShaderProgram.program, "Vmatrix");
         waterShaderProgram.texSamplerLocation = glGetUniformLocation(waterShaderProgram.program, "texSampler");
         waterShaderProgram.frameDurationLocation = glGetUniformLocation(waterShaderProgram.program, "frameDuration");
-        
-        shaderList.clear();
+}
+
+void initializeFireShaderProgram(const std::string& vertexSource, const std::string& fragmentSource) {
+
+    std::vector<GLuint> shaderList;
 
         // push vertex shader and fragment shader
-        shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "dynamicTexture.vert"));
-        shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "dynamicTexture.frag"));
+        shaderList.push_back(pgr::createShaderFromSource(GL_VERTEX_SHADER, vertexSource));
+        shaderList.push_back(pgr::createShaderFromSource(GL_FRAGMENT_SHADER, fragmentSource));
 
         // create the program with two shaders
         fireShaderProgram.program = pgr::createProgram(shaderList);
@@ -608,84 +959,578 @@ void initializeShaderPrograms() {
 }
 
 
-//load single mesh
-bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
-    Assimp::Importer importer;
+//reads whole shader file, runs on a startup worker
+std::string readShaderSource(const std::string& fileName) {
 
-    // Unitize object in size (scale the model to fit into (-1..1)^3)
-    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+    std::ifstream stream(fileName.c_str(), std::ios::binary);
+    if (!stream) {
+        std::cerr << "readShaderSource(): can not open " << fileName << std::endl;
+        return std::string();
+    }
 
-    // Load asset from the file - you can play with various processing steps
-    const aiScene* scn = importer.ReadFile(fileName.c_str(), 0
-        | aiProcess_Triangulate             // Triangulate polygons (if any).
-        | aiProcess_PreTransformVertices    // Transforms scene hierarchy into one root with geometry-leafs only. For more see Doc.
-        | aiProcess_GenSmoothNormals        // Calculate normals per vertex.
-        | aiProcess_JoinIdenticalVertices);
+    std::stringstream source;
+    source << stream.rdbuf();
+    return source.str();
+}
 
-    // abort if the loader fails
-    if (scn == NULL) {
-        std::cerr << "assimp error: " << importer.GetErrorString() << std::endl;
-        *geometry = NULL;
-        return false;
+//startup task ids of the shader programs, geometry uploads depend on them
+static int commonShaderTask = -1;
+static int skyboxShaderTask = -1;
+static int waterShaderTask = -1;
+static int fireShaderTask = -1;
+
+typedef struct ShaderSources {
+  std::string vertex;
+  std::string fragment;
+} ShaderSources;
+
+static int addShaderTask(const std::string& vertexFile, const std::string& fragmentFile,
+                         void (*initialize)(const std::string&, const std::string&)) {
+
+    ShaderSources* sources = new ShaderSources;
+
+    return addStartupTask("shader " + vertexFile + " + " + fragmentFile,
+        [=]() {
+            sources->vertex = readShaderSource(vertexFile);
+            sources->fragment = readShaderSource(fragmentFile);
+        },
+        [=]() {
+            initialize(sources->vertex, sources->fragment);
+            delete sources;
+            CHECK_GL_ERROR();
+        }
+    );
+}
+
+//schedules the shader programs, they are built by runStartupTasks
+void initializeShaderPrograms() {
+
+    commonShaderTask = addShaderTask("lightingPerVertex.vert", "lightingPerVertex.frag", initializeCommonShaderProgram);
+    skyboxShaderTask = addShaderTask("skybox.vert", "skybox.frag", initializeSkyboxShaderProgram);
+    waterShaderTask = addShaderTask("water.vert", "water.frag", initializeWaterShaderProgram);
+    fireShaderTask = addShaderTask("dynamicTexture.vert", "dynamicTexture.frag", initializeFireShaderProgram);
+
+#if GPU_DRIVEN_DRAWING
+    std::string* cullingSource = new std::string;
+    addStartupTask("shader gpuCulling.comp",
+        [=]() { *cullingSource = readShaderSource("gpuCulling.comp"); },
+        [=]() {
+            initGpuCulling(*cullingSource);
+            delete cullingSource;
+            CHECK_GL_ERROR();
+        }
+    );
+#endif
+}
+
+
+//static meshes of one vertex layout share the pages of its arena, indexed by VertexFormat
+static GeometryArena meshArenas[2];
+
+static GeometryArena* meshArena(VertexFormat format) {
+
+    GeometryArena* arena = &meshArenas[format];
+    if (arena->vertexSize == 0)
+        initGeometryArena(arena, vertexFormatSize(format));
+    return arena;
+}
+
+void getGeometryArenaStats(ArenaStats* stats) {
+
+    memset(stats, 0, sizeof(ArenaStats));
+    for (int format = 0; format < 2; format++)
+        addGeometryArenaStats(meshArenas[format], stats);
+}
+
+//uploads vertices already in geometry->vertexFormat and indices of indexSize bytes, fills the buffers, VAO and levels of detail
+//numVertices, the format and its dequantization ranges must be set, setMeshAttributes needs them
+static void createMeshBufferObjects(MeshGeometry* geometry, const std::string& name, const void* vertexData, const void* indexData, size_t indexSize,
+                                    size_t numIndices, const MeshLod* lods, size_t numLods, SCommonShaderProgram& shader) {
+
+    const size_t numVertices = geometry->numVertices;
+    const size_t vertexSize = vertexFormatSize(geometry->vertexFormat);
+    geometry->indexType = indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    geometry->arenaAllocation.page = NULL;
+    geometry->baseVertex = 0;
+    geometry->indexByteOffset = 0;
+
+#if GEOMETRY_ARENA
+    // meshes of one vertex layout share the page buffers and are drawn from the page VAO
+    GeometryArena* arena = meshArena(geometry->vertexFormat);
+    if (allocateArenaMesh(arena, vertexData, numVertices, indexData, indexSize * numIndices, &geometry->arenaAllocation)) {
+        ArenaPage* page = geometry->arenaAllocation.page;
+        if (page->vertexArrayObject == 0) {
+            glGenVertexArrays(1, &page->vertexArrayObject);
+            glBindVertexArray(page->vertexArrayObject);
+
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->elementBufferObject);
+            glBindBuffer(GL_ARRAY_BUFFER, page->vertexBufferObject);
+            setMeshAttributes(geometry, shader);
+
+            glBindVertexArray(0);
+        }
+
+        geometry->vertexBufferObject = page->vertexBufferObject;
+        geometry->elementBufferObject = page->elementBufferObject;
+        geometry->vertexArrayObject = page->vertexArrayObject;
+        geometry->baseVertex = arenaBaseVertex(*arena, geometry->arenaAllocation);
+        geometry->indexByteOffset = geometry->arenaAllocation.indices.offset;
     }
+    else {
+        std::cerr << "createMeshBufferObjects(): no arena page for " << name << ", using own buffers" << std::endl;
+    }
+#endif
 
-    // some formats store whole scene (multiple meshes and materials, lights, cameras, ...) in one file, we cannot handle that in our simplified example
-    if (scn->mNumMeshes != 1) {
-        std::cerr << "this simplified loader can only process files with only one mesh" << std::endl;
-        *geometry = NULL;
+    if (geometry->arenaAllocation.page == NULL) {
+        glGenBuffers(1, &(geometry->vertexBufferObject));
+        glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+        glBufferData(GL_ARRAY_BUFFER, vertexSize * numVertices, vertexData, GL_STATIC_DRAW);
+
+        glGenVertexArrays(1, &(geometry->vertexArrayObject));
+        glBindVertexArray(geometry->vertexArrayObject);
+
+        glGenBuffers(1, &(geometry->elementBufferObject));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * numIndices, indexData, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+        setMeshAttributes(geometry, shader);
+
+        glBindVertexArray(0);
+    }
+
+    geometry->numLods = 1;
+    geometry->lods[0].firstIndex = 0;
+    geometry->lods[0].numIndices = (uint32_t)numIndices;
+    geometry->lods[0].error = 0.0f;
+    if (numLods > 0) {
+        geometry->numLods = (unsigned int)std::min(numLods, (size_t)MESH_MAX_LODS);
+        for (unsigned int i = 0; i < geometry->numLods; i++)
+            geometry->lods[i] = lods[i];
+    }
+    geometry->numTriangles = geometry->lods[0].numIndices / 3;
+}
+
+//creates VBO, EBO and VAO, the vertex layout is chosen per mesh and the bounds are computed from the positions
+//with GEOMETRY_ARENA the mesh gets blocks of the shared page buffers and the page VAO instead
+//indices should already be in the optimized order (mesh_optimizer.h), they are only narrowed to 16 bits when they fit
+//lods are ranges of the indices (mesh_simplifier.h), none = one level with all of them
+void createMeshBuffers(MeshGeometry* geometry, const std::string& name, const VertexStreams& streams, const unsigned int* indices, size_t numIndices,
+                       const MeshLod* lods, size_t numLods, SCommonShaderProgram& shader) {
+
+    const size_t numVertices = streams.numVertices;
+    computeMeshBounds(geometry, streams.positions, numVertices, streams.positionStride);
+
+    geometry->numVertices = numVertices;
+    geometry->vertexFormat = VERTEX_FORMAT_FLOAT;
+    geometry->positionScale = glm::vec3(1.0f);
+    geometry->positionOffset = glm::vec3(0.0f);
+    geometry->texCoordTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+    std::vector<CompactVertex> compactVertices;
+    std::vector<float> interleavedVertices;
+
+#if COMPACT_VERTICES
+    // positions are quantized in the mesh box, meshes with too wide UV range stay in floats
+    if (encodeCompactVertices(streams, geometry->boundsMin, geometry->boundsMax, &compactVertices, &geometry->texCoordTransform)) {
+        geometry->vertexFormat = VERTEX_FORMAT_COMPACT;
+        geometry->positionScale = geometry->boundsMax - geometry->boundsMin;
+        geometry->positionOffset = geometry->boundsMin;
+    }
+#endif
+
+    const void* vertexData = compactVertices.data();
+    if (geometry->vertexFormat == VERTEX_FORMAT_FLOAT) {
+        // mapped cache blobs already are interleaved and go to OpenGL as they are
+        if (isInterleavedFloatLayout(streams)) {
+            vertexData = streams.positions;
+        }
+        else {
+            copyInterleavedVertices(streams, &interleavedVertices);
+            vertexData = interleavedVertices.data();
+        }
+    }
+
+    const size_t vertexSize = vertexFormatSize(geometry->vertexFormat);
+
+    // half the index bytes for all but the biggest meshes, indices stay relative to the mesh with a base vertex
+    std::vector<unsigned short> shortIndices;
+    const void* indexData = indices;
+    size_t indexSize = sizeof(unsigned int);
+
+    if (numVertices < 65536) {
+        shortIndices.assign(indices, indices + numIndices);
+        indexData = shortIndices.data();
+        indexSize = sizeof(unsigned short);
+    }
+
+    createMeshBufferObjects(geometry, name, vertexData, indexData, indexSize, numIndices, lods, numLods, shader);
+
+    const size_t floatSize = vertexFormatSize(VERTEX_FORMAT_FLOAT);
+    VertexCacheStats cacheStats = analyzeVertexCache(indices, geometry->lods[0].numIndices, numVertices, VERTEX_CACHE_FIFO_SIZE);
+    std::cout << "Vertex buffer of " << name << ": " << numVertices << " vertices, "
+              << (geometry->vertexFormat == VERTEX_FORMAT_COMPACT ? "compact " : "float ") << vertexSize << " B each, "
+              << (floatSize - vertexSize) * numVertices + (sizeof(unsigned int) - indexSize) * numIndices << " B saved, "
+              << indexSize * 8 << " bit indices" << (geometry->arenaAllocation.page != NULL ? " in arena" : "") << ", ACMR " << cacheStats.acmr << ", ATVR " << cacheStats.atvr << ", LOD triangles";
+    for (unsigned int i = 0; i < geometry->numLods; i++)
+        std::cout << (i == 0 ? " " : "/") << geometry->lods[i].numIndices / 3;
+    std::cout << std::endl;
+}
+
+//planar streams of CPU mesh data
+static VertexStreams meshDataStreams(const MeshData& mesh) {
+
+    VertexStreams streams;
+    streams.positions = mesh.positions.data();
+    streams.normals = mesh.normals.data();
+    streams.texCoords = mesh.texCoords.data();
+    streams.positionStride = 3;
+    streams.normalStride = 3;
+    streams.texCoordStride = 2;
+    streams.numVertices = mesh.positions.size() / 3;
+    return streams;
+}
+
+//Where startup texture time and video memory go, printed by printTextureReport
+typedef struct TextureLoadStats {
+  unsigned int  textures;           // 2D textures and cube map faces
+  unsigned int  cooked;             // of them uploaded from a KTX2 container
+  unsigned int  streamed;           // of the cooked ones only the placeholder levels, the rest is streamed
+  unsigned int  arrays;             // texture arrays, their layers are counted as cooked textures
+  unsigned int  decodedFallback;    // block levels decoded on the CPU, the driver has no S3TC
+  double        cookedTime;         // ms, mapping + upload
+  double        decodeTime;         // ms, pgr decode + upload + mipmap generation
+  size_t        cookedBytes;        // video memory of the levels, as stored
+  size_t        decodedBytes;       // RGBA8 with a full mip chain
+} TextureLoadStats;
+
+static TextureLoadStats textureStats;
+
+//all levels of the container into the bound texture, target is GL_TEXTURE_2D or a cube map face
+static void uploadTextureCache(const TextureCache& cache, GLenum target) {
+
+    const GLenum internalFormat = textureInternalFormat(cache.format);
+    const bool compressed = internalFormat != GL_RGBA8;
+
+    for (size_t i = 0; i < cache.levels.size(); i++) {
+        const TextureCacheLevel& level = cache.levels[i];
+
+        if (compressed) {
+            glCompressedTexImage2D(target, (GLint)i, internalFormat, level.width, level.height, 0, (GLsizei)level.size, level.data);
+            textureStats.cookedBytes += level.size;
+        }
+        else if (cache.format == TEXTURE_FORMAT_RGBA8) {
+            glTexImage2D(target, (GLint)i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+            textureStats.cookedBytes += level.size;
+        }
+        else {
+            // no decoder in the driver, the blocks are still cheaper to expand than the source image
+            TextureImage image;
+            decodeTextureLevel(level.data, cache.format, level.width, level.height, &image);
+            glTexImage2D(target, (GLint)i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+            textureStats.cookedBytes += image.pixels.size();
+        }
+    }
+    if (cache.format != TEXTURE_FORMAT_RGBA8 && !compressed)
+        textureStats.decodedFallback++;
+}
+
+//RGBA8 size of level 0 of the bound texture with the mip chain glGenerateMipmap adds
+static size_t decodedTextureBytes(GLenum target) {
+
+    GLint width = 0, height = 0;
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
+    return (size_t)width * height * 4 * 4 / 3;
+}
+
+static double millisecondsSince(const std::chrono::high_resolution_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//2D texture of the image, from its cooked KTX2 (mesh_cooker) if it is up to date, decoded by pgr otherwise
+static GLuint loadTexture(const std::string& fileName) {
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    textureStats.textures++;
+
+#if TEXTURE_STREAMING
+    size_t placeholderBytes = 0;
+    GLuint streamedTexture = createStreamedTexture(fileName, &placeholderBytes);
+    if (streamedTexture != 0) {
+        bindTexture(0, GL_TEXTURE_2D, 0);
+        textureStats.cooked++;
+        textureStats.streamed++;
+        textureStats.cookedBytes += placeholderBytes;
+        textureStats.cookedTime += millisecondsSince(start);
+        return streamedTexture;
+    }
+#endif
+
+    TextureCache cache;
+    if (openTextureCache(fileName, &cache)) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        uploadTextureCache(cache, GL_TEXTURE_2D);
+        closeTextureCache(&cache);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        textureStats.cooked++;
+        textureStats.cookedTime += millisecondsSince(start);
+        return texture;
+    }
+
+    GLuint texture = pgr::createTexture(fileName);
+    if (texture != 0) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        textureStats.decodedBytes += decodedTextureBytes(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    textureStats.decodeTime += millisecondsSince(start);
+    return texture;
+}
+
+//one face of the bound cube map, mipmapped is cleared if the face has no cooked levels and needs glGenerateMipmap
+static bool loadTextureImage(const std::string& fileName, GLenum target, bool* mipmapped) {
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    textureStats.textures++;
+
+    TextureCache cache;
+    if (openTextureCache(fileName, &cache)) {
+        uploadTextureCache(cache, target);
+        closeTextureCache(&cache);
+
+        textureStats.cooked++;
+        textureStats.cookedTime += millisecondsSince(start);
+        return true;
+    }
+
+    *mipmapped = false;
+    bool loaded = pgr::loadTexImage2D(fileName, target);
+    if (loaded)
+        textureStats.decodedBytes += decodedTextureBytes(target);
+    textureStats.decodeTime += millisecondsSince(start);
+    return loaded;
+}
+
+//file to read ahead on a worker for the texture, the container if there is one
+static std::string texturePrefetchFile(const std::string& fileName) {
+
+    const std::string containerFile = textureCachePath(fileName);
+    std::ifstream container(containerFile.c_str(), std::ios::binary);
+    return container ? containerFile : fileName;
+}
+
+void printTextureReport() {
+
+    std::cout << "textures: " << textureStats.textures << " loaded, " << textureStats.cooked << " from KTX2 (" << textureStats.streamed << " streamed) in " << textureStats.cookedTime
+              << " ms (" << textureStats.cookedBytes / (1024.0 * 1024.0) << " MB video memory";
+    if (textureStats.decodedFallback > 0)
+        std::cout << ", " << textureStats.decodedFallback << " expanded to RGBA8 without S3TC";
+    if (textureStats.arrays > 0)
+        std::cout << ", " << textureStats.arrays << " texture arrays";
+    std::cout << "), " << textureStats.textures - textureStats.cooked << " decoded in " << textureStats.decodeTime
+              << " ms (" << textureStats.decodedBytes / (1024.0 * 1024.0) << " MB video memory)" << std::endl;
+}
+
+#if TEXTURE_ARRAYS
+//Part texture file waiting for buildTextureArrays
+typedef struct ArrayTextureUse {
+  std::string             fileName;
+  TextureFormat           format;
+  std::vector<MeshPart*>  parts;
+} ArrayTextureUse;
+
+static std::vector<ArrayTextureUse> arrayTextureUses;
+static std::vector<GLuint> textureArrays;
+#endif
+
+//leaves the texture of the part to buildTextureArrays if the file can be an array layer
+static bool deferArrayTexture(const std::string& fileName, MeshPart* part) {
+
+#if TEXTURE_ARRAYS
+    for (size_t i = 0; i < arrayTextureUses.size(); i++) {
+        if (arrayTextureUses[i].fileName == fileName) {
+            arrayTextureUses[i].parts.push_back(part);
+            return true;
+        }
+    }
+
+    ArrayTextureUse use;
+    if (!textureArrayCandidate(fileName, TEXTURE_ARRAY_LAYER_SIZE, &use.format))
         return false;
+    use.fileName = fileName;
+    use.parts.push_back(part);
+    arrayTextureUses.push_back(use);
+    return true;
+#else
+    return false;
+#endif
+}
+
+//packs the deferred part textures into one array per format, a format with a single texture gets a plain one
+static void buildTextureArrays() {
+
+#if TEXTURE_ARRAYS
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    const TextureFormat formats[] = { TEXTURE_FORMAT_RGBA8, TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3 };
+
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        std::vector<ArrayTextureUse*> layers;
+        std::vector<std::string> fileNames;
+        for (size_t i = 0; i < arrayTextureUses.size(); i++) {
+            if (arrayTextureUses[i].format == formats[f]) {
+                layers.push_back(&arrayTextureUses[i]);
+                fileNames.push_back(arrayTextureUses[i].fileName);
+            }
+        }
+
+        size_t bytes = 0;
+        GLuint array = fileNames.size() >= 2 ? createTextureArray(fileNames, TEXTURE_ARRAY_LAYER_SIZE, &bytes) : 0;
+        if (array == 0)
+            continue;
+
+        std::cout << "Texture array of " << fileNames.size() << " layers:";
+        for (size_t layer = 0; layer < layers.size(); layer++) {
+            std::cout << " " << layers[layer]->fileName;
+            for (size_t p = 0; p < layers[layer]->parts.size(); p++) {
+                layers[layer]->parts[p]->texture = array;
+                layers[layer]->parts[p]->textureLayer = (int)layer;
+            }
+            layers[layer]->parts.clear();
+        }
+        std::cout << std::endl;
+
+        textureArrays.push_back(array);
+        textureStats.arrays++;
+        textureStats.textures += (unsigned int)layers.size();
+        textureStats.cooked += (unsigned int)layers.size();
+        textureStats.cookedBytes += bytes;
     }
+    textureStats.cookedTime += millisecondsSince(start);
+
+    // the rest is loaded as before
+    for (size_t i = 0; i < arrayTextureUses.size(); i++) {
+        if (arrayTextureUses[i].parts.empty())
+            continue;
+        std::cout << "Loading texture file: " << arrayTextureUses[i].fileName << std::endl;
+        GLuint texture = loadTexture(arrayTextureUses[i].fileName);
+        for (size_t p = 0; p < arrayTextureUses[i].parts.size(); p++)
+            arrayTextureUses[i].parts[p]->texture = texture;
+    }
+    arrayTextureUses.clear();
+    CHECK_GL_ERROR();
+#endif
+}
 
-    // in this phase we know we have one mesh in our loaded scene, we can directly copy its data to OpenGL ...
-    const aiMesh* mesh = scn->mMeshes[0];
+//makes a part of every material and loads the diffuse textures, each file once
+//ranges[level * materials.size() + material], a mesh without them is one part drawn with the whole levels
+void setMeshParts(MeshGeometry* geometry, const std::vector<MeshMaterial>& materials, const MeshRange* ranges, size_t numRanges) {
 
-    *geometry = new MeshGeometry;
+    const size_t numParts = materials.size();
+    const bool hasRanges = numParts > 0 && numRanges == geometry->numLods * numParts;
 
-    // vertex buffer object, store all vertex positions and normals
-    glGenBuffers(1, &((*geometry)->vertexBufferObject));
-    glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
-    glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float) * mesh->mNumVertices, 0, GL_STATIC_DRAW); // allocate memory for vertices, normals, and texture coordinates
-    // first store all vertices
-    glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float) * mesh->mNumVertices, mesh->mVertices);
-    // then store all normals
-    glBufferSubData(GL_ARRAY_BUFFER, 3 * sizeof(float) * mesh->mNumVertices, 3 * sizeof(float) * mesh->mNumVertices, mesh->mNormals);
+    geometry->parts.resize(hasRanges ? numParts : 1);
 
-    // just texture 0 for now
-    float* textureCoords = new float[2 * mesh->mNumVertices];  // 2 floats per vertex
-    float* currentTextureCoord = textureCoords;
+    for (size_t p = 0; p < geometry->parts.size(); p++) {
+        MeshPart& part = geometry->parts[p];
 
-    // copy texture coordinates
-    aiVector3D vect;
+        if (p < numParts) {
+            part.ambient = materials[p].ambient;
+            part.diffuse = materials[p].diffuse;
+            part.specular = materials[p].specular;
+            part.shininess = materials[p].shininess;
+        }
+        else {
+            part.ambient = glm::vec3(0.0f);
+            part.diffuse = glm::vec3(0.6f);
+            part.specular = glm::vec3(0.0f);
+            part.shininess = 0.0f;
+        }
 
-    if (mesh->HasTextureCoords(0)) {
-        // we use 2D textures with 2 coordinates and ignore the third coordinate
-        for (unsigned int idx = 0; idx < mesh->mNumVertices; idx++) {
-            vect = (mesh->mTextureCoords[0])[idx];
-            *currentTextureCoord++ = vect.x;
-            *currentTextureCoord++ = vect.y;
+        part.texture = 0;
+        part.textureLayer = -1;
+        const std::string texturePath = p < numParts ? materials[p].texturePath : std::string();
+        if (!texturePath.empty()) {
+            for (size_t q = 0; q < p; q++) {
+                if (materials[q].texturePath == texturePath)
+                    part.texture = geometry->parts[q].texture;
+            }
+            if (part.texture == 0 && !deferArrayTexture(texturePath, &part)) {
+                std::cout << "Loading texture file: " << texturePath << std::endl;
+                part.texture = loadTexture(texturePath);
+            }
+        }
+
+        for (unsigned int level = 0; level < MESH_MAX_LODS; level++) {
+            MeshRange range = { 0, 0 };
+            if (level < geometry->numLods) {
+                if (hasRanges) {
+                    range = ranges[level * numParts + p];
+                }
+                else {
+                    range.firstIndex = geometry->lods[level].firstIndex;
+                    range.numIndices = geometry->lods[level].numIndices;
+                }
+            }
+            part.ranges[level] = range;
         }
     }
+    CHECK_GL_ERROR();
+}
+
+//copies mesh parsed on CPU to OpenGL - all loaders end here
+bool uploadMeshData(const MeshData& mesh, const std::string& fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
 
-    // finally store all texture coordinates
-    glBufferSubData(GL_ARRAY_BUFFER, 6 * sizeof(float) * mesh->mNumVertices, 2 * sizeof(float) * mesh->mNumVertices, textureCoords);
+    const size_t numVertices = mesh.positions.size() / 3;
 
-    // copy all mesh faces into one big array (assimp supports faces with ordinary number of vertices, we use only 3 -> triangles)
-    unsigned int* indices = new unsigned int[mesh->mNumFaces * 3];
-    for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
-        indices[f * 3 + 0] = mesh->mFaces[f].mIndices[0];
-        indices[f * 3 + 1] = mesh->mFaces[f].mIndices[1];
-        indices[f * 3 + 2] = mesh->mFaces[f].mIndices[2];
+    if (numVertices == 0 || mesh.indices.empty()) {
+        *geometry = NULL;
+        return false;
     }
 
-    // copy our temporary index array to OpenGL and free the array
-    glGenBuffers(1, &((*geometry)->elementBufferObject));
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*geometry)->elementBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * sizeof(unsigned) * mesh->mNumFaces, indices, GL_STATIC_DRAW);
+    *geometry = new MeshGeometry;
+
+    createMeshBuffers(*geometry, fileName, meshDataStreams(mesh), mesh.indices.data(), mesh.indices.size(), mesh.lods.data(), mesh.lods.size(), shader);
 
-    delete[] indices;
+    setMeshParts(*geometry, mesh.materials, mesh.ranges.data(), mesh.ranges.size());
+    (*geometry)->id = fileName;
 
-    // copy the material info to MeshGeometry structure
-    const aiMaterial* mat = scn->mMaterials[mesh->mMaterialIndex];
+    return true;
+}
+
+//uploads mesh from its cooked blob, already simplified and optimized - float meshes send the mapped vertices to glBufferData as they are
+bool uploadMeshCache(const MeshCache& cache, const std::string& fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
+
+    const MeshCacheHeader* header = cache.header;
+    *geometry = new MeshGeometry;
+
+    VertexStreams streams;
+    streams.positions = cache.vertices;
+    streams.normals = cache.vertices + 3;
+    streams.texCoords = cache.vertices + 6;
+    streams.positionStride = 8;
+    streams.normalStride = 8;
+    streams.texCoordStride = 8;
+    streams.numVertices = header->numVertices;
+
+    createMeshBuffers(*geometry, fileName, streams, cache.indices, header->numIndices, header->lods, header->numLods, shader);
+    setMeshParts(*geometry, cache.materials, cache.ranges, (size_t)header->numLods * header->numMaterials);
+    (*geometry)->id = fileName;
+
+    return true;
+}
+
+//material specifics of an Assimp material, the texture path is made relative to the working directory
+static MeshMaterial assimpMaterial(const aiMaterial* mat, const std::string& fileName) {
+
+    MeshMaterial material;
     aiColor4D color;
     aiString name;
     aiReturn retValue = AI_SUCCESS;
@@ -695,16 +1540,15 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, M
 
     if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_DIFFUSE, &color)) != AI_SUCCESS)
         color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-
-    (*geometry)->diffuse = glm::vec3(color.r, color.g, color.b);
+    material.diffuse = glm::vec3(color.r, color.g, color.b);
 
     if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_AMBIENT, &color)) != AI_SUCCESS)
         color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-    (*geometry)->ambient = glm::vec3(color.r, color.g, color.b);
+    material.ambient = glm::vec3(color.r, color.g, color.b);
 
     if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_SPECULAR, &color)) != AI_SUCCESS)
         color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-    (*geometry)->specular = glm::vec3(color.r, color.g, color.b);
+    material.specular = glm::vec3(color.r, color.g, color.b);
 
     ai_real shininess, strength;
     unsigned int max;	// changed: to unsigned
@@ -715,67 +1559,309 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, M
     max = 1;
     if ((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS_STRENGTH, &strength, &max)) != AI_SUCCESS)
         strength = 1.0f;
-    (*geometry)->shininess = shininess * strength;
-
-    (*geometry)->texture = 0;
+    material.shininess = shininess * strength;
 
-    // load texture image
+    // texture image is loaded with the other parts in setMeshParts
     if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
         // get texture name 
         aiString path; // filename
 
-        aiReturn texFound = mat->GetTexture(aiTextureType_DIFFUSE, 0, &path);
-        std::string textureName = path.data;
+        mat->GetTexture(aiTextureType_DIFFUSE, 0, &path);
+        material.texturePath = path.data;
 
         size_t found = fileName.find_last_of("/\\");
         // insert correct texture file path 
-        if (found != std::string::npos) { // not found
-          //subMesh_p->textureName.insert(0, "/");
-            textureName.insert(0, fileName.substr(0, found + 1));
+        if (found != std::string::npos)
+            material.texturePath.insert(0, fileName.substr(0, found + 1));
+    }
+
+    return material;
+}
+
+//load mesh with any number of submeshes and materials
+bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, MeshGeometry** geometry) {
+    Assimp::Importer importer;
+
+    // Unitize object in size (scale the model to fit into (-1..1)^3)
+    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+
+    // Load asset from the file - you can play with various processing steps
+    const aiScene* scn = importer.ReadFile(fileName.c_str(), 0
+        | aiProcess_Triangulate             // Triangulate polygons (if any).
+        | aiProcess_PreTransformVertices    // Transforms scene hierarchy into one root with geometry-leafs only. For more see Doc.
+        | aiProcess_GenSmoothNormals        // Calculate normals per vertex.
+        | aiProcess_JoinIdenticalVertices);
+
+    // abort if the loader fails
+    if (scn == NULL) {
+        std::cerr << "assimp error: " << importer.GetErrorString() << std::endl;
+        *geometry = NULL;
+        return false;
+    }
+
+    // PreTransformVertices leaves one mesh per material, they are appended sorted by material into one vertex and index array
+    std::vector<unsigned int> meshOrder(scn->mNumMeshes);
+    for (unsigned int m = 0; m < scn->mNumMeshes; m++)
+        meshOrder[m] = m;
+    std::stable_sort(meshOrder.begin(), meshOrder.end(), [scn](unsigned int a, unsigned int b) {
+        return scn->mMeshes[a]->mMaterialIndex < scn->mMeshes[b]->mMaterialIndex;
+    });
+
+    MeshData meshData;
+    std::vector<int> materialParts(scn->mNumMaterials, -1);
+
+    for (unsigned int m = 0; m < scn->mNumMeshes; m++) {
+        const aiMesh* mesh = scn->mMeshes[meshOrder[m]];
+        if (mesh->mNumFaces == 0 || !mesh->HasNormals())
+            continue;
+
+        const unsigned int baseVertex = (unsigned int)(meshData.positions.size() / 3);
+
+        // copy positions and normals to CPU mesh data
+        meshData.positions.insert(meshData.positions.end(), (const float*)mesh->mVertices, (const float*)mesh->mVertices + 3 * mesh->mNumVertices);
+        meshData.normals.insert(meshData.normals.end(), (const float*)mesh->mNormals, (const float*)mesh->mNormals + 3 * mesh->mNumVertices);
+
+        // just texture 0 for now, we use 2D textures with 2 coordinates and ignore the third coordinate
+        for (unsigned int idx = 0; idx < mesh->mNumVertices; idx++) {
+            meshData.texCoords.push_back(mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][idx].x : 0.0f);
+            meshData.texCoords.push_back(mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][idx].y : 0.0f);
+        }
+
+        // meshes of one material follow each other, so they extend the same range
+        if (materialParts[mesh->mMaterialIndex] < 0) {
+            materialParts[mesh->mMaterialIndex] = (int)meshData.materials.size();
+            meshData.materials.push_back(assimpMaterial(scn->mMaterials[mesh->mMaterialIndex], fileName));
+            MeshRange range = { (uint32_t)meshData.indices.size(), 0 };
+            meshData.ranges.push_back(range);
         }
 
-        std::cout << "Loading texture file: " << textureName << std::endl;
-        (*geometry)->texture = pgr::createTexture(textureName);
+        // copy the triangles (assimp supports faces with ordinary number of vertices, we use only 3 -> triangles)
+        for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
+            if (mesh->mFaces[f].mNumIndices != 3)
+                continue;
+            for (int k = 0; k < 3; k++)
+                meshData.indices.push_back(baseVertex + mesh->mFaces[f].mIndices[k]);
+            meshData.ranges.back().numIndices += 3;
+        }
     }
-    CHECK_GL_ERROR();
 
-    glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
-    glBindVertexArray((*geometry)->vertexArrayObject);
+    if (meshData.indices.empty()) {
+        std::cerr << "loadSingleMesh(): " << fileName << " has no triangles" << std::endl;
+        *geometry = NULL;
+        return false;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*geometry)->elementBufferObject); // bind our element array buffer (indices) to vao
-    glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
+    // assimp order is arbitrary, reorder before copying to OpenGL
+    buildMeshLods(&meshData);
+    optimizeMesh(&meshData);
 
-    glEnableVertexAttribArray(shader.posLocation);
-    glVertexAttribPointer(shader.posLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    return uploadMeshData(meshData, fileName, shader, geometry);
+}
 
-    if (!day == 1) {
-        glEnableVertexAttribArray(shader.normalLocation);
-        glVertexAttribPointer(shader.normalLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)(3 * sizeof(float) * mesh->mNumVertices));
+//mesh on its way from disk to OpenGL, filled by prepareMesh and consumed by finishMesh
+typedef struct MeshLoad {
+  std::string   fileName;
+  MeshCache     cache;
+  bool          cached;     // blob is mapped in cache
+  MeshData      mesh;
+  bool          parsed;     // no valid blob, OBJ parsed into mesh
+} MeshLoad;
+
+//CPU part of mesh loading: cooked blob first, then native OBJ loader - no GL calls, safe on a worker thread
+void prepareMesh(MeshLoad* load) {
+
+    load->cached = openMeshCache(load->fileName, &load->cache);
+    load->parsed = false;
+
+    if (!load->cached) {
+        std::cout << "Mesh cache of " << load->fileName << " is missing or stale, run mesh_cooker to rebuild it" << std::endl;
+        load->parsed = parseObjFile(load->fileName, &load->mesh);
+
+        // cooked blobs are simplified and optimized by mesh_cooker, parsed meshes here on the worker
+        if (load->parsed) {
+            buildMeshLods(&load->mesh);
+            optimizeMesh(&load->mesh);
+        }
     }
-    else {
-        glDisableVertexAttribArray(shader.colorLocation);
-        // following line is problematic on AMD/ATI graphic cards
-        // -> if you see black screen (no objects at all) than try to set color manually in vertex shader to see at least something
-        glVertexAttrib3f(shader.colorLocation, color.r, color.g, color.b);
+
+    //textures are decoded by pgr on the context thread, at least have the files in memory by then
+    const std::vector<MeshMaterial>& materials = load->cached ? load->cache.materials : load->mesh.materials;
+    for (size_t i = 0; i < materials.size(); i++) {
+        if (!materials[i].texturePath.empty())
+            prefetchFile(texturePrefetchFile(materials[i].texturePath));
     }
+}
 
-    glEnableVertexAttribArray(shader.texCoordLocation);
-    glVertexAttribPointer(shader.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0, (void*)(6 * sizeof(float) * mesh->mNumVertices));
-    CHECK_GL_ERROR();
+//GL part of mesh loading, Assimp only for files the native loader can not handle
+bool finishMesh(MeshLoad* load, SCommonShaderProgram& shader, MeshGeometry** geometry) {
 
-    glBindVertexArray(0);
+    if (load->cached) {
+        bool uploaded = uploadMeshCache(load->cache, load->fileName, shader, geometry);
+        closeMeshCache(&load->cache);
+        load->cached = false;
+        return uploaded;
+    }
 
-    (*geometry)->numTriangles = mesh->mNumFaces;
+    if (load->parsed && uploadMeshData(load->mesh, load->fileName, shader, geometry))
+        return true;
 
-    return true;
+    std::cerr << "loadMesh(): falling back to assimp for " << load->fileName << std::endl;
+    return loadSingleMesh(load->fileName, shader, geometry);
 }
 
+#if MESH_LOADER_BENCHMARK
+//compares import time of Assimp and the native OBJ loader on all models, CPU part only (no GL upload)
+void benchmarkMeshLoaders() {
+
+    const char* models[] = {
+        GROUND_MODEL_NAME, PLANT_MODEL_NAME, TREE_MODEL_NAME, BENCH_MODEL_NAME, HALL_MODEL_NAME,
+        EAGLE_MODEL_NAME, HAT_MODEL_NAME, BROOM_MODEL_NAME, WAND_MODEL_NAME, FIREPLACE_MODEL_NAME
+    };
+
+    double assimpTotal = 0.0;
+    double nativeTotal = 0.0;
+
+    std::cout << "mesh loader benchmark (ms):" << std::endl;
+
+    for (size_t i = 0; i < sizeof(models) / sizeof(models[0]); i++) {
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+
+        Assimp::Importer importer;
+        importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+        const aiScene* scn = importer.ReadFile(models[i], 0
+            | aiProcess_Triangulate
+            | aiProcess_PreTransformVertices
+            | aiProcess_GenSmoothNormals
+            | aiProcess_JoinIdenticalVertices);
+
+        BenchmarkClock::time_point middle = BenchmarkClock::now();
+
+        MeshData mesh;
+        bool nativeLoaded = parseObjFile(models[i], &mesh);
+
+        BenchmarkClock::time_point end = BenchmarkClock::now();
+
+        double assimpTime = millisecondsBetween(start, middle);
+        double nativeTime = millisecondsBetween(middle, end);
+
+        if (scn == NULL || !nativeLoaded) {
+            std::cout << "  " << models[i] << ": skipped, assimp " << (scn != NULL ? "ok" : "failed")
+                      << ", native " << (nativeLoaded ? "ok" : "failed") << std::endl;
+            continue;
+        }
+
+        assimpTotal += assimpTime;
+        nativeTotal += nativeTime;
+
+        unsigned int assimpVertices = 0;
+        for (unsigned int m = 0; m < scn->mNumMeshes; m++)
+            assimpVertices += scn->mMeshes[m]->mNumVertices;
+
+        std::cout << "  " << models[i] << ": assimp " << assimpTime << ", native " << nativeTime
+                  << " (" << assimpTime / nativeTime << "x), vertices " << assimpVertices
+                  << " / " << mesh.positions.size() / 3 << ", materials " << scn->mNumMaterials << " / " << mesh.materials.size() << std::endl;
+    }
+
+    std::cout << "  total: assimp " << assimpTotal << ", native " << nativeTotal << std::endl;
+}
+#endif
+
+#if MESH_OPTIMIZER_BENCHMARK
+//vertex cache efficiency of all shipped models in the order they come from the OBJ files and after optimizeMesh
+//the rock is optimized by mesh_cooker --rock before it is embedded, the executable has only the result
+void benchmarkMeshOptimizer() {
+
+    const char* models[] = {
+        GROUND_MODEL_NAME, PLANT_MODEL_NAME, TREE_MODEL_NAME, BENCH_MODEL_NAME, HALL_MODEL_NAME,
+        EAGLE_MODEL_NAME, HAT_MODEL_NAME, BROOM_MODEL_NAME, WAND_MODEL_NAME, FIREPLACE_MODEL_NAME
+    };
+
+    std::cout << "mesh optimizer benchmark, FIFO " << VERTEX_CACHE_FIFO_SIZE << " ACMR / ATVR:" << std::endl;
+
+    for (size_t i = 0; i < sizeof(models) / sizeof(models[0]); i++) {
+        MeshData mesh;
+        if (!parseObjFile(models[i], &mesh)) {
+            std::cout << "  " << models[i] << ": skipped, can not load" << std::endl;
+            continue;
+        }
+
+        VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.positions.size() / 3, VERTEX_CACHE_FIFO_SIZE);
+
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        optimizeMesh(&mesh);
+        double time = millisecondsBetween(start, BenchmarkClock::now());
+
+        VertexCacheStats after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.positions.size() / 3, VERTEX_CACHE_FIFO_SIZE);
+
+        std::cout << "  " << models[i] << ": " << mesh.indices.size() / 3 << " triangles, ACMR " << before.acmr << " -> " << after.acmr
+                  << ", ATVR " << before.atvr << " -> " << after.atvr << " in " << time << " ms" << std::endl;
+    }
+}
+#endif
+
+#if TRANSFORM_CACHE_BENCHMARK
+//per frame matrix work of N static objects plus 1% moving ones, rebuilt every frame vs cached with dirty flags
+void benchmarkTransformCache() {
+
+    const int numFrames = 100;
+    const size_t counts[] = { 100, 1000, 10000, 100000 };
+
+    glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 10.0f);
+
+    std::cout << "transform cache benchmark, ms per frame (" << numFrames << " frames):" << std::endl;
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        std::vector<Object> objects(counts[c]);
+        for (size_t i = 0; i < objects.size(); i++) {
+            objects[i].position = glm::vec3(rand() % 200 - 100, 0.0f, rand() % 200 - 100);
+            objects[i].direction = glm::vec3(0.0f, 1.0f, 0.0f);
+            objects[i].rotationAngle = (float)(rand() % 360);
+            objects[i].size = 1.0f;
+        }
+        const size_t numMoving = std::max<size_t>(1, objects.size() / 100);
+        volatile float sink = 0.0f;     // keeps the results alive
+
+        // before - model, normal and PVM matrix of every object rebuilt for every draw
+        BenchmarkClock::time_point start = BenchmarkClock::now();
+        for (int frame = 0; frame < numFrames; frame++) {
+            for (size_t i = 0; i < objects.size(); i++) {
+                glm::mat4 modelMatrix = objectModelMatrix(OBJECT_TREE, &objects[i], viewMatrix);
+                glm::mat4 normalMatrix = normalMatrixOf(modelMatrix);
+                glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * modelMatrix;
+                sink += PVMmatrix[3][0] + normalMatrix[0][0];
+            }
+        }
+        double rebuildTime = millisecondsBetween(start, BenchmarkClock::now()) / numFrames;
+
+        // after - PV once per frame, matrices recomputed only for moved objects
+        start = BenchmarkClock::now();
+        for (int frame = 0; frame < numFrames; frame++) {
+            glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
+            for (size_t i = 0; i < numMoving; i++) {
+                objects[i].position.y = 0.01f * frame;
+                objects[i].transformDirty = true;
+            }
+            for (size_t i = 0; i < objects.size(); i++) {
+                updateObjectTransform(OBJECT_TREE, &objects[i], viewMatrix);
+                glm::mat4 PVMmatrix = PVmatrix * objects[i].modelMatrix;
+                sink += PVMmatrix[3][0] + objects[i].normalMatrix[0][0];
+            }
+        }
+        double cachedTime = millisecondsBetween(start, BenchmarkClock::now()) / numFrames;
+
+        std::cout << "  " << objects.size() << " objects (" << numMoving << " moving): rebuilt " << rebuildTime
+                  << ", cached " << cachedTime << " (" << rebuildTime / cachedTime << "x)" << std::endl;
+    }
+}
+#endif
+
 //Init all geometries we need 
 
 void initfireGeometry(GLuint shader, MeshGeometry** geometry) {
     *geometry = new MeshGeometry;
 
-    (*geometry)->texture = pgr::createTexture(FIRE_TEXTURE_NAME);
+    (*geometry)->texture = loadTexture(FIRE_TEXTURE_NAME);
     CHECK_GL_ERROR();
     glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
     glBindVertexArray((*geometry)->vertexArrayObject);
@@ -783,6 +1869,7 @@ void initfireGeometry(GLuint shader, MeshGeometry** geometry) {
     glGenBuffers(1, &((*geometry)->vertexBufferObject)); \
         glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
     glBufferData(GL_ARRAY_BUFFER, sizeof(fireVertexData), fireVertexData, GL_STATIC_DRAW);
+    computeMeshBounds(*geometry, fireVertexData, fireNumQuadVertices, 5);
 
     glEnableVertexAttribArray(fireShaderProgram.posLocation);
     // vertices of triangles - start at the beginning of the array (interlaced array)
@@ -836,10 +1923,12 @@ void initSkyboxGeometry(GLuint shader, CubeMapGeometry** geometry){
       GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
     };
 
+    // cooked faces come with their levels, mipmaps are generated only if some face was decoded
+    bool mipmapped = true;
     for (int i = 0; i < 6; i++) {
         std::string texName = std::string(SKYBOX_PREFIX_DAY) + std::to_string(i+1) + ".png";
         
-        if (!pgr::loadTexImage2D(texName, targets[i])) {
+        if (!loadTextureImage(texName, targets[i], &mipmapped)) {
             pgr::dieWithError("Skybox cube map 1 loading failed!");
         }
     }
@@ -849,16 +1938,18 @@ void initSkyboxGeometry(GLuint shader, CubeMapGeometry** geometry){
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    if (!mipmapped)
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
     glActiveTexture(GL_TEXTURE1);
 
+    mipmapped = true;
     for (int i = 0; i < 6; i++) {
         std::string texName = std::string(SKYBOX_PREFIX_NIGHT) + std::to_string(i + 1) + ".jpg";
         
-        if (!pgr::loadTexImage2D(texName, targets[i])) {
+        if (!loadTextureImage(texName, targets[i], &mipmapped)) {
             pgr::dieWithError("Skybox cube map 2 loading failed!");
         }
     }
@@ -868,7 +1959,8 @@ void initSkyboxGeometry(GLuint shader, CubeMapGeometry** geometry){
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    if (!mipmapped)
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
     glActiveTexture(GL_TEXTURE0);
 
 }
@@ -877,7 +1969,7 @@ void initWaterGeometry(GLuint shader, MeshGeometry** geometry) {
 
     *geometry = new MeshGeometry;
 
-    (*geometry)->texture = pgr::createTexture(WATER_TEXTURE_NAME);
+    (*geometry)->texture = loadTexture(WATER_TEXTURE_NAME);
 
     glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
     glBindVertexArray((*geometry)->vertexArrayObject);
@@ -885,6 +1977,7 @@ void initWaterGeometry(GLuint shader, MeshGeometry** geometry) {
     glGenBuffers(1, &((*geometry)->vertexBufferObject)); \
         glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
     glBufferData(GL_ARRAY_BUFFER, sizeof(waterVertexData), waterVertexData, GL_STATIC_DRAW);
+    computeMeshBounds(*geometry, waterVertexData, waterNumQuadVertices, 5);
 
     glEnableVertexAttribArray(waterShaderProgram.posLocation);
     // vertices of triangles - start at the beginning of the array (interlaced array)
@@ -899,129 +1992,170 @@ void initWaterGeometry(GLuint shader, MeshGeometry** geometry) {
     (*geometry)->numTriangles = waterNumQuadVertices;
 }
 
+//the rock blob is linked into the executable already optimized, quantized and with its levels (embedded_mesh.h)
+//both blocks go from the mapped image straight to glBufferData, nothing is parsed or copied
 void initRockGeometry(SCommonShaderProgram& shader, MeshGeometry** geometry) {
 
-    *geometry = new MeshGeometry;
-
-    glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
-    glBindVertexArray((*geometry)->vertexArrayObject);
-
-    glGenBuffers(1, &((*geometry)->vertexBufferObject));
-    glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
-    glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float) * cliff_rock_two_objNVertices, cliff_rock_two_objVertices, GL_STATIC_DRAW);
-    (*geometry)->texture = pgr::createTexture("data/rock_hardcoded/rock_texture.png");
-
-    // copy our temporary index array to opengl and free the array
-    glGenBuffers(1, &((*geometry)->elementBufferObject));
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (*geometry)->elementBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * sizeof(unsigned int) * cliff_rock_two_objNTriangles, cliff_rock_two_objTriangles, GL_STATIC_DRAW);
+    const char* data;
+    size_t size;
+    EmbeddedMesh rock;
+    if (!findEmbeddedData(ROCK_MESH_RESOURCE, &data, &size) || !parseEmbeddedMesh(data, size, &rock)) {
+        std::cerr << "initRockGeometry(): no valid " << ROCK_MODEL_NAME << " in the executable, run mesh_cooker --rock" << std::endl;
+        *geometry = NULL;
+        return;
+    }
 
-    glEnableVertexAttribArray(shader.posLocation);
-    // vertices of triangles - start at the beginning of the array
-    glVertexAttribPointer(shader.posLocation, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
+    const EmbeddedMeshHeader* header = rock.header;
+    *geometry = new MeshGeometry;
 
-    glEnableVertexAttribArray(shader.normalLocation);
-    // normal of vertex starts after the color (interlaced array)
-    glVertexAttribPointer(shader.normalLocation, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    (*geometry)->boundsMin = glm::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+    (*geometry)->boundsMax = glm::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+    (*geometry)->boundingSphere = glm::vec4(header->boundingSphere[0], header->boundingSphere[1], header->boundingSphere[2], header->boundingSphere[3]);
+    (*geometry)->numVertices = header->numVertices;
+    (*geometry)->vertexFormat = (VertexFormat)header->vertexFormat;
+    (*geometry)->texCoordTransform = glm::vec4(header->texCoordTransform[0], header->texCoordTransform[1], header->texCoordTransform[2], header->texCoordTransform[3]);
+    if ((*geometry)->vertexFormat == VERTEX_FORMAT_COMPACT) {
+        (*geometry)->positionScale = (*geometry)->boundsMax - (*geometry)->boundsMin;
+        (*geometry)->positionOffset = (*geometry)->boundsMin;
+    }
 
-    (*geometry)->ambient = glm::vec3(1.0f, 1.0f, 1.0f);
-    (*geometry)->diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
-    (*geometry)->specular = glm::vec3(1.0f, 1.0f, 1.0f);
-    (*geometry)->shininess = 10.0f;
-    glEnableVertexAttribArray(shader.texCoordLocation);
-    glVertexAttribPointer(shader.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    createMeshBufferObjects(*geometry, ROCK_MODEL_NAME, rock.vertices, rock.indices, header->indexSize, header->numIndices, header->lods, header->numLods, shader);
 
-    glBindVertexArray(0);
+    MeshMaterial material;
+    material.ambient = glm::vec3(1.0f, 1.0f, 1.0f);
+    material.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+    material.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    material.shininess = 10.0f;
+    material.texturePath = ROCK_TEXTURE_NAME;
+    setMeshParts(*geometry, std::vector<MeshMaterial>(1, material), NULL, 0);
+    (*geometry)->id = ROCK_MODEL_NAME;
 
-    (*geometry)->numTriangles = cliff_rock_two_objNTriangles;
+    std::cout << "Vertex buffer of " << ROCK_MODEL_NAME << ": " << header->numVertices << " vertices, "
+              << ((*geometry)->vertexFormat == VERTEX_FORMAT_COMPACT ? "compact" : "float") << ", " << header->indexSize * 8
+              << " bit indices, " << size << " B embedded" << std::endl;
 }
 
 
 void drawSkybox(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
 
-    glUseProgram(skyboxShaderProgram.program);
+    bindProgram(skyboxShaderProgram.program);
 
-    glm::mat4 matrix = projectionMatrix * viewMatrix;
     glm::mat4 viewRotation = viewMatrix;
     viewRotation[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
     glm::mat4 inversePVmatrix = glm::inverse(projectionMatrix * viewRotation);
 
-    glUniformMatrix4fv(skyboxShaderProgram.inversePVmatrixLocation, 1, GL_FALSE, glm::value_ptr(inversePVmatrix));
-    glUniform1i(skyboxShaderProgram.skyboxSamplerLocation, 0);
-    glUniform1i(skyboxShaderProgram.skyboxSampler2Location, 1);
+    setUniformMat4(skyboxShaderProgram.inversePVmatrixLocation, inversePVmatrix);
+    setUniformInt(skyboxShaderProgram.skyboxSamplerLocation, 0);
+    setUniformInt(skyboxShaderProgram.skyboxSampler2Location, 1);
 
-    glBindVertexArray(skyboxGeometry->vertexArrayObject);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxGeometry->texture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxGeometry->texture2);
+    bindVertexArray(skyboxGeometry->vertexArrayObject);
+    bindTexture(0, GL_TEXTURE_CUBE_MAP, skyboxGeometry->texture);
+    bindTexture(1, GL_TEXTURE_CUBE_MAP, skyboxGeometry->texture2);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, skyboxGeometry->numTriangles + 2);
-    glActiveTexture(GL_TEXTURE0);
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+}
 
+//mesh is prepared on a worker, uploaded once the common shader program exists
+static int addMeshTask(const std::string& fileName, MeshGeometry** geometry, const std::string& errorMessage) {
+
+    MeshLoad* load = new MeshLoad;
+    load->fileName = fileName;
+
+    return addStartupTask("mesh " + fileName,
+        [=]() {
+            prepareMesh(load);
+        },
+        [=]() {
+            if (finishMesh(load, shaderProgram, geometry) != true) {
+                std::cerr << "initializeModels(): " << errorMessage << std::endl;
+            }
+            delete load;
+            CHECK_GL_ERROR();
+        },
+        std::vector<int>(1, commonShaderTask)
+    );
 }
 
+//procedural geometry only needs its texture files read ahead
+static int addGeometryTask(const std::string& name, const std::vector<std::string>& textureFiles, int shaderTask, std::function<void()> initialize) {
+
+    return addStartupTask(name,
+        [=]() {
+            for (size_t i = 0; i < textureFiles.size(); i++)
+                prefetchFile(texturePrefetchFile(textureFiles[i]));
+        },
+        [=]() {
+            initialize();
+            CHECK_GL_ERROR();
+        },
+        std::vector<int>(1, shaderTask)
+    );
+}
+
+//schedules all geometry, call after initializeShaderPrograms, loaded by runStartupTasks
 void initializeModels() {
 
-    if (loadSingleMesh(GROUND_MODEL_NAME, shaderProgram, &groundGeometry) != true) {
-        std::cerr << "initializeModels(): Ground model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(PLANT_MODEL_NAME, shaderProgram, &plantGeometry) != true) {
-        std::cerr << "initializeModels(): Ground model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(TREE_MODEL_NAME, shaderProgram, &treeGeometry) != true) {
-        std::cerr << "initializeModels(): Tree model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(BENCH_MODEL_NAME, shaderProgram, &benchGeometry) != true) {
-        std::cerr << "initializeModels(): Bench model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(HALL_MODEL_NAME, shaderProgram, &hallGeometry) != true) {
-        std::cerr << "initializeModels(): Hall model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(EAGLE_MODEL_NAME, shaderProgram, &eagleGeometry) != true) {
-        std::cerr << "initializeModels(): Eagle model loading failed." << std::endl;
-    }
-    if (loadSingleMesh(HAT_MODEL_NAME, shaderProgram, &hatGeometry) != true) {
-        std::cerr << "initializeModels(): Hat model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(BROOM_MODEL_NAME, shaderProgram, &broomGeometry) != true) {
-        std::cerr << "initializeModels(): Broom model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(WAND_MODEL_NAME, shaderProgram, &wandGeometry) != true) {
-        std::cerr << "initializeModels(): Torch model loading failed." << std::endl;
-    }
-    CHECK_GL_ERROR();
-    if (loadSingleMesh(FIREPLACE_MODEL_NAME, shaderProgram, &fireplaceGeometry) != true) {
-        std::cerr << "initializeModels(): Fireplace model loading failed." << std::endl;
+    runStartupBenchmarks();
+#if TEXTURE_STREAMING
+    initTextureStreaming((size_t)TEXTURE_STREAM_BUDGET_MB << 20);
+#endif
+
+    //meshes whose part textures may be packed into arrays
+    std::vector<int> meshTasks;
+    meshTasks.push_back(addMeshTask(GROUND_MODEL_NAME, &groundGeometry, "Ground model loading failed."));
+    meshTasks.push_back(addMeshTask(PLANT_MODEL_NAME, &plantGeometry, "Ground model loading failed."));
+    meshTasks.push_back(addMeshTask(TREE_MODEL_NAME, &treeGeometry, "Tree model loading failed."));
+    meshTasks.push_back(addMeshTask(BENCH_MODEL_NAME, &benchGeometry, "Bench model loading failed."));
+    meshTasks.push_back(addMeshTask(HALL_MODEL_NAME, &hallGeometry, "Hall model loading failed."));
+    meshTasks.push_back(addMeshTask(EAGLE_MODEL_NAME, &eagleGeometry, "Eagle model loading failed."));
+    meshTasks.push_back(addMeshTask(HAT_MODEL_NAME, &hatGeometry, "Hat model loading failed."));
+    meshTasks.push_back(addMeshTask(BROOM_MODEL_NAME, &broomGeometry, "Broom model loading failed."));
+    meshTasks.push_back(addMeshTask(WAND_MODEL_NAME, &wandGeometry, "Torch model loading failed."));
+    meshTasks.push_back(addMeshTask(FIREPLACE_MODEL_NAME, &fireplaceGeometry, "Fireplace model loading failed."));
+
+    std::vector<std::string> skyboxFiles;
+    for (int i = 0; i < 6; i++) {
+        skyboxFiles.push_back(std::string(SKYBOX_PREFIX_DAY) + std::to_string(i + 1) + ".png");
+        skyboxFiles.push_back(std::string(SKYBOX_PREFIX_NIGHT) + std::to_string(i + 1) + ".jpg");
     }
-    CHECK_GL_ERROR();
-    initSkyboxGeometry(skyboxShaderProgram.program, &skyboxGeometry);
-    initWaterGeometry(waterShaderProgram.program, &waterGeometry);
-    initRockGeometry(shaderProgram, &rockGeometry);
-    initfireGeometry(fireShaderProgram.program, &fireGeometry);
-    CHECK_GL_ERROR();
 
+    addGeometryTask("skybox", skyboxFiles, skyboxShaderTask, []() { initSkyboxGeometry(skyboxShaderProgram.program, &skyboxGeometry); });
+    addGeometryTask("water", std::vector<std::string>(1, WATER_TEXTURE_NAME), waterShaderTask, []() { initWaterGeometry(waterShaderProgram.program, &waterGeometry); });
+    meshTasks.push_back(addGeometryTask("rock", std::vector<std::string>(1, ROCK_TEXTURE_NAME), commonShaderTask, []() { initRockGeometry(shaderProgram, &rockGeometry); }));
+    addGeometryTask("fire", std::vector<std::string>(1, FIRE_TEXTURE_NAME), fireShaderTask, []() { initfireGeometry(fireShaderProgram.program, &fireGeometry); });
+
+    addStartupTask("texture arrays", std::function<void()>(), buildTextureArrays, meshTasks);
 }
 
 void cleanupGeometry(MeshGeometry *geometry) {
 
-    glDeleteVertexArrays(1, &(geometry->vertexArrayObject));
-    glDeleteBuffers(1, &(geometry->elementBufferObject));
-    glDeleteBuffers(1, &(geometry->vertexBufferObject));
+    // arena meshes only give their blocks back, the page buffers go with the arena
+    if (geometry->arenaAllocation.page != NULL) {
+        freeArenaMesh(&geometry->arenaAllocation);
+    }
+    else {
+        glDeleteVertexArrays(1, &(geometry->vertexArrayObject));
+        glDeleteBuffers(1, &(geometry->elementBufferObject));
+        glDeleteBuffers(1, &(geometry->vertexBufferObject));
+    }
 
     if (geometry->texture != 0) {
+        releaseStreamedTexture(geometry->texture);
         glDeleteTextures(1, &(geometry->texture));
     }
 
+    //parts with the same texture file share one texture, texture arrays are deleted by cleanupModels
+    std::vector<GLuint> partTextures;
+    for (size_t p = 0; p < geometry->parts.size(); p++) {
+        GLuint texture = geometry->parts[p].texture;
+        if (texture != 0 && geometry->parts[p].textureLayer < 0 && std::find(partTextures.begin(), partTextures.end(), texture) == partTextures.end()) {
+            releaseStreamedTexture(texture);
+            partTextures.push_back(texture);
+        }
+    }
+    if (!partTextures.empty())
+        glDeleteTextures((GLsizei)partTextures.size(), partTextures.data());
+
 }
 
 // Deletes all geometries
@@ -1044,4 +2178,20 @@ void cleanupModels() {
 
     cleanupGeometry(waterGeometry);
 
+    for (int format = 0; format < 2; format++)
+        deleteGeometryArena(&meshArenas[format]);
+
+    cleanupTextureStreaming();
+
+#if TEXTURE_ARRAYS
+    if (!textureArrays.empty())
+        glDeleteTextures((GLsizei)textureArrays.size(), textureArrays.data());
+    textureArrays.clear();
+#endif
+
+#if RENDER_QUEUE_STATS
+    glDeleteQueries(RENDER_TIMER_QUERIES, timerQueries);
+    timerQueries[0] = 0;
+    timerFrame = 0;
+#endif
 }
@@ -11,23 +11,56 @@
 #define __RENDER_STUFF_H
 
 #include "data.h"
-#include "cliff_rock_two_obj.h"
+#include "render_queue.h"
+#include "vertex_format.h"
+#include "mesh_data.h"
+#include "geometry_arena.h"
 
-//Struct with VBO, VAO, EBO, unique id, material specifics and texture
+//Triangles of one material, drawn with one call per level of detail
+typedef struct MeshPart {
+  glm::vec3     ambient;
+  glm::vec3     diffuse;
+  glm::vec3     specular;
+  float         shininess;
+  GLuint        texture;                    // 0 if the part has none, parts with the same texture file share it
+  int           textureLayer;               // layer if texture is a GL_TEXTURE_2D_ARRAY (texture_array.h), -1 for a GL_TEXTURE_2D
+  MeshRange     ranges[MESH_MAX_LODS];      // of the element buffer, one per level of the geometry
+} MeshPart;
+
+//Struct with VBO, VAO, EBO, unique id, material parts and texture
 typedef struct MeshGeometry {
   GLuint        vertexBufferObject;
   GLuint        elementBufferObject;
   GLuint        vertexArrayObject;
   unsigned int  numTriangles;
+  GLenum        indexType = GL_UNSIGNED_INT;    // GL_UNSIGNED_SHORT for meshes with fewer than 65536 vertices
   // id is used to recognize, which geometry belongs to which object
   std::string	id;
 
-  //material specifics
-  glm::vec3     ambient;
-  glm::vec3     diffuse;
-  glm::vec3     specular;
-  float         shininess;
-  GLuint        texture;
+  //lit meshes have a part per material sorted by it, all parts share the buffers
+  std::vector<MeshPart> parts;
+  GLuint        texture = 0;                // water, fire and skybox textures
+
+  //model space bounds, computed when the mesh is loaded
+  glm::vec3     boundsMin;
+  glm::vec3     boundsMax;
+  glm::vec4     boundingSphere;     // center xyz, radius w
+
+  //vertex buffer layout, compact meshes are dequantized in the vertex shader with these ranges
+  VertexFormat  vertexFormat = VERTEX_FORMAT_FLOAT;
+  size_t        numVertices = 0;
+  glm::vec3     positionScale = glm::vec3(1.0f);            // position = offset + value * scale
+  glm::vec3     positionOffset = glm::vec3(0.0f);
+  glm::vec4     texCoordTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);   // xy scale, zw offset
+
+  //levels of detail, ranges of the element buffer filled by createMeshBuffers, level 0 is the full mesh
+  MeshLod       lods[MESH_MAX_LODS];
+  unsigned int  numLods = 0;
+
+  //meshes in the geometry arena use the buffers and VAO of their page, indices are relative to baseVertex
+  ArenaAllocation arenaAllocation;            // page NULL = own buffers
+  GLint         baseVertex = 0;
+  size_t        indexByteOffset = 0;          // where the mesh indices start in the element buffer
 } MeshGeometry;
 
 //MeshGeometry with one added texture pointer for multitexturing
@@ -38,7 +71,7 @@ typedef struct CubeMapGeometry : MeshGeometry{
 } CubeMapGeometry;
 
 
-//Struct with important object information
+//Transform of a scene object, the hot component of entities (entity_storage.h)
 typedef struct Object {
 
   glm::vec3 position;
@@ -46,14 +79,26 @@ typedef struct Object {
   float		rotationAngle;
   float     size;
 
-  float startTime;
-  float currentTime;
+  //world and normal matrix, recomputed by updateObjectTransform when transformDirty is set
+  glm::mat4 modelMatrix;
+  glm::mat4 normalMatrix;
+  bool      transformDirty = true;      // set whenever position, direction, rotationAngle or size change
 
-  std::string id;
+  int       lodLevel = 0;               // level of detail drawn last frame, kept for the hysteresis
 
- 
 } Object;
 
+//Time of an animated object, the animation component of entities
+typedef struct ObjectAnimation {
+
+  float     startTime;
+  float     currentTime;
+  float     frameDuration;      // texture frame of water and fire, 0 if the texture does not change
+  float     speed;              // curve parameter per second of the eagle flight
+  glm::vec3 initPosition;       // start of the flight curve
+
+} ObjectAnimation;
+
 //Struct for camera, added speed and yaw and pitch angles of view
 typedef struct CameraObject : public Object {
 
@@ -63,33 +108,6 @@ typedef struct CameraObject : public Object {
   float pitch;		//view angle up and down
 
 } CameraObject;
-
-//Struct for objects that is moving
-typedef struct MoveableObject : public Object {
-	glm::vec3 initPosition;
-	float speed;
-	glm::vec3 rotdirection;
-} MoveableObject;
-
-//Object for ground
-typedef struct GroundObject : public Object {
-
-}GroundObject;
-
-//water object = moveable texture
-typedef struct WaterObject : public Object {
-	int    textureFrames;
-	float  frameDuration;
-	float  speed;
-
-};
-
-//fire object = dynamic texture
-typedef struct FireObject : public Object {
-	int    textureFrames;
-	float  frameDuration;
-
-};
 //Shader program for common objects
 typedef struct _commonShaderProgram {
   
@@ -105,8 +123,6 @@ typedef struct _commonShaderProgram {
   GLint MmatrixLocation;
   GLint normalMatrixLocation;
 
-  GLint timeLocation;
-
   GLint diffuseLocation;
   GLint ambientLocation;
   GLint specularLocation;
@@ -114,14 +130,24 @@ typedef struct _commonShaderProgram {
 
   GLint useTextureLocation;
   GLint texSamplerLocation;
+  GLint texArraySamplerLocation;        //sampler2DArray on TEXTURE_ARRAY_UNIT
+  GLint textureLayerLocation;           //layer of the part texture, -1 samples texSampler
+
+  //dequantization of compact vertices (vertex_format.h)
+  GLint positionScaleLocation;
+  GLint positionOffsetLocation;
+  GLint texCoordTransformLocation;
+  GLint octahedralNormalLocation;
 
-  GLint torchPositionLocation;		//camera position
-  GLint torchDirectionLocation;		//view direction
-  GLint torchOnLocation;			//is torch switched on
+  //lights, day time and fog come from the Lighting uniform block (lighting_buffer.h)
 
-  GLint dayTimeLocation;			//is it day or night
-  GLint fogColourLocation;			//fog colour changing according to day time
-  GLint fogOnLocation;				//is fog showing
+  //instanced variant only, -1 in the common program
+  GLint instanceModelMatrixLocation;	//per instance model matrix (4 attribute slots)
+  GLint instanceNormalMatrixLocation;	//per instance normal matrix (4 attribute slots)
+  GLint PVmatrixLocation;				//projection * view, model comes per instance
+
+  //GPU driven variant only (gpu_culling.h), -1 in the others
+  GLint drawIndexLocation;				//per draw record index, instanced attribute
 
 } SCommonShaderProgram;
 
@@ -136,31 +162,99 @@ typedef struct SkyboxShaderProgram {
 	GLint skyboxSamplerLocation;		//day texture
 	GLint skyboxSampler2Location;		//night texture
 
-	GLint fogActiveLocation;
-	GLint fogColourLocation;			//fog colour
-	GLint blendFactorLocation;			//blend between day and night
+	//fog and day/night blend come from the Lighting uniform block
 
 } SkyboxShaderProgram;
 
-void drawWand(Object* wand, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawFireplace(Object* fireplace, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawFire(FireObject* fire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawRock(Object* rock, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawBroom(Object* broom, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawEagle(MoveableObject* eagle, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawHall(Object* hall, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawBench(Object* bench, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawHat(Object* hat, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawTree(Object* tree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawPlant(Object* plant, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+//Kinds of scene objects, each has its own geometry and way of placing it
+enum ObjectKind {
+  OBJECT_GROUND,
+  OBJECT_WATER,
+  OBJECT_PLANT,
+  OBJECT_TREE,
+  OBJECT_BENCH,
+  OBJECT_HALL,
+  OBJECT_EAGLE,
+  OBJECT_HAT,
+  OBJECT_BROOM,
+  OBJECT_WAND,
+  OBJECT_ROCK,
+  OBJECT_FIREPLACE,
+  OBJECT_FIRE,
+  OBJECT_KIND_COUNT
+};
+
+#define INSTANCE_MAX_CELLS  (INSTANCE_LOD_CELLS * INSTANCE_LOD_CELLS)
+
+//Instances of a batch in one grid cell, all of them are drawn at the same level of detail
+typedef struct InstanceCell {
+  glm::vec4     boundingSphere;     // world space sphere around the instance spheres of the cell
+  float         instanceRadius;     // of the largest instance sphere, the level is picked for it at the nearest point of the cell
+  unsigned int  firstInstance;      // instances of the cell follow each other in the instance buffer
+  unsigned int  numInstances;
+  int           lodLevel;           // drawn last frame, kept for the hysteresis
+} InstanceCell;
+
+//Repeated static objects of one kind, drawn with one instanced call per run of cells at the same level of detail
+typedef struct InstanceBatch {
+  const MeshGeometry*  geometry;
+  GLuint               vertexArrayObjects[INSTANCE_MAX_CELLS];  // geometry buffers + per instance attributes from the cell's first instance
+  GLuint               instanceBufferObject;    // model and normal matrix, uploaded once in cell order
+  unsigned int         numInstances;
+  glm::vec4            boundingSphere;          // world space sphere around all instances, culled as a whole
+  glm::vec3            boundsMin;               // world space box around the instance spheres
+  glm::vec3            boundsMax;
+
+  //non-empty cells in buffer order, neighbours in the grid are neighbours here so runs of one level are long
+  InstanceCell            cells[INSTANCE_MAX_CELLS];
+  unsigned int            numCells;
+  std::vector<glm::mat4>  instanceData;         // model and normal matrix of every instance, in cell order
+} InstanceBatch;
+
+void computeMeshBounds(MeshGeometry* geometry, const float* positions, size_t numVertices, size_t stride);
+glm::vec4 transformBoundingSphere(const glm::vec4& sphere, const glm::mat4& modelMatrix);
+//world space box of the object, false if its geometry is not loaded
+bool objectWorldBounds(ObjectKind kind, Object* object, glm::vec3* boundsMin, glm::vec3* boundsMax);
+
+//projection of the frame for the level of detail selection, enabled = false draws full meshes only
+void setLodProjection(const glm::mat4& projectionMatrix, int viewportHeight, bool enabled);
+
+//pixels per world unit of the frame for the level of detail selection, 0 if LOD is disabled
+float getLodPixelsPerUnit();
+//geometry drawn for the kind, NULL if it is not loaded
+const MeshGeometry* getObjectGeometry(ObjectKind kind);
+//attribute pointers of the mesh for a lit program, the vertex buffer must be bound
+void setMeshAttributes(const MeshGeometry* geometry, const SCommonShaderProgram& shader);
+
+glm::mat4 objectModelMatrix(ObjectKind kind, const Object* object, const glm::mat4& viewMatrix);
+//refreshes the cached matrices if the object is dirty, the fire billboard faces the camera and is refreshed every time
+void updateObjectTransform(ObjectKind kind, Object* object, const glm::mat4& viewMatrix);
+//animation may be NULL for objects that do not change in time
+void queueObject(RenderQueue* queue, ObjectKind kind, Object* object, const ObjectAnimation* animation, int stencilId, const glm::mat4& viewMatrix);
+
+//matrices are taken once, objects must not move while the batch exists
+bool createInstanceBatch(ObjectKind kind, const std::vector<Object*>& objects, InstanceBatch** batch);
+void deleteInstanceBatch(InstanceBatch* batch);
+//picks the level of every cell, the instance buffer is never uploaded again
+void queueInstanceBatch(RenderQueue* queue, InstanceBatch* batch, int stencilId, const glm::mat4& viewMatrix);
+//texture streaming requests of objects drawn without the queue, the queue functions make them on their own
+void requestObjectTextures(ObjectKind kind, Object* object, const glm::mat4& viewMatrix);
+void requestBatchTextures(const InstanceBatch* batch, const glm::mat4& viewMatrix);
+//PVmatrix = projection * view, computed once per frame by the caller
+void submitRenderQueue(RenderQueue* queue, const glm::mat4& viewMatrix, const glm::mat4& PVmatrix);
 void drawSkybox(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawBase(GroundObject* base, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawWater(WaterObject* water, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
 
+//both only add startup tasks (task_scheduler.h), the loading itself happens in runStartupTasks
 void initializeShaderPrograms();
 void cleanupShaderPrograms();
+//true once the INDIRECT program and the culling program are built (GPU_DRIVEN_DRAWING)
+bool gpuDrivenAvailable();
 
 void initializeModels();
 void cleanupModels();
+//startup time and video memory of the cooked and the decoded textures
+void printTextureReport();
+//page memory of the arenas of all vertex layouts (GEOMETRY_ARENA)
+void getGeometryArenaStats(ArenaStats* stats);
 
 #endif
@@ -0,0 +1,174 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_arena.cpp
+ * @date    18/10/2026
+ * @brief   Block list of the scene arena and the restart benchmark.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include "data.h"
+#include "scene_arena.h"
+
+#if SCENE_ARENA_BENCHMARK
+#include "entity_storage.h"
+#include "benchmark.h"
+#endif
+
+static size_t alignSize(size_t size) {
+    return (size + SCENE_ARENA_ALIGNMENT - 1) & ~(size_t)(SCENE_ARENA_ALIGNMENT - 1);
+}
+
+//operator new only guarantees the alignment of fundamental types, the byte before the block keeps the shift
+static char* allocateBlock(size_t size) {
+
+    char* memory = (char*)::operator new(size + SCENE_ARENA_ALIGNMENT);
+    size_t shift = SCENE_ARENA_ALIGNMENT - ((size_t)memory & (SCENE_ARENA_ALIGNMENT - 1));
+    memory[shift - 1] = (char)shift;
+    return memory + shift;
+}
+
+static void freeBlock(char* block) {
+    ::operator delete(block - (unsigned char)block[-1]);
+}
+
+void initSceneArena(SceneArena* arena, size_t blockSize) {
+
+    arena->blocks.clear();
+    arena->blockSize = alignSize(std::max(blockSize, (size_t)SCENE_ARENA_ALIGNMENT));
+    arena->capacity = arena->blockSize;
+    arena->used = 0;
+    arena->filled = 0;
+    arena->blocks.push_back(allocateBlock(arena->capacity));
+}
+
+void deleteSceneArena(SceneArena* arena) {
+
+    for (size_t i = 0; i < arena->blocks.size(); i++)
+        freeBlock(arena->blocks[i]);
+    arena->blocks.clear();
+    arena->capacity = 0;
+    arena->used = 0;
+    arena->filled = 0;
+}
+
+void* allocateSceneArena(SceneArena* arena, size_t size) {
+
+    size = alignSize(std::max(size, (size_t)1));
+
+    if (arena->used + size > arena->capacity) {
+        // the rest of the last block is skipped
+        arena->capacity = std::max(arena->blockSize, size);
+        arena->used = 0;
+        arena->blocks.push_back(allocateBlock(arena->capacity));
+    }
+
+    char* memory = arena->blocks.back() + arena->used;
+    arena->used += size;
+    arena->filled += size;
+    return memory;
+}
+
+void resetSceneArena(SceneArena* arena) {
+
+    if (arena->blocks.size() > 1) {
+        for (size_t i = 0; i < arena->blocks.size(); i++)
+            freeBlock(arena->blocks[i]);
+        arena->blocks.clear();
+        arena->blockSize = alignSize(arena->filled);
+        arena->blocks.push_back(allocateBlock(arena->blockSize));
+    }
+    arena->capacity = arena->blockSize;
+    arena->used = 0;
+    arena->filled = 0;
+}
+
+#if SCENE_ARENA_BENCHMARK
+static void placeTree(Object* transform, size_t i) {
+
+    transform->position = glm::vec3((float)(i % 1000), 0.8f, (float)(i / 1000));
+    transform->direction = glm::vec3(1.0f, 0.0f, 0.0f);
+    transform->rotationAngle = glm::radians(270.0f);
+    transform->size = TREE_SIZE;
+    transform->transformDirty = true;
+}
+
+static void populateScene(EntityStorage* storage, size_t numObjects) {
+
+    for (size_t i = 0; i < numObjects; i++) {
+        EntityHandle entity = createEntity(storage, OBJECT_TREE, 4);
+        placeTree(entityTransform(storage, entity), i);
+    }
+}
+
+static void benchmarkRestart(size_t numObjects, int numRestarts) {
+
+    typedef BenchmarkClock Clock;
+
+    // the old restart, every object deleted and allocated again with its name
+    std::vector<HeapObject*> objects(numObjects);
+    for (size_t i = 0; i < numObjects; i++)
+        objects[i] = new HeapObject;
+
+    Clock::time_point start = Clock::now();
+    for (int restart = 0; restart < numRestarts; restart++) {
+        for (size_t i = 0; i < numObjects; i++)
+            delete objects[i];
+        for (size_t i = 0; i < numObjects; i++) {
+            objects[i] = new HeapObject;
+            placeTree(&objects[i]->transform, i);
+            objects[i]->startTime = objects[i]->currentTime = 0.0f;
+            objects[i]->id = TREE_MODEL_NAME;
+        }
+    }
+    double heapTime = millisecondsBetween(start, Clock::now()) / numRestarts;
+    for (size_t i = 0; i < numObjects; i++)
+        delete objects[i];
+
+    // arena reset and the objects created again one by one
+    SceneArena arena;
+    initSceneArena(&arena, SCENE_ARENA_BLOCK_SIZE);
+    EntityStorage entities;
+
+    start = Clock::now();
+    for (int restart = 0; restart < numRestarts; restart++) {
+        resetSceneArena(&arena);
+        initEntities(&entities, &arena);
+        populateScene(&entities, numObjects);
+    }
+    double populateTime = millisecondsBetween(start, Clock::now()) / numRestarts;
+
+    // arena reset and a copy of the prebuilt template
+    SceneArena templateArena;
+    initSceneArena(&templateArena, SCENE_ARENA_BLOCK_SIZE);
+    EntityStorage sceneTemplate;
+    initEntities(&sceneTemplate, &templateArena);
+    populateScene(&sceneTemplate, numObjects);
+
+    start = Clock::now();
+    for (int restart = 0; restart < numRestarts; restart++) {
+        resetSceneArena(&arena);
+        copyEntities(&entities, &arena, sceneTemplate);
+        for (size_t i = 0; i < entities.count; i++)
+            entities.animations[i].startTime = entities.animations[i].currentTime = 0.0f;
+    }
+    double templateTime = millisecondsBetween(start, Clock::now()) / numRestarts;
+
+    std::cout << "  " << numObjects << " objects: new/delete " << heapTime << " ms, arena + create " << populateTime
+              << " ms, arena + template " << templateTime << " ms (" << arena.blocks.size() << " arena block of "
+              << arena.blockSize / 1024 << " KB)" << std::endl;
+
+    deleteSceneArena(&arena);
+    deleteSceneArena(&templateArena);
+}
+
+void benchmarkSceneArena() {
+
+    std::cout << "scene arena benchmark, restart latency:" << std::endl;
+    benchmarkRestart(1000, 100);
+    benchmarkRestart(10000, 20);
+    benchmarkRestart(100000, 5);
+}
+#endif
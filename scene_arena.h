@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_arena.h
+ * @date    18/10/2026
+ * @brief   Monotonic allocator owned by the scene, everything in it is freed at once on restart.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __SCENE_ARENA_H
+#define __SCENE_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+//alignment of every allocation, enough for glm matrices and SSE loads
+#define SCENE_ARENA_ALIGNMENT   16
+
+//Blocks handed out front to back, there is no free of a single allocation
+typedef struct SceneArena {
+  std::vector<char*>  blocks;       // allocations come from the last one
+  size_t              blockSize;    // of the first block, later ones are at least this large
+  size_t              capacity;     // bytes of the last block
+  size_t              used;
+  size_t              filled;       // bytes of all allocations, the next reset makes one block this large
+} SceneArena;
+
+void initSceneArena(SceneArena* arena, size_t blockSize);
+//frees all blocks, nothing allocated from the arena may be used afterwards
+void deleteSceneArena(SceneArena* arena);
+
+/**
+ * @brief Returns size bytes aligned to SCENE_ARENA_ALIGNMENT, a new block is added if the last one is full.
+ *
+ * The memory is not initialized.
+ */
+void* allocateSceneArena(SceneArena* arena, size_t size);
+
+/**
+ * @brief Frees everything at once by moving back to the start of the first block.
+ *
+ * If the last fill needed more than one block they are replaced by one block of the whole size,
+ * so filling the arena the same way again does not allocate.
+ */
+void resetSceneArena(SceneArena* arena);
+
+//arrays of count elements, T must be plain data - no constructor is run
+template <typename T>
+T* allocateSceneArray(SceneArena* arena, size_t count) {
+    return (T*)allocateSceneArena(arena, count * sizeof(T));
+}
+
+#endif
@@ -0,0 +1,423 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_bvh.cpp
+ * @date    18/10/2026
+ * @brief   Bounding volume hierarchy over world space object boxes, built with SAH and refitted for moving objects.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include "data.h"
+#include "scene_bvh.h"
+#if SCENE_BVH_BENCHMARK
+#include "glm/gtc/matrix_transform.hpp"
+#include "benchmark.h"
+#endif
+
+void clearSceneBvh(SceneBvh* bvh) {
+
+    bvh->nodes.clear();
+    bvh->objectMin.clear();
+    bvh->objectMax.clear();
+    bvh->objectOrder.clear();
+    bvh->objectLeaf.clear();
+    bvh->culling = CullingStats();
+}
+
+int addBvhObject(SceneBvh* bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+
+    bvh->objectMin.push_back(boundsMin);
+    bvh->objectMax.push_back(boundsMax);
+    return (int)bvh->objectMin.size() - 1;
+}
+
+static float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+
+    glm::vec3 extent = boundsMax - boundsMin;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+//leaf - union of its objects, inner node - union of its children
+static void updateNodeBounds(SceneBvh* bvh, int nodeIndex) {
+
+    BvhNode& node = bvh->nodes[nodeIndex];
+
+    if (node.count > 0) {
+        node.boundsMin = bvh->objectMin[bvh->objectOrder[node.first]];
+        node.boundsMax = bvh->objectMax[bvh->objectOrder[node.first]];
+        for (int i = 1; i < node.count; i++) {
+            int id = bvh->objectOrder[node.first + i];
+            node.boundsMin = glm::min(node.boundsMin, bvh->objectMin[id]);
+            node.boundsMax = glm::max(node.boundsMax, bvh->objectMax[id]);
+        }
+    }
+    else {
+        const BvhNode& left = bvh->nodes[node.first];
+        const BvhNode& right = bvh->nodes[node.first + 1];
+        node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+        node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+    }
+}
+
+static void makeLeaf(SceneBvh* bvh, int nodeIndex) {
+
+    const BvhNode& node = bvh->nodes[nodeIndex];
+    for (int i = 0; i < node.count; i++)
+        bvh->objectLeaf[bvh->objectOrder[node.first + i]] = nodeIndex;
+}
+
+//splits the node along the cheapest binned plane, recursively
+static void subdivide(SceneBvh* bvh, int nodeIndex, const std::vector<glm::vec3>& centroids) {
+
+    const int first = bvh->nodes[nodeIndex].first;
+    const int count = bvh->nodes[nodeIndex].count;
+
+    if (count <= 1) {
+        makeLeaf(bvh, nodeIndex);
+        return;
+    }
+
+    glm::vec3 centroidMin = centroids[bvh->objectOrder[first]];
+    glm::vec3 centroidMax = centroidMin;
+    for (int i = 1; i < count; i++) {
+        centroidMin = glm::min(centroidMin, centroids[bvh->objectOrder[first + i]]);
+        centroidMax = glm::max(centroidMax, centroids[bvh->objectOrder[first + i]]);
+    }
+
+    float bestCost = -1.0f;
+    int bestAxis = -1;
+    int bestBin = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+            continue;
+
+        glm::vec3 binMin[SCENE_BVH_BINS], binMax[SCENE_BVH_BINS];
+        int binCount[SCENE_BVH_BINS] = { 0 };
+        float scale = SCENE_BVH_BINS / extent;
+
+        for (int i = 0; i < count; i++) {
+            int id = bvh->objectOrder[first + i];
+            int bin = std::min(SCENE_BVH_BINS - 1, (int)((centroids[id][axis] - centroidMin[axis]) * scale));
+            binMin[bin] = (binCount[bin] == 0) ? bvh->objectMin[id] : glm::min(binMin[bin], bvh->objectMin[id]);
+            binMax[bin] = (binCount[bin] == 0) ? bvh->objectMax[id] : glm::max(binMax[bin], bvh->objectMax[id]);
+            binCount[bin]++;
+        }
+
+        // areas and counts left of every plane, then sweep from the right
+        float leftArea[SCENE_BVH_BINS - 1];
+        int leftCount[SCENE_BVH_BINS - 1];
+        glm::vec3 sweepMin, sweepMax;
+        int sweepCount = 0;
+
+        for (int bin = 0; bin < SCENE_BVH_BINS - 1; bin++) {
+            if (binCount[bin] > 0) {
+                sweepMin = (sweepCount == 0) ? binMin[bin] : glm::min(sweepMin, binMin[bin]);
+                sweepMax = (sweepCount == 0) ? binMax[bin] : glm::max(sweepMax, binMax[bin]);
+                sweepCount += binCount[bin];
+            }
+            leftCount[bin] = sweepCount;
+            leftArea[bin] = (sweepCount > 0) ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+        }
+
+        sweepCount = 0;
+        for (int bin = SCENE_BVH_BINS - 1; bin > 0; bin--) {
+            if (binCount[bin] > 0) {
+                sweepMin = (sweepCount == 0) ? binMin[bin] : glm::min(sweepMin, binMin[bin]);
+                sweepMax = (sweepCount == 0) ? binMax[bin] : glm::max(sweepMax, binMax[bin]);
+                sweepCount += binCount[bin];
+            }
+            if (sweepCount == 0 || leftCount[bin - 1] == 0)
+                continue;
+
+            float cost = leftCount[bin - 1] * leftArea[bin - 1] + sweepCount * surfaceArea(sweepMin, sweepMax);
+            if (bestAxis < 0 || cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    // all centroids in one point, or visiting two children costs more than testing every object
+    float nodeArea = surfaceArea(bvh->nodes[nodeIndex].boundsMin, bvh->nodes[nodeIndex].boundsMax);
+    if (bestAxis < 0 || (count <= SCENE_BVH_LEAF_SIZE && SCENE_BVH_TRAVERSAL_COST * nodeArea + bestCost >= count * nodeArea)) {
+        makeLeaf(bvh, nodeIndex);
+        return;
+    }
+
+    float scale = SCENE_BVH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    int* begin = bvh->objectOrder.data() + first;
+    int* middle = std::partition(begin, begin + count, [&](int id) {
+        return std::min(SCENE_BVH_BINS - 1, (int)((centroids[id][bestAxis] - centroidMin[bestAxis]) * scale)) < bestBin;
+    });
+    int leftCount = (int)(middle - begin);
+
+    int leftChild = (int)bvh->nodes.size();
+    bvh->nodes.resize(bvh->nodes.size() + 2);
+
+    BvhNode& left = bvh->nodes[leftChild];
+    left.first = first;
+    left.count = leftCount;
+    left.parent = nodeIndex;
+
+    BvhNode& right = bvh->nodes[leftChild + 1];
+    right.first = first + leftCount;
+    right.count = count - leftCount;
+    right.parent = nodeIndex;
+
+    bvh->nodes[nodeIndex].first = leftChild;
+    bvh->nodes[nodeIndex].count = 0;
+
+    updateNodeBounds(bvh, leftChild);
+    updateNodeBounds(bvh, leftChild + 1);
+    subdivide(bvh, leftChild, centroids);
+    subdivide(bvh, leftChild + 1, centroids);
+}
+
+void buildSceneBvh(SceneBvh* bvh) {
+
+    const int numObjects = (int)bvh->objectMin.size();
+
+    bvh->nodes.clear();
+    bvh->objectOrder.resize(numObjects);
+    bvh->objectLeaf.assign(numObjects, 0);
+    if (numObjects == 0)
+        return;
+
+    std::vector<glm::vec3> centroids(numObjects);
+    for (int i = 0; i < numObjects; i++) {
+        bvh->objectOrder[i] = i;
+        centroids[i] = 0.5f * (bvh->objectMin[i] + bvh->objectMax[i]);
+    }
+
+    //a binary tree has at most 2n - 1 nodes, children are added in pairs
+    bvh->nodes.reserve(2 * numObjects);
+    bvh->nodes.resize(1);
+    bvh->nodes[0].first = 0;
+    bvh->nodes[0].count = numObjects;
+    bvh->nodes[0].parent = -1;
+
+    updateNodeBounds(bvh, 0);
+    subdivide(bvh, 0, centroids);
+}
+
+void updateBvhObject(SceneBvh* bvh, int id, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+
+    bvh->objectMin[id] = boundsMin;
+    bvh->objectMax[id] = boundsMax;
+
+    if (bvh->nodes.empty())
+        return;
+
+    //walk up while the bounds keep changing
+    for (int nodeIndex = bvh->objectLeaf[id]; nodeIndex >= 0; nodeIndex = bvh->nodes[nodeIndex].parent) {
+        BvhNode& node = bvh->nodes[nodeIndex];
+        glm::vec3 oldMin = node.boundsMin;
+        glm::vec3 oldMax = node.boundsMax;
+
+        updateNodeBounds(bvh, nodeIndex);
+        if (node.boundsMin == oldMin && node.boundsMax == oldMax)
+            break;
+    }
+}
+
+//false if the box is behind one of the planes in planeMask, planes the box is completely in front of are removed from the mask
+static bool testBoxPlanes(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax, int* planeMask) {
+
+    for (int p = 0; p < 6; p++) {
+        if ((*planeMask & (1 << p)) == 0)
+            continue;
+
+        const glm::vec4& plane = frustum.planes[p];
+
+        // corner farthest along the plane normal and the one opposite to it
+        glm::vec3 positive(plane.x >= 0.0f ? boundsMax.x : boundsMin.x, plane.y >= 0.0f ? boundsMax.y : boundsMin.y, plane.z >= 0.0f ? boundsMax.z : boundsMin.z);
+        glm::vec3 negative(plane.x >= 0.0f ? boundsMin.x : boundsMax.x, plane.y >= 0.0f ? boundsMin.y : boundsMax.y, plane.z >= 0.0f ? boundsMin.z : boundsMax.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+        if (glm::dot(glm::vec3(plane), negative) + plane.w >= 0.0f)
+            *planeMask &= ~(1 << p);
+    }
+    return true;
+}
+
+size_t cullSceneBvh(SceneBvh* bvh, const Frustum& frustum, std::vector<int>* objects) {
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    objects->clear();
+    unsigned int nodesVisited = 0;
+
+    //node index followed by the planes still to be tested
+    std::vector<int>& stack = bvh->stack;
+    stack.clear();
+    if (!bvh->nodes.empty()) {
+        stack.push_back(0);
+        stack.push_back(0x3F);
+    }
+
+    while (!stack.empty()) {
+        int planeMask = stack.back();
+        stack.pop_back();
+        const BvhNode& node = bvh->nodes[stack.back()];
+        stack.pop_back();
+        nodesVisited++;
+
+        if (planeMask != 0 && !testBoxPlanes(frustum, node.boundsMin, node.boundsMax, &planeMask))
+            continue;
+
+        if (node.count > 0) {
+            for (int i = 0; i < node.count; i++) {
+                int id = bvh->objectOrder[node.first + i];
+                int objectMask = planeMask;
+                if (objectMask == 0 || testBoxPlanes(frustum, bvh->objectMin[id], bvh->objectMax[id], &objectMask))
+                    objects->push_back(id);
+            }
+        }
+        else {
+            stack.push_back(node.first);
+            stack.push_back(planeMask);
+            stack.push_back(node.first + 1);
+            stack.push_back(planeMask);
+        }
+    }
+
+    bvh->culling.tested = nodesVisited;
+    bvh->culling.visible = (unsigned int)objects->size();
+    bvh->culling.culled = (unsigned int)(bvh->objectMin.size() - objects->size());
+    bvh->culling.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    return objects->size();
+}
+
+static bool boxesOverlap(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax) {
+    return aMin.x <= bMax.x && aMax.x >= bMin.x && aMin.y <= bMax.y && aMax.y >= bMin.y && aMin.z <= bMax.z && aMax.z >= bMin.z;
+}
+
+size_t queryBvhBox(SceneBvh* bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<int>* objects) {
+
+    objects->clear();
+
+    std::vector<int>& stack = bvh->stack;
+    stack.clear();
+    if (!bvh->nodes.empty())
+        stack.push_back(0);
+
+    while (!stack.empty()) {
+        const BvhNode& node = bvh->nodes[stack.back()];
+        stack.pop_back();
+
+        if (!boxesOverlap(node.boundsMin, node.boundsMax, boundsMin, boundsMax))
+            continue;
+
+        if (node.count > 0) {
+            for (int i = 0; i < node.count; i++) {
+                int id = bvh->objectOrder[node.first + i];
+                if (boxesOverlap(bvh->objectMin[id], bvh->objectMax[id], boundsMin, boundsMax))
+                    objects->push_back(id);
+            }
+        }
+        else {
+            stack.push_back(node.first);
+            stack.push_back(node.first + 1);
+        }
+    }
+
+    return objects->size();
+}
+
+#if SCENE_BVH_BENCHMARK
+void benchmarkSceneBvh() {
+
+    typedef BenchmarkClock Clock;
+
+    const int numObjects = 100000;
+    const int numMoving = 1000;
+    const int numBoxQueries = 1000;
+
+    SceneBvh bvh;
+    for (int i = 0; i < numObjects; i++) {
+        glm::vec3 center(randomFloat(-100.0f, 100.0f), randomFloat(0.0f, 10.0f), randomFloat(-100.0f, 100.0f));
+        glm::vec3 halfSize(randomFloat(0.1f, 1.0f), randomFloat(0.1f, 1.0f), randomFloat(0.1f, 1.0f));
+        addBvhObject(&bvh, center - halfSize, center + halfSize);
+    }
+
+    Clock::time_point start = Clock::now();
+    buildSceneBvh(&bvh);
+    double buildTime = millisecondsBetween(start, Clock::now());
+
+    // moving objects shifted by a small step, as the eagle is every update
+    start = Clock::now();
+    for (int i = 0; i < numMoving; i++) {
+        glm::vec3 step(randomFloat(-0.5f, 0.5f), 0.0f, randomFloat(-0.5f, 0.5f));
+        updateBvhObject(&bvh, i, bvh.objectMin[i] + step, bvh.objectMax[i] + step);
+    }
+    double refitTime = millisecondsBetween(start, Clock::now());
+
+    SceneBvh rebuilt;
+    rebuilt.objectMin = bvh.objectMin;
+    rebuilt.objectMax = bvh.objectMax;
+    start = Clock::now();
+    buildSceneBvh(&rebuilt);
+    double rebuildTime = millisecondsBetween(start, Clock::now());
+
+    glm::mat4 viewMatrix = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projectionMatrix = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 50.0f);
+    Frustum frustum;
+    extractFrustumPlanes(projectionMatrix * viewMatrix, &frustum);
+
+    std::vector<int> bvhVisible, bruteVisible;
+
+    start = Clock::now();
+    cullSceneBvh(&bvh, frustum, &bvhVisible);
+    double bvhCullTime = millisecondsBetween(start, Clock::now());
+
+    start = Clock::now();
+    for (int i = 0; i < numObjects; i++) {
+        int planeMask = 0x3F;
+        if (testBoxPlanes(frustum, bvh.objectMin[i], bvh.objectMax[i], &planeMask))
+            bruteVisible.push_back(i);
+    }
+    double bruteCullTime = millisecondsBetween(start, Clock::now());
+
+    std::sort(bvhVisible.begin(), bvhVisible.end());
+
+    // small boxes, as for collisions or picking around a point
+    std::vector<glm::vec3> queryMin(numBoxQueries), queryMax(numBoxQueries);
+    for (int i = 0; i < numBoxQueries; i++) {
+        queryMin[i] = glm::vec3(randomFloat(-100.0f, 100.0f), randomFloat(0.0f, 10.0f), randomFloat(-100.0f, 100.0f));
+        queryMax[i] = queryMin[i] + glm::vec3(2.0f);
+    }
+
+    std::vector<int> found;
+    size_t bvhFound = 0, bruteFound = 0;
+
+    start = Clock::now();
+    for (int i = 0; i < numBoxQueries; i++)
+        bvhFound += queryBvhBox(&bvh, queryMin[i], queryMax[i], &found);
+    double bvhQueryTime = millisecondsBetween(start, Clock::now());
+
+    start = Clock::now();
+    for (int i = 0; i < numBoxQueries; i++) {
+        for (int j = 0; j < numObjects; j++) {
+            if (boxesOverlap(bvh.objectMin[j], bvh.objectMax[j], queryMin[i], queryMax[i]))
+                bruteFound++;
+        }
+    }
+    double bruteQueryTime = millisecondsBetween(start, Clock::now());
+
+    std::cout << "scene BVH benchmark, " << numObjects << " objects, " << bvh.nodes.size() << " nodes:" << std::endl;
+    std::cout << "  build " << buildTime << " ms, refit of " << numMoving << " moved objects " << refitTime
+              << " ms, full rebuild " << rebuildTime << " ms" << std::endl;
+    std::cout << "  frustum: BVH " << bvhCullTime << " ms (" << bvh.culling.tested << " nodes), brute force " << bruteCullTime
+              << " ms, " << bvhVisible.size() << " visible, results " << (bvhVisible == bruteVisible ? "match" : "DIFFER") << std::endl;
+    std::cout << "  " << numBoxQueries << " box queries: BVH " << bvhQueryTime << " ms, brute force " << bruteQueryTime
+              << " ms, " << bvhFound << " found, results " << (bvhFound == bruteFound ? "match" : "DIFFER") << std::endl;
+}
+#endif
@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_bvh.h
+ * @date    18/10/2026
+ * @brief   Bounding volume hierarchy over world space object boxes, built with SAH and refitted for moving objects.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __SCENE_BVH_H
+#define __SCENE_BVH_H
+
+#include <vector>
+#include "glm/glm.hpp"
+#include "frustum_culling.h"
+
+//objects in a leaf at most, fewer when splitting is cheaper by SAH
+#define SCENE_BVH_LEAF_SIZE     4
+//centroid bins per axis when searching for the split
+#define SCENE_BVH_BINS          12
+//cost of visiting a node relative to testing one object, scales the SAH leaf decision
+#define SCENE_BVH_TRAVERSAL_COST 1.0f
+
+//Inner node: children are firstChild and firstChild + 1, count is 0
+//Leaf: objects objectOrder[first .. first + count - 1]
+typedef struct BvhNode {
+  glm::vec3 boundsMin;
+  int       first;
+  glm::vec3 boundsMax;
+  int       count;
+  int       parent;     // -1 for the root
+} BvhNode;
+
+typedef struct SceneBvh {
+  std::vector<BvhNode>    nodes;            // root is nodes[0]
+  std::vector<glm::vec3>  objectMin;        // world space box of every object, indexed by id
+  std::vector<glm::vec3>  objectMax;
+  std::vector<int>        objectOrder;      // ids grouped by leaf
+  std::vector<int>        objectLeaf;       // leaf node holding each id
+
+  std::vector<int>        stack;            // traversal stack, kept to avoid allocations
+  CullingStats            culling;          // last cullSceneBvh, tested = nodes visited
+} SceneBvh;
+
+void clearSceneBvh(SceneBvh* bvh);
+
+//adds an object before buildSceneBvh, returns its id
+int addBvhObject(SceneBvh* bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+//builds the hierarchy over all added objects, call once after the static scene is set up
+void buildSceneBvh(SceneBvh* bvh);
+
+//moves an object and refits its leaf and the ancestors, the tree structure stays the same
+void updateBvhObject(SceneBvh* bvh, int id, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+/**
+ * @brief Collects ids of objects whose boxes intersect the frustum.
+ *
+ * Subtrees completely inside the frustum are taken without testing their nodes.
+ *
+ * @param objects  cleared and filled with the visible ids
+ * @return number of visible objects
+ */
+size_t cullSceneBvh(SceneBvh* bvh, const Frustum& frustum, std::vector<int>* objects);
+
+//ids of objects whose boxes overlap the given box
+size_t queryBvhBox(SceneBvh* bvh, const glm::vec3& boundsMin, const glm::vec3& boundsMax, std::vector<int>* objects);
+
+#endif
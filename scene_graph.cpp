@@ -0,0 +1,455 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_graph.cpp
+ * @date    18/10/2026
+ * @brief   Transform hierarchy of scene files (data/SceneGraphFinal.xml) flattened into depth first arrays.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include "data.h"
+#include "scene_graph.h"
+#include "xml_parser.h"
+#if SCENE_GRAPH_BENCHMARK
+#include "benchmark.h"
+#endif
+
+void clearSceneGraph(SceneGraph* graph) {
+
+    graph->parents.clear();
+    graph->subtreeEnds.clear();
+    graph->flags.clear();
+    graph->positions.clear();
+    graph->rotations.clear();
+    graph->scales.clear();
+    graph->worldMatrices.clear();
+    graph->dirtyNodes.clear();
+    graph->types.clear();
+    graph->models.clear();
+    graph->names.clear();
+    graph->modelNames.clear();
+    graph->modelPaths.clear();
+    graph->animations.clear();
+}
+
+int addSceneNode(SceneGraph* graph, int parent, SceneNodeType type, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+
+    const int node = (int)graph->parents.size();
+
+    graph->parents.push_back(parent);
+    graph->subtreeEnds.push_back(node + 1);
+    graph->flags.push_back(0);
+    graph->positions.push_back(position);
+    graph->rotations.push_back(rotation);
+    graph->scales.push_back(scale);
+    graph->worldMatrices.push_back(glm::mat4(1.0f));
+    graph->types.push_back((unsigned char)type);
+    graph->models.push_back(-1);
+    graph->names.push_back(std::string());
+
+    return node;
+}
+
+//translation * rotation about x, y, z * scale, written out instead of three glm::rotate calls
+static glm::mat4 localMatrix(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+
+    const float cx = cosf(rotation.x), sx = sinf(rotation.x);
+    const float cy = cosf(rotation.y), sy = sinf(rotation.y);
+    const float cz = cosf(rotation.z), sz = sinf(rotation.z);
+
+    glm::mat4 matrix;
+    matrix[0] = glm::vec4(cy * cz, cy * sz, -sy, 0.0f) * scale.x;
+    matrix[1] = glm::vec4(cz * sx * sy - cx * sz, cx * cz + sx * sy * sz, cy * sx, 0.0f) * scale.y;
+    matrix[2] = glm::vec4(cx * cz * sy + sx * sz, cx * sy * sz - cz * sx, cx * cy, 0.0f) * scale.z;
+    matrix[3] = glm::vec4(position, 1.0f);
+    return matrix;
+}
+
+//world matrix of one node from its parent one, the parent must be up to date
+static void updateWorldMatrix(SceneGraph* graph, int node) {
+
+    glm::mat4 local = localMatrix(graph->positions[node], graph->rotations[node], graph->scales[node]);
+    const int parent = graph->parents[node];
+    if (parent < 0) {
+        graph->worldMatrices[node] = local;
+        return;
+    }
+
+    glm::mat4 parentMatrix = graph->worldMatrices[parent];
+    if (graph->flags[node] & SCENE_NODE_UNSCALED) {
+        for (int axis = 0; axis < 3; axis++) {
+            float length = glm::length(glm::vec3(parentMatrix[axis]));
+            if (length > 0.0f)
+                parentMatrix[axis] /= length;
+        }
+    }
+    graph->worldMatrices[node] = parentMatrix * local;
+}
+
+void finishSceneGraph(SceneGraph* graph) {
+
+    const int numNodes = (int)graph->parents.size();
+
+    // children are after their parents, so going backwards every subtree is complete when its root is reached
+    for (int node = 0; node < numNodes; node++)
+        graph->subtreeEnds[node] = node + 1;
+    for (int node = numNodes - 1; node > 0; node--) {
+        int parent = graph->parents[node];
+        graph->subtreeEnds[parent] = std::max(graph->subtreeEnds[parent], graph->subtreeEnds[node]);
+    }
+
+    for (int node = 0; node < numNodes; node++) {
+        updateWorldMatrix(graph, node);
+        graph->flags[node] &= ~SCENE_NODE_DIRTY;
+    }
+    graph->dirtyNodes.clear();
+}
+
+static void markSceneNodeDirty(SceneGraph* graph, int node) {
+
+    if ((graph->flags[node] & SCENE_NODE_DIRTY) == 0) {
+        graph->flags[node] |= SCENE_NODE_DIRTY;
+        graph->dirtyNodes.push_back(node);
+    }
+}
+
+void setSceneNodeTransform(SceneGraph* graph, int node, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+
+    graph->positions[node] = position;
+    graph->rotations[node] = rotation;
+    graph->scales[node] = scale;
+    markSceneNodeDirty(graph, node);
+}
+
+void animateSceneGraph(SceneGraph* graph, float phase) {
+
+    const float t = std::min(std::max(phase, 0.0f), 1.0f);
+
+    for (size_t i = 0; i < graph->animations.size(); i++) {
+        const SceneAnimation& animation = graph->animations[i];
+
+        if (graph->types[animation.node] == SCENE_NODE_CURVE_ANIMATION) {
+            const float u = 1.0f - t;
+            glm::vec3 position = u * u * u * animation.startPosition + 3.0f * u * u * t * animation.control1
+                               + 3.0f * u * t * t * animation.control2 + t * t * t * animation.endPosition;
+            setSceneNodeTransform(graph, animation.node, position, glm::vec3(0.0f), glm::vec3(1.0f));
+        }
+        else {
+            setSceneNodeTransform(graph, animation.node, glm::mix(animation.startPosition, animation.endPosition, t),
+                                  glm::mix(animation.startRotation, animation.endRotation, t), glm::mix(animation.startScale, animation.endScale, t));
+        }
+    }
+}
+
+size_t updateSceneGraph(SceneGraph* graph) {
+
+    // subtrees are nested or disjoint ranges, in ascending order a dirty node inside the last updated range is already done
+    std::sort(graph->dirtyNodes.begin(), graph->dirtyNodes.end());
+
+    size_t updated = 0;
+    int coveredEnd = 0;
+
+    for (size_t i = 0; i < graph->dirtyNodes.size(); i++) {
+        const int root = graph->dirtyNodes[i];
+        graph->flags[root] &= ~SCENE_NODE_DIRTY;
+        if (root < coveredEnd)
+            continue;
+
+        coveredEnd = graph->subtreeEnds[root];
+        for (int node = root; node < coveredEnd; node++)
+            updateWorldMatrix(graph, node);
+        updated += coveredEnd - root;
+    }
+
+    graph->dirtyNodes.clear();
+    return updated;
+}
+
+//x, y, z attributes, missing ones are 0
+static glm::vec3 tagVector(const XmlTag& tag) {
+
+    return glm::vec3(xmlFloat(tag, "x", 0.0f), xmlFloat(tag, "y", 0.0f), xmlFloat(tag, "z", 0.0f));
+}
+
+//models may be used by nodes before the <Models> section lists them
+static int sceneModel(SceneGraph* graph, const XmlString& name) {
+
+    for (size_t i = 0; i < graph->modelNames.size(); i++) {
+        if (graph->modelNames[i].size() == name.size && graph->modelNames[i].compare(0, name.size, name.data, name.size) == 0)
+            return (int)i;
+    }
+    graph->modelNames.push_back(xmlToString(name));
+    graph->modelPaths.push_back(std::string());
+    return (int)graph->modelNames.size() - 1;
+}
+
+//which pose the following <Rotation>, <Position> and <Scale> belong to
+typedef enum ScenePose {
+  SCENE_POSE_NONE,
+  SCENE_POSE_LOCAL,     // <Transform>
+  SCENE_POSE_START,     // <Start> of a linear animation
+  SCENE_POSE_END,       // <End>
+} ScenePose;
+
+//scale 0 is used by the grouping nodes of the file to drop the parent scale, the root one is meant for the terrain only
+static glm::vec3 nodeScale(SceneGraph* graph, int node, const glm::vec3& scale) {
+
+    if (scale == glm::vec3(0.0f)) {
+        graph->flags[node] |= SCENE_NODE_UNSCALED;
+        return glm::vec3(1.0f);
+    }
+    return scale;
+}
+
+bool loadSceneGraph(const std::string& fileName, SceneGraph* graph) {
+
+    XmlReader reader;
+    if (!openXmlReader(fileName, &reader)) {
+        std::cerr << "loadSceneGraph(): can not open " << fileName << std::endl;
+        return false;
+    }
+
+    clearSceneGraph(graph);
+
+    std::vector<int> openNodes;
+    bool inModels = false;
+    bool inSceneGraph = false;
+    ScenePose pose = SCENE_POSE_NONE;
+    int animation = -1;             // of the innermost open node, -1 if it is not animated
+
+    XmlTag tag;
+    bool malformed = false;
+
+    while (nextXmlTag(&reader, &tag)) {
+        const bool opening = !tag.closing;
+
+        if (xmlEquals(tag.name, "Models")) {
+            inModels = opening && !tag.selfClosing;
+        }
+        else if (xmlEquals(tag.name, "SceneGraph")) {
+            inSceneGraph = opening && !tag.selfClosing;
+        }
+        else if (inModels && xmlEquals(tag.name, "Model") && opening) {
+            const XmlString* name = xmlAttribute(tag, "name");
+            const XmlString* path = xmlAttribute(tag, "path");
+            if (name != NULL && path != NULL)
+                graph->modelPaths[sceneModel(graph, *name)] = xmlToString(*path);
+        }
+        else if (!inSceneGraph) {
+            continue;
+        }
+        else if (xmlEquals(tag.name, "Node")) {
+            if (tag.closing) {
+                if (openNodes.empty()) {
+                    malformed = true;
+                    break;
+                }
+                // poses of a node are before its <Children>, nothing of the parent follows
+                openNodes.pop_back();
+                pose = SCENE_POSE_NONE;
+                animation = -1;
+                continue;
+            }
+
+            const int parent = openNodes.empty() ? -1 : openNodes.back();
+            if (parent < 0 && !graph->parents.empty()) {
+                std::cerr << "loadSceneGraph(): " << fileName << " has more than one root node" << std::endl;
+                closeXmlReader(&reader);
+                clearSceneGraph(graph);
+                return false;
+            }
+
+            int type = xmlInt(tag, "type", SCENE_NODE_GROUP);
+            if (type < SCENE_NODE_GROUP || type > SCENE_NODE_CURVE_ANIMATION)
+                type = SCENE_NODE_GROUP;
+
+            int node = addSceneNode(graph, parent, (SceneNodeType)type, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f));
+            const XmlString* name = xmlAttribute(tag, "name");
+            if (name != NULL)
+                graph->names[node] = xmlToString(*name);
+
+            animation = -1;
+            if (type >= SCENE_NODE_LINEAR_ANIMATION) {
+                SceneAnimation nodeAnimation;
+                nodeAnimation.node = node;
+                nodeAnimation.startPosition = nodeAnimation.endPosition = glm::vec3(0.0f);
+                nodeAnimation.startRotation = nodeAnimation.endRotation = glm::vec3(0.0f);
+                nodeAnimation.startScale = nodeAnimation.endScale = glm::vec3(1.0f);
+                nodeAnimation.control1 = nodeAnimation.control2 = glm::vec3(0.0f);
+                graph->animations.push_back(nodeAnimation);
+                animation = (int)graph->animations.size() - 1;
+            }
+
+            if (!tag.selfClosing)
+                openNodes.push_back(node);
+        }
+        else if (openNodes.empty()) {
+            continue;
+        }
+        else if (xmlEquals(tag.name, "Transform")) {
+            pose = (opening && !tag.selfClosing) ? SCENE_POSE_LOCAL : SCENE_POSE_NONE;
+        }
+        else if ((xmlEquals(tag.name, "Start") || xmlEquals(tag.name, "End")) && animation >= 0) {
+            SceneAnimation& nodeAnimation = graph->animations[animation];
+            if (tag.selfClosing) {
+                // curve points are the attributes
+                (xmlEquals(tag.name, "Start") ? nodeAnimation.startPosition : nodeAnimation.endPosition) = tagVector(tag);
+            }
+            else {
+                pose = !opening ? SCENE_POSE_NONE : (xmlEquals(tag.name, "Start") ? SCENE_POSE_START : SCENE_POSE_END);
+            }
+        }
+        else if ((xmlEquals(tag.name, "Control1") || xmlEquals(tag.name, "Control2")) && animation >= 0 && opening) {
+            (xmlEquals(tag.name, "Control1") ? graph->animations[animation].control1 : graph->animations[animation].control2) = tagVector(tag);
+        }
+        else if (xmlEquals(tag.name, "SceneObject") && opening) {
+            const XmlString* model = xmlAttribute(tag, "model");
+            if (model != NULL)
+                graph->models[openNodes.back()] = sceneModel(graph, *model);
+        }
+        else if ((xmlEquals(tag.name, "Position") || xmlEquals(tag.name, "Rotation") || xmlEquals(tag.name, "Scale")) && opening && pose != SCENE_POSE_NONE) {
+            const int node = openNodes.back();
+            glm::vec3 value = tagVector(tag);
+
+            if (pose == SCENE_POSE_LOCAL) {
+                if (xmlEquals(tag.name, "Position"))
+                    graph->positions[node] = value;
+                else if (xmlEquals(tag.name, "Rotation"))
+                    graph->rotations[node] = glm::radians(value);
+                else
+                    graph->scales[node] = nodeScale(graph, node, value);
+            }
+            else if (animation >= 0) {
+                SceneAnimation& nodeAnimation = graph->animations[animation];
+                const bool start = pose == SCENE_POSE_START;
+                if (xmlEquals(tag.name, "Position"))
+                    (start ? nodeAnimation.startPosition : nodeAnimation.endPosition) = value;
+                else if (xmlEquals(tag.name, "Rotation"))
+                    (start ? nodeAnimation.startRotation : nodeAnimation.endRotation) = glm::radians(value);
+                else
+                    (start ? nodeAnimation.startScale : nodeAnimation.endScale) = nodeScale(graph, node, value);
+            }
+        }
+    }
+
+    const size_t position = reader.position - reader.file.data;
+    malformed = malformed || reader.malformed;
+    closeXmlReader(&reader);
+
+    if (malformed || !openNodes.empty() || graph->parents.empty()) {
+        if (graph->parents.empty() && !malformed)
+            std::cerr << "loadSceneGraph(): " << fileName << " has no <SceneGraph> nodes" << std::endl;
+        else
+            std::cerr << "loadSceneGraph(): " << fileName << " is malformed near byte " << position << std::endl;
+        clearSceneGraph(graph);
+        return false;
+    }
+
+    // animated nodes start in their start pose, finishSceneGraph computes the world matrices of all nodes anyway
+    animateSceneGraph(graph, 0.0f);
+    finishSceneGraph(graph);
+    return true;
+}
+
+#if SCENE_GRAPH_BENCHMARK
+//largest difference of two graphs' world matrices
+static float worldMatrixDifference(const SceneGraph& a, const SceneGraph& b) {
+
+    float difference = 0.0f;
+    for (size_t node = 0; node < a.worldMatrices.size() && node < b.worldMatrices.size(); node++) {
+        for (int column = 0; column < 4; column++) {
+            glm::vec4 delta = glm::abs(a.worldMatrices[node][column] - b.worldMatrices[node][column]);
+            difference = std::max(difference, std::max(std::max(delta.x, delta.y), std::max(delta.z, delta.w)));
+        }
+    }
+    return difference;
+}
+
+void benchmarkSceneGraph() {
+
+    typedef BenchmarkClock Clock;
+
+    const int numLoads = 100;
+    const int numNodes = 1000000;
+    const int numDirty = numNodes / 100;
+    const std::string generatedFile = "scene_graph_benchmark.xml";
+
+    SceneGraph graph;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < numLoads; i++)
+        loadSceneGraph(SCENE_GRAPH_FILE_NAME, &graph);
+    double loadTime = millisecondsBetween(start, Clock::now()) / numLoads;
+
+    start = Clock::now();
+    markSceneNodeDirty(&graph, 0);
+    size_t fullUpdated = updateSceneGraph(&graph);
+    double fullTime = millisecondsBetween(start, Clock::now());
+
+    start = Clock::now();
+    animateSceneGraph(&graph, 0.5f);
+    size_t animationUpdated = updateSceneGraph(&graph);
+    double animationTime = millisecondsBetween(start, Clock::now());
+
+    std::cout << "scene graph benchmark, " << SCENE_GRAPH_FILE_NAME << ": " << graph.parents.size() << " nodes, " << graph.modelNames.size()
+              << " models, " << graph.animations.size() << " animated" << std::endl;
+    std::cout << "  load " << loadTime << " ms, full update " << fullTime << " ms (" << fullUpdated << " nodes), animation update "
+              << animationTime << " ms (" << animationUpdated << " nodes)" << std::endl;
+
+    SceneGraph generated;
+    start = Clock::now();
+    generateSceneGraph(&generated, numNodes);
+    double buildTime = millisecondsBetween(start, Clock::now());
+
+    start = Clock::now();
+    markSceneNodeDirty(&generated, 0);
+    fullUpdated = updateSceneGraph(&generated);
+    fullTime = millisecondsBetween(start, Clock::now());
+
+    // random nodes move, as objects of a game level would - their subtrees overlap and are updated once
+    std::vector<int> moved(numDirty);
+    for (int i = 0; i < numDirty; i++)
+        moved[i] = (int)(((size_t)rand() * (RAND_MAX + 1u) + rand()) % numNodes);
+
+    start = Clock::now();
+    for (int i = 0; i < numDirty; i++) {
+        int node = moved[i];
+        setSceneNodeTransform(&generated, node, generated.positions[node] + glm::vec3(0.1f, 0.0f, 0.0f), generated.rotations[node], generated.scales[node]);
+    }
+    size_t dirtyUpdated = updateSceneGraph(&generated);
+    double dirtyTime = millisecondsBetween(start, Clock::now());
+
+    // a leaf, the common case of a single moving object
+    int leaf = numNodes - 1;
+    start = Clock::now();
+    setSceneNodeTransform(&generated, leaf, generated.positions[leaf], generated.rotations[leaf] + glm::vec3(0.0f, 0.1f, 0.0f), generated.scales[leaf]);
+    size_t leafUpdated = updateSceneGraph(&generated);
+    double leafTime = millisecondsBetween(start, Clock::now());
+
+    std::cout << "  generated " << numNodes << " nodes in " << buildTime << " ms: full update " << fullTime << " ms (" << fullUpdated
+              << " nodes), " << numDirty << " moved nodes " << dirtyTime << " ms (" << dirtyUpdated << " nodes), one leaf " << leafTime
+              << " ms (" << leafUpdated << " nodes)" << std::endl;
+
+    if (!writeSceneGraphFile(generated, generatedFile)) {
+        std::cout << "  can not write " << generatedFile << std::endl;
+        return;
+    }
+
+    std::ifstream written(generatedFile.c_str(), std::ios::binary | std::ios::ate);
+    double megabytes = (double)written.tellg() / (1024.0 * 1024.0);
+    written.close();
+
+    SceneGraph loaded;
+    start = Clock::now();
+    bool loadedOk = loadSceneGraph(generatedFile, &loaded);
+    loadTime = millisecondsBetween(start, Clock::now());
+    std::remove(generatedFile.c_str());
+
+    std::cout << "  generated file " << megabytes << " MB: load " << loadTime << " ms (" << megabytes / (loadTime / 1000.0) << " MB/s), "
+              << (loadedOk ? loaded.parents.size() : 0) << " nodes, world matrices differ by " << worldMatrixDifference(generated, loaded) << std::endl;
+}
+#endif
@@ -0,0 +1,99 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    scene_graph.h
+ * @date    18/10/2026
+ * @brief   Transform hierarchy of scene files (data/SceneGraphFinal.xml) flattened into depth first arrays.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __SCENE_GRAPH_H
+#define __SCENE_GRAPH_H
+
+#include <vector>
+#include <string>
+#include "glm/glm.hpp"
+
+//type attribute of <Node> in the scene file
+typedef enum SceneNodeType {
+  SCENE_NODE_GROUP = 1,             // only a transform
+  SCENE_NODE_OBJECT = 2,            // transform and <SceneObject model="..."/>
+  SCENE_NODE_LINEAR_ANIMATION = 3,  // transform moving between the <Start> and <End> poses
+  SCENE_NODE_CURVE_ANIMATION = 4,   // translation along a cubic Bezier curve <Start>, <Control1>, <Control2>, <End>
+} SceneNodeType;
+
+//flags of a node
+#define SCENE_NODE_DIRTY        1   // in dirtyNodes, its subtree gets new world matrices in updateSceneGraph
+#define SCENE_NODE_UNSCALED     2   // scale 0 in the file - takes the parent rotation and position but not its scale
+
+//Poses of an animated node, phase 0 is the start pose, 1 the end one
+typedef struct SceneAnimation {
+  int           node;
+  glm::vec3     startPosition;      // curve: first point
+  glm::vec3     endPosition;        // curve: last point
+  glm::vec3     startRotation;      // radians
+  glm::vec3     endRotation;
+  glm::vec3     startScale;
+  glm::vec3     endScale;
+  glm::vec3     control1;           // curve only
+  glm::vec3     control2;
+} SceneAnimation;
+
+//Nodes in depth first order - a parent is always before its children and the subtree of node i
+//is the range [i, subtreeEnds[i]), so world matrices are propagated by one pass over a range
+//local transform is translation * rotation * scale, the rotation turns about x, then y, then z
+typedef struct SceneGraph {
+  //hot, read by every update
+  std::vector<int>            parents;          // -1 for the root
+  std::vector<int>            subtreeEnds;
+  std::vector<unsigned char>  flags;
+  std::vector<glm::vec3>      positions;
+  std::vector<glm::vec3>      rotations;        // radians
+  std::vector<glm::vec3>      scales;
+  std::vector<glm::mat4>      worldMatrices;
+  std::vector<int>            dirtyNodes;       // roots of the subtrees to update, each node once
+
+  //cold, for lookups and the game objects made from the nodes
+  std::vector<unsigned char>  types;            // SceneNodeType
+  std::vector<int>            models;           // index to modelNames, -1 for nodes without a model
+  std::vector<std::string>    names;
+  std::vector<std::string>    modelNames;       // <Models> section, name attribute
+  std::vector<std::string>    modelPaths;       // empty for a model the nodes use but the section does not list
+  std::vector<SceneAnimation> animations;
+} SceneGraph;
+
+void clearSceneGraph(SceneGraph* graph);
+
+/**
+ * @brief Appends a node, finishSceneGraph has to be called before the first update.
+ *
+ * The parent must be the last added node or one of its ancestors, so the nodes stay in depth first order.
+ *
+ * @return index of the node
+ */
+int addSceneNode(SceneGraph* graph, int parent, SceneNodeType type, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+
+//computes the subtree ranges and all world matrices after the nodes are added
+void finishSceneGraph(SceneGraph* graph);
+
+/**
+ * @brief Loads <SceneGraph> and <Models> of a scene file, other sections are skipped.
+ *
+ * Animated nodes start in their start pose. Lights, shaders and terrain of the file are left to the caller.
+ *
+ * @return false if the file can not be read, is malformed or has more than one root node
+ */
+bool loadSceneGraph(const std::string& fileName, SceneGraph* graph);
+
+//changes the local transform and marks the subtree for updateSceneGraph
+void setSceneNodeTransform(SceneGraph* graph, int node, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+
+//moves all animated nodes to the phase between their start (0) and end (1) poses
+void animateSceneGraph(SceneGraph* graph, float phase);
+
+/**
+ * @brief Recomputes world matrices of the dirty subtrees only, each at most once.
+ * @return number of recomputed matrices
+ */
+size_t updateSceneGraph(SceneGraph* graph);
+
+#endif
@@ -7,21 +7,35 @@ out vec4 color_f;
 
 const float lower = -1.0f;			//lower border of fog
 const float upper = 5.0f;			//upper border of fog
-uniform vec3 fogColour;
 
-uniform bool fogActive;
+//per frame lighting computed on the CPU, the same block is in all programs using it (LightingBlock in lighting_buffer.h)
+struct Light {
+    vec4  ambient;
+    vec4  diffuse;
+    vec4  specular;
+    vec4  position;         // view space, w = 0 for directional lights
+    vec4  spotDirection;    // view space
+    vec4  parameters;       // x = spot cos cut off, y = spot exponent, z = intensity (0 = off)
+};
 
-uniform float blendFactor;			//blend between day and night
+layout(std140) uniform Lighting {
+    Light sun;              // directional light moving on sky during daytime
+    Light torch;            // flashlight moving with camera
+    Light lamp;             // point light as a lamp on castle
+    vec4  globalAmbient;
+    vec4  fogColour;        // rgb, a = 1 if fog is on
+    vec4  dayTime;          // x = 0 at day .. 1 at night
+};
 
 void main() {
 
 	vec4 tex1 = texture(skyboxSampler, texCoord_v);
 	vec4 tex2 = texture(skyboxSampler2, texCoord_v);
-	color_f = mix(tex1, tex2, blendFactor);
+	color_f = mix(tex1, tex2, dayTime.x);		//blend between day and night
   
-    if(fogActive){
+    if(fogColour.a > 0.0){
 		float factor = (texCoord_v.y - lower)/(upper - lower);
 		factor = clamp(factor, 0.0, 1.0);
-		color_f = mix(vec4(fogColour, 1.0), color_f, factor);
+		color_f = mix(vec4(fogColour.rgb, 1.0), color_f, factor);
     }
 }
@@ -0,0 +1,166 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    task_scheduler.cpp
+ * @date    18/10/2026
+ * @brief   Worker pool and completion queue running the startup task graph.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include "data.h"
+#include "task_scheduler.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//taken during static initialization, close enough to the process start
+static Clock::time_point processStart = Clock::now();
+static Clock::time_point schedulerStart;
+static double schedulerTime = 0.0;
+
+static std::vector<StartupTask> startupTasks;
+
+//ids of tasks whose work part is done, filled by workers and drained by the context thread
+static std::deque<int> completedTasks;
+static std::mutex completedMutex;
+static std::condition_variable completedCondition;
+
+static std::atomic<int> nextTask;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int addStartupTask(const std::string& name, std::function<void()> work, std::function<void()> finish,
+                   const std::vector<int>& dependencies) {
+
+    StartupTask task;
+    task.name = name;
+    task.work = work;
+    task.finish = finish;
+    task.dependencies = dependencies;
+    task.worker = -1;
+    task.workStart = task.workTime = 0.0;
+    task.finishStart = task.finishTime = 0.0;
+    task.workDone = false;
+    task.finished = false;
+
+    startupTasks.push_back(task);
+    return (int)startupTasks.size() - 1;
+}
+
+static void workerLoop(int worker) {
+
+    for (int id = nextTask++; id < (int)startupTasks.size(); id = nextTask++) {
+        StartupTask& task = startupTasks[id];
+
+        task.worker = worker;
+        task.workStart = millisecondsSince(schedulerStart);
+        if (task.work)
+            task.work();
+        task.workTime = millisecondsSince(schedulerStart) - task.workStart;
+
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completedTasks.push_back(id);
+        completedCondition.notify_one();
+    }
+}
+
+static bool dependenciesFinished(const StartupTask& task) {
+
+    for (size_t i = 0; i < task.dependencies.size(); i++) {
+        if (!startupTasks[task.dependencies[i]].finished)
+            return false;
+    }
+    return true;
+}
+
+void runStartupTasks() {
+
+    schedulerStart = Clock::now();
+    nextTask = 0;
+
+    unsigned int numWorkers = STARTUP_WORKER_THREADS;
+    if (numWorkers == 0)
+        numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    numWorkers = std::min(numWorkers, (unsigned int)startupTasks.size());
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < numWorkers; i++)
+        workers.push_back(std::thread(workerLoop, (int)i));
+
+    size_t numFinished = 0;
+
+    while (numFinished < startupTasks.size()) {
+        {
+            std::unique_lock<std::mutex> lock(completedMutex);
+            completedCondition.wait(lock, []() { return !completedTasks.empty(); });
+
+            while (!completedTasks.empty()) {
+                startupTasks[completedTasks.front()].workDone = true;
+                completedTasks.pop_front();
+            }
+        }
+
+        //one finish can unblock others, so repeat until nothing more is ready
+        bool progress = true;
+        while (progress) {
+            progress = false;
+
+            for (size_t i = 0; i < startupTasks.size(); i++) {
+                StartupTask& task = startupTasks[i];
+                if (task.finished || !task.workDone || !dependenciesFinished(task))
+                    continue;
+
+                task.finishStart = millisecondsSince(schedulerStart);
+                if (task.finish)
+                    task.finish();
+                task.finishTime = millisecondsSince(schedulerStart) - task.finishStart;
+                task.finished = true;
+
+                numFinished++;
+                progress = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    schedulerTime = millisecondsSince(schedulerStart);
+}
+
+void printStartupReport() {
+
+    double timeToFirstFrame = millisecondsSince(processStart);
+    double serialTime = 0.0;
+
+    std::cout << "startup tasks (ms):" << std::endl;
+    std::cout << "  " << std::left << std::setw(44) << "task" << std::right
+              << std::setw(7) << "worker" << std::setw(10) << "start" << std::setw(10) << "work"
+              << std::setw(10) << "gl start" << std::setw(10) << "gl" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (size_t i = 0; i < startupTasks.size(); i++) {
+        const StartupTask& task = startupTasks[i];
+        serialTime += task.workTime + task.finishTime;
+
+        std::cout << "  " << std::left << std::setw(44) << task.name << std::right
+                  << std::setw(7) << task.worker << std::setw(10) << task.workStart << std::setw(10) << task.workTime
+                  << std::setw(10) << task.finishStart << std::setw(10) << task.finishTime << std::endl;
+    }
+
+    std::cout << "  serial sum " << serialTime << ", scheduled " << schedulerTime
+              << " (" << serialTime - schedulerTime << " saved by overlap)" << std::endl;
+    std::cout << "  time to first frame " << timeToFirstFrame << std::endl;
+
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
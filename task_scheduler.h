@@ -0,0 +1,49 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    task_scheduler.h
+ * @date    18/10/2026
+ * @brief   Startup task graph - file I/O and parsing on worker threads, GL calls on the context thread.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __TASK_SCHEDULER_H
+#define __TASK_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+//One unit of startup work, split into a part without GL calls and a part needing the context
+typedef struct StartupTask {
+  std::string             name;
+  std::function<void()>   work;           // runs on a worker thread, may be empty
+  std::function<void()>   finish;         // runs on the context thread after work, may be empty
+  std::vector<int>        dependencies;   // tasks whose finish has to run before this finish
+
+  //filled in by runStartupTasks, milliseconds since the scheduler started
+  int     worker;
+  double  workStart;
+  double  workTime;
+  double  finishStart;
+  double  finishTime;
+  bool    workDone;
+  bool    finished;
+} StartupTask;
+
+//adds task to the graph, returns its id for use as a dependency of later tasks
+int addStartupTask(const std::string& name, std::function<void()> work, std::function<void()> finish,
+                   const std::vector<int>& dependencies = std::vector<int>());
+
+/**
+ * @brief Runs all added tasks and returns when every finish part is done.
+ *
+ * Work parts are picked up by a pool of worker threads in the order they were added.
+ * Finished work goes to a completion queue which the calling (context) thread drains,
+ * running finish parts as soon as their dependencies are satisfied.
+ */
+void runStartupTasks();
+
+//prints time to first frame and the per task breakdown, call once the first frame is on screen
+void printStartupReport();
+
+#endif
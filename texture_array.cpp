@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_array.cpp
+ * @date    18/10/2026
+ * @brief   Layer selection and upload of texture arrays from cooked KTX2 containers.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include "texture_array.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "gl_state.h"
+
+//level of the container with layerSize texels, -1 if it has none
+static int layerLevel(const TextureCache& cache, unsigned int layerSize) {
+
+    for (size_t level = 0; level < cache.levels.size(); level++) {
+        if (cache.levels[level].width == layerSize && cache.levels[level].height == layerSize)
+            return (int)level;
+    }
+    return -1;
+}
+
+bool textureArrayCandidate(const std::string& fileName, unsigned int layerSize, TextureFormat* format) {
+
+    TextureCache cache;
+    if (!openTextureCache(fileName, &cache))
+        return false;
+
+    *format = cache.format;
+    const bool candidate = layerLevel(cache, layerSize) >= 0;
+    closeTextureCache(&cache);
+    return candidate;
+}
+
+GLuint createTextureArray(const std::vector<std::string>& fileNames, unsigned int layerSize, size_t* bytes) {
+
+    *bytes = 0;
+
+    std::vector<TextureCache> caches(fileNames.size());
+    std::vector<int> firstLevels(fileNames.size());
+    size_t opened = 0;
+    for (; opened < fileNames.size(); opened++) {
+        if (!openTextureCache(fileNames[opened], &caches[opened]))
+            break;
+        firstLevels[opened] = layerLevel(caches[opened], layerSize);
+        if (firstLevels[opened] < 0 || caches[opened].format != caches[0].format) {
+            closeTextureCache(&caches[opened]);
+            break;
+        }
+    }
+    if (opened < fileNames.size()) {
+        std::cerr << "createTextureArray(): " << fileNames[opened] << " has no " << layerSize << " texel level anymore" << std::endl;
+        for (size_t i = 0; i < opened; i++)
+            closeTextureCache(&caches[i]);
+        return 0;
+    }
+
+    const TextureFormat format = caches[0].format;
+    const GLenum internalFormat = textureInternalFormat(format);
+    const bool decode = internalFormat == GL_RGBA8 && format != TEXTURE_FORMAT_RGBA8;
+    const GLsizei numLayers = (GLsizei)fileNames.size();
+    const int numLevels = (int)caches[0].levels.size() - firstLevels[0];
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindTexture(TEXTURE_ARRAY_UNIT, GL_TEXTURE_2D_ARRAY, texture);
+
+    for (int level = 0; level < numLevels; level++) {
+        const TextureCacheLevel& first = caches[0].levels[firstLevels[0] + level];
+
+        // storage of all layers first, then every layer's level into its slice
+        if (internalFormat == GL_RGBA8) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, first.width, first.height, numLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            *bytes += (size_t)first.width * first.height * 4 * numLayers;
+        }
+        else {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, first.width, first.height, numLayers, 0, (GLsizei)(first.size * numLayers), NULL);
+            *bytes += first.size * numLayers;
+        }
+
+        for (GLsizei layer = 0; layer < numLayers; layer++) {
+            const TextureCacheLevel& cacheLevel = caches[layer].levels[firstLevels[layer] + level];
+            if (internalFormat != GL_RGBA8) {
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, cacheLevel.width, cacheLevel.height, 1,
+                                          internalFormat, (GLsizei)cacheLevel.size, cacheLevel.data);
+            }
+            else if (decode) {
+                TextureImage image;
+                decodeTextureLevel(cacheLevel.data, format, cacheLevel.width, cacheLevel.height, &image);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, cacheLevel.width, cacheLevel.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+            }
+            else {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, cacheLevel.width, cacheLevel.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, cacheLevel.data);
+            }
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    for (size_t i = 0; i < caches.size(); i++)
+        closeTextureCache(&caches[i]);
+    return texture;
+}
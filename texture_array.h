@@ -0,0 +1,37 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_array.h
+ * @date    18/10/2026
+ * @brief   Cooked textures of one size and format packed as layers of a GL_TEXTURE_2D_ARRAY.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_ARRAY_H
+#define __TEXTURE_ARRAY_H
+
+#include <string>
+#include <vector>
+#include "pgr.h"
+#include "texture_encoder.h"
+
+//texture unit the arrays are sampled from, unit 0 keeps the GL_TEXTURE_2D of the other parts
+#define TEXTURE_ARRAY_UNIT  1
+
+/**
+ * @brief True if the cooked container of fileName can be a layer.
+ *
+ * Square power of two containers qualify if their mip chain has a level of layerSize texels,
+ * larger ones join with that level so the layer keeps the whole UV range and the wrapping.
+ *
+ * @param format  of the container, textures only share an array with the same format
+ */
+bool textureArrayCandidate(const std::string& fileName, unsigned int layerSize, TextureFormat* format);
+
+/**
+ * @brief One array, layer i is fileNames[i] from its level of layerSize texels down to 1x1.
+ * @param bytes  video memory of the array
+ * @return 0 if a container can not be opened anymore
+ */
+GLuint createTextureArray(const std::vector<std::string>& fileNames, unsigned int layerSize, size_t* bytes);
+
+#endif
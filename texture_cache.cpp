@@ -0,0 +1,399 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_cache.cpp
+ * @date    18/10/2026
+ * @brief   Writing, validating and mapping of cooked KTX2 textures.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "texture_cache.h"
+
+//level data starts on this boundary, a multiple of every block size
+#define TEXTURE_CACHE_ALIGNMENT 16
+
+//Vulkan formats of the KTX2 header
+#define VK_FORMAT_R8G8B8A8_UNORM        37
+#define VK_FORMAT_BC1_RGB_UNORM_BLOCK   131
+#define VK_FORMAT_BC3_UNORM_BLOCK       137
+
+static const unsigned char ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+//Fixed part of a KTX2 file, followed by levelCount Ktx2Level
+typedef struct Ktx2Header {
+  unsigned char identifier[12];
+  uint32_t  vkFormat;
+  uint32_t  typeSize;
+  uint32_t  pixelWidth;
+  uint32_t  pixelHeight;
+  uint32_t  pixelDepth;
+  uint32_t  layerCount;
+  uint32_t  faceCount;
+  uint32_t  levelCount;
+  uint32_t  supercompressionScheme;
+
+  uint32_t  dfdByteOffset;
+  uint32_t  dfdByteLength;
+  uint32_t  kvdByteOffset;
+  uint32_t  kvdByteLength;
+  uint64_t  sgdByteOffset;
+  uint64_t  sgdByteLength;
+} Ktx2Header;
+
+typedef struct Ktx2Level {
+  uint64_t  byteOffset;
+  uint64_t  byteLength;
+  uint64_t  uncompressedByteLength;
+} Ktx2Level;
+
+static_assert(sizeof(Ktx2Header) == 80, "Ktx2Header must match the KTX2 layout");
+
+//64 bit FNV-1a, continues from the given hash
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool fileStamp(const std::string& fileName, uint64_t* size, int64_t* time) {
+
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(fileName.c_str(), &info) != 0)
+        return false;
+#else
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0)
+        return false;
+#endif
+
+    *size = (uint64_t)info.st_size;
+    *time = (int64_t)info.st_mtime;
+    return true;
+}
+
+static bool identifySource(const std::string& sourceFile, TextureCacheSource* source) {
+
+    MappedFile file;
+    if (!mapFile(sourceFile, &file))
+        return false;
+
+    source->hash = hashBytes(14695981039346656037ull, file.data, file.size);
+    unmapFile(&file);
+
+    return fileStamp(sourceFile, &source->size, &source->time);
+}
+
+static uint32_t vkFormatOf(TextureFormat format) {
+
+    if (format == TEXTURE_FORMAT_BC1)
+        return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    if (format == TEXTURE_FORMAT_BC3)
+        return VK_FORMAT_BC3_UNORM_BLOCK;
+    return VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+static bool textureFormatOf(uint32_t vkFormat, TextureFormat* format) {
+
+    switch (vkFormat) {
+        case VK_FORMAT_R8G8B8A8_UNORM:       *format = TEXTURE_FORMAT_RGBA8; return true;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:  *format = TEXTURE_FORMAT_BC1; return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK:      *format = TEXTURE_FORMAT_BC3; return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks the container and fills the levels, only the subset written by writeTextureCache is accepted.
+ * @param sourceOffset  set to the file offset of the TextureCacheSource value
+ */
+static bool parseContainer(const MappedFile& file, TextureCache* cache, size_t* sourceOffset) {
+
+    if (file.size < sizeof(Ktx2Header))
+        return false;
+
+    const Ktx2Header* header = (const Ktx2Header*)file.data;
+    if (memcmp(header->identifier, ktx2Identifier, sizeof(ktx2Identifier)) != 0)
+        return false;
+
+    // 2D, no array, no cube, stored levels, no supercompression
+    if (!textureFormatOf(header->vkFormat, &cache->format) || header->pixelWidth == 0 || header->pixelHeight == 0
+            || header->pixelDepth != 0 || header->layerCount != 0 || header->faceCount != 1
+            || header->levelCount == 0 || header->levelCount > 32 || header->supercompressionScheme != 0)
+        return false;
+
+    if (sizeof(Ktx2Header) + (uint64_t)header->levelCount * sizeof(Ktx2Level) > file.size
+            || (uint64_t)header->kvdByteOffset + header->kvdByteLength > file.size)
+        return false;
+
+    const Ktx2Level* levels = (const Ktx2Level*)(file.data + sizeof(Ktx2Header));
+    cache->levels.resize(header->levelCount);
+    for (uint32_t i = 0; i < header->levelCount; i++) {
+        TextureCacheLevel& level = cache->levels[i];
+        level.width = std::max(header->pixelWidth >> i, 1u);
+        level.height = std::max(header->pixelHeight >> i, 1u);
+        level.size = textureLevelSize(cache->format, level.width, level.height);
+        if (levels[i].byteLength != level.size || levels[i].byteOffset + levels[i].byteLength > file.size)
+            return false;
+        level.data = (const unsigned char*)file.data + levels[i].byteOffset;
+    }
+
+    // key/value pairs: length, key, NUL, value, padded to 4 bytes
+    *sourceOffset = 0;
+    size_t offset = header->kvdByteOffset;
+    const size_t end = (size_t)header->kvdByteOffset + header->kvdByteLength;
+    const size_t keyLength = strlen(TEXTURE_CACHE_SOURCE_KEY) + 1;
+
+    while (offset + 4 <= end) {
+        uint32_t length;
+        memcpy(&length, file.data + offset, 4);
+        if (offset + 4 + length > end)
+            return false;
+
+        if (length == keyLength + sizeof(TextureCacheSource) && memcmp(file.data + offset + 4, TEXTURE_CACHE_SOURCE_KEY, keyLength) == 0)
+            *sourceOffset = offset + 4 + keyLength;
+
+        offset += 4 + ((length + 3) & ~3u);
+    }
+    return *sourceOffset != 0;
+}
+
+std::string textureCachePath(const std::string& sourceFile) {
+
+    std::string name = sourceFile;
+    for (size_t i = 0; i < name.size(); i++) {
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':')
+            name[i] = '_';
+    }
+
+    return std::string(TEXTURE_CACHE_DIRECTORY) + name + ".ktx2";
+}
+
+bool openTextureCache(const std::string& sourceFile, TextureCache* cache) {
+
+    if (!mapFile(textureCachePath(sourceFile), &cache->file))
+        return false;
+
+    size_t sourceOffset;
+    if (!parseContainer(cache->file, cache, &sourceOffset)) {
+        closeTextureCache(cache);
+        return false;
+    }
+
+    TextureCacheSource stored;
+    memcpy(&stored, cache->file.data + sourceOffset, sizeof(stored));
+
+    //sources may be missing in a shipped build - the container is all we have then
+    TextureCacheSource current;
+    if (fileStamp(sourceFile, &current.size, &current.time) && (current.size != stored.size || current.time != stored.time)) {
+        if (!identifySource(sourceFile, &current) || current.hash != stored.hash) {
+            closeTextureCache(cache);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void closeTextureCache(TextureCache* cache) {
+
+    unmapFile(&cache->file);
+    cache->levels.clear();
+}
+
+bool textureCacheUpToDate(const std::string& sourceFile) {
+
+    TextureCacheSource source;
+    if (!identifySource(sourceFile, &source))
+        return false;
+
+    TextureCache cache;
+    const std::string containerFile = textureCachePath(sourceFile);
+    if (!mapFile(containerFile, &cache.file))
+        return false;
+
+    size_t sourceOffset;
+    TextureCacheSource stored;
+    bool upToDate = parseContainer(cache.file, &cache, &sourceOffset);
+    if (upToDate) {
+        memcpy(&stored, cache.file.data + sourceOffset, sizeof(stored));
+        upToDate = (stored.hash == source.hash);
+    }
+    closeTextureCache(&cache);
+
+    if (upToDate && (stored.size != source.size || stored.time != source.time)) {
+        std::fstream stream(containerFile.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(sourceOffset);
+        stream.write((const char*)&source, sizeof(source));
+    }
+    return upToDate;
+}
+
+static uint32_t alignOffset(uint64_t offset) {
+    return (uint32_t)((offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~(uint64_t)(TEXTURE_CACHE_ALIGNMENT - 1));
+}
+
+static void appendWords(std::vector<uint32_t>* words, std::initializer_list<uint32_t> values) {
+    words->insert(words->end(), values);
+}
+
+//basic data format descriptor of the format, as required by KTX2
+static std::vector<uint32_t> formatDescriptor(TextureFormat format) {
+
+    // sample: bit offset | bit length - 1 | channel, position, lower, upper
+    std::vector<uint32_t> samples;
+    uint32_t colorModel, blockDimensions, bytesPlane0;
+
+    if (format == TEXTURE_FORMAT_RGBA8) {
+        colorModel = 1;             // RGBSDA
+        blockDimensions = 0;
+        bytesPlane0 = 4;
+        const uint32_t channels[4] = { 0, 1, 2, 15 };
+        for (uint32_t c = 0; c < 4; c++)
+            appendWords(&samples, { (8 * c) | (7u << 16) | (channels[c] << 24), 0, 0, 255 });
+    }
+    else if (format == TEXTURE_FORMAT_BC1) {
+        colorModel = 128;           // BC1A
+        blockDimensions = 3 | (3 << 8);
+        bytesPlane0 = 8;
+        appendWords(&samples, { 63u << 16, 0, 0, 0xFFFFFFFFu });
+    }
+    else {
+        colorModel = 130;           // BC3
+        blockDimensions = 3 | (3 << 8);
+        bytesPlane0 = 16;
+        appendWords(&samples, { (63u << 16) | (15u << 24), 0, 0, 0xFFFFFFFFu });
+        appendWords(&samples, { 64 | (63u << 16), 0, 0, 0xFFFFFFFFu });
+    }
+
+    const uint32_t blockSize = 24 + 4 * (uint32_t)samples.size();
+    std::vector<uint32_t> words;
+    appendWords(&words, { 4 + blockSize, 0, 2 | (blockSize << 16),
+                          colorModel | (1 << 8) | (1 << 16),      // BT.709 primaries, linear transfer as the UNORM format
+                          blockDimensions, bytesPlane0, 0 });
+    words.insert(words.end(), samples.begin(), samples.end());
+    return words;
+}
+
+static void appendKeyValue(std::string* data, const std::string& key, const void* value, size_t valueSize) {
+
+    const uint32_t length = (uint32_t)(key.size() + 1 + valueSize);
+    data->append((const char*)&length, 4);
+    data->append(key.c_str(), key.size() + 1);
+    data->append((const char*)value, valueSize);
+    data->append((4 - data->size() % 4) % 4, '\0');
+}
+
+static void writePadding(std::ofstream& stream, uint64_t offset) {
+
+    static const char zeros[TEXTURE_CACHE_ALIGNMENT] = { 0 };
+    uint64_t position = (uint64_t)stream.tellp();
+    if (position < offset)
+        stream.write(zeros, offset - position);
+}
+
+bool writeTextureCache(const std::string& sourceFile, const TextureImage& image, bool compress, TextureCookStats* stats) {
+
+    TextureCacheSource source;
+    if (!identifySource(sourceFile, &source)) {
+        std::cerr << "writeTextureCache(): can not read " << sourceFile << std::endl;
+        return false;
+    }
+
+    const TextureFormat format = !compress ? TEXTURE_FORMAT_RGBA8 : (imageHasAlpha(image) ? TEXTURE_FORMAT_BC3 : TEXTURE_FORMAT_BC1);
+
+    std::vector<TextureImage> mipLevels;
+    buildMipChain(image, &mipLevels);
+
+    std::vector<std::vector<unsigned char> > data(mipLevels.size());
+    for (size_t i = 0; i < mipLevels.size(); i++)
+        encodeTextureLevel(mipLevels[i], format, &data[i]);
+
+    stats->width = image.width;
+    stats->height = image.height;
+    stats->levels = (unsigned int)mipLevels.size();
+    stats->format = format;
+    stats->bytes = 0;
+    stats->uncompressedBytes = 0;
+    for (size_t i = 0; i < mipLevels.size(); i++) {
+        stats->bytes += data[i].size();
+        stats->uncompressedBytes += textureLevelSize(TEXTURE_FORMAT_RGBA8, mipLevels[i].width, mipLevels[i].height);
+    }
+
+    TextureImage decoded;
+    decodeTextureLevel(data[0].data(), format, image.width, image.height, &decoded);
+    double squaredError = 0.0;
+    for (size_t i = 0; i < image.pixels.size(); i++) {
+        const double difference = (double)decoded.pixels[i] - image.pixels[i];
+        squaredError += difference * difference;
+    }
+    stats->error = (float)sqrt(squaredError / std::max(image.pixels.size(), (size_t)1));
+
+    std::vector<uint32_t> descriptor = formatDescriptor(format);
+
+    // keys sorted by their bytes as the format asks, data is stored bottom row first
+    std::string keyValues;
+    appendKeyValue(&keyValues, TEXTURE_CACHE_SOURCE_KEY, &source, sizeof(source));
+    appendKeyValue(&keyValues, "KTXorientation", "ru", 3);
+    appendKeyValue(&keyValues, "KTXwriter", "mesh_cooker", 12);
+
+    Ktx2Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.identifier, ktx2Identifier, sizeof(ktx2Identifier));
+    header.vkFormat = vkFormatOf(format);
+    header.typeSize = 1;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.faceCount = 1;
+    header.levelCount = (uint32_t)mipLevels.size();
+    header.dfdByteOffset = (uint32_t)(sizeof(Ktx2Header) + sizeof(Ktx2Level) * mipLevels.size());
+    header.dfdByteLength = (uint32_t)(descriptor.size() * sizeof(uint32_t));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = (uint32_t)keyValues.size();
+
+    // smallest level first, so a reader streaming the file gets something to show early
+    std::vector<Ktx2Level> levels(mipLevels.size());
+    uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+    for (size_t i = mipLevels.size(); i-- > 0; ) {
+        offset = alignOffset(offset);
+        levels[i].byteOffset = offset;
+        levels[i].byteLength = data[i].size();
+        levels[i].uncompressedByteLength = data[i].size();
+        offset += data[i].size();
+    }
+
+    //write next to the container and rename, so a running game never maps half written file
+    const std::string containerFile = textureCachePath(sourceFile);
+    const std::string temporaryFile = containerFile + ".tmp";
+    std::ofstream stream(temporaryFile.c_str(), std::ios::binary | std::ios::trunc);
+    if (!stream)
+        return false;
+
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)levels.data(), sizeof(Ktx2Level) * levels.size());
+    stream.write((const char*)descriptor.data(), header.dfdByteLength);
+    stream.write(keyValues.data(), keyValues.size());
+    for (size_t i = mipLevels.size(); i-- > 0; ) {
+        writePadding(stream, levels[i].byteOffset);
+        stream.write((const char*)data[i].data(), data[i].size());
+    }
+    stream.close();
+
+    if (!stream) {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+
+    std::remove(containerFile.c_str());
+    return std::rename(temporaryFile.c_str(), containerFile.c_str()) == 0;
+}
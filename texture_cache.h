@@ -0,0 +1,73 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_cache.h
+ * @date    18/10/2026
+ * @brief   Cooked textures - KTX2 containers with full mip chains, memory mapped at startup.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_CACHE_H
+#define __TEXTURE_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "texture_encoder.h"
+
+#define TEXTURE_CACHE_DIRECTORY "data/cache/"
+//key of the KTX2 key/value data holding the source identity (TextureCacheSource)
+#define TEXTURE_CACHE_SOURCE_KEY "HGsource"
+
+//Source image identity - size and time for a cheap check, content hash decides
+typedef struct TextureCacheSource {
+  uint64_t  hash;
+  uint64_t  size;
+  int64_t   time;
+} TextureCacheSource;
+
+//One mip level, data points into the mapped file
+typedef struct TextureCacheLevel {
+  const unsigned char*  data;
+  size_t                size;
+  unsigned int          width;
+  unsigned int          height;
+} TextureCacheLevel;
+
+//Mapped container, level pointers stay valid until closeTextureCache
+typedef struct TextureCache {
+  MappedFile                      file;
+  TextureFormat                   format;
+  std::vector<TextureCacheLevel>  levels;       // level 0 is the full size image
+} TextureCache;
+
+//Output of one cook
+typedef struct TextureCookStats {
+  unsigned int  width;
+  unsigned int  height;
+  unsigned int  levels;
+  TextureFormat format;
+  size_t        bytes;                  // all levels as stored and uploaded
+  size_t        uncompressedBytes;      // the same levels as RGBA8
+  float         error;                  // RMS error of level 0 after compression, 0..255
+} TextureCookStats;
+
+//container file name for given source image, e.g. data/water.png -> data/cache/data_water.png.ktx2
+std::string textureCachePath(const std::string& sourceFile);
+
+//maps the container of the source image, fails if it is missing, not one of ours or stale
+bool openTextureCache(const std::string& sourceFile, TextureCache* cache);
+void closeTextureCache(TextureCache* cache);
+
+//true if the container matches the source content, the stored size and time are refreshed if only they differ
+bool textureCacheUpToDate(const std::string& sourceFile);
+
+/**
+ * @brief Builds the mip chain of the decoded source image and writes it as KTX2.
+ * @param image     decoded sourceFile, rows from the bottom up
+ * @param compress  BC1 (opaque) or BC3 (with alpha) if true, RGBA8 otherwise
+ * @return false if the source can not be identified or the file written
+ */
+bool writeTextureCache(const std::string& sourceFile, const TextureImage& image, bool compress, TextureCookStats* stats);
+
+#endif
@@ -0,0 +1,497 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_encoder.cpp
+ * @date    18/10/2026
+ * @brief   Lanczos mip filter, principal axis BC1/BC3 encoder and the block decoder.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "texture_encoder.h"
+
+static const float PI = 3.14159265358979f;
+
+size_t textureLevelSize(TextureFormat format, unsigned int width, unsigned int height) {
+
+    if (format == TEXTURE_FORMAT_RGBA8)
+        return (size_t)width * height * 4;
+
+    const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == TEXTURE_FORMAT_BC1 ? 8 : 16);
+}
+
+bool imageHasAlpha(const TextureImage& image) {
+
+    for (size_t i = 3; i < image.pixels.size(); i += 4) {
+        if (image.pixels[i] != 255)
+            return true;
+    }
+    return false;
+}
+
+//---- mip chain ----
+
+static float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static float lanczos(float x) {
+
+    x = fabsf(x);
+    if (x < 1e-5f)
+        return 1.0f;
+    if (x >= (float)TEXTURE_MIP_FILTER_LOBES)
+        return 0.0f;
+
+    const float px = PI * x;
+    return (float)TEXTURE_MIP_FILTER_LOBES * sinf(px) * sinf(px / TEXTURE_MIP_FILTER_LOBES) / (px * px);
+}
+
+//Taps of one destination texel
+typedef struct FilterTaps {
+  int                 first;
+  std::vector<float>  weights;
+} FilterTaps;
+
+//normalized filter taps of every destination texel, the kernel is stretched over the source texels it covers
+static void buildFilterTaps(unsigned int sourceSize, unsigned int destinationSize, std::vector<FilterTaps>* taps) {
+
+    const float scale = (float)sourceSize / (float)destinationSize;
+    const float support = TEXTURE_MIP_FILTER_LOBES * scale;
+
+    taps->resize(destinationSize);
+    for (unsigned int i = 0; i < destinationSize; i++) {
+        const float center = (i + 0.5f) * scale;
+        const int first = (int)floorf(center - support);
+        const int last = (int)ceilf(center + support);
+
+        FilterTaps& tap = (*taps)[i];
+        tap.first = first;
+        tap.weights.resize(last - first + 1);
+
+        float sum = 0.0f;
+        for (int j = first; j <= last; j++) {
+            float weight = lanczos((j + 0.5f - center) / scale);
+            tap.weights[j - first] = weight;
+            sum += weight;
+        }
+        for (size_t j = 0; j < tap.weights.size(); j++)
+            tap.weights[j] /= sum;
+    }
+}
+
+//4 floats per texel, linear premultiplied color and alpha
+static void resampleRows(const std::vector<float>& source, unsigned int sourceWidth, unsigned int height,
+                         unsigned int destinationWidth, std::vector<float>* destination) {
+
+    std::vector<FilterTaps> taps;
+    buildFilterTaps(sourceWidth, destinationWidth, &taps);
+
+    destination->assign((size_t)destinationWidth * height * 4, 0.0f);
+    for (unsigned int y = 0; y < height; y++) {
+        const float* row = &source[(size_t)y * sourceWidth * 4];
+        float* out = &(*destination)[(size_t)y * destinationWidth * 4];
+
+        for (unsigned int x = 0; x < destinationWidth; x++) {
+            const FilterTaps& tap = taps[x];
+            for (size_t j = 0; j < tap.weights.size(); j++) {
+                const int column = std::min(std::max(tap.first + (int)j, 0), (int)sourceWidth - 1);
+                for (int c = 0; c < 4; c++)
+                    out[x * 4 + c] += tap.weights[j] * row[column * 4 + c];
+            }
+        }
+    }
+}
+
+static void resampleColumns(const std::vector<float>& source, unsigned int width, unsigned int sourceHeight,
+                            unsigned int destinationHeight, std::vector<float>* destination) {
+
+    std::vector<FilterTaps> taps;
+    buildFilterTaps(sourceHeight, destinationHeight, &taps);
+
+    destination->assign((size_t)width * destinationHeight * 4, 0.0f);
+    for (unsigned int y = 0; y < destinationHeight; y++) {
+        const FilterTaps& tap = taps[y];
+        float* out = &(*destination)[(size_t)y * width * 4];
+
+        for (size_t j = 0; j < tap.weights.size(); j++) {
+            const int row = std::min(std::max(tap.first + (int)j, 0), (int)sourceHeight - 1);
+            const float* in = &source[(size_t)row * width * 4];
+            const float weight = tap.weights[j];
+            for (unsigned int i = 0; i < width * 4; i++)
+                out[i] += weight * in[i];
+        }
+    }
+}
+
+static void toLinear(const TextureImage& image, std::vector<float>* texels) {
+
+    float table[256];
+    for (int i = 0; i < 256; i++)
+        table[i] = srgbToLinear(i / 255.0f);
+
+    const size_t count = (size_t)image.width * image.height;
+    texels->resize(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* pixel = &image.pixels[i * 4];
+        const float alpha = pixel[3] / 255.0f;
+        for (int c = 0; c < 3; c++)
+            (*texels)[i * 4 + c] = table[pixel[c]] * alpha;
+        (*texels)[i * 4 + 3] = alpha;
+    }
+}
+
+static void fromLinear(const std::vector<float>& texels, unsigned int width, unsigned int height, TextureImage* image) {
+
+    image->width = width;
+    image->height = height;
+    image->pixels.resize((size_t)width * height * 4);
+
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        // negative lobes may push values out of range
+        const float alpha = std::min(std::max(texels[i * 4 + 3], 0.0f), 1.0f);
+        for (int c = 0; c < 3; c++) {
+            float value = alpha > 1e-6f ? texels[i * 4 + c] / alpha : 0.0f;
+            value = linearToSrgb(std::min(std::max(value, 0.0f), 1.0f));
+            image->pixels[i * 4 + c] = (unsigned char)(value * 255.0f + 0.5f);
+        }
+        image->pixels[i * 4 + 3] = (unsigned char)(alpha * 255.0f + 0.5f);
+    }
+}
+
+void buildMipChain(const TextureImage& image, std::vector<TextureImage>* levels) {
+
+    levels->clear();
+    levels->push_back(image);
+
+    // every level is filtered from the float data of the previous one, not from its 8 bit copy
+    std::vector<float> texels, rows;
+    toLinear(image, &texels);
+
+    unsigned int width = image.width;
+    unsigned int height = image.height;
+
+    while (width > 1 || height > 1) {
+        const unsigned int nextWidth = std::max(width / 2, 1u);
+        const unsigned int nextHeight = std::max(height / 2, 1u);
+
+        resampleRows(texels, width, height, nextWidth, &rows);
+        resampleColumns(rows, nextWidth, height, nextHeight, &texels);
+        width = nextWidth;
+        height = nextHeight;
+
+        // ringing of the negative lobes must not add up over the levels
+        for (size_t i = 0; i < texels.size(); i += 4) {
+            texels[i + 3] = std::min(std::max(texels[i + 3], 0.0f), 1.0f);
+            for (int c = 0; c < 3; c++)
+                texels[i + c] = std::min(std::max(texels[i + c], 0.0f), texels[i + 3]);
+        }
+
+        TextureImage level;
+        fromLinear(texels, width, height, &level);
+        levels->push_back(level);
+    }
+}
+
+//---- BC1 / BC3 ----
+
+static unsigned short packColor565(const float* color) {
+
+    const int r = (int)(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    const int g = (int)(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+    const int b = (int)(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackColor565(unsigned short packed, int* color) {
+
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+//4 color palette of the endpoints, 3 colors + black if color0 <= color1 and the block may use it
+static void colorPalette(unsigned short color0, unsigned short color1, bool allowThreeColors, int palette[4][3]) {
+
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+
+    for (int c = 0; c < 3; c++) {
+        if (color0 > color1 || !allowThreeColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+//nearest palette entry of every texel, returns the squared error of the block
+static int pickColorIndices(const unsigned char block[16][4], unsigned short color0, unsigned short color1, unsigned int* indices) {
+
+    int palette[4][3];
+    colorPalette(color0, color1, false, palette);
+
+    int error = 0;
+    *indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestDistance = 1 << 30;
+        for (int p = 0; p < 4; p++) {
+            int distance = 0;
+            for (int c = 0; c < 3; c++) {
+                const int d = block[i][c] - palette[p][c];
+                distance += d * d;
+            }
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = p;
+            }
+        }
+        *indices |= (unsigned int)best << (2 * i);
+        error += bestDistance;
+    }
+    return error;
+}
+
+//endpoints along the principal axis of the block colors, then one least squares refit for the chosen indices
+static void encodeColorBlock(const unsigned char block[16][4], unsigned char* out) {
+
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += block[i][c] / 16.0f;
+
+    float covariance[6] = { 0.0f };     // rr rg rb gg gb bb
+    for (int i = 0; i < 16; i++) {
+        const float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+        covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+        covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+    }
+
+    // power iteration from the luminance direction
+    float axis[3] = { 0.299f, 0.587f, 0.114f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        const float length = sqrtf(x * x + y * y + z * z);
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+
+    float minProjection = 1e30f, maxProjection = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        const float projection = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    float endpoint0[3], endpoint1[3];
+    for (int c = 0; c < 3; c++) {
+        endpoint0[c] = mean[c] + axis[c] * maxProjection;
+        endpoint1[c] = mean[c] + axis[c] * minProjection;
+    }
+
+    unsigned short color0 = packColor565(endpoint0);
+    unsigned short color1 = packColor565(endpoint1);
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    unsigned int indices;
+    int error = pickColorIndices(block, color0, color1, &indices);
+
+    // least squares endpoints for the chosen indices: texel = a * endpoint0 + b * endpoint1
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = { 0.0f }, bx[3] = { 0.0f };
+    for (int i = 0; i < 16; i++) {
+        const float a = weights[(indices >> (2 * i)) & 3];
+        const float b = 1.0f - a;
+        aa += a * a; ab += a * b; bb += b * b;
+        for (int c = 0; c < 3; c++) {
+            ax[c] += a * block[i][c];
+            bx[c] += b * block[i][c];
+        }
+    }
+
+    const float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) > 1e-6f) {
+        for (int c = 0; c < 3; c++) {
+            endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+
+        unsigned short refined0 = packColor565(endpoint0);
+        unsigned short refined1 = packColor565(endpoint1);
+        if (refined0 < refined1)
+            std::swap(refined0, refined1);
+
+        unsigned int refinedIndices;
+        int refinedError = pickColorIndices(block, refined0, refined1, &refinedIndices);
+        if (refinedError < error) {
+            color0 = refined0;
+            color1 = refined1;
+            indices = refinedIndices;
+        }
+    }
+
+    // equal endpoints select the 3 color mode in BC1, index 0 still gives color0 there
+    if (color0 == color1)
+        indices = 0;
+
+    out[0] = (unsigned char)(color0 & 0xFF);
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)(color1 & 0xFF);
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (unsigned char)((indices >> (8 * i)) & 0xFF);
+}
+
+static void alphaPalette(int alpha0, int alpha1, int palette[8]) {
+
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    if (alpha0 > alpha1) {
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+    else {
+        for (int i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+//8 value mode between the smallest and largest alpha of the block
+static void encodeAlphaBlock(const unsigned char block[16][4], unsigned char* out) {
+
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++) {
+        alpha0 = std::max(alpha0, (int)block[i][3]);
+        alpha1 = std::min(alpha1, (int)block[i][3]);
+    }
+
+    int palette[8];
+    alphaPalette(alpha0, alpha1, palette);
+
+    unsigned long long bits = 0;
+    if (alpha0 != alpha1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            for (int p = 1; p < 8; p++) {
+                if (abs(palette[p] - block[i][3]) < abs(palette[best] - block[i][3]))
+                    best = p;
+            }
+            bits |= (unsigned long long)best << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+}
+
+//4x4 texels at x, y, texels outside a partial block repeat the edge
+static void gatherBlock(const TextureImage& image, unsigned int x, unsigned int y, unsigned char block[16][4]) {
+
+    for (unsigned int j = 0; j < 4; j++) {
+        const unsigned int row = std::min(y + j, image.height - 1);
+        for (unsigned int i = 0; i < 4; i++) {
+            const unsigned int column = std::min(x + i, image.width - 1);
+            memcpy(block[j * 4 + i], &image.pixels[((size_t)row * image.width + column) * 4], 4);
+        }
+    }
+}
+
+void encodeTextureLevel(const TextureImage& image, TextureFormat format, std::vector<unsigned char>* data) {
+
+    data->resize(textureLevelSize(format, image.width, image.height));
+
+    if (format == TEXTURE_FORMAT_RGBA8) {
+        memcpy(data->data(), image.pixels.data(), data->size());
+        return;
+    }
+
+    const size_t blockSize = format == TEXTURE_FORMAT_BC1 ? 8 : 16;
+    unsigned char* out = data->data();
+    unsigned char block[16][4];
+
+    for (unsigned int y = 0; y < image.height; y += 4) {
+        for (unsigned int x = 0; x < image.width; x += 4) {
+            gatherBlock(image, x, y, block);
+            if (format == TEXTURE_FORMAT_BC3) {
+                encodeAlphaBlock(block, out);
+                encodeColorBlock(block, out + 8);
+            }
+            else {
+                encodeColorBlock(block, out);
+            }
+            out += blockSize;
+        }
+    }
+}
+
+void decodeTextureLevel(const unsigned char* data, TextureFormat format, unsigned int width, unsigned int height, TextureImage* image) {
+
+    image->width = width;
+    image->height = height;
+    image->pixels.resize((size_t)width * height * 4);
+
+    if (format == TEXTURE_FORMAT_RGBA8) {
+        memcpy(image->pixels.data(), data, image->pixels.size());
+        return;
+    }
+
+    const size_t blockSize = format == TEXTURE_FORMAT_BC1 ? 8 : 16;
+
+    for (unsigned int y = 0; y < height; y += 4) {
+        for (unsigned int x = 0; x < width; x += 4, data += blockSize) {
+            const unsigned char* color = format == TEXTURE_FORMAT_BC3 ? data + 8 : data;
+
+            int palette[4][3];
+            const unsigned short color0 = (unsigned short)(color[0] | (color[1] << 8));
+            const unsigned short color1 = (unsigned short)(color[2] | (color[3] << 8));
+            colorPalette(color0, color1, format == TEXTURE_FORMAT_BC1, palette);
+            const unsigned int indices = color[4] | (color[5] << 8) | (color[6] << 16) | ((unsigned int)color[7] << 24);
+
+            int alphas[8];
+            unsigned long long alphaBits = 0;
+            if (format == TEXTURE_FORMAT_BC3) {
+                alphaPalette(data[0], data[1], alphas);
+                for (int i = 0; i < 6; i++)
+                    alphaBits |= (unsigned long long)data[2 + i] << (8 * i);
+            }
+
+            for (unsigned int i = 0; i < 16; i++) {
+                const unsigned int column = x + i % 4, row = y + i / 4;
+                if (column >= width || row >= height)
+                    continue;
+
+                unsigned char* pixel = &image->pixels[((size_t)row * width + column) * 4];
+                const unsigned int index = (indices >> (2 * i)) & 3;
+                for (int c = 0; c < 3; c++)
+                    pixel[c] = (unsigned char)palette[index][c];
+
+                if (format == TEXTURE_FORMAT_BC3)
+                    pixel[3] = (unsigned char)alphas[(alphaBits >> (3 * i)) & 7];
+                else
+                    pixel[3] = (color0 <= color1 && index == 3) ? 0 : 255;
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_encoder.h
+ * @date    18/10/2026
+ * @brief   Mip chain filtering and BC1/BC3 block compression of cooked textures.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_ENCODER_H
+#define __TEXTURE_ENCODER_H
+
+#include <vector>
+#include <cstddef>
+
+//lobes of the Lanczos filter building the mip levels, in texels of the smaller level
+#define TEXTURE_MIP_FILTER_LOBES    2
+
+//Layout of the level data in a cooked texture
+enum TextureFormat {
+  TEXTURE_FORMAT_RGBA8,         // uncompressed fallback, 4 bytes per texel
+  TEXTURE_FORMAT_BC1,           // opaque, 8 bytes per 4x4 block
+  TEXTURE_FORMAT_BC3,           // with alpha, 16 bytes per 4x4 block
+};
+
+//Decoded image, 4 bytes per texel RGBA, rows from the bottom up as OpenGL takes them
+typedef struct TextureImage {
+  unsigned int                width;
+  unsigned int                height;
+  std::vector<unsigned char>  pixels;
+} TextureImage;
+
+//bytes of one level, block formats round the size up to whole blocks
+size_t textureLevelSize(TextureFormat format, unsigned int width, unsigned int height);
+
+//true if some texel is not fully opaque - decides between BC1 and BC3
+bool imageHasAlpha(const TextureImage& image);
+
+/**
+ * @brief Fills levels with the image followed by smaller levels down to 1x1.
+ *
+ * Each level halves the previous one (odd sizes round down) with a separable Lanczos filter.
+ * Colors are filtered in linear light and weighted by alpha, so dark fringes do not grow
+ * around transparent texels. Edges are clamped.
+ */
+void buildMipChain(const TextureImage& image, std::vector<TextureImage>* levels);
+
+//encodes one level, data is resized to textureLevelSize
+void encodeTextureLevel(const TextureImage& image, TextureFormat format, std::vector<unsigned char>* data);
+//decodes one level of any format back to RGBA8, used when the driver can not sample the block format
+void decodeTextureLevel(const unsigned char* data, TextureFormat format, unsigned int width, unsigned int height, TextureImage* image);
+
+#endif
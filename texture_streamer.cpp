@@ -0,0 +1,480 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_streamer.cpp
+ * @date    18/10/2026
+ * @brief   Worker threads fill mapped PBOs with mip levels, the context thread uploads and evicts them.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include "texture_streamer.h"
+#include "texture_cache.h"
+#include "gl_state.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//Streamed texture, levels residentLevel..last are in video memory
+typedef struct StreamedTexture {
+  TextureCache      cache;              // mapped while the texture lives, the workers read the levels from it
+  int               residentLevel;      // finest level in video memory, GL_TEXTURE_BASE_LEVEL
+  int               tailLevel;          // the placeholder levels start here and stay resident
+  int               loadingLevel;       // level on its way, -1 if none
+  int               wantedLevel;        // finest level asked for in lastUsedFrame
+  float             pixels;             // largest request of lastUsedFrame, the load priority
+  unsigned int      lastUsedFrame;
+  bool              waiting;            // wantedLevel has been finer than residentLevel since waitStart
+  Clock::time_point waitStart;
+} StreamedTexture;
+
+//One level copied (or decoded) by a worker into a mapped PBO
+typedef struct StreamJob {
+  GLuint                texture;
+  int                   level;
+  int                   buffer;
+  const unsigned char*  source;
+  TextureFormat         format;
+  unsigned int          width;
+  unsigned int          height;
+  bool                  decode;         // blocks are expanded to RGBA8, the driver has no S3TC
+  unsigned char*        destination;
+  size_t                size;           // bytes written to destination
+} StreamJob;
+
+static bool streamingRunning = false;
+static std::unordered_map<GLuint, StreamedTexture> streamedTextures;
+static unsigned int streamFrame = 0;
+static size_t budget = 0;
+static size_t loadingBytes = 0;
+static TextureStreamStats streamStats;
+
+static GLuint pixelBuffers[TEXTURE_STREAM_BUFFERS] = { 0 };
+static bool pixelBufferBusy[TEXTURE_STREAM_BUFFERS] = { false };
+
+//jobs for the workers and jobs they finished, both under jobMutex
+static std::deque<StreamJob> pendingJobs;
+static std::deque<StreamJob> finishedJobs;
+static std::mutex jobMutex;
+static std::condition_variable pendingCondition;
+static std::condition_variable finishedCondition;
+static bool stopWorkers = false;
+static std::vector<std::thread> workers;
+
+bool blockCompressionSupported() {
+
+    static int supported = -1;
+    if (supported < 0) {
+        supported = 0;
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++) {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (name != NULL && strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+                supported = 1;
+        }
+    }
+    return supported == 1;
+}
+
+GLenum textureInternalFormat(TextureFormat format) {
+
+    if (format == TEXTURE_FORMAT_RGBA8 || !blockCompressionSupported())
+        return GL_RGBA8;
+    return format == TEXTURE_FORMAT_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+//video memory of a level as uploaded
+static size_t levelBytes(const TextureCache& cache, int level) {
+
+    const TextureCacheLevel& cacheLevel = cache.levels[level];
+    if (textureInternalFormat(cache.format) == GL_RGBA8)
+        return (size_t)cacheLevel.width * cacheLevel.height * 4;
+    return cacheLevel.size;
+}
+
+//level of the bound texture, data is in the format of the container or RGBA8 if the internal format is
+static void texImageLevel(TextureFormat format, int level, unsigned int width, unsigned int height, size_t size, const void* data) {
+
+    const GLenum internalFormat = textureInternalFormat(format);
+    if (internalFormat == GL_RGBA8)
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, (GLsizei)size, data);
+}
+
+static void workerLoop() {
+
+    for (;;) {
+        StreamJob job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            pendingCondition.wait(lock, []() { return stopWorkers || !pendingJobs.empty(); });
+            if (pendingJobs.empty())
+                return;
+            job = pendingJobs.front();
+            pendingJobs.pop_front();
+        }
+
+        // the copy is where the mapped container pages are read from disk
+        if (job.decode) {
+            TextureImage image;
+            decodeTextureLevel(job.source, job.format, job.width, job.height, &image);
+            memcpy(job.destination, image.pixels.data(), job.size);
+        }
+        else {
+            memcpy(job.destination, job.source, job.size);
+        }
+
+        std::lock_guard<std::mutex> lock(jobMutex);
+        finishedJobs.push_back(job);
+        finishedCondition.notify_all();
+    }
+}
+
+void initTextureStreaming(size_t budgetBytes) {
+
+    if (streamingRunning)
+        return;
+
+    memset(&streamStats, 0, sizeof(streamStats));
+    budget = budgetBytes;
+    streamStats.budgetBytes = budget;
+    loadingBytes = 0;
+    streamFrame = 0;
+
+    glGenBuffers(TEXTURE_STREAM_BUFFERS, pixelBuffers);
+    for (int i = 0; i < TEXTURE_STREAM_BUFFERS; i++)
+        pixelBufferBusy[i] = false;
+
+    stopWorkers = false;
+    for (int i = 0; i < TEXTURE_STREAM_WORKERS; i++)
+        workers.push_back(std::thread(workerLoop));
+
+    streamingRunning = true;
+}
+
+//uploads the level of a finished job from its PBO, the PBO is free again afterwards
+static void uploadJob(const StreamJob& job) {
+
+    pixelBufferBusy[job.buffer] = false;
+    loadingBytes -= job.size;
+    streamStats.loading--;
+
+    // the PBO is unmapped either way, the level of a texture released meanwhile is dropped
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[job.buffer]);
+    std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.find(job.texture);
+    if (it == streamedTextures.end()) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+    StreamedTexture& streamed = it->second;
+    streamed.loadingLevel = -1;
+
+    bindTexture(0, GL_TEXTURE_2D, job.texture);
+
+    // the store can be lost while mapped (mode switch), the level is simply requested again
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE) {
+        texImageLevel(job.decode ? TEXTURE_FORMAT_RGBA8 : job.format, job.level, job.width, job.height, job.size, (const void*)0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.level);
+        streamed.residentLevel = job.level;
+
+        streamStats.residentBytes += job.size;
+        streamStats.uploadedBytes += job.size;
+        streamStats.levelsLoaded++;
+
+        double latency = std::chrono::duration<double, std::milli>(Clock::now() - streamed.waitStart).count();
+        streamStats.latency += (latency - streamStats.latency) / streamStats.levelsLoaded;
+        streamStats.maxLatency = std::max(streamStats.maxLatency, latency);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+//uploads what the workers finished, with wait it blocks until at least one job is finished
+static void uploadFinishedJobs(bool wait) {
+
+    std::deque<StreamJob> jobs;
+    {
+        std::unique_lock<std::mutex> lock(jobMutex);
+        if (wait)
+            finishedCondition.wait(lock, []() { return !finishedJobs.empty(); });
+        jobs.swap(finishedJobs);
+    }
+    for (size_t i = 0; i < jobs.size(); i++)
+        uploadJob(jobs[i]);
+}
+
+void cleanupTextureStreaming() {
+
+    if (!streamingRunning)
+        return;
+
+    while (streamStats.loading > 0)
+        uploadFinishedJobs(true);
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopWorkers = true;
+    }
+    pendingCondition.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    workers.clear();
+
+    glDeleteBuffers(TEXTURE_STREAM_BUFFERS, pixelBuffers);
+    for (std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.begin(); it != streamedTextures.end(); ++it)
+        closeTextureCache(&it->second.cache);
+    streamedTextures.clear();
+
+    streamingRunning = false;
+}
+
+GLuint createStreamedTexture(const std::string& fileName, size_t* residentBytes) {
+
+    *residentBytes = 0;
+    if (!streamingRunning)
+        return 0;
+
+    StreamedTexture streamed;
+    if (!openTextureCache(fileName, &streamed.cache))
+        return 0;
+    const TextureCache& cache = streamed.cache;
+    const int numLevels = (int)cache.levels.size();
+
+    int tail = 0;
+    while (tail + 1 < numLevels && std::max(cache.levels[tail].width, cache.levels[tail].height) > TEXTURE_STREAM_PLACEHOLDER_SIZE)
+        tail++;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    bindTexture(0, GL_TEXTURE_2D, texture);
+
+    // the placeholder is small enough to upload right away
+    for (int level = tail; level < numLevels; level++) {
+        const TextureCacheLevel& cacheLevel = cache.levels[level];
+        if (textureInternalFormat(cache.format) == GL_RGBA8 && cache.format != TEXTURE_FORMAT_RGBA8) {
+            TextureImage image;
+            decodeTextureLevel(cacheLevel.data, cache.format, cacheLevel.width, cacheLevel.height, &image);
+            texImageLevel(TEXTURE_FORMAT_RGBA8, level, cacheLevel.width, cacheLevel.height, image.pixels.size(), image.pixels.data());
+        }
+        else {
+            texImageLevel(cache.format, level, cacheLevel.width, cacheLevel.height, cacheLevel.size, cacheLevel.data);
+        }
+        *residentBytes += levelBytes(cache, level);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, tail);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // nothing finer to stream
+    if (tail == 0) {
+        closeTextureCache(&streamed.cache);
+        return texture;
+    }
+
+    streamed.residentLevel = tail;
+    streamed.tailLevel = tail;
+    streamed.loadingLevel = -1;
+    streamed.wantedLevel = tail;
+    streamed.pixels = 0.0f;
+    streamed.lastUsedFrame = streamFrame;
+    streamed.waiting = false;
+    streamedTextures[texture] = streamed;
+
+    streamStats.textures++;
+    streamStats.residentBytes += *residentBytes;
+    return texture;
+}
+
+void releaseStreamedTexture(GLuint texture) {
+
+    std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.find(texture);
+    if (it == streamedTextures.end())
+        return;
+
+    while (it->second.loadingLevel >= 0)
+        uploadFinishedJobs(true);
+
+    for (int level = it->second.residentLevel; level < (int)it->second.cache.levels.size(); level++)
+        streamStats.residentBytes -= levelBytes(it->second.cache, level);
+    streamStats.textures--;
+
+    closeTextureCache(&it->second.cache);
+    streamedTextures.erase(it);
+}
+
+void requestStreamedTexture(GLuint texture, float pixels) {
+
+    std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.find(texture);
+    if (it == streamedTextures.end())
+        return;
+    StreamedTexture& streamed = it->second;
+
+    // one texel per pixel across the largest dimension
+    const TextureCacheLevel& top = streamed.cache.levels[0];
+    float texels = (float)std::max(top.width, top.height);
+    int level = pixels > 0.0f ? (int)std::floor(std::log2(std::max(texels / pixels, 1.0f))) : streamed.tailLevel;
+    level = std::min(level, streamed.tailLevel);
+
+    if (streamed.lastUsedFrame != streamFrame) {
+        streamed.lastUsedFrame = streamFrame;
+        streamed.wantedLevel = level;
+        streamed.pixels = pixels;
+    }
+    else {
+        streamed.wantedLevel = std::min(streamed.wantedLevel, level);
+        streamed.pixels = std::max(streamed.pixels, pixels);
+    }
+}
+
+//level below which the texture has more than it needs, textures not used this frame only keep the placeholder
+static int keptLevel(const StreamedTexture& streamed) {
+
+    return streamed.lastUsedFrame == streamFrame ? streamed.wantedLevel : streamed.tailLevel;
+}
+
+//drops the finest resident level, the texture samples the next one from now on
+static void evictLevel(GLuint texture, StreamedTexture* streamed) {
+
+    const int level = streamed->residentLevel;
+
+    bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    // an empty image in the texture's own format gives the level's memory back,
+    // levels under the base level do not affect completeness
+    texImageLevel(streamed->cache.format, level, 0, 0, 0, NULL);
+
+    streamed->residentLevel = level + 1;
+    streamStats.residentBytes -= levelBytes(streamed->cache, level);
+    streamStats.levelsEvicted++;
+}
+
+//evicts levels nobody needs this frame, least recently used first, until bytes more fit into the budget
+static bool makeRoom(size_t bytes) {
+
+    if (streamStats.residentBytes + loadingBytes + bytes <= budget)
+        return true;
+
+    std::vector<GLuint> candidates;
+    for (std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.begin(); it != streamedTextures.end(); ++it) {
+        if (it->second.loadingLevel < 0 && it->second.residentLevel < keptLevel(it->second))
+            candidates.push_back(it->first);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](GLuint a, GLuint b) {
+        const StreamedTexture& first = streamedTextures[a];
+        const StreamedTexture& second = streamedTextures[b];
+        if (first.lastUsedFrame != second.lastUsedFrame)
+            return first.lastUsedFrame < second.lastUsedFrame;
+        return first.pixels < second.pixels;
+    });
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        StreamedTexture& streamed = streamedTextures[candidates[i]];
+        while (streamed.residentLevel < keptLevel(streamed)) {
+            evictLevel(candidates[i], &streamed);
+            if (streamStats.residentBytes + loadingBytes + bytes <= budget)
+                return true;
+        }
+    }
+    return false;
+}
+
+//maps a free PBO for the next finer level of the texture and hands it to the workers
+static bool startLoad(GLuint texture, StreamedTexture* streamed, int buffer) {
+
+    const int level = streamed->residentLevel - 1;
+    const TextureCacheLevel& cacheLevel = streamed->cache.levels[level];
+    const size_t size = levelBytes(streamed->cache, level);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[buffer]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (destination == NULL) {
+        std::cerr << "updateTextureStreaming(): can not map a pixel buffer of " << size << " bytes" << std::endl;
+        return false;
+    }
+
+    StreamJob job;
+    job.texture = texture;
+    job.level = level;
+    job.buffer = buffer;
+    job.source = cacheLevel.data;
+    job.format = streamed->cache.format;
+    job.width = cacheLevel.width;
+    job.height = cacheLevel.height;
+    job.decode = textureInternalFormat(job.format) == GL_RGBA8 && job.format != TEXTURE_FORMAT_RGBA8;
+    job.destination = (unsigned char*)destination;
+    job.size = size;
+
+    pixelBufferBusy[buffer] = true;
+    streamed->loadingLevel = level;
+    loadingBytes += size;
+    streamStats.loading++;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        pendingJobs.push_back(job);
+    }
+    pendingCondition.notify_one();
+    return true;
+}
+
+void updateTextureStreaming() {
+
+    if (!streamingRunning)
+        return;
+
+    uploadFinishedJobs(false);
+
+    // latency counts from the first frame a level is missing
+    std::vector<GLuint> candidates;
+    for (std::unordered_map<GLuint, StreamedTexture>::iterator it = streamedTextures.begin(); it != streamedTextures.end(); ++it) {
+        StreamedTexture& streamed = it->second;
+        const bool missing = streamed.lastUsedFrame == streamFrame && streamed.wantedLevel < streamed.residentLevel;
+        if (missing && !streamed.waiting)
+            streamed.waitStart = Clock::now();
+        streamed.waiting = missing;
+
+        if (missing && streamed.loadingLevel < 0)
+            candidates.push_back(it->first);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](GLuint a, GLuint b) {
+        return streamedTextures[a].pixels > streamedTextures[b].pixels;
+    });
+
+    size_t startedBytes = 0;
+    int buffer = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        while (buffer < TEXTURE_STREAM_BUFFERS && pixelBufferBusy[buffer])
+            buffer++;
+        if (buffer == TEXTURE_STREAM_BUFFERS)
+            break;
+
+        StreamedTexture& streamed = streamedTextures[candidates[i]];
+        const size_t size = levelBytes(streamed.cache, streamed.residentLevel - 1);
+        if (startedBytes > 0 && startedBytes + size > TEXTURE_STREAM_FRAME_BYTES)
+            break;
+        if (!makeRoom(size))
+            continue;
+        if (!startLoad(candidates[i], &streamed, buffer))
+            break;
+        startedBytes += size;
+    }
+
+    streamFrame++;
+}
+
+const TextureStreamStats& getTextureStreamStats() {
+
+    return streamStats;
+}
@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    texture_streamer.h
+ * @date    18/10/2026
+ * @brief   Streaming of cooked texture mip levels - worker reads, PBO uploads and an LRU memory budget.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __TEXTURE_STREAMER_H
+#define __TEXTURE_STREAMER_H
+
+#include <string>
+#include "pgr.h"
+#include "texture_encoder.h"
+
+//S3TC is an extension, gl_core headers do not have its formats
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT     0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#endif
+
+#define TEXTURE_STREAM_WORKERS          2           // threads copying and decoding levels into the PBOs
+#define TEXTURE_STREAM_BUFFERS          8           // pixel buffer objects, also the most levels on their way at once
+#define TEXTURE_STREAM_FRAME_BYTES      (4 << 20)   // level bytes started per frame, a bigger level still goes alone
+#define TEXTURE_STREAM_PLACEHOLDER_SIZE 32          // levels up to this many texels across are uploaded at creation and never evicted
+
+//Counters of the streamer, resident and budget are current, the rest accumulate from initTextureStreaming
+typedef struct TextureStreamStats {
+  unsigned int  textures;           // streamed textures
+  unsigned int  loading;            // levels on their way
+  size_t        residentBytes;      // video memory of the streamed levels
+  size_t        budgetBytes;
+  size_t        uploadedBytes;
+  unsigned int  levelsLoaded;
+  unsigned int  levelsEvicted;
+  double        latency;            // ms from a level being wanted to its upload, average
+  double        maxLatency;
+} TextureStreamStats;
+
+//true if the driver samples BC1/BC3, checked once
+bool blockCompressionSupported();
+//internal format a level of the format is uploaded with, RGBA8 when the driver can not sample the blocks
+GLenum textureInternalFormat(TextureFormat format);
+
+//starts the workers and creates the PBOs, needs the context
+void initTextureStreaming(size_t budgetBytes);
+//waits for the workers, deletes the PBOs and forgets the remaining textures (their GL names are not deleted)
+void cleanupTextureStreaming();
+
+/**
+ * @brief 2D texture with only the mip tail of the cooked container of fileName resident.
+ *
+ * The container stays mapped, finer levels are loaded by updateTextureStreaming once
+ * requestStreamedTexture asks for them.
+ *
+ * @param residentBytes  video memory of the placeholder levels
+ * @return 0 if the streamer is not running or the source has no up to date container
+ */
+GLuint createStreamedTexture(const std::string& fileName, size_t* residentBytes);
+//call before glDeleteTextures of a streamed texture, waits for its levels on their way
+void releaseStreamedTexture(GLuint texture);
+
+//marks the texture used this frame by something about pixels texels across on screen, other textures are ignored
+void requestStreamedTexture(GLuint texture, float pixels);
+
+/**
+ * @brief Once per frame on the context thread, after the requests of the frame.
+ *
+ * Uploads the levels the workers finished, evicts least recently used levels while the
+ * budget is exceeded and starts loading the next finer level of the requested textures,
+ * the largest on screen first.
+ */
+void updateTextureStreaming();
+
+const TextureStreamStats& getTextureStreamStats();
+
+#endif
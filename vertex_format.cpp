@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    vertex_format.cpp
+ * @date    18/10/2026
+ * @brief   Quantized 16 byte vertices: positions in the mesh box, octahedral normals and normalized UVs.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+#include "vertex_format.h"
+
+size_t vertexFormatSize(VertexFormat format) {
+    return format == VERTEX_FORMAT_COMPACT ? sizeof(CompactVertex) : 8 * sizeof(float);
+}
+
+bool isInterleavedFloatLayout(const VertexStreams& streams) {
+
+    return streams.positionStride == 8 && streams.normalStride == 8 && streams.texCoordStride == 8
+        && streams.normals == streams.positions + 3
+        && streams.texCoords == streams.positions + 6;
+}
+
+void copyInterleavedVertices(const VertexStreams& streams, std::vector<float>* vertices) {
+
+    vertices->assign(8 * streams.numVertices, 0.0f);
+
+    for (size_t i = 0; i < streams.numVertices; i++) {
+        float* vertex = vertices->data() + 8 * i;
+        for (int c = 0; c < 3; c++) {
+            vertex[c] = streams.positions[i * streams.positionStride + c];
+            vertex[3 + c] = streams.normals[i * streams.normalStride + c];
+        }
+        if (streams.texCoords != NULL) {
+            vertex[6] = streams.texCoords[i * streams.texCoordStride];
+            vertex[7] = streams.texCoords[i * streams.texCoordStride + 1];
+        }
+    }
+}
+
+//0..1 to the full unsigned 16 bit range, rounded to the nearest step
+static uint16_t quantizeUnorm16(float value) {
+
+    value = std::min(std::max(value, 0.0f), 1.0f);
+    return (uint16_t)(value * 65535.0f + 0.5f);
+}
+
+//position of value in the range, 0 for an empty range
+static float rangeFraction(float value, float minimum, float extent) {
+    return extent > 0.0f ? (value - minimum) / extent : 0.0f;
+}
+
+static float signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+glm::vec2 encodeOctahedral(const glm::vec3& normal) {
+
+    float sum = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+    if (sum == 0.0f)
+        return glm::vec2(0.5f, 0.5f);   // degenerate normal, decodes to +z
+
+    // project onto the octahedron, the lower half is folded over the diagonals
+    float x = normal.x / sum;
+    float y = normal.y / sum;
+    if (normal.z < 0.0f) {
+        float foldedX = (1.0f - fabsf(y)) * signNotZero(x);
+        float foldedY = (1.0f - fabsf(x)) * signNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return glm::vec2(x * 0.5f + 0.5f, y * 0.5f + 0.5f);
+}
+
+glm::vec3 decodeOctahedral(const glm::vec2& encoded) {
+
+    float x = encoded.x * 2.0f - 1.0f;
+    float y = encoded.y * 2.0f - 1.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    if (z < 0.0f) {
+        float unfoldedX = (1.0f - fabsf(y)) * signNotZero(x);
+        float unfoldedY = (1.0f - fabsf(x)) * signNotZero(y);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+
+    return glm::normalize(glm::vec3(x, y, z));
+}
+
+bool encodeCompactVertices(const VertexStreams& streams, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                           std::vector<CompactVertex>* vertices, glm::vec4* texCoordTransform) {
+
+    const size_t numVertices = streams.numVertices;
+
+    // UV box, tiled meshes go outside 0..1
+    float texCoordMin[2] = { 0.0f, 0.0f };
+    float texCoordMax[2] = { 0.0f, 0.0f };
+    if (streams.texCoords != NULL) {
+        for (size_t i = 0; i < numVertices; i++) {
+            for (int c = 0; c < 2; c++) {
+                float value = streams.texCoords[i * streams.texCoordStride + c];
+                texCoordMin[c] = (i == 0) ? value : std::min(texCoordMin[c], value);
+                texCoordMax[c] = (i == 0) ? value : std::max(texCoordMax[c], value);
+            }
+        }
+    }
+
+    const float texCoordExtent[2] = { texCoordMax[0] - texCoordMin[0], texCoordMax[1] - texCoordMin[1] };
+    if (texCoordExtent[0] > COMPACT_TEXCOORD_RANGE || texCoordExtent[1] > COMPACT_TEXCOORD_RANGE)
+        return false;
+
+    const glm::vec3 extent = boundsMax - boundsMin;
+    vertices->resize(numVertices);
+
+    for (size_t i = 0; i < numVertices; i++) {
+        CompactVertex& vertex = (*vertices)[i];
+        const float* position = streams.positions + i * streams.positionStride;
+        const float* normal = streams.normals + i * streams.normalStride;
+
+        for (int c = 0; c < 3; c++)
+            vertex.position[c] = quantizeUnorm16(rangeFraction(position[c], boundsMin[c], extent[c]));
+        vertex.position[3] = 0;
+
+        glm::vec2 octahedral = encodeOctahedral(glm::vec3(normal[0], normal[1], normal[2]));
+        vertex.normal[0] = quantizeUnorm16(octahedral.x);
+        vertex.normal[1] = quantizeUnorm16(octahedral.y);
+
+        for (int c = 0; c < 2; c++) {
+            float value = streams.texCoords != NULL ? streams.texCoords[i * streams.texCoordStride + c] : 0.0f;
+            vertex.texCoord[c] = quantizeUnorm16(rangeFraction(value, texCoordMin[c], texCoordExtent[c]));
+        }
+    }
+
+    *texCoordTransform = glm::vec4(texCoordExtent[0], texCoordExtent[1], texCoordMin[0], texCoordMin[1]);
+    return true;
+}
@@ -0,0 +1,70 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    vertex_format.h
+ * @date    18/10/2026
+ * @brief   Quantized 16 byte vertices: positions in the mesh box, octahedral normals and normalized UVs.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __VERTEX_FORMAT_H
+#define __VERTEX_FORMAT_H
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+//widest UV range of a compact mesh, 16 units keep a step of 1/4096 (a quarter texel of a 1024 texture)
+#define COMPACT_TEXCOORD_RANGE  16.0f
+
+//blobs linked into the executable record it, raise it whenever CompactVertex or the float layout changes
+#define VERTEX_LAYOUT_VERSION   1
+
+//Layout of a mesh vertex buffer, picked per mesh when it is uploaded
+enum VertexFormat {
+  VERTEX_FORMAT_FLOAT,      // interleaved floats, position | normal | texCoord, 32 bytes per vertex
+  VERTEX_FORMAT_COMPACT     // interleaved CompactVertex, 16 bytes per vertex
+};
+
+//All values are unsigned normalized, the vertex shader maps them back with per mesh ranges
+typedef struct CompactVertex {
+  uint16_t  position[4];    // xyz in the mesh box, w is padding so the normal starts 8 byte aligned
+  uint16_t  normal[2];      // octahedral encoding
+  uint16_t  texCoord[2];    // in the mesh UV box
+} CompactVertex;
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay 16 bytes");
+
+//Float vertex data as a loader has it, strides in floats (3, 3, 2 for planar arrays, 8 for interleaved ones)
+typedef struct VertexStreams {
+  const float*  positions;
+  const float*  normals;
+  const float*  texCoords;      // NULL if the mesh has none, all zero then
+  size_t        positionStride;
+  size_t        normalStride;
+  size_t        texCoordStride;
+  size_t        numVertices;
+} VertexStreams;
+
+size_t vertexFormatSize(VertexFormat format);
+
+//true if the streams already are one block in the interleaved float layout and can be uploaded as they are
+bool isInterleavedFloatLayout(const VertexStreams& streams);
+//copies the streams to the interleaved float layout
+void copyInterleavedVertices(const VertexStreams& streams, std::vector<float>* vertices);
+
+/**
+ * @brief Quantizes the streams to compact vertices.
+ *
+ * Position = boundsMin + value * (boundsMax - boundsMin), texCoord = transform.zw + value * transform.xy.
+ *
+ * @param texCoordTransform  xy scale and zw offset of the UV box
+ * @return false if the UV range is wider than COMPACT_TEXCOORD_RANGE, the mesh stays in floats then
+ */
+bool encodeCompactVertices(const VertexStreams& streams, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                           std::vector<CompactVertex>* vertices, glm::vec4* texCoordTransform);
+
+//unit normal to two values in 0..1 and back, the shader does the same decoding
+glm::vec2 encodeOctahedral(const glm::vec3& normal);
+glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+
+#endif
@@ -0,0 +1,287 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    xml_parser.cpp
+ * @date    18/10/2026
+ * @brief   Zero-copy XML tag reader over memory mapped scene and configuration files.
+ */
+ //----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "data.h"
+#include "xml_parser.h"
+#include "number_parser.h"
+#if XML_PARSER_BENCHMARK
+#include "benchmark.h"
+#endif
+
+bool openXmlReader(const std::string& fileName, XmlReader* reader) {
+
+    reader->malformed = false;
+    if (!mapFile(fileName, &reader->file)) {
+        reader->position = reader->end = NULL;
+        return false;
+    }
+
+    reader->position = reader->file.data;
+    reader->end = reader->file.data + reader->file.size;
+    return true;
+}
+
+void closeXmlReader(XmlReader* reader) {
+
+    unmapFile(&reader->file);
+    reader->position = reader->end = NULL;
+}
+
+static inline bool isXmlSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool isXmlNameEnd(char c) {
+    return isXmlSpace(c) || c == '>' || c == '/' || c == '=';
+}
+
+static inline const char* skipXmlSpaces(const char* p, const char* end) {
+    while (p < end && isXmlSpace(*p))
+        ++p;
+    return p;
+}
+
+static bool malformedXml(XmlReader* reader, const char* position) {
+
+    reader->malformed = true;
+    reader->position = position;
+    return false;
+}
+
+//first "-->" at or after p
+static const char* findCommentEnd(const char* p, const char* end) {
+
+    while (p + 3 <= end) {
+        p = (const char*)memchr(p, '-', end - p);
+        if (p == NULL || p + 3 > end)
+            return NULL;
+        if (p[1] == '-' && p[2] == '>')
+            return p;
+        ++p;
+    }
+    return NULL;
+}
+
+bool nextXmlTag(XmlReader* reader, XmlTag* tag) {
+
+    const char* end = reader->end;
+    const char* p = reader->position;
+    if (p == NULL || reader->malformed)
+        return false;
+
+    // text, comments and declarations up to the next element
+    const char* tagStart;
+    while (true) {
+        p = (const char*)memchr(p, '<', end - p);
+        if (p == NULL) {
+            reader->position = end;
+            return false;
+        }
+        tagStart = p;
+
+        if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+            const char* commentEnd = findCommentEnd(p + 4, end);
+            if (commentEnd == NULL)
+                return malformedXml(reader, tagStart);
+            p = commentEnd + 3;
+        }
+        else if (end - p >= 2 && (p[1] == '?' || p[1] == '!')) {
+            p = (const char*)memchr(p + 2, '>', end - p - 2);
+            if (p == NULL)
+                return malformedXml(reader, tagStart);
+            ++p;
+        }
+        else {
+            break;
+        }
+    }
+
+    ++p;
+    tag->closing = p < end && *p == '/';
+    tag->selfClosing = false;
+    tag->numAttributes = 0;
+    if (tag->closing)
+        ++p;
+
+    tag->name.data = p;
+    while (p < end && !isXmlNameEnd(*p))
+        ++p;
+    tag->name.size = p - tag->name.data;
+    if (tag->name.size == 0)
+        return malformedXml(reader, tagStart);
+
+    while (true) {
+        p = skipXmlSpaces(p, end);
+        if (p >= end)
+            return malformedXml(reader, tagStart);
+
+        if (*p == '>') {
+            reader->position = p + 1;
+            return true;
+        }
+        if (*p == '/') {
+            if (p + 1 >= end || p[1] != '>')
+                return malformedXml(reader, tagStart);
+            tag->selfClosing = true;
+            reader->position = p + 2;
+            return true;
+        }
+
+        XmlString name;
+        name.data = p;
+        while (p < end && !isXmlNameEnd(*p))
+            ++p;
+        name.size = p - name.data;
+
+        p = skipXmlSpaces(p, end);
+        if (name.size == 0 || p >= end || *p != '=')
+            return malformedXml(reader, tagStart);
+        p = skipXmlSpaces(p + 1, end);
+        if (p >= end || (*p != '"' && *p != '\''))
+            return malformedXml(reader, tagStart);
+
+        const char* valueEnd = (const char*)memchr(p + 1, *p, end - p - 1);
+        if (valueEnd == NULL)
+            return malformedXml(reader, tagStart);
+
+        if (tag->numAttributes < XML_MAX_ATTRIBUTES) {
+            XmlAttribute& attribute = tag->attributes[tag->numAttributes++];
+            attribute.name = name;
+            attribute.value.data = p + 1;
+            attribute.value.size = valueEnd - p - 1;
+        }
+        p = valueEnd + 1;
+    }
+}
+
+bool xmlEquals(const XmlString& string, const char* text) {
+
+    return strncmp(string.data, text, string.size) == 0 && text[string.size] == '\0';
+}
+
+const XmlString* xmlAttribute(const XmlTag& tag, const char* name) {
+
+    for (int i = 0; i < tag.numAttributes; i++) {
+        if (xmlEquals(tag.attributes[i].name, name))
+            return &tag.attributes[i].value;
+    }
+    return NULL;
+}
+
+float xmlFloat(const XmlTag& tag, const char* name, float fallback) {
+
+    const XmlString* value = xmlAttribute(tag, name);
+    if (value == NULL)
+        return fallback;
+
+    float result;
+    parseFloat(value->data, value->data + value->size, &result);
+    return result;
+}
+
+int xmlInt(const XmlTag& tag, const char* name, int fallback) {
+
+    const XmlString* value = xmlAttribute(tag, name);
+    if (value == NULL || value->size == 0)
+        return fallback;
+
+    const char* p = value->data;
+    const char* end = p + value->size;
+    bool negative = *p == '-';
+    if (*p == '-' || *p == '+')
+        ++p;
+
+    int result = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        result = result * 10 + (*p++ - '0');
+    return negative ? -result : result;
+}
+
+std::string xmlToString(const XmlString& string) {
+
+    return std::string(string.data, string.size);
+}
+
+#if XML_PARSER_BENCHMARK
+void benchmarkXmlParser() {
+
+    typedef BenchmarkClock Clock;
+
+    const int numNodes = 500000;
+    const std::string fileName = "xml_parser_benchmark.xml";
+
+    SceneGraph scene;
+    generateSceneGraph(&scene, numNodes);
+    bool written = writeSceneGraphFile(scene, fileName);
+    clearSceneGraph(&scene);
+    if (!written) {
+        std::cout << "XML parser benchmark: can not write " << fileName << std::endl;
+        return;
+    }
+    prefetchFile(fileName);
+
+    XmlReader reader;
+    XmlTag tag;
+    if (!openXmlReader(fileName, &reader)) {
+        std::cout << "XML parser benchmark: can not map " << fileName << std::endl;
+        return;
+    }
+    const double megabytes = reader.file.size / (1024.0 * 1024.0);
+
+    // tags and attribute views only
+    size_t numTags = 0, numAttributes = 0;
+    Clock::time_point start = Clock::now();
+    while (nextXmlTag(&reader, &tag)) {
+        numTags++;
+        numAttributes += tag.numAttributes;
+    }
+    double tagTime = millisecondsBetween(start, Clock::now());
+    bool malformed = reader.malformed;
+
+    // x, y, z of every vector element with parseFloat
+    reader.position = reader.file.data;
+    size_t numFloats = 0;
+    double sum = 0.0;
+    start = Clock::now();
+    while (nextXmlTag(&reader, &tag)) {
+        if (tag.numAttributes == 3 && !tag.closing) {
+            sum += xmlFloat(tag, "x", 0.0f) + xmlFloat(tag, "y", 0.0f) + xmlFloat(tag, "z", 0.0f);
+            numFloats += 3;
+        }
+    }
+    double floatTime = millisecondsBetween(start, Clock::now());
+
+    // the same values copied into strings and converted by strtof, as a DOM parser with owned strings would
+    reader.position = reader.file.data;
+    double copiedSum = 0.0;
+    start = Clock::now();
+    while (nextXmlTag(&reader, &tag)) {
+        if (tag.numAttributes == 3 && !tag.closing) {
+            for (int i = 0; i < 3; i++) {
+                std::string name = xmlToString(tag.attributes[i].name);
+                std::string value = xmlToString(tag.attributes[i].value);
+                copiedSum += strtof(value.c_str(), NULL);
+            }
+        }
+    }
+    double copiedTime = millisecondsBetween(start, Clock::now());
+
+    closeXmlReader(&reader);
+    std::remove(fileName.c_str());
+
+    std::cout << "XML parser benchmark, " << megabytes << " MB, " << numTags << " tags, " << numAttributes << " attributes"
+              << (malformed ? ", MALFORMED" : "") << ":" << std::endl;
+    std::cout << "  tags " << tagTime << " ms (" << megabytes / (tagTime / 1000.0) << " MB/s), with " << numFloats << " floats "
+              << floatTime << " ms (" << megabytes / (floatTime / 1000.0) << " MB/s), copied strings and strtof " << copiedTime
+              << " ms (" << megabytes / (copiedTime / 1000.0) << " MB/s), sums differ by " << sum - copiedSum << std::endl;
+}
+#endif
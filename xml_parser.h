@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------------
+/**
+ * @file    xml_parser.h
+ * @date    18/10/2026
+ * @brief   Zero-copy XML tag reader over memory mapped scene and configuration files.
+ */
+ //----------------------------------------------------------------------------------------
+
+#ifndef __XML_PARSER_H
+#define __XML_PARSER_H
+
+#include <string>
+#include <cstddef>
+#include "mapped_file.h"
+
+//attributes kept per tag, the scene files have at most 5
+#define XML_MAX_ATTRIBUTES      16
+
+//View into the file text, not null terminated and valid as long as the file is mapped
+typedef struct XmlString {
+  const char*   data;
+  size_t        size;
+} XmlString;
+
+typedef struct XmlAttribute {
+  XmlString     name;
+  XmlString     value;          // without the quotes, entities are left as they are
+} XmlAttribute;
+
+//One element tag, text between tags, comments and declarations are skipped
+typedef struct XmlTag {
+  XmlString     name;
+  XmlAttribute  attributes[XML_MAX_ATTRIBUTES];
+  int           numAttributes;  // further attributes of the tag are dropped
+  bool          closing;        // </name>
+  bool          selfClosing;    // <name ... />
+} XmlTag;
+
+typedef struct XmlReader {
+  MappedFile    file;
+  const char*   position;
+  const char*   end;
+  bool          malformed;      // reading stopped at a broken tag, position points to it
+} XmlReader;
+
+//maps the file, returns false if it can not be opened
+bool openXmlReader(const std::string& fileName, XmlReader* reader);
+
+//unmaps the file, all views into it become invalid
+void closeXmlReader(XmlReader* reader);
+
+/**
+ * @brief Reads the next element tag, nothing is allocated or copied.
+ * @return false at the end of the text or on a malformed tag (reader->malformed is set)
+ */
+bool nextXmlTag(XmlReader* reader, XmlTag* tag);
+
+bool xmlEquals(const XmlString& string, const char* text);
+
+//value of the attribute, NULL if the tag does not have it
+const XmlString* xmlAttribute(const XmlTag& tag, const char* name);
+
+//value of the attribute as a float or an int, fallback if the tag does not have it
+float xmlFloat(const XmlTag& tag, const char* name, float fallback);
+int xmlInt(const XmlTag& tag, const char* name, int fallback);
+
+std::string xmlToString(const XmlString& string);
+
+#endif